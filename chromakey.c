@@ -0,0 +1,375 @@
+/**
+ * chromakey element, see chromakey.h
+ **/
+#include <gst/gst.h>
+#include <gst/video/video.h>
+#include <gst/video/gstvideofilter.h>
+
+#include "chromakey.h"
+#include "key_convert.h"
+
+GST_DEBUG_CATEGORY_STATIC (chroma_key_debug);
+#define GST_CAT_DEFAULT chroma_key_debug
+
+typedef enum {
+	CHROMA_KEY_METHOD_GREEN,
+	CHROMA_KEY_METHOD_BLUE,
+	CHROMA_KEY_METHOD_CUSTOM
+} ChromaKeyMethod;
+
+#define DEFAULT_METHOD CHROMA_KEY_METHOD_GREEN
+#define DEFAULT_TARGET_R 0
+#define DEFAULT_TARGET_G 255
+#define DEFAULT_TARGET_B 0
+#define DEFAULT_ANGLE 20.0
+#define DEFAULT_NOISE_LEVEL 2.0
+#define DEFAULT_BLACK_SENSITIVITY 100
+#define DEFAULT_WHITE_SENSITIVITY 100
+
+#define GST_TYPE_CHROMA_KEY_METHOD (gst_chroma_key_method_get_type ())
+
+struct _GstChromaKey {
+	GstVideoFilter parent;
+
+	/* properties and the key made from them, protected by the object lock */
+	ChromaKeyMethod method;
+	guint target_r, target_g, target_b;
+	gfloat angle;
+	gfloat noise_level;
+	guint black_sensitivity, white_sensitivity;
+	KeyParams params;
+
+	guint8 *scratch;       /* one KeyRow for the negotiated width */
+};
+
+struct _GstChromaKeyClass {
+	GstVideoFilterClass parent_class;
+};
+
+enum {
+	PROP_0,
+	PROP_METHOD,
+	PROP_TARGET_R,
+	PROP_TARGET_G,
+	PROP_TARGET_B,
+	PROP_ANGLE,
+	PROP_NOISE_LEVEL,
+	PROP_BLACK_SENSITIVITY,
+	PROP_WHITE_SENSITIVITY
+};
+
+static GstStaticPadTemplate sink_template = GST_STATIC_PAD_TEMPLATE ("sink",
+		GST_PAD_SINK,
+		GST_PAD_ALWAYS,
+		GST_STATIC_CAPS (GST_VIDEO_CAPS_MAKE ("{ I420, Y42B }")));
+
+static GstStaticPadTemplate src_template = GST_STATIC_PAD_TEMPLATE ("src",
+		GST_PAD_SRC,
+		GST_PAD_ALWAYS,
+		GST_STATIC_CAPS (GST_VIDEO_CAPS_MAKE ("AYUV")));
+
+G_DEFINE_TYPE (GstChromaKey, gst_chroma_key, GST_TYPE_VIDEO_FILTER);
+
+static GType
+gst_chroma_key_method_get_type (void)
+{
+	static GType type = 0;
+	static const GEnumValue values[] = {
+		{CHROMA_KEY_METHOD_GREEN, "Chroma Key on pure green", "green"},
+		{CHROMA_KEY_METHOD_BLUE, "Chroma Key on pure blue", "blue"},
+		{CHROMA_KEY_METHOD_CUSTOM, "Chroma Key on custom RGB values", "custom"},
+		{0, NULL, NULL}
+	};
+
+	if (!type)
+		type = g_enum_register_static ("GstChromaKeyMethod", values);
+	return type;
+}
+
+/* call with the object lock */
+static void
+gst_chroma_key_update_params (GstChromaKey *key)
+{
+	guint8 r = key->target_r, g = key->target_g, b = key->target_b;
+
+	switch (key->method) {
+		case CHROMA_KEY_METHOD_GREEN:
+			r = 0;
+			g = 255;
+			b = 0;
+			break;
+		case CHROMA_KEY_METHOD_BLUE:
+			r = 0;
+			g = 0;
+			b = 255;
+			break;
+		case CHROMA_KEY_METHOD_CUSTOM:
+			break;
+	}
+	key_params_init (&key->params, r, g, b, key->angle, key->noise_level,
+			key->black_sensitivity, key->white_sensitivity);
+}
+
+static void
+gst_chroma_key_set_property (GObject *object, guint prop_id,
+		const GValue *value, GParamSpec *pspec)
+{
+	GstChromaKey *key = GST_CHROMA_KEY (object);
+
+	GST_OBJECT_LOCK (key);
+	switch (prop_id) {
+		case PROP_METHOD:
+			key->method = g_value_get_enum (value);
+			break;
+		case PROP_TARGET_R:
+			key->target_r = g_value_get_uint (value);
+			break;
+		case PROP_TARGET_G:
+			key->target_g = g_value_get_uint (value);
+			break;
+		case PROP_TARGET_B:
+			key->target_b = g_value_get_uint (value);
+			break;
+		case PROP_ANGLE:
+			key->angle = g_value_get_float (value);
+			break;
+		case PROP_NOISE_LEVEL:
+			key->noise_level = g_value_get_float (value);
+			break;
+		case PROP_BLACK_SENSITIVITY:
+			key->black_sensitivity = g_value_get_uint (value);
+			break;
+		case PROP_WHITE_SENSITIVITY:
+			key->white_sensitivity = g_value_get_uint (value);
+			break;
+		default:
+			G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+			break;
+	}
+	gst_chroma_key_update_params (key);
+	GST_OBJECT_UNLOCK (key);
+}
+
+static void
+gst_chroma_key_get_property (GObject *object, guint prop_id, GValue *value,
+		GParamSpec *pspec)
+{
+	GstChromaKey *key = GST_CHROMA_KEY (object);
+
+	GST_OBJECT_LOCK (key);
+	switch (prop_id) {
+		case PROP_METHOD:
+			g_value_set_enum (value, key->method);
+			break;
+		case PROP_TARGET_R:
+			g_value_set_uint (value, key->target_r);
+			break;
+		case PROP_TARGET_G:
+			g_value_set_uint (value, key->target_g);
+			break;
+		case PROP_TARGET_B:
+			g_value_set_uint (value, key->target_b);
+			break;
+		case PROP_ANGLE:
+			g_value_set_float (value, key->angle);
+			break;
+		case PROP_NOISE_LEVEL:
+			g_value_set_float (value, key->noise_level);
+			break;
+		case PROP_BLACK_SENSITIVITY:
+			g_value_set_uint (value, key->black_sensitivity);
+			break;
+		case PROP_WHITE_SENSITIVITY:
+			g_value_set_uint (value, key->white_sensitivity);
+			break;
+		default:
+			G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+			break;
+	}
+	GST_OBJECT_UNLOCK (key);
+}
+
+/* I420 or Y42B in, AYUV out, everything else stays */
+static GstCaps *
+gst_chroma_key_transform_caps (GstBaseTransform *trans,
+		GstPadDirection direction, GstCaps *caps, GstCaps *filter)
+{
+	GValue formats = G_VALUE_INIT, format = G_VALUE_INIT;
+	GstCaps *ret, *tmp;
+	GstStructure *s;
+	guint i;
+
+	g_value_init (&formats, GST_TYPE_LIST);
+	g_value_init (&format, G_TYPE_STRING);
+	if (direction == GST_PAD_SINK) {
+		g_value_set_static_string (&format, "AYUV");
+		gst_value_list_append_value (&formats, &format);
+	} else {
+		g_value_set_static_string (&format, "I420");
+		gst_value_list_append_value (&formats, &format);
+		g_value_set_static_string (&format, "Y42B");
+		gst_value_list_append_value (&formats, &format);
+	}
+
+	ret = gst_caps_copy (caps);
+	for (i = 0; i < gst_caps_get_size (ret); i++) {
+		s = gst_caps_get_structure (ret, i);
+		gst_structure_set_value (s, "format", &formats);
+		gst_structure_remove_fields (s, "colorimetry", "chroma-site", NULL);
+	}
+	g_value_unset (&format);
+	g_value_unset (&formats);
+
+	if (filter) {
+		tmp = ret;
+		ret = gst_caps_intersect_full (filter, tmp, GST_CAPS_INTERSECT_FIRST);
+		gst_caps_unref (tmp);
+	}
+	return ret;
+}
+
+static gboolean
+gst_chroma_key_set_info (GstVideoFilter *filter, GstCaps *incaps,
+		GstVideoInfo *in_info, GstCaps *outcaps, GstVideoInfo *out_info)
+{
+	GstChromaKey *key = GST_CHROMA_KEY (filter);
+
+	g_free (key->scratch);
+	key->scratch = g_malloc (4 * ((GST_VIDEO_INFO_WIDTH (in_info) + 1) / 2));
+	return TRUE;
+}
+
+static GstFlowReturn
+gst_chroma_key_transform_frame (GstVideoFilter *filter, GstVideoFrame *in,
+		GstVideoFrame *out)
+{
+	GstChromaKey *key = GST_CHROMA_KEY (filter);
+	const guint8 *y, *u, *v;
+	KeyParams params;
+	KeyRow row;
+	gint i, width, height, cw, vsub;
+
+	GST_OBJECT_LOCK (key);
+	params = key->params;
+	GST_OBJECT_UNLOCK (key);
+
+	width = GST_VIDEO_FRAME_WIDTH (in);
+	height = GST_VIDEO_FRAME_HEIGHT (in);
+	cw = (width + 1) / 2;
+	/* I420 shares a chroma row between two luma rows, Y42B does not */
+	vsub = GST_VIDEO_FORMAT_INFO_H_SUB (in->info.finfo, 1);
+	row.ka = key->scratch;
+	row.ky = row.ka + cw;
+	row.ku = row.ky + cw;
+	row.kv = row.ku + cw;
+
+	for (i = 0; i < height; i++) {
+		y = (const guint8 *) GST_VIDEO_FRAME_COMP_DATA (in, 0) +
+			i * GST_VIDEO_FRAME_COMP_STRIDE (in, 0);
+		u = (const guint8 *) GST_VIDEO_FRAME_COMP_DATA (in, 1) +
+			(i >> vsub) * GST_VIDEO_FRAME_COMP_STRIDE (in, 1);
+		v = (const guint8 *) GST_VIDEO_FRAME_COMP_DATA (in, 2) +
+			(i >> vsub) * GST_VIDEO_FRAME_COMP_STRIDE (in, 2);
+		if (!(i & ((1 << vsub) - 1)))
+			key_chroma_row (&row, u, v, cw, &params);
+		key_pack_row ((guint8 *) GST_VIDEO_FRAME_PLANE_DATA (out, 0) +
+				i * GST_VIDEO_FRAME_PLANE_STRIDE (out, 0), y, u, v, &row, width, &params);
+	}
+	return GST_FLOW_OK;
+}
+
+static void
+gst_chroma_key_finalize (GObject *object)
+{
+	GstChromaKey *key = GST_CHROMA_KEY (object);
+
+	g_free (key->scratch);
+
+	G_OBJECT_CLASS (gst_chroma_key_parent_class)->finalize (object);
+}
+
+static void
+gst_chroma_key_class_init (GstChromaKeyClass *klass)
+{
+	GObjectClass *gobject_class = G_OBJECT_CLASS (klass);
+	GstElementClass *element_class = GST_ELEMENT_CLASS (klass);
+	GstBaseTransformClass *trans_class = GST_BASE_TRANSFORM_CLASS (klass);
+	GstVideoFilterClass *filter_class = GST_VIDEO_FILTER_CLASS (klass);
+
+	gobject_class->set_property = gst_chroma_key_set_property;
+	gobject_class->get_property = gst_chroma_key_get_property;
+	gobject_class->finalize = gst_chroma_key_finalize;
+
+	g_object_class_install_property (gobject_class, PROP_METHOD,
+			g_param_spec_enum ("method", "Method", "Which colour is keyed out",
+				GST_TYPE_CHROMA_KEY_METHOD, DEFAULT_METHOD,
+				G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+	g_object_class_install_property (gobject_class, PROP_TARGET_R,
+			g_param_spec_uint ("target-r", "Target Red", "The red colour value for custom RGB keying",
+				0, 255, DEFAULT_TARGET_R, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+	g_object_class_install_property (gobject_class, PROP_TARGET_G,
+			g_param_spec_uint ("target-g", "Target Green", "The green colour value for custom RGB keying",
+				0, 255, DEFAULT_TARGET_G, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+	g_object_class_install_property (gobject_class, PROP_TARGET_B,
+			g_param_spec_uint ("target-b", "Target Blue", "The blue colour value for custom RGB keying",
+				0, 255, DEFAULT_TARGET_B, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+	g_object_class_install_property (gobject_class, PROP_ANGLE,
+			g_param_spec_float ("angle", "Angle", "Size of the colour sphere around the key (7.5 to 80)",
+				0.0, 90.0, DEFAULT_ANGLE, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+	g_object_class_install_property (gobject_class, PROP_NOISE_LEVEL,
+			g_param_spec_float ("noise-level", "Noise Level", "Size of noise radius",
+				0.0, 64.0, DEFAULT_NOISE_LEVEL, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+	g_object_class_install_property (gobject_class, PROP_BLACK_SENSITIVITY,
+			g_param_spec_uint ("black-sensitivity", "Black Sensitivity", "Sensitivity to dark colours",
+				0, 128, DEFAULT_BLACK_SENSITIVITY, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+	g_object_class_install_property (gobject_class, PROP_WHITE_SENSITIVITY,
+			g_param_spec_uint ("white-sensitivity", "White Sensitivity", "Sensitivity to bright colours",
+				0, 128, DEFAULT_WHITE_SENSITIVITY, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+	gst_element_class_add_pad_template (element_class,
+			gst_static_pad_template_get (&sink_template));
+	gst_element_class_add_pad_template (element_class,
+			gst_static_pad_template_get (&src_template));
+	gst_element_class_set_static_metadata (element_class,
+			"Chroma key", "Filter/Effect/Video",
+			"Keys out a green or blue screen from I420 or Y42B into AYUV in one pass",
+			"surface-streams");
+
+	trans_class->transform_caps = GST_DEBUG_FUNCPTR (gst_chroma_key_transform_caps);
+	filter_class->set_info = GST_DEBUG_FUNCPTR (gst_chroma_key_set_info);
+	filter_class->transform_frame = GST_DEBUG_FUNCPTR (gst_chroma_key_transform_frame);
+}
+
+static void
+gst_chroma_key_init (GstChromaKey *key)
+{
+	key->method = DEFAULT_METHOD;
+	key->target_r = DEFAULT_TARGET_R;
+	key->target_g = DEFAULT_TARGET_G;
+	key->target_b = DEFAULT_TARGET_B;
+	key->angle = DEFAULT_ANGLE;
+	key->noise_level = DEFAULT_NOISE_LEVEL;
+	key->black_sensitivity = DEFAULT_BLACK_SENSITIVITY;
+	key->white_sensitivity = DEFAULT_WHITE_SENSITIVITY;
+	gst_chroma_key_update_params (key);
+}
+
+static gboolean
+plugin_init (GstPlugin *plugin)
+{
+	GST_DEBUG_CATEGORY_INIT (chroma_key_debug, "chromakey", 0, "Chroma key");
+
+	key_init ();
+	GST_INFO ("keying with %s", key_impl_name ());
+
+	return gst_element_register (plugin, "chromakey", GST_RANK_NONE,
+			GST_TYPE_CHROMA_KEY);
+}
+
+gboolean
+chroma_key_register (void)
+{
+	return gst_plugin_register_static (GST_VERSION_MAJOR, GST_VERSION_MINOR,
+			"chromakey", "Chroma key", plugin_init, "1.0",
+			"LGPL", "3mixer", "3mixer", "https://gstreamer.freedesktop.org/");
+}
@@ -0,0 +1,37 @@
+/**
+ * chromakey: green or blue screen keying of I420 (or Y42B) video into AYUV.
+ *
+ * Does what "alpha method=green" does after jpegdec or vp8dec, but in a
+ * single vectorised pass that reads the decoder's I420 buffer and writes
+ * the keyed AYUV straight into the buffer going downstream. The key is
+ * computed once per chroma sample, it only depends on the chroma.
+ *
+ *   jpegdec ! chromakey method=green angle=20 ! multimixer ...
+ *
+ * The properties are those of the alpha element for its keying methods.
+ **/
+#ifndef __CHROMA_KEY_H__
+#define __CHROMA_KEY_H__
+
+#include <gst/gst.h>
+
+G_BEGIN_DECLS
+
+#define GST_TYPE_CHROMA_KEY \
+  (gst_chroma_key_get_type())
+#define GST_CHROMA_KEY(obj) \
+  (G_TYPE_CHECK_INSTANCE_CAST((obj),GST_TYPE_CHROMA_KEY,GstChromaKey))
+#define GST_IS_CHROMA_KEY(obj) \
+  (G_TYPE_CHECK_INSTANCE_TYPE((obj),GST_TYPE_CHROMA_KEY))
+
+typedef struct _GstChromaKey      GstChromaKey;
+typedef struct _GstChromaKeyClass GstChromaKeyClass;
+
+GType gst_chroma_key_get_type (void);
+
+/* registers the element with the application, call after gst_init */
+gboolean chroma_key_register (void);
+
+G_END_DECLS
+
+#endif /* __CHROMA_KEY_H__ */
@@ -0,0 +1,604 @@
+//# both ends of the dual surface setup in one process
+// was start_dual_src.sh and start_dual_sinks.sh: one gst-launch-1.0 per stream, each
+// with its own clock, lsusb and v4l2-ctl calls, wmctrl polling loops and sleeps.
+// now every stream is a branch of one pipeline under one clock, all started at once:
+//   dualstream send [--slot=N] [--profile=jpeg|h264|vp8] TARGET
+//   dualstream receive [--slot=N] [--profile=jpeg|h264|vp8]
+// ports: surface 5000+slot, face 6000+slot, audio 7000+slot.
+// send: audio from pulse, the face cam as MJPEG (or re-encoded with the profile,
+// see surfaceprofile.c) and the surface, found by its USB ID in sysfs:
+//   Kinect v2 (045e:02d9)  Protonect, it owns the device, runs as a child
+//   SUR40 (045e:0775)      v4l2src on the touch device, in the pipeline
+//   otherwise              the c920, focus fixed here, through ./gstreamer as a child
+// the cameras in the pipeline are captured without copies, see v4l2capture.h.
+// a child only starts once the face cam streams, the face cam needs its USB
+// bandwidth first.
+// receive: the videos through surfacesrc, the audio through a jitter buffer, all
+// sinks synchronised on the one clock. Each window is placed by wmctrl once it has
+// shown a frame, no polling.
+// --sync on both ends: the receiver serves its pipeline clock on port 8000+slot
+// and the sender slaves to it, the sender's streams go through one rtpbin whose
+// RTCP sender reports (port+500) carry the capture time, and the receiver plays
+// every stream at that time plus the latency, audio and video aligned on the
+// shared clock instead of each jitter buffer timing its stream by arrival.
+// the surface of a child program has no sender reports and plays by arrival.
+// Every few seconds the latency of each stream is printed: from capture to udpsink
+// when sending, from arrival to the sink when receiving.
+// build: gcc -Wall -O2 dualstream.c surfacesrc.c frameguard.c surfaceprofile.c v4l2capture.c -o dualstream $(pkg-config --cflags --libs gstreamer-1.0 gstreamer-rtp-1.0 gstreamer-net-1.0) -lm
+#include <gst/gst.h>
+#include <gst/net/gstnet.h>
+#include <glib.h>
+#include <glib-unix.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <linux/videodev2.h>
+
+#include "surfacesrc.h"
+#include "surfaceprofile.h"
+#include "v4l2capture.h"
+
+// need udev rules for the logitech cameras, e.g. in /etc/udev/rules.d/99-camera-symlink.rules
+#define FACECAM "/dev/video-face"
+#define SURFCAM "/dev/video-surf"
+#define TOUCHDEV "/dev/v4l-touch0"
+
+#define REPORT_INTERVAL 5      /* seconds */
+#define CLOCK_PORT 8000        /* + slot, the receiver's clock with --sync */
+#define CLOCK_SYNC_TIMEOUT 5   /* seconds the sender waits for it */
+
+enum {
+	STREAM_SURFACE,
+	STREAM_FACE,
+	STREAM_AUDIO,
+	N_STREAMS
+};
+
+/**
+ * one stream, its sink is named "<name>_sink",
+ * its window (receive) is titled the same
+ **/
+typedef struct {
+	const gchar *name;
+	gint port;                 /* + slot */
+	gint rtcp_port;            /* + slot, with --sync */
+	const gchar *geometry;     /* wmctrl -e, NULL for no window */
+
+	/* latency from the buffer timestamp to the sink, under lock */
+	GMutex lock;
+	guint64 count;
+	GstClockTimeDiff sum, max;
+	guint frames;
+} Stream;
+
+static Stream streams[N_STREAMS] = {
+	{"surface", 5000, 5500, "0,0,1100,-1,-1"},
+	{"face", 6000, 6500, "0,0,0,-1,-1"},
+	{"audio", 7000, 7500, NULL}
+};
+
+static gint opt_slot = 0;
+static gchar *opt_profile = "jpeg";
+static gchar *opt_protonect = "gstreamerTemplate/libfreenect2/build/bin/Protonect";
+static gchar *opt_camera = "./gstreamer";
+static gchar *opt_io_mode = V4L2_CAPTURE_IO_MODE_DEFAULT;
+static gint opt_capture_buffers = V4L2_CAPTURE_BUFFERS_DEFAULT;
+static gboolean opt_sync = FALSE;
+
+static GOptionEntry entries[] = {
+	{"slot", 's', 0, G_OPTION_ARG_INT, &opt_slot, "Added to every port (default 0)", "N"},
+	{"profile", 'p', 0, G_OPTION_ARG_STRING, &opt_profile, "Streaming profile: jpeg, h264 or vp8 (default jpeg)", "NAME"},
+	{"protonect", 0, 0, G_OPTION_ARG_STRING, &opt_protonect, "Protonect for a Kinect surface", "PATH"},
+	{"camera", 0, 0, G_OPTION_ARG_STRING, &opt_camera, "Program streaming the c920 surface", "PATH"},
+	{"io-mode", 0, 0, G_OPTION_ARG_STRING, &opt_io_mode, "io-mode of the cameras: mmap, dmabuf, rw... (default mmap)", "MODE"},
+	{"capture-buffers", 0, 0, G_OPTION_ARG_INT, &opt_capture_buffers, "Buffers per camera on top of the driver minimum, 0 leaves it to v4l2src (default 4)", "N"},
+	{"sync", 0, 0, G_OPTION_ARG_NONE, &opt_sync, "Align audio and video by RTCP on a shared clock, on both ends", NULL},
+	{NULL}
+};
+
+static GstElement *pipeline;
+static GMainLoop *loop;
+static gchar **child_argv;     /* surface program, started with the face cam */
+static GPid child;
+static GstNetTimeProvider *clock_provider;  /* receive --sync */
+static gboolean placing_windows;  /* receive */
+
+/*****************************************************************************
+ * Devices
+ ****************************************************************************/
+/**
+ * what lsusb -d vendor:product would tell, from sysfs
+ **/
+static gboolean
+usb_device_present (const gchar *vendor, const gchar *product)
+{
+	const gchar *ids[2] = { vendor, product };
+	const gchar *files[2] = { "idVendor", "idProduct" };
+	const gchar *name;
+	gboolean found = FALSE;
+	GDir *dir;
+	gint i;
+
+	dir = g_dir_open ("/sys/bus/usb/devices", 0, NULL);
+	if (!dir)
+		return FALSE;
+	while (!found && (name = g_dir_read_name (dir)) != NULL) {
+		found = TRUE;
+		for (i = 0; i < 2 && found; i++) {
+			gchar *path, *contents = NULL;
+
+			path = g_build_filename ("/sys/bus/usb/devices", name, files[i], NULL);
+			found = g_file_get_contents (path, &contents, NULL, NULL) &&
+				g_ascii_strncasecmp (contents, ids[i], 4) == 0;
+			g_free (contents);
+			g_free (path);
+		}
+	}
+	g_dir_close (dir);
+	return found;
+}
+
+/**
+ * the c920 refocuses on every hand over the surface
+ **/
+static void
+fix_focus (const gchar *device)
+{
+	struct v4l2_control control;
+	int fd;
+
+	fd = open (device, O_RDWR);
+	if (fd < 0) {
+		g_printerr ("%s: cannot fix the focus\n", device);
+		return;
+	}
+	control.id = V4L2_CID_FOCUS_AUTO;
+	control.value = 0;
+	ioctl (fd, VIDIOC_S_CTRL, &control);
+	control.id = V4L2_CID_FOCUS_ABSOLUTE;
+	control.value = 0;
+	ioctl (fd, VIDIOC_S_CTRL, &control);
+	close (fd);
+}
+
+/*****************************************************************************
+ * Latency and windows
+ ****************************************************************************/
+static gboolean
+place_window_cb (gpointer user_data)
+{
+	Stream *stream = user_data;
+	gchar *command;
+
+	command = g_strdup_printf ("sh -c 'wmctrl -r %s_sink -e %s && wmctrl -r %s_sink -b add,fullscreen'",
+			stream->name, stream->geometry, stream->name);
+	if (!g_spawn_command_line_async (command, NULL))
+		g_printerr ("%s: wmctrl could not be started\n", stream->name);
+	g_free (command);
+	return G_SOURCE_REMOVE;
+}
+
+/**
+ * on the sink pad of each stream: how long since the buffer was captured
+ * (send) or arrived (receive), both timestamps are on the pipeline clock
+ **/
+static GstPadProbeReturn
+latency_probe (GstPad *pad, GstPadProbeInfo *info, gpointer user_data)
+{
+	Stream *stream = user_data;
+	GstBuffer *buffer = GST_PAD_PROBE_INFO_BUFFER (info);
+	GstElement *element;
+	GstClock *clock;
+	GstEvent *event;
+	const GstSegment *segment;
+	GstClockTime running;
+	GstClockTimeDiff latency;
+
+	if (!GST_BUFFER_PTS_IS_VALID (buffer))
+		return GST_PAD_PROBE_OK;
+	element = gst_pad_get_parent_element (pad);
+	clock = gst_element_get_clock (element);
+	event = gst_pad_get_sticky_event (pad, GST_EVENT_SEGMENT, 0);
+	if (clock && event) {
+		gst_event_parse_segment (event, &segment);
+		running = gst_segment_to_running_time (segment, GST_FORMAT_TIME, GST_BUFFER_PTS (buffer));
+		latency = GST_CLOCK_DIFF (running,
+				gst_clock_get_time (clock) - gst_element_get_base_time (element));
+
+		g_mutex_lock (&stream->lock);
+		stream->count++;
+		stream->sum += latency;
+		stream->max = MAX (stream->max, latency);
+		/* the sink has made its window while rendering the first frame */
+		if (++stream->frames == 2 && stream->geometry && placing_windows)
+			g_idle_add (place_window_cb, stream);
+		g_mutex_unlock (&stream->lock);
+	}
+	if (event)
+		gst_event_unref (event);
+	if (clock)
+		gst_object_unref (clock);
+	gst_object_unref (element);
+	return GST_PAD_PROBE_OK;
+}
+
+static gboolean
+report_cb (gpointer user_data)
+{
+	GstStructure *stats;
+	GstElement *src;
+	guint64 count, lost;
+	GstClockTimeDiff sum, max;
+	guint latency;
+	gint i;
+
+	for (i = 0; i < N_STREAMS; i++) {
+		Stream *stream = &streams[i];
+
+		g_mutex_lock (&stream->lock);
+		count = stream->count;
+		sum = stream->sum;
+		max = stream->max;
+		stream->count = 0;
+		stream->sum = stream->max = 0;
+		g_mutex_unlock (&stream->lock);
+		if (!count)
+			continue;
+
+		g_print ("%-8s %6.1f ms mean %6.1f ms max over %" G_GUINT64_FORMAT " buffers",
+				stream->name, (gdouble) sum / count / GST_MSECOND,
+				(gdouble) max / GST_MSECOND, count);
+		/* a surfacesrc has the name of its stream */
+		src = gst_bin_get_by_name (GST_BIN (pipeline), stream->name);
+		if (src && g_object_class_find_property (G_OBJECT_GET_CLASS (src), "stats")) {
+			g_object_get (src, "stats", &stats, NULL);
+			gst_structure_get_uint (stats, "latency-ms", &latency);
+			gst_structure_get_uint64 (stats, "packets-lost", &lost);
+			g_print (", jitter buffer %u ms, %" G_GUINT64_FORMAT " packets lost", latency, lost);
+			gst_structure_free (stats);
+		}
+		if (src)
+			gst_object_unref (src);
+		g_print ("\n");
+	}
+	return G_SOURCE_CONTINUE;
+}
+
+/*****************************************************************************
+ * Pipelines
+ ****************************************************************************/
+static gboolean
+start_child_cb (gpointer user_data)
+{
+	GError *error = NULL;
+
+	if (!g_spawn_async (NULL, child_argv, NULL, G_SPAWN_DO_NOT_REAP_CHILD, NULL, NULL,
+				&child, &error)) {
+		g_printerr ("%s could not be started: %s\n", child_argv[0], error->message);
+		g_clear_error (&error);
+	}
+	return G_SOURCE_REMOVE;
+}
+
+static GstPadProbeReturn
+face_streaming_probe (GstPad *pad, GstPadProbeInfo *info, gpointer user_data)
+{
+	g_idle_add (start_child_cb, NULL);
+	return GST_PAD_PROBE_REMOVE;
+}
+
+/**
+ * after the payloader: the stream's udpsink, named for the stream.
+ * with --sync through rtpbin session N (the stream's index), which also
+ * sends its RTCP sender reports
+ **/
+static gchar *
+sender_transport (const gchar *target, Stream *stream)
+{
+	gint session = stream - streams;
+
+	if (!opt_sync)
+		return g_strdup_printf ("udpsink host=%s port=%d sync=false name=%s_sink",
+				target, stream->port + opt_slot, stream->name);
+	return g_strdup_printf ("rtp.send_rtp_sink_%d "
+			"rtp.send_rtp_src_%d ! udpsink host=%s port=%d sync=false name=%s_sink "
+			"rtp.send_rtcp_src_%d ! udpsink host=%s port=%d sync=false async=false",
+			session, session, target, stream->port + opt_slot, stream->name,
+			session, target, stream->rtcp_port + opt_slot);
+}
+
+/**
+ * the profile's tail from videoconvert to the stream's udpsink
+ **/
+static gchar *
+sender_tail (const gchar *target, Stream *stream)
+{
+	SurfaceProfileOptions options = SURFACE_PROFILE_OPTIONS_DEFAULT;
+	gchar *payloader, *transport, *tail;
+
+	payloader = surface_profile_payloader (opt_profile, &options);
+	transport = sender_transport (target, stream);
+	tail = g_strdup_printf ("%s ! %s", payloader, transport);
+	g_free (payloader);
+	g_free (transport);
+	return tail;
+}
+
+static gchar *
+send_description (const gchar *target)
+{
+	SurfaceProfileOptions options = SURFACE_PROFILE_OPTIONS_DEFAULT;
+	GString *description = g_string_new (NULL);
+	gchar *tail;
+
+	/* the sender reports map RTP time to the capture time on the clock */
+	if (opt_sync)
+		g_string_append (description,
+				"rtpbin name=rtp ntp-time-source=clock-time rtcp-sync-send-time=false ");
+
+	tail = sender_transport (target, &streams[STREAM_AUDIO]);
+	g_string_append_printf (description, "pulsesrc ! rtpgstpay config-interval=1 ! %s ", tail);
+	g_free (tail);
+
+	if (g_file_test (FACECAM, G_FILE_TEST_EXISTS)) {
+		/* limiting to 15fps to leave USB bandwidth to the surface */
+		g_string_append (description,
+				"v4l2src name=face device=" FACECAM " ! image/jpeg,width=1280,height=720,framerate=15/1 ! ");
+		if (strcmp (opt_profile, "jpeg") == 0) {
+			tail = sender_transport (target, &streams[STREAM_FACE]);
+			g_string_append_printf (description, "rtpgstpay config-interval=1 ! %s ", tail);
+			g_free (tail);
+		} else {
+			tail = sender_tail (target, &streams[STREAM_FACE]);
+			g_string_append_printf (description, "jpegdec ! %s ", tail);
+			g_free (tail);
+		}
+	}
+
+	/* a child sends on its own, without rtpbin */
+	if (usb_device_present ("045e", "0775"))
+		tail = sender_tail (target, &streams[STREAM_SURFACE]);
+	else
+		tail = surface_profile_sender (opt_profile, &options, target,
+				streams[STREAM_SURFACE].port + opt_slot);
+	if (usb_device_present ("045e", "02d9")) {
+		gchar *gstpipe = g_strdup_printf ("videorate ! video/x-raw,framerate=15/1 ! %s", tail);
+
+		g_print ("Kinect connected\n");
+		child_argv = g_new0 (gchar *, 4);
+		child_argv[0] = g_strdup (opt_protonect);
+		child_argv[1] = g_strdup ("-gstpipe");
+		child_argv[2] = gstpipe;
+	} else if (usb_device_present ("045e", "0775")) {
+		g_print ("SUR40 connected\n");
+		g_string_append_printf (description,
+				"v4l2src device=" TOUCHDEV " ! video/x-raw,format=GRAY8,width=960,height=540 ! %s ", tail);
+	} else {
+		g_print ("c920 surface camera\n");
+		fix_focus (SURFCAM);
+		child_argv = g_new0 (gchar *, 4);
+		child_argv[0] = g_strdup (opt_camera);
+		child_argv[1] = g_strdup (SURFCAM);
+		child_argv[2] = g_strdup (tail);
+	}
+	g_free (tail);
+
+	return g_string_free (description, FALSE);
+}
+
+/**
+ * with --sync each stream is timed by its sender reports: surfacesrc
+ * rtcp-port for the videos, an rtpbin for the audio
+ **/
+static gchar *
+receive_description (void)
+{
+	const gchar *decoder = surface_profile_decoder (opt_profile);
+	gint rtcp[N_STREAMS] = { 0 };
+	gchar *audio, *description;
+	gint i;
+
+	if (opt_sync)
+		for (i = 0; i < N_STREAMS; i++)
+			rtcp[i] = streams[i].rtcp_port + opt_slot;
+
+	if (opt_sync)
+		audio = g_strdup_printf (
+			"rtpbin name=audio_rtp latency=50 ntp-sync=true ntp-time-source=clock-time "
+			"udpsrc port=%d caps=\"application/x-rtp,media=application,clock-rate=90000,encoding-name=X-GST\" ! "
+			"  audio_rtp.recv_rtp_sink_0 "
+			"udpsrc port=%d caps=\"application/x-rtcp\" ! audio_rtp.recv_rtcp_sink_0 "
+			"audio_rtp. ! rtpgstdepay",
+			streams[STREAM_AUDIO].port + opt_slot, rtcp[STREAM_AUDIO]);
+	else
+		audio = g_strdup_printf (
+			"udpsrc port=%d caps=\"application/x-rtp,media=application,clock-rate=90000,encoding-name=X-GST\" ! "
+			"  rtpjitterbuffer latency=50 ! rtpgstdepay",
+			streams[STREAM_AUDIO].port + opt_slot);
+
+	/* taginject titles the windows for wmctrl */
+	description = g_strdup_printf (
+		"surfacesrc name=surface port=%d rtcp-port=%d encoding=%s ! %s ! videoflip method=rotate-180 ! "
+		"  videoconvert ! taginject tags=\"title=surface_sink\" ! autovideosink name=surface_sink "
+		"surfacesrc name=face port=%d rtcp-port=%d encoding=%s ! %s ! "
+		"  videoconvert ! taginject tags=\"title=face_sink\" ! autovideosink name=face_sink "
+		"%s ! audioconvert ! audioresample ! autoaudiosink name=audio_sink",
+		streams[STREAM_SURFACE].port + opt_slot, rtcp[STREAM_SURFACE], opt_profile, decoder,
+		streams[STREAM_FACE].port + opt_slot, rtcp[STREAM_FACE], opt_profile, decoder,
+		audio);
+	g_free (audio);
+	return description;
+}
+
+/**
+ * --sync: both ends run on the receiver's clock, it serves it and the
+ * sender slaves to it. The sender waits a little for the clock, a late
+ * receiver only delays the alignment.
+ **/
+static void
+share_clock (gboolean sending, const gchar *target)
+{
+	GstClock *clock;
+
+	if (sending) {
+		clock = gst_net_client_clock_new ("dualstream", target, CLOCK_PORT + opt_slot, 0);
+		if (!gst_clock_wait_for_sync (clock, CLOCK_SYNC_TIMEOUT * GST_SECOND))
+			g_printerr ("no clock from %s yet, the streams align once it comes\n", target);
+	} else {
+		clock = gst_system_clock_obtain ();
+		clock_provider = gst_net_time_provider_new (clock, NULL, CLOCK_PORT + opt_slot);
+	}
+	gst_pipeline_use_clock (GST_PIPELINE (pipeline), clock);
+	gst_object_unref (clock);
+}
+
+static gboolean
+bus_cb (GstBus *bus, GstMessage *msg, gpointer user_data)
+{
+	GError *err;
+	gchar *debug_info;
+
+	switch (GST_MESSAGE_TYPE (msg)) {
+		case GST_MESSAGE_ERROR:
+			gst_message_parse_error (msg, &err, &debug_info);
+			g_printerr ("Error received from element %s: %s\n", GST_OBJECT_NAME (msg->src), err->message);
+			g_printerr ("Debugging information: %s\n", debug_info ? debug_info : "none");
+			g_clear_error (&err);
+			g_free (debug_info);
+			g_main_loop_quit (loop);
+			break;
+		case GST_MESSAGE_EOS:
+			g_main_loop_quit (loop);
+			break;
+		case GST_MESSAGE_LATENCY:
+			/* a surfacesrc adapted its jitter buffer */
+			gst_bin_recalculate_latency (GST_BIN (pipeline));
+			break;
+		default:
+			break;
+	}
+	return TRUE;
+}
+
+static gboolean
+quit_cb (gpointer user_data)
+{
+	g_main_loop_quit (loop);
+	return G_SOURCE_REMOVE;
+}
+
+int main(int argc, char *argv[]) {
+	GOptionContext *context;
+	GError *error = NULL;
+	gchar *description;
+	gboolean sending;
+	GstElement *element;
+	GstPad *pad;
+	gint i;
+
+	/**
+	 * 1) Parse the options, gst_init is part of it
+	 **/
+	context = g_option_context_new ("send TARGET | receive - all streams of a dual surface in one pipeline");
+	g_option_context_add_main_entries (context, entries, NULL);
+	g_option_context_add_group (context, gst_init_get_option_group ());
+	if (!g_option_context_parse (context, &argc, &argv, &error)) {
+		g_printerr ("%s\n", error->message);
+		g_clear_error (&error);
+		return -1;
+	}
+	g_option_context_free (context);
+	sending = argc > 2 && strcmp (argv[1], "send") == 0;
+	if (!sending && (argc < 2 || strcmp (argv[1], "receive") != 0)) {
+		g_printerr ("usage: %s [options] send TARGET | receive\n", argv[0]);
+		return -1;
+	}
+	if (!surface_profile_decoder (opt_profile)) {
+		g_printerr ("unknown profile %s, use jpeg, h264 or vp8\n", opt_profile);
+		return -1;
+	}
+	if (!surface_src_register ()) {
+		g_printerr ("surfacesrc could not be registered.\n");
+		return -1;
+	}
+
+	/**
+	 * 2) One pipeline for all streams
+	 **/
+	placing_windows = !sending;
+	description = sending ? send_description (argv[2]) : receive_description ();
+	pipeline = gst_parse_launch (description, &error);
+	g_free (description);
+	if (!pipeline) {
+		g_printerr ("pipeline could not be created: %s\n", error->message);
+		g_clear_error (&error);
+		return -1;
+	}
+
+	if (sending)
+		v4l2_capture_tune (GST_BIN (pipeline), opt_io_mode, MAX (opt_capture_buffers, 0));
+	if (opt_sync)
+		share_clock (sending, sending ? argv[2] : NULL);
+
+	/**
+	 * 3) Measure every stream at its sink, start the surface
+	 * program once the face cam streams
+	 **/
+	for (i = 0; i < N_STREAMS; i++) {
+		gchar *name = g_strdup_printf ("%s_sink", streams[i].name);
+
+		g_mutex_init (&streams[i].lock);
+		element = gst_bin_get_by_name (GST_BIN (pipeline), name);
+		g_free (name);
+		if (!element)
+			continue;
+		pad = gst_element_get_static_pad (element, "sink");
+		gst_pad_add_probe (pad, GST_PAD_PROBE_TYPE_BUFFER, latency_probe, &streams[i], NULL);
+		gst_object_unref (pad);
+		gst_object_unref (element);
+	}
+	if (child_argv) {
+		element = gst_bin_get_by_name (GST_BIN (pipeline), "face");
+		if (element) {
+			pad = gst_element_get_static_pad (element, "src");
+			gst_pad_add_probe (pad, GST_PAD_PROBE_TYPE_BUFFER, face_streaming_probe, NULL, NULL);
+			gst_object_unref (pad);
+			gst_object_unref (element);
+		} else {
+			g_idle_add (start_child_cb, NULL);
+		}
+	}
+
+	/**
+	 * 4) Start everything at once
+	 **/
+	if (gst_element_set_state (pipeline, GST_STATE_PLAYING) == GST_STATE_CHANGE_FAILURE) {
+		g_printerr ("Unable to set the pipeline to the playing state.\n");
+		gst_object_unref (pipeline);
+		return -1;
+	}
+
+	loop = g_main_loop_new (NULL, FALSE);
+	gst_bus_add_watch (GST_ELEMENT_BUS (pipeline), bus_cb, NULL);
+	g_timeout_add_seconds (REPORT_INTERVAL, report_cb, NULL);
+	g_unix_signal_add (SIGINT, quit_cb, NULL);
+	g_unix_signal_add (SIGTERM, quit_cb, NULL);
+	g_main_loop_run (loop);
+
+	/**
+	 * 5) Stop the child with us
+	 **/
+	if (child) {
+		kill (child, SIGTERM);
+		g_spawn_close_pid (child);
+	}
+	g_strfreev (child_argv);
+	gst_element_set_state (pipeline, GST_STATE_NULL);
+	gst_object_unref (pipeline);
+	if (clock_provider)
+		gst_object_unref (clock_provider);
+	g_main_loop_unref (loop);
+	return 0;
+}
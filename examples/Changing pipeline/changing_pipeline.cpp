@@ -1,6 +1,7 @@
 #include <gst/gst.h>
 
 static gchar *opt_effects = NULL;
+static gboolean opt_preroll = FALSE;
 
 #define DEFAULT_EFFECTS "identity,exclusion,navigationtest,agingtv,videoflip,vertigotv,gaussianblur,shagadelictv,edgetv"
 
@@ -8,6 +9,7 @@ static GstPad *blockpad;
 static GstElement *conv_before;
 static GstElement *conv_after;
 static GstElement *cur_effect;
+static GstElement *next_effect;   /* pre-rolled, waiting for the flip */
 static GstElement *pipeline;
 
 static GQueue effects = G_QUEUE_INIT;
@@ -83,9 +85,98 @@ pad_probe_cb (GstPad * pad, GstPadProbeInfo * info, gpointer user_data)
     return GST_PAD_PROBE_OK;
 }
 
+/* the old effect leaves on the main loop, away from the stream */
+static gboolean
+dispose_effect_cb (gpointer user_data)
+{
+    GstElement *old = GST_ELEMENT (user_data);
+
+    gst_element_set_state (old, GST_STATE_NULL);
+    GST_DEBUG_OBJECT (pipeline, "removing %" GST_PTR_FORMAT, old);
+    gst_bin_remove (GST_BIN (pipeline), old);
+    g_queue_push_tail (&effects, old);
+
+    return FALSE;
+}
+
+/* runs between two buffers: the next effect is already playing, so
+ * relinking is all there is to do and no frame is held back */
+static GstPadProbeReturn
+flip_probe_cb (GstPad * pad, GstPadProbeInfo * info, gpointer user_data)
+{
+    GstElement *old = cur_effect;
+    GstElement *next = (GstElement *) g_atomic_pointer_get (&next_effect);
+    GstPadProbeReturn ret = GST_PAD_PROBE_REMOVE;
+    GstCaps *caps;
+
+    g_print ("Switching from '%s' to '%s'..\n", GST_OBJECT_NAME (old),
+             GST_OBJECT_NAME (next));
+
+    gst_element_unlink_many (conv_before, old, conv_after, NULL);
+    /* the sticky caps and segment follow with the buffer */
+    gst_element_link_many (conv_before, next, conv_after, NULL);
+    cur_effect = next;
+    g_atomic_pointer_set (&next_effect, NULL);
+
+    /* a format the new effect cannot take is converted from the next
+     * buffer on, this one is dropped */
+    caps = gst_pad_get_current_caps (pad);
+    if (caps != NULL && !gst_pad_peer_query_accept_caps (pad, caps))
+    {
+        gst_pad_mark_reconfigure (pad);
+        gst_pad_remove_probe (pad, GST_PAD_PROBE_INFO_ID (info));
+        ret = GST_PAD_PROBE_DROP;
+    }
+    if (caps != NULL)
+        gst_caps_unref (caps);
+
+    g_idle_add (dispose_effect_cb, gst_object_ref (old));
+
+    return ret;
+}
+
+static gboolean
+preroll_switch (GMainLoop * loop)
+{
+    GstElement *next;
+    GstPad *pad;
+
+    /* still waiting for a buffer to flip on */
+    if (g_atomic_pointer_get (&next_effect) != NULL)
+        return TRUE;
+
+    next = (GstElement *) g_queue_pop_head (&effects);
+    if (next == NULL)
+    {
+        GST_DEBUG_OBJECT (pipeline, "no more effects");
+        g_main_loop_quit (loop);
+        return FALSE;
+    }
+
+    /* state change and setup happen here, while the old one still runs */
+    gst_bin_add (GST_BIN (pipeline), next);
+    if (gst_element_set_state (next, GST_STATE_PLAYING) == GST_STATE_CHANGE_FAILURE)
+    {
+        g_print ("Skipping '%s'\n", GST_OBJECT_NAME (next));
+        g_idle_add (dispose_effect_cb, gst_object_ref (next));
+        return TRUE;
+    }
+
+    g_atomic_pointer_set (&next_effect, next);
+    pad = gst_element_get_static_pad (conv_before, "src");
+    gst_pad_add_probe (pad, (GstPadProbeType) (GST_PAD_PROBE_TYPE_BLOCK |
+                       GST_PAD_PROBE_TYPE_BUFFER), flip_probe_cb, NULL, NULL);
+    gst_object_unref (pad);
+
+    return TRUE;
+}
+
 static gboolean
 timeout_cb (gpointer user_data)
 {
+    if (opt_preroll)
+        return preroll_switch ((GMainLoop *) user_data);
+
     gst_pad_add_probe (blockpad, GST_PAD_PROBE_TYPE_BLOCK_DOWNSTREAM,
                        pad_probe_cb, user_data, NULL);
 
@@ -126,6 +217,10 @@ main (int argc, char **argv)
             "effects", 'e', 0, G_OPTION_ARG_STRING, &opt_effects,
             "Effects to use (comma-separated list of element names)", NULL
         },
+        {
+            "preroll", 'p', 0, G_OPTION_ARG_NONE, &opt_preroll,
+            "Start the next effect ahead and switch between two buffers instead of draining", NULL
+        },
         {NULL}
     };
     GOptionContext *ctx;
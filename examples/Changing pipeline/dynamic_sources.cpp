@@ -1,10 +1,28 @@
+/*
+ * Mixes VP8 streams from UDP ports, joining and leaving while it runs.
+ *
+ *   ./dynamic_sources 5000 5001
+ *
+ * Type "+5002" to add a port, "-5000" to remove one, "q" to quit. A port
+ * that receives nothing for 5 seconds is removed by itself.
+ */
+#include <stdlib.h>
 #include <gst/gst.h>
 
+#include "../../chromakey.h"
+#include "source_manager.h"
+
+#define IDLE_TIMEOUT_MS 5000
+
 static GstElement *pipeline;
+static SourceManager *manager;
 
 static gboolean bus_cb (GstBus * bus, GstMessage * msg, gpointer user_data)
 {
-    GMainLoop *loop = user_data;
+    GMainLoop *loop = (GMainLoop *) user_data;
+
+    if (source_manager_handle_message (manager, msg))
+        return TRUE;
 
     switch (GST_MESSAGE_TYPE (msg))
     {
@@ -20,6 +38,10 @@ static gboolean bus_cb (GstBus * bus, GstMessage * msg, gpointer user_data)
         g_main_loop_quit (loop);
         break;
     }
+    case GST_MESSAGE_LATENCY:
+        /* a branch joined or left */
+        gst_bin_recalculate_latency (GST_BIN (pipeline));
+        break;
     default:
         break;
     }
@@ -27,38 +49,44 @@ static gboolean bus_cb (GstBus * bus, GstMessage * msg, gpointer user_data)
     return TRUE;
 }
 
-static GstElement * add_source(GstElement * first_link, int port)
+static gboolean stdin_cb (GIOChannel * channel, GIOCondition condition,
+                          gpointer user_data)
 {
-    GstElement *src, *rtpvp8depay, *vp8dec, *alpha;
-    src = gst_element_factory_make ("udpsrc", NULL);
-    g_object_set(src, "port", port, NULL);
-    gst_util_set_object_arg (G_OBJECT (src), "caps", "application/x-rtp");
-
-    rtpvp8depay = gst_element_factory_make ("rtpvp8depay", NULL);
-
-    vp8dec = gst_element_factory_make ("vp8dec", NULL);
-
-    alpha = gst_element_factory_make ("alpha", NULL);
-    gst_util_set_object_arg (G_OBJECT (alpha), "method", "green");
-
-    gst_bin_add_many (GST_BIN (pipeline), src, rtpvp8depay, vp8dec, alpha, NULL);
-
-    if (first_link != NULL)
-    {
-        gst_element_link(first_link, src);
-    }
+    GMainLoop *loop = (GMainLoop *) user_data;
+    gchar *line = NULL;
+
+    /* without a terminal the ports stay as given */
+    if (g_io_channel_read_line (channel, &line, NULL, NULL, NULL) != G_IO_STATUS_NORMAL)
+        return FALSE;
+
+    g_strstrip (line);
+    if (line[0] == '+')
+        source_manager_add (manager, atoi (line + 1));
+    else if (line[0] == '-' && !source_manager_remove (manager, atoi (line + 1)))
+        g_print ("No source on port %s\n", line + 1);
+    else if (line[0] == 'q')
+        g_main_loop_quit (loop);
+    g_free (line);
 
-    gst_element_link_many (src, rtpvp8depay, vp8dec, alpha, NULL);
-    return alpha;
+    return TRUE;
 }
 
 int main (int argc, char **argv)
 {
+    GstElement *background, *videomixer, *videoconvert, *autovideosink;
+    GIOChannel *input;
+    GMainLoop *loop;
+    gint i;
+
     g_print ("Initialising pipeline\n");
     gst_init (&argc, &argv);
+    chroma_key_register ();
     pipeline = gst_pipeline_new ("pipeline");
-    GstElement * alpha =  add_source(NULL, 5000);
-    GstElement *videomixer, *videoconvert, *autovideosink;
+
+    /* a live background keeps the mixer running with no sources at all */
+    background = gst_element_factory_make ("videotestsrc", NULL);
+    g_object_set (background, "is-live", TRUE, NULL);
+    gst_util_set_object_arg (G_OBJECT (background), "pattern", "black");
 
     videomixer = gst_element_factory_make ("videomixer", NULL);
     gst_util_set_object_arg (G_OBJECT (videomixer), "name", "mixer");
@@ -67,18 +95,28 @@ int main (int argc, char **argv)
 
     autovideosink = gst_element_factory_make ("autovideosink", NULL);
 
-    gst_bin_add_many (GST_BIN (pipeline), videomixer, videoconvert, autovideosink, NULL);
+    gst_bin_add_many (GST_BIN (pipeline), background, videomixer, videoconvert, autovideosink, NULL);
+
+    gst_element_link_many (background, videomixer, videoconvert, autovideosink, NULL);
 
-    gst_element_link_many (alpha, videomixer, videoconvert, autovideosink, NULL);
+    manager = source_manager_new (pipeline, videomixer, IDLE_TIMEOUT_MS);
+    if (argc < 2)
+        source_manager_add (manager, 5000);
+    for (i = 1; i < argc; i++)
+        source_manager_add (manager, atoi (argv[i]));
 
     gst_element_set_state (pipeline, GST_STATE_PLAYING);
     g_print ("Initialised pipeline\n");
 
-    GMainLoop *loop = g_main_loop_new (NULL, FALSE);
+    loop = g_main_loop_new (NULL, FALSE);
     gst_bus_add_watch (GST_ELEMENT_BUS (pipeline), bus_cb, loop);
+    input = g_io_channel_unix_new (0);
+    g_io_add_watch (input, G_IO_IN, stdin_cb, loop);
     g_main_loop_run (loop);
 
+    g_io_channel_unref (input);
     gst_element_set_state (pipeline, GST_STATE_NULL);
+    source_manager_free (manager);
     gst_object_unref (pipeline);
     return 0;
 }
@@ -0,0 +1,185 @@
+#include <gst/gst.h>
+
+#include "source_manager.h"
+
+typedef struct
+{
+    gint port;
+    GstElement *bin;
+    GstElement *udpsrc;
+    GstPad *srcpad;     /* ghost pad of the bin */
+    GstPad *mixerpad;   /* requested from the mixer */
+} Source;
+
+struct _SourceManager
+{
+    GstElement *pipeline;
+    GstElement *mixer;
+    guint idle_timeout_ms;
+    GList *sources;
+};
+
+SourceManager *
+source_manager_new (GstElement * pipeline, GstElement * mixer,
+                    guint idle_timeout_ms)
+{
+    SourceManager *manager = g_new0 (SourceManager, 1);
+
+    manager->pipeline = (GstElement *) gst_object_ref (pipeline);
+    manager->mixer = (GstElement *) gst_object_ref (mixer);
+    manager->idle_timeout_ms = idle_timeout_ms;
+    return manager;
+}
+
+static Source *
+find_source (SourceManager * manager, gint port)
+{
+    GList *l;
+
+    for (l = manager->sources; l != NULL; l = l->next)
+    {
+        if (((Source *) l->data)->port == port)
+            return (Source *) l->data;
+    }
+    return NULL;
+}
+
+gboolean
+source_manager_add (SourceManager * manager, gint port)
+{
+    GstElement *rtpvp8depay, *vp8dec, *key;
+    GstPad *pad;
+    Source *source;
+    gchar *name;
+
+    if (find_source (manager, port) != NULL)
+        return TRUE;
+
+    source = g_new0 (Source, 1);
+    source->port = port;
+
+    name = g_strdup_printf ("source-%d", port);
+    source->bin = gst_bin_new (name);
+    g_free (name);
+
+    source->udpsrc = gst_element_factory_make ("udpsrc", NULL);
+    rtpvp8depay = gst_element_factory_make ("rtpvp8depay", NULL);
+    vp8dec = gst_element_factory_make ("vp8dec", NULL);
+    key = gst_element_factory_make ("chromakey", NULL);
+    if (!source->udpsrc || !rtpvp8depay || !vp8dec || !key)
+    {
+        g_printerr ("Source %d: missing elements\n", port);
+        gst_object_unref (source->bin);
+        g_free (source);
+        return FALSE;
+    }
+
+    g_object_set (source->udpsrc, "port", port,
+                  "timeout", (guint64) manager->idle_timeout_ms * GST_MSECOND, NULL);
+    gst_util_set_object_arg (G_OBJECT (source->udpsrc), "caps", "application/x-rtp");
+    gst_util_set_object_arg (G_OBJECT (key), "method", "green");
+
+    gst_bin_add_many (GST_BIN (source->bin), source->udpsrc, rtpvp8depay,
+                      vp8dec, key, NULL);
+    gst_element_link_many (source->udpsrc, rtpvp8depay, vp8dec, key, NULL);
+
+    pad = gst_element_get_static_pad (key, "src");
+    source->srcpad = gst_ghost_pad_new ("src", pad);
+    gst_object_unref (pad);
+    gst_element_add_pad (source->bin, source->srcpad);
+
+    /* the rest of the pipeline keeps playing, only the new branch and
+     * its mixer pad start up */
+    gst_bin_add (GST_BIN (manager->pipeline), source->bin);
+    source->mixerpad = gst_element_get_request_pad (manager->mixer, "sink_%u");
+    if (source->mixerpad == NULL ||
+        gst_pad_link (source->srcpad, source->mixerpad) != GST_PAD_LINK_OK)
+    {
+        g_printerr ("Source %d: could not link to the mixer\n", port);
+        if (source->mixerpad != NULL)
+        {
+            gst_element_release_request_pad (manager->mixer, source->mixerpad);
+            gst_object_unref (source->mixerpad);
+        }
+        gst_bin_remove (GST_BIN (manager->pipeline), source->bin);
+        g_free (source);
+        return FALSE;
+    }
+    gst_element_sync_state_with_parent (source->bin);
+
+    manager->sources = g_list_prepend (manager->sources, source);
+    g_print ("Source %d added on %s\n", port, GST_PAD_NAME (source->mixerpad));
+    return TRUE;
+}
+
+static GstPadProbeReturn
+drop_probe_cb (GstPad * pad, GstPadProbeInfo * info, gpointer user_data)
+{
+    return GST_PAD_PROBE_DROP;
+}
+
+static void
+remove_source (SourceManager * manager, Source * source)
+{
+    manager->sources = g_list_remove (manager->sources, source);
+
+    /* nothing more reaches the mixer, and udpsrc sees its buffers
+     * accepted instead of a not-linked error while it is stopped */
+    gst_pad_add_probe (source->srcpad, GST_PAD_PROBE_TYPE_DATA_DOWNSTREAM,
+                       drop_probe_cb, NULL, NULL);
+
+    /* flushes a buffer the mixer still holds from this branch */
+    gst_element_release_request_pad (manager->mixer, source->mixerpad);
+    gst_object_unref (source->mixerpad);
+
+    gst_element_set_state (source->bin, GST_STATE_NULL);
+    gst_bin_remove (GST_BIN (manager->pipeline), source->bin);
+
+    g_print ("Source %d removed\n", source->port);
+    g_free (source);
+}
+
+gboolean
+source_manager_remove (SourceManager * manager, gint port)
+{
+    Source *source = find_source (manager, port);
+
+    if (source == NULL)
+        return FALSE;
+    remove_source (manager, source);
+    return TRUE;
+}
+
+gboolean
+source_manager_handle_message (SourceManager * manager, GstMessage * msg)
+{
+    GList *l;
+
+    if (GST_MESSAGE_TYPE (msg) != GST_MESSAGE_ELEMENT ||
+        !gst_message_has_name (msg, "GstUDPSrcTimeout"))
+        return FALSE;
+
+    for (l = manager->sources; l != NULL; l = l->next)
+    {
+        Source *source = (Source *) l->data;
+
+        if (GST_MESSAGE_SRC (msg) == GST_OBJECT (source->udpsrc))
+        {
+            g_print ("Source %d idle\n", source->port);
+            remove_source (manager, source);
+            break;
+        }
+    }
+    /* a late timeout of a branch already gone is handled too */
+    return TRUE;
+}
+
+void
+source_manager_free (SourceManager * manager)
+{
+    while (manager->sources != NULL)
+        remove_source (manager, (Source *) manager->sources->data);
+    gst_object_unref (manager->mixer);
+    gst_object_unref (manager->pipeline);
+    g_free (manager);
+}
@@ -0,0 +1,33 @@
+/**
+ * Adds and removes udpsrc ! rtpvp8depay ! vp8dec ! chromakey branches on
+ * a running videomixer, one per UDP port, without touching the rest of
+ * the pipeline. Each branch gets its own requested mixer pad, which is
+ * released again when the branch goes.
+ *
+ * A branch that receives nothing for idle_timeout_ms is removed by itself:
+ * udpsrc posts a timeout message on the bus, pass the bus messages to
+ * source_manager_handle_message. Everything runs on the main loop thread.
+ **/
+#ifndef SOURCE_MANAGER_H
+#define SOURCE_MANAGER_H
+
+#include <gst/gst.h>
+
+G_BEGIN_DECLS
+
+typedef struct _SourceManager SourceManager;
+
+SourceManager *source_manager_new (GstElement * pipeline, GstElement * mixer,
+                                   guint idle_timeout_ms);
+void source_manager_free (SourceManager * manager);
+
+gboolean source_manager_add (SourceManager * manager, gint port);
+gboolean source_manager_remove (SourceManager * manager, gint port);
+
+/* TRUE when the message was a branch timeout and has been handled */
+gboolean source_manager_handle_message (SourceManager * manager,
+                                        GstMessage * msg);
+
+G_END_DECLS
+
+#endif /* SOURCE_MANAGER_H */
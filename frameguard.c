@@ -0,0 +1,156 @@
+/**
+ * frame guard, see frameguard.h
+ **/
+#include <string.h>
+#include <gst/rtp/gstrtpbuffer.h>
+
+#include "frameguard.h"
+
+/* RFC 3550 A.1: a sequence number further off than this is a new stream */
+#define MAX_DROPOUT 3000
+#define MAX_MISORDER 100
+
+typedef enum {
+	GUARD_PASS,
+	GUARD_PASS_DISCONT,    /* pass, first of a new frame after a dropped one */
+	GUARD_DROP
+} GuardAction;
+
+void
+frame_guard_reset (FrameGuard *g)
+{
+	gboolean whole_frames = g->whole_frames;
+
+	memset (g, 0, sizeof (*g));
+	g->whole_frames = whole_frames;
+}
+
+/* a frame that lost packets: dropped whole, or passed on for the decoder
+ * to conceal and the intra refresh to repair */
+static void
+frame_guard_damaged (FrameGuard *g)
+{
+	if (g->whole_frames) {
+		g->frames_dropped++;
+		g->need_discont = TRUE;
+	} else {
+		g->frames_damaged++;
+	}
+}
+
+/* a restarted sender, or one that jumped: the frame in progress is lost
+ * and the next packet starts the stream afresh */
+static void
+frame_guard_resync (FrameGuard *g)
+{
+	if (g->in_frame)
+		frame_guard_damaged (g);
+	g->have_seq = FALSE;
+	g->in_frame = FALSE;
+	g->broken = FALSE;
+}
+
+/* start: the packet begins a frame (rtpgstpay fragment offset 0), only
+ * used for whole frames, sliced codecs start a frame with a new timestamp.
+ * marker: the packet ends a frame. discont: upstream says the stream
+ * starts over, an older sequence number is then no late packet. */
+static GuardAction
+frame_guard_packet (FrameGuard *g, guint32 ssrc, guint16 seq, guint32 timestamp,
+		gboolean start, gboolean marker, gboolean discont)
+{
+	GuardAction action;
+	gint gap = 0;
+
+	if (g->have_seq) {
+		gap = gst_rtp_buffer_compare_seqnum (g->last_seq, seq) - 1;
+		if (ssrc != g->last_ssrc || gap > MAX_DROPOUT || gap < -MAX_MISORDER ||
+				(discont && gap < 0)) {
+			GST_DEBUG ("stream restarted at seq %u, was %u", seq, g->last_seq);
+			frame_guard_resync (g);
+			gap = 0;
+		} else if (gap < 0) {
+			return GUARD_DROP; /* duplicate or too late */
+		} else {
+			g->packets_lost += gap;
+		}
+	}
+	if (!g->whole_frames)
+		start = !g->have_seq || timestamp != g->last_timestamp;
+	g->have_seq = TRUE;
+	g->last_ssrc = ssrc;
+	g->last_seq = seq;
+	g->last_timestamp = timestamp;
+
+	if (start) {
+		/* a gap before a frame start was the end of the last frame */
+		if (g->in_frame)
+			frame_guard_damaged (g);
+		g->in_frame = TRUE;
+		/* without a start flag the gap may as well have been our head */
+		g->broken = !g->whole_frames && gap > 0;
+	} else if (gap > 0 || !g->in_frame) {
+		/* lost inside this frame, or joined the stream in the middle */
+		g->in_frame = TRUE;
+		g->broken = TRUE;
+	}
+
+	if (g->broken && g->whole_frames)
+		action = GUARD_DROP;
+	else if (g->need_discont)
+		action = GUARD_PASS_DISCONT;
+	else
+		action = GUARD_PASS;
+
+	if (action == GUARD_PASS_DISCONT)
+		g->need_discont = FALSE;
+
+	if (marker) {
+		if (g->broken)
+			frame_guard_damaged (g);
+		else
+			g->frames_delivered++;
+		g->in_frame = FALSE;
+		g->broken = FALSE;
+	}
+	return action;
+}
+
+gboolean
+frame_guard_process (FrameGuard *g, GstBuffer **buffer, gboolean *end_of_frame)
+{
+	GstRTPBuffer rtp = GST_RTP_BUFFER_INIT;
+	GuardAction action;
+	gboolean start, marker, discont;
+	guint32 ssrc, timestamp;
+	guint16 seq;
+	guint8 *payload;
+
+	if (!gst_rtp_buffer_map (*buffer, GST_MAP_READ, &rtp))
+		return FALSE;
+	ssrc = gst_rtp_buffer_get_ssrc (&rtp);
+	seq = gst_rtp_buffer_get_seq (&rtp);
+	marker = gst_rtp_buffer_get_marker (&rtp);
+	timestamp = gst_rtp_buffer_get_timestamp (&rtp);
+	payload = gst_rtp_buffer_get_payload (&rtp);
+	/* the rtpgstpay header has the fragment offset in bytes 4 to 7 */
+	start = gst_rtp_buffer_get_payload_len (&rtp) >= 8 &&
+		GST_READ_UINT32_BE (payload + 4) == 0;
+	gst_rtp_buffer_unmap (&rtp);
+
+	discont = GST_BUFFER_FLAG_IS_SET (*buffer, GST_BUFFER_FLAG_DISCONT);
+	action = frame_guard_packet (g, ssrc, seq, timestamp, start, marker, discont);
+	if (end_of_frame)
+		*end_of_frame = marker;
+
+	switch (action) {
+		case GUARD_DROP:
+			return FALSE;
+		case GUARD_PASS_DISCONT:
+			/* rtpgstdepay clears what it has of the dropped frame */
+			*buffer = gst_buffer_make_writable (*buffer);
+			GST_BUFFER_FLAG_SET (*buffer, GST_BUFFER_FLAG_DISCONT);
+			return TRUE;
+		default:
+			return TRUE;
+	}
+}
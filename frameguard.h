@@ -0,0 +1,48 @@
+/**
+ * Frame guard of the surface stream receivers (surfacesrc, slotsrc).
+ *
+ * Looks at the RTP packets of one stream in sequence order and counts
+ * lost packets and frames. With whole_frames (JPEG in rtpgstpay) every
+ * frame that lost a packet is dropped and the next complete frame starts
+ * with DISCONT, so the depayloader forgets the partial one and the
+ * decoder only sees complete frames. Without it (H.264 and VP8 slices)
+ * damaged frames are passed on for the decoder to conceal. A new SSRC, a
+ * DISCONT buffer going back or a sequence number far off starts over, as
+ * a restarted sender does.
+ **/
+#ifndef __FRAME_GUARD_H__
+#define __FRAME_GUARD_H__
+
+#include <gst/gst.h>
+
+G_BEGIN_DECLS
+
+typedef struct {
+	gboolean whole_frames; /* drop damaged frames, else pass them to be concealed */
+
+	/* what the guard has seen of the frame being received */
+	gboolean have_seq;
+	guint32 last_ssrc;
+	guint16 last_seq;
+	guint32 last_timestamp;
+	gboolean in_frame;
+	gboolean broken;
+	gboolean need_discont;
+
+	guint64 packets_lost;
+	guint64 frames_delivered;
+	guint64 frames_dropped;
+	guint64 frames_damaged;
+} FrameGuard;
+
+/* forgets the stream and the counts, keeps whole_frames */
+void frame_guard_reset (FrameGuard *guard);
+
+/* FALSE when the packet is to be dropped, else *buffer may have been made
+ * writable to set DISCONT. end_of_frame tells if it had the marker. */
+gboolean frame_guard_process (FrameGuard *guard, GstBuffer **buffer,
+		gboolean *end_of_frame);
+
+G_END_DECLS
+
+#endif /* __FRAME_GUARD_H__ */
@@ -67,6 +67,14 @@ static GtkAdjustment *highpass_blur_adjustment, *highpass_noise_adjustment;
 static GtkAdjustment *amplify_adjustment;
 static GtkCheckButton *trackdark_checkbutton;
 
+/* file mode input, a grayrecord capture is replayed by grayreplay,
+ * anything else goes through decodebin */
+static const gchar *input_file = "FrontDI.m4v";
+static gboolean input_is_capture = FALSE;
+static gboolean start_from_file = FALSE;
+static gboolean replay_fast = FALSE;
+static const gchar *record_file = NULL;
+
 static GstElement *pipeline;
 static GstElement *blobtuio;
 static guint source_video_embed_xid;
@@ -413,9 +421,15 @@ initgst(gboolean from_video)
 
   if (from_video)
     src = gst_element_factory_make ("v4l2src", "source");
-  else {
+  else if (input_is_capture) {
+    /* loop so that the parameters can be tuned on the same footage */
+    src = gst_element_factory_make ("grayreplay", "source");
+    if (src)
+      g_object_set (G_OBJECT (src), "location", input_file,
+          "pace", !replay_fast, "loop", TRUE, NULL);
+  } else {
     src = gst_element_factory_make ("filesrc", "source");
-    g_object_set (G_OBJECT (src), "location", "FrontDI.m4v", NULL); /* FIXME browse file */
+    g_object_set (G_OBJECT (src), "location", input_file, NULL); /* FIXME browse file */
     decodebin = gst_element_factory_make ("decodebin", "decodebin");
   }
   ffmpegcolorspace[0] = gst_element_factory_make ("ffmpegcolorspace", "colorconvert1");
@@ -473,18 +487,24 @@ initgst(gboolean from_video)
       smooth_xvimagesink, highpass_xvimagesink, amplify_xvimagesink, threshold_xvimagesink,
       blobtuio, queuesrc, queuebg, queueblob, queuesmooth, queuehighpass, queueamplify, queuethreshold,
       NULL);
-  if (!from_video)
+  if (decodebin)
     gst_bin_add (GST_BIN (pipeline), decodebin);
 #endif
-  if (from_video)
+  if (!decodebin)
     gst_element_link(src, ffmpegcolorspace[0]);
   else {
     gst_element_link_pads (src, "src", decodebin, "sink");
     g_signal_connect (decodebin, "new-decoded-pad", G_CALLBACK (cb_new_pad), ffmpegcolorspace[0]);
   }
 
-  /* convert to grayscale and fix width and height */
-  caps = gst_caps_new_simple ("video/x-raw-gray",
+  /* convert to grayscale and fix width and height, a capture keeps the
+   * size it was recorded at */
+  if (!from_video && input_is_capture)
+    caps = gst_caps_new_simple ("video/x-raw-gray",
+  	      "bpp", G_TYPE_INT, 8,
+	      NULL);
+  else
+    caps = gst_caps_new_simple ("video/x-raw-gray",
   	      "bpp", G_TYPE_INT, 8,
 	      "width", G_TYPE_INT, camera_width,
 	      "height", G_TYPE_INT, camera_height,
@@ -495,6 +515,30 @@ initgst(gboolean from_video)
   gst_element_link_many(tee, queuesrc, ffmpegcolorspace[1], src_xvimagesink, NULL);
   gst_element_link_many(tee, queueblob, blobtuio, NULL);
 
+  if (record_file) {
+    GstElement *queuerecord, *record;
+
+    queuerecord = gst_element_factory_make ("queue", "queuerecord");
+    record = gst_element_factory_make ("grayrecord", "record");
+    if (!queuerecord || !record) {
+      g_error("missing element\n");
+      return;
+    }
+    g_object_set (record, "location", record_file, NULL);
+    gst_bin_add_many (GST_BIN (pipeline), queuerecord, record, NULL);
+    gst_element_link_many (tee, queuerecord, record, NULL);
+  }
+
+  /* let the display keep up with an unpaced replay */
+  if (!from_video && input_is_capture && replay_fast) {
+    g_object_set (src_xvimagesink, "sync", FALSE, NULL);
+    g_object_set (bg_xvimagesink, "sync", FALSE, NULL);
+    g_object_set (smooth_xvimagesink, "sync", FALSE, NULL);
+    g_object_set (highpass_xvimagesink, "sync", FALSE, NULL);
+    g_object_set (amplify_xvimagesink, "sync", FALSE, NULL);
+    g_object_set (threshold_xvimagesink, "sync", FALSE, NULL);
+  }
+
   pad = gst_element_get_static_pad (queuebg, "sink");
   rpad = gst_element_get_request_pad (blobtuio, "srcbg");
   gst_pad_link (rpad, pad);
@@ -675,6 +719,10 @@ initgtklayout()
 const struct option long_opt[] =
 {
   {"camera_resolution", 1, NULL, 'c' },
+  {"file", 1, NULL, 'f' },
+  {"replay", 1, NULL, 'r' },
+  {"fast", 0, NULL, 'F' },
+  {"record", 1, NULL, 'o' },
   {NULL, 0, NULL, '\0' },
 };
 
@@ -683,7 +731,7 @@ parse_args (int argc, char *argv[])
 {
   int i;
   while (1) {
-    i = getopt_long(argc, argv, "c:", long_opt, NULL);
+    i = getopt_long(argc, argv, "c:f:r:Fo:", long_opt, NULL);
     if (i == -1)
       break;
     switch (i) {
@@ -697,6 +745,26 @@ parse_args (int argc, char *argv[])
           g_error("camera resolution invalid\n");
         }
         break;
+      case 'f':
+        /* video file for file mode, decoded by decodebin */
+        input_file = optarg;
+        input_is_capture = FALSE;
+        start_from_file = TRUE;
+        break;
+      case 'r':
+        /* grayrecord capture for file mode */
+        input_file = optarg;
+        input_is_capture = TRUE;
+        start_from_file = TRUE;
+        break;
+      case 'F':
+        /* replay the capture as fast as possible */
+        replay_fast = TRUE;
+        break;
+      case 'o':
+        /* record the camera (or replayed) frames */
+        record_file = optarg;
+        break;
     }
   }
 }
@@ -721,13 +789,21 @@ main (int   argc,
   /* init gtk layout */
   gtkbuilder = initgtklayout();
 
-  initgst(TRUE);
+  if (start_from_file) {
+    gtk_toggle_button_set_active (GTK_TOGGLE_BUTTON (WID ("file_radio")),
+        TRUE);
+    initgst(FALSE);
+  } else
+    initgst(TRUE);
 
   gtk_main();
 
   gst_object_unref(gtkbuilder);
-  if (pipeline)
+  if (pipeline) {
+    /* stopping closes a recording properly */
+    gst_element_set_state (pipeline, GST_STATE_NULL);
     gst_object_unref(GST_OBJECT (pipeline));
+  }
   return 0;
 }
 
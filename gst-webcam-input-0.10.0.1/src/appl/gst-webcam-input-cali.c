@@ -77,7 +77,7 @@ struct blob_coord blobsamples[MAX_SAMPLES];
 struct blob_coord blobraw[4];
 struct blob_coord blobscr[4];
 static gint screen_width, screen_height;
-static gfloat transform_matrix[6];
+static gfloat transform_matrix[9];
 
 static void
 shutdownlo()
@@ -125,12 +125,15 @@ save_calibration()
   if (!fp) {
     g_warning("save to " WEBCAM_SYSCONFDIR G_DIR_SEPARATOR_S "gst-webcam-input.cal failed");
   } else {        
-    fprintf (fp, "%f,%f,%f,%f,%f,%f\n", transform_matrix[0],
+    fprintf (fp, "%.8g,%.8g,%.8g,%.8g,%.8g,%.8g,%.8g,%.8g,%.8g\n", transform_matrix[0],
         transform_matrix[1],
         transform_matrix[2],
         transform_matrix[3],
         transform_matrix[4],
-        transform_matrix[5]);
+        transform_matrix[5],
+        transform_matrix[6],
+        transform_matrix[7],
+        transform_matrix[8]);
     fclose (fp);
   }
 #endif
@@ -153,19 +156,24 @@ calibrate_tuio_to_screen()
     yblob[i] = blobraw[i].y;
   }
   
-  n_point_cal(xscr, yscr, xblob, yblob, 4, transform_matrix);
+  /* full perspective, the camera is rarely square to the surface */
+  n_point_cal_homography(xscr, yscr, xblob, yblob, 4, transform_matrix);
 
   /* write to file */
   save_calibration();
 
   if (conf->matrix)
     g_free(conf->matrix);
-  conf->matrix = g_strdup_printf("%f,%f,%f,%f,%f,%f", transform_matrix[0],
+  conf->matrix = g_strdup_printf("%.8g,%.8g,%.8g,%.8g,%.8g,%.8g,%.8g,%.8g,%.8g",
+            transform_matrix[0],
             transform_matrix[1],
             transform_matrix[2],
             transform_matrix[3],
             transform_matrix[4],
-            transform_matrix[5]);
+            transform_matrix[5],
+            transform_matrix[6],
+            transform_matrix[7],
+            transform_matrix[8]);
 
   /* start the tuio stream again and let input driver to handle the TUIO events */
   shutdownlo();
@@ -23,6 +23,8 @@
 #  include <config.h>
 #endif
 
+#include <math.h>
+#include <string.h>
 #include "n-point-cal.h"
 
 /* Least square solution of linear equation set
@@ -76,3 +78,144 @@ n_point_cal(gfloat *xk, gfloat *yk, gfloat *xk_a, gfloat *yk_a, gint n,
   matrix[5] = det_y3/det;
 }
 
+
+/* normalise points to centroid 0 and mean distance sqrt(2), keeps the
+ * normal equations well conditioned with pixel sized coordinates */
+static void
+normalize_points(gfloat *x, gfloat *y, gint n, gdouble *t)
+{
+  gint k;
+  gdouble cx, cy, dist, s;
+
+  cx = cy = dist = 0;
+  for(k=0;k<n;k++) {
+    cx += x[k];
+    cy += y[k];
+  }
+  cx /= n;
+  cy /= n;
+  for(k=0;k<n;k++)
+    dist += sqrt((x[k] - cx)*(x[k] - cx) + (y[k] - cy)*(y[k] - cy));
+  dist /= n;
+  s = dist > 0 ? G_SQRT2 / dist : 1;
+
+  /* x' = s*x - s*cx, y' = s*y - s*cy */
+  t[0] = s;
+  t[1] = -s * cx;
+  t[2] = -s * cy;
+}
+
+/* solve a*x = b in place by gaussian elimination with partial pivoting */
+static gboolean
+solve_linear(gdouble a[8][8], gdouble *b, gint n)
+{
+  gint i, j, k, pivot;
+  gdouble f, tmp;
+
+  for(i=0;i<n;i++) {
+    pivot = i;
+    for(j=i+1;j<n;j++) {
+      if (fabs(a[j][i]) > fabs(a[pivot][i]))
+        pivot = j;
+    }
+    if (fabs(a[pivot][i]) < 1e-12)
+      return FALSE;
+    if (pivot != i) {
+      for(k=0;k<n;k++) {
+        tmp = a[i][k]; a[i][k] = a[pivot][k]; a[pivot][k] = tmp;
+      }
+      tmp = b[i]; b[i] = b[pivot]; b[pivot] = tmp;
+    }
+    for(j=i+1;j<n;j++) {
+      f = a[j][i] / a[i][i];
+      for(k=i;k<n;k++)
+        a[j][k] -= f * a[i][k];
+      b[j] -= f * b[i];
+    }
+  }
+  for(i=n-1;i>=0;i--) {
+    for(k=i+1;k<n;k++)
+      b[i] -= a[i][k] * b[k];
+    b[i] /= a[i][i];
+  }
+  return TRUE;
+}
+
+/* Least square 3x3 homography (row major, matrix[8] = 1) mapping the
+ * blob points xk_a,yk_a to the screen points xk,yk, n >= 4.
+ * Each point gives 2 rows of the DLT system
+ *   h0 x + h1 y + h2 - h6 x X - h7 y X = X
+ *   h3 x + h4 y + h5 - h6 x Y - h7 y Y = Y
+ * solved through its normal equations on normalised points.
+ * Falls back to the affine fit when the points are degenerate. */
+void
+n_point_cal_homography(gfloat *xk, gfloat *yk, gfloat *xk_a, gfloat *yk_a,
+    gint n, gfloat *matrix)
+{
+  gint k, i, j;
+  gdouble ts[3], td[3];
+  gdouble ata[8][8], atb[8];
+  gdouble row[2][8], rhs[2];
+  gdouble x, y, X, Y;
+  gdouble h[9], hs[9];
+
+  if (n < 4)
+    goto affine;
+
+  normalize_points(xk_a, yk_a, n, ts);
+  normalize_points(xk, yk, n, td);
+
+  memset(ata, 0, sizeof(ata));
+  memset(atb, 0, sizeof(atb));
+  for(k=0;k<n;k++) {
+    x = ts[0] * xk_a[k] + ts[1];
+    y = ts[0] * yk_a[k] + ts[2];
+    X = td[0] * xk[k] + td[1];
+    Y = td[0] * yk[k] + td[2];
+
+    row[0][0] = x; row[0][1] = y; row[0][2] = 1;
+    row[0][3] = 0; row[0][4] = 0; row[0][5] = 0;
+    row[0][6] = -x * X; row[0][7] = -y * X;
+    rhs[0] = X;
+    row[1][0] = 0; row[1][1] = 0; row[1][2] = 0;
+    row[1][3] = x; row[1][4] = y; row[1][5] = 1;
+    row[1][6] = -x * Y; row[1][7] = -y * Y;
+    rhs[1] = Y;
+
+    for(i=0;i<8;i++) {
+      for(j=0;j<8;j++)
+        ata[i][j] += row[0][i] * row[0][j] + row[1][i] * row[1][j];
+      atb[i] += row[0][i] * rhs[0] + row[1][i] * rhs[1];
+    }
+  }
+
+  if (!solve_linear(ata, atb, 8))
+    goto affine;
+
+  /* denormalise: H = Td^-1 * Hn * Ts */
+  for(i=0;i<8;i++)
+    h[i] = atb[i];
+  h[8] = 1;
+  for(i=0;i<3;i++) {
+    hs[i*3 + 0] = h[i*3 + 0] * ts[0];
+    hs[i*3 + 1] = h[i*3 + 1] * ts[0];
+    hs[i*3 + 2] = h[i*3 + 0] * ts[1] + h[i*3 + 1] * ts[2] + h[i*3 + 2];
+  }
+  for(j=0;j<3;j++) {
+    h[0*3 + j] = (hs[0*3 + j] - td[1] * hs[2*3 + j]) / td[0];
+    h[1*3 + j] = (hs[1*3 + j] - td[2] * hs[2*3 + j]) / td[0];
+    h[2*3 + j] = hs[2*3 + j];
+  }
+
+  if (fabs(h[8]) < 1e-12)
+    goto affine;
+  for(i=0;i<9;i++)
+    matrix[i] = h[i] / h[8];
+  return;
+
+affine:
+  n_point_cal(xk, yk, xk_a, yk_a, n, matrix);
+  matrix[6] = 0;
+  matrix[7] = 0;
+  matrix[8] = 1;
+}
@@ -24,6 +24,7 @@
 #endif
 
 #include "blob_detector.h"
+#include "blob_moments.h"
 
 const struct _Zone default_zone = {
   0, 0,
@@ -33,6 +34,8 @@ const struct _Zone default_zone = {
   FALSE
 };
 
+static const ZoneMoments default_moments = { 0, 0, 0, 0, 0, 0 };
+
 #define DEFAULT_ZONE_ARRAY_SIZE 100
 
 static gint
@@ -84,17 +87,20 @@ join_zones(GArray *zoneid, gint p, gint q)
 }
 
 static void
-update_zone(GArray *zoneid, GArray *zonearray, gint x, gint y, gint id)
+update_zone(GArray *zoneid, GArray *zonearray, GArray *momentsarray,
+    gint x, gint y, gint id, guint weight)
 {
   Zone *zone;
 
   /* id is one based */
   id--;
 
-  if(zoneid->len <= id) {
-    g_array_append_val(zoneid, id);
+  /* mark 1 is skipped when the first pixel is dark, fill the gap */
+  while(zoneid->len <= id) {
+    gint root = zoneid->len;
+    g_array_append_val(zoneid, root);
   }
-  if(zonearray->len <= id) {
+  while(zonearray->len <= id) {
     g_array_append_val(zonearray, default_zone);
   }
   zone = &g_array_index(zonearray, Zone, id);
@@ -110,10 +116,27 @@ update_zone(GArray *zoneid, GArray *zonearray, gint x, gint y, gint id)
     zone->xend = x;
   if(y>zone->yend)
     zone->yend = y;
+
+  if(momentsarray) {
+    ZoneMoments *m;
+    guint64 wx = (guint64)weight * x;
+    guint64 wy = (guint64)weight * y;
+
+    while(momentsarray->len <= id) {
+      g_array_append_val(momentsarray, default_moments);
+    }
+    m = &g_array_index(momentsarray, ZoneMoments, id);
+    m->m00 += weight;
+    m->m10 += wx;
+    m->m01 += wy;
+    m->m20 += wx * x;
+    m->m02 += wy * y;
+    m->m11 += wx * y;
+  }
 }
 
 static void
-zone_root_count(GArray *zoneid, GArray *zonearray)
+zone_root_count(GArray *zoneid, GArray *zonearray, GArray *momentsarray)
 {
   gint i;
   gint id;
@@ -135,21 +158,36 @@ zone_root_count(GArray *zoneid, GArray *zonearray)
       zone_parent->total_x += zone_child->total_x;
       zone_parent->total_y += zone_child->total_y;
       zone_parent->surface_size += zone_child->surface_size;
+      if(momentsarray) {
+        ZoneMoments *m_parent = &g_array_index(momentsarray, ZoneMoments, id);
+        ZoneMoments *m_child = &g_array_index(momentsarray, ZoneMoments, i);
+        m_parent->m00 += m_child->m00;
+        m_parent->m10 += m_child->m10;
+        m_parent->m01 += m_child->m01;
+        m_parent->m20 += m_child->m20;
+        m_parent->m02 += m_child->m02;
+        m_parent->m11 += m_child->m11;
+      }
     }
   }
 }
 
 static void
-generate_final_zone(GArray *zoneid, GArray *zonearray, GArray **ret_zonearray,
+generate_final_zone(GArray *zoneid, GArray *zonearray, GArray *momentsarray,
+    GArray **ret_zonearray, GArray **ret_momentsarray,
     gint surface_min, gint surface_max)
 {
   /* Ignore all child, we just care about root nodes */
   gint i;
   GArray *root_zonearray;
+  GArray *root_momentsarray = NULL;
   Zone *zone;
 
   root_zonearray = g_array_sized_new(FALSE, FALSE, sizeof(Zone),
       zonearray->len);
+  if(momentsarray)
+    root_momentsarray = g_array_sized_new(FALSE, FALSE, sizeof(ZoneMoments),
+        zonearray->len);
 
   for(i=0; i<zonearray->len; i++) {
     if(i == g_array_index(zoneid, gint, i)) {
@@ -158,32 +196,62 @@ generate_final_zone(GArray *zoneid, GArray *zonearray, GArray **ret_zonearray,
 
       /* filter root node if total surface area is out of limited */
       if((zone->surface_size > surface_max) ||
-         (zone->surface_size < surface_min))
+         (zone->surface_size < surface_min) ||
+         (zone->surface_size == 0))
         continue;
 
       g_array_append_val(root_zonearray, *zone);
+      if(momentsarray)
+        g_array_append_val(root_momentsarray,
+            g_array_index(momentsarray, ZoneMoments, i));
     }
   }
   *ret_zonearray = root_zonearray;
+  if(ret_momentsarray)
+    *ret_momentsarray = root_momentsarray;
 }
 
-void
-find_zones(guint8* graybuf, gint width, gint height, guint threshold,
-    gint surface_min, gint surface_max, gint *markbuf, GArray **ret_zonearray)
+/* every mark left in markbuf replaced by the mark of its root */
+static void
+resolve_marks(GArray *zoneid, gint *markbuf, gint size, gint num_marks)
+{
+  gint *root;
+  gint i;
+
+  /* id is one based, 0 stays background */
+  root = g_new(gint, num_marks + 1);
+  root[0] = 0;
+  for(i=1; i<=num_marks; i++)
+    root[i] = quick_union_root(zoneid, i-1) + 1;
+
+  for(i=0; i<size; i++)
+    markbuf[i] = root[markbuf[i]];
+  g_free(root);
+}
+
+static void
+find_zones_internal(guint8* graybuf, gint width, gint height, guint threshold,
+    gint surface_min, gint surface_max, gint *markbuf, GArray **ret_zonearray,
+    GArray **ret_momentsarray, gint *ret_num_marks)
 {
   GArray *zoneid, *zonearray;
+  GArray *momentsarray = NULL;
   gint *prevline_buf, *curline_buf;
   gint x, y;
   gint zone_mark = 1;
   gint index = 0;
 
   create_zones(&zoneid, &zonearray, DEFAULT_ZONE_ARRAY_SIZE);
+  if(ret_momentsarray)
+    momentsarray = g_array_sized_new(FALSE, FALSE, sizeof(ZoneMoments),
+        DEFAULT_ZONE_ARRAY_SIZE);
 
   prevline_buf = markbuf;
   curline_buf = markbuf;
   if(graybuf[index++] > threshold) {
     *curline_buf++ = zone_mark;
-    update_zone(zoneid, zonearray, 0, 0, zone_mark);
+    update_zone(zoneid, zonearray, momentsarray, 0, 0, zone_mark,
+        graybuf[index-1] - threshold);
   } else {
     *curline_buf++ = 0;
   }
@@ -193,7 +261,8 @@ find_zones(guint8* graybuf, gint width, gint height, guint threshold,
       prev_id = *(curline_buf-1);
       if(prev_id == 0)
         prev_id = ++zone_mark;
-      update_zone(zoneid, zonearray, x, 0, prev_id);
+      update_zone(zoneid, zonearray, momentsarray, x, 0, prev_id,
+          graybuf[index-1] - threshold);
       *curline_buf++ = prev_id;
     } else {
       *curline_buf++ = 0;
@@ -210,7 +279,8 @@ find_zones(guint8* graybuf, gint width, gint height, guint threshold,
         if(!prev_id)
           prev_id = ++zone_mark;
       }
-      update_zone(zoneid, zonearray, 0, y, prev_id);
+      update_zone(zoneid, zonearray, momentsarray, 0, y, prev_id,
+          graybuf[index-1] - threshold);
       *curline_buf++ = prev_id;
     } else {
       prevline_buf++;
@@ -233,7 +303,8 @@ find_zones(guint8* graybuf, gint width, gint height, guint threshold,
           }
         }
         prevline_buf++;
-        update_zone(zoneid, zonearray, x, y, prev_id);
+        update_zone(zoneid, zonearray, momentsarray, x, y, prev_id,
+            graybuf[index-1] - threshold);
         *curline_buf++ = prev_id;
         /* join marker if needed */
         if (*prevline_buf && (prev_id != *prevline_buf)) {
@@ -258,7 +329,8 @@ find_zones(guint8* graybuf, gint width, gint height, guint threshold,
       }
       prevline_buf++;
       *curline_buf++ = prev_id;
-      update_zone(zoneid, zonearray, x, y, prev_id);
+      update_zone(zoneid, zonearray, momentsarray, x, y, prev_id,
+          graybuf[index-1] - threshold);
     } else {
       prevline_buf++;
       *curline_buf++ = 0;
@@ -266,10 +338,49 @@ find_zones(guint8* graybuf, gint width, gint height, guint threshold,
   }
 
   /* finally count all root node and get the result */
-  zone_root_count(zoneid, zonearray);
-  generate_final_zone(zoneid, zonearray, ret_zonearray, surface_min,
-    surface_max);
+  zone_root_count(zoneid, zonearray, momentsarray);
+  if(ret_num_marks) {
+    *ret_num_marks = zonearray->len;
+    resolve_marks(zoneid, markbuf, width * height, zonearray->len);
+  }
+  generate_final_zone(zoneid, zonearray, momentsarray, ret_zonearray,
+    ret_momentsarray, surface_min, surface_max);
   g_array_free(zoneid, TRUE);
   g_array_free(zonearray, TRUE);
+  if(momentsarray)
+    g_array_free(momentsarray, TRUE);
+}
+
+/* Same labelling as find_zones, with the intensity weighted moments of
+ * every zone in a second array, ret_momentsarray may be NULL. The weight
+ * of a pixel is its value above the threshold, so the centroid falls
+ * between pixels. */
+void
+find_zones_moments(guint8* graybuf, gint width, gint height, guint threshold,
+    gint surface_min, gint surface_max, gint *markbuf, GArray **ret_zonearray,
+    GArray **ret_momentsarray)
+{
+  find_zones_internal(graybuf, width, height, threshold, surface_min,
+      surface_max, markbuf, ret_zonearray, ret_momentsarray, NULL);
+}
+
+/* As find_zones_moments, and markbuf is left with one mark per 8-connected
+ * component (1 to *ret_num_marks, 0 for background) whatever its size, for
+ * the region adjacency tree of find_fiducials. */
+void
+find_zones_regions(guint8* graybuf, gint width, gint height, guint threshold,
+    gint surface_min, gint surface_max, gint *markbuf, GArray **ret_zonearray,
+    GArray **ret_momentsarray, gint *ret_num_marks)
+{
+  find_zones_internal(graybuf, width, height, threshold, surface_min,
+      surface_max, markbuf, ret_zonearray, ret_momentsarray, ret_num_marks);
+}
+
+void
+find_zones(guint8* graybuf, gint width, gint height, guint threshold,
+    gint surface_min, gint surface_max, gint *markbuf, GArray **ret_zonearray)
+{
+  find_zones_moments(graybuf, width, height, threshold, surface_min,
+      surface_max, markbuf, ret_zonearray, NULL);
 }
 
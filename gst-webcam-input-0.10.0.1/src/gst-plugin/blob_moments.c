@@ -0,0 +1,209 @@
+/*
+ *  gst-tuio - Gstreamer to tuio computer vision plugin
+ *
+ *  Copyright (C) 2010 Keith Mok <ek9852@gmail.com>
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+
+#ifdef HAVE_CONFIG_H
+#  include <config.h>
+#endif
+
+#include <math.h>
+#include <string.h>
+#include <glib.h>
+#include "blob_moments.h"
+#include "image_utils.h"
+
+/* A uniform ellipse with semi axes a and b has central second moments
+ * a^2/4 and b^2/4 along its axes, the full axes are 4 sqrt(lambda). */
+void
+zone_moments_shape (const ZoneMoments *m, BlobShape *shape)
+{
+  gdouble cx, cy, mu20, mu02, mu11, mean, diff, lambda1, lambda2;
+
+  cx = (gdouble)m->m10 / m->m00;
+  cy = (gdouble)m->m01 / m->m00;
+  mu20 = (gdouble)m->m20 / m->m00 - cx * cx;
+  mu02 = (gdouble)m->m02 / m->m00 - cy * cy;
+  mu11 = (gdouble)m->m11 / m->m00 - cx * cy;
+
+  mean = (mu20 + mu02) / 2;
+  diff = sqrt ((mu20 - mu02) * (mu20 - mu02) / 4 + mu11 * mu11);
+  lambda1 = mean + diff;
+  lambda2 = mean - diff;
+
+  shape->x = cx;
+  shape->y = cy;
+  shape->angle = (diff > 0) ? 0.5 * atan2 (2 * mu11, mu20 - mu02) : 0;
+  /* a single pixel or line has no extent, rounding may go below 0 */
+  shape->width = (lambda1 > 0) ? 4 * sqrt (lambda1) : 0;
+  shape->height = (lambda2 > 0) ? 4 * sqrt (lambda2) : 0;
+}
+
+/* Moments of a zone found on the frame decimated by decimate, taken again
+ * from the full resolution frame inside the zone bounding box (plus one
+ * coarse pixel). The pixels go through the background subtraction, the
+ * smooth and highpass filters and the amplify curve of the coarse
+ * pipeline, against the coarse background. The filter radii are in full
+ * resolution pixels; the filters run on a crop that is larger by their
+ * sum, so the measured pixels come out as if the whole frame had been
+ * filtered. Returns the number of pixels above threshold, 0 leaves m
+ * empty. */
+gint
+zone_moments_refine (const guint8 *frame, gint width, gint height,
+    const guint8 *background, gint decimate, gboolean trackdark,
+    guint smooth, guint highpass_blur, guint highpass_noise,
+    guint amplify_shift, guint threshold, const Zone *zone,
+    ZoneMoments *m)
+{
+  const guint8 *f, *b;
+  guint8 *crop, *image, *image_temp, *blur_temp, *swap, *c;
+  gint bg_width = width / decimate;
+  gint bg_height = height / decimate;
+  gint x, y, x0, x1, y0, y1, d, surface = 0;
+  gint margin, cx0, cy0, cw, ch;
+  guint64 wx, wy;
+  guint v;
+
+  memset (m, 0, sizeof(*m));
+
+  x0 = MAX ((zone->xstart - 1) * decimate, 0);
+  y0 = MAX ((zone->ystart - 1) * decimate, 0);
+  x1 = MIN ((zone->xend + 2) * decimate, width);
+  y1 = MIN ((zone->yend + 2) * decimate, height);
+
+  margin = smooth + (highpass_blur ? highpass_blur + highpass_noise : 0);
+  cx0 = MAX (x0 - margin, 0);
+  cy0 = MAX (y0 - margin, 0);
+  cw = MIN (x1 + margin, width) - cx0;
+  ch = MIN (y1 + margin, height) - cy0;
+
+  crop = g_malloc (3 * cw * ch);
+  image = crop;
+  image_temp = crop + cw * ch;
+  blur_temp = crop + 2 * cw * ch;
+
+  c = image;
+  for (y = cy0; y < cy0 + ch; y++) {
+    f = frame + y * width;
+    b = background + MIN (y / decimate, bg_height - 1) * bg_width;
+    for (x = cx0; x < cx0 + cw; x++) {
+      d = f[x] - b[MIN (x / decimate, bg_width - 1)];
+      if (trackdark)
+        d = -d;
+      *c++ = d < 0 ? 0 : d;
+    }
+  }
+
+  if (smooth) {
+    pf_image8_box_blur (image, image_temp, cw, cw, ch, blur_temp, smooth);
+    swap = image;
+    image = image_temp;
+    image_temp = swap;
+  }
+  if (highpass_blur) {
+    pf_image8_box_blur (image, image_temp, cw, cw, ch, blur_temp,
+        highpass_blur);
+    pf_image8_subtract (image, image_temp, image, cw, cw, ch);
+    if (highpass_noise) {
+      pf_image8_box_blur (image, image_temp, cw, cw, ch, blur_temp,
+          highpass_noise);
+      swap = image;
+      image = image_temp;
+      image_temp = swap;
+    }
+  }
+
+  for (y = y0; y < y1; y++) {
+    c = image + (y - cy0) * cw - cx0;
+    for (x = x0; x < x1; x++) {
+      v = c[x];
+      if (amplify_shift < 8) {
+        v = (v * v) >> amplify_shift;
+        if (v > 255)
+          v = 255;
+      }
+      if (v <= threshold)
+        continue;
+
+      v -= threshold;
+      wx = (guint64)v * x;
+      wy = (guint64)v * y;
+      m->m00 += v;
+      m->m10 += wx;
+      m->m01 += wy;
+      m->m20 += wx * x;
+      m->m02 += wy * y;
+      m->m11 += wx * y;
+      surface++;
+    }
+  }
+
+  g_free (crop);
+
+  return surface;
+}
+
+/* coarse pixel x covers the full resolution pixels x*d .. x*d+d-1 */
+void
+blob_shape_undecimate (BlobShape *shape, gint decimate)
+{
+  shape->x = (shape->x + 0.5f) * decimate - 0.5f;
+  shape->y = (shape->y + 0.5f) * decimate - 0.5f;
+  shape->width *= decimate;
+  shape->height *= decimate;
+}
+
+/* The ellipse is carried over by its centre and the ends of both half
+ * axes, good enough for any mapping that is smooth over a blob. */
+void
+blob_shape_map (const BlobShape *shape, BlobMapFunc map, gpointer data,
+    BlobShape *dst)
+{
+  gfloat c, s, x, y, ax, ay, bx, by;
+
+  c = cos (shape->angle);
+  s = sin (shape->angle);
+
+  map (data, shape->x, shape->y, &x, &y);
+  map (data, shape->x + c * shape->width / 2, shape->y + s * shape->width / 2,
+      &ax, &ay);
+  map (data, shape->x - s * shape->height / 2,
+      shape->y + c * shape->height / 2, &bx, &by);
+
+  ax -= x;
+  ay -= y;
+  bx -= x;
+  by -= y;
+
+  dst->x = x;
+  dst->y = y;
+  dst->width = 2 * sqrt (ax * ax + ay * ay);
+  dst->height = 2 * sqrt (bx * bx + by * by);
+  if (dst->width > 0) {
+    dst->angle = atan2 (ay, ax);
+    /* same half turn as zone_moments_shape */
+    if (dst->angle > G_PI_2)
+      dst->angle -= G_PI;
+    else if (dst->angle <= -G_PI_2)
+      dst->angle += G_PI;
+  } else {
+    dst->angle = 0;
+  }
+}
@@ -0,0 +1,81 @@
+/*
+ *  gst-tuio - Gstreamer to tuio computer vision plugin
+ *
+ *  Copyright (C) 2010 Keith Mok <ek9852@gmail.com>
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+
+#ifndef __BLOB_MOMENTS_H__
+#define __BLOB_MOMENTS_H__
+
+#include <glib.h>
+#include "blob_detector.h"
+
+G_BEGIN_DECLS
+
+typedef struct _ZoneMoments ZoneMoments;
+typedef struct _BlobShape   BlobShape;
+
+/* Raw moments of a zone up to the second order, every pixel weighted by
+ * how far it is above the threshold. Kept in a GArray parallel to the
+ * Zone array returned by find_zones_moments. */
+struct _ZoneMoments
+{
+  guint64 m00;
+  guint64 m10, m01;
+  guint64 m20, m02, m11;
+};
+
+/* Weighted centroid and the equivalent ellipse of a blob, width is the
+ * major axis and height the minor axis, angle in radian between the
+ * major axis and the x axis, in (-pi/2, pi/2]. */
+struct _BlobShape
+{
+  gfloat x;
+  gfloat y;
+  gfloat angle;
+  gfloat width;
+  gfloat height;
+};
+
+/* maps a point from one coordinate space to another */
+typedef void (*BlobMapFunc) (gpointer data, gfloat x, gfloat y,
+    gfloat *xdst, gfloat *ydst);
+
+void find_zones_moments (guint8 *graybuf, gint width, gint height,
+    guint threshold, gint surface_min, gint surface_max, gint *markbuf,
+    GArray **ret_zonearray, GArray **ret_momentsarray);
+
+void find_zones_regions (guint8 *graybuf, gint width, gint height,
+    guint threshold, gint surface_min, gint surface_max, gint *markbuf,
+    GArray **ret_zonearray, GArray **ret_momentsarray, gint *ret_num_marks);
+
+void zone_moments_shape (const ZoneMoments *m, BlobShape *shape);
+
+gint zone_moments_refine (const guint8 *frame, gint width, gint height,
+    const guint8 *background, gint decimate, gboolean trackdark,
+    guint smooth, guint highpass_blur, guint highpass_noise,
+    guint amplify_shift, guint threshold, const Zone *zone,
+    ZoneMoments *m);
+void blob_shape_undecimate (BlobShape *shape, gint decimate);
+void blob_shape_map (const BlobShape *shape, BlobMapFunc map, gpointer data,
+    BlobShape *dst);
+
+G_END_DECLS
+
+#endif /* __BLOB_MOMENTS_H__ */
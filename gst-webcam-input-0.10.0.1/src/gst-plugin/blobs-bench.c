@@ -0,0 +1,734 @@
+/*
+ *  gst-tuio - Gstreamer to tuio computer vision plugin
+ *
+ *  Copyright (C) 2010 Keith Mok <ek9852@gmail.com>
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+
+/* Offline benchmark of the blob pipeline.
+ *
+ * Runs every registered image_utils variant and find_zones on recorded
+ * GRAY8 frames or on a synthetic touch pattern, in isolation and end to
+ * end, and reports ns/pixel, frames/s and allocations per frame.
+ *
+ *   make blobs-bench
+ *   ./blobs-bench --size 640x480 --blobs 10 --blob-radius 6 --noise 12
+ *   ./blobs-bench --size 320x240 --input recorded.gray
+ *   ./blobs-bench --input table.gray
+ *
+ * With --lens (and optionally --remap-matrix) the end to end runs go
+ * through the fused remap + background stage, which is also compared
+ * with the unfused passes.
+ *
+ *   ./blobs-bench --lens 300,300,160,120,-0.25,0.05
+ *
+ * With --verify it instead checks every variant bit-exact against the c
+ * reference and exits non-zero on a mismatch.
+ *
+ *   ./blobs-bench --verify 100
+ */
+
+#ifdef HAVE_CONFIG_H
+#  include <config.h>
+#endif
+
+#include <glib.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "blob_detector.h"
+#include "blob_moments.h"
+#include "gray_capture.h"
+#include "image_utils.h"
+#include "image_utils_impl.h"
+#include "image_remap.h"
+#include "stage_stats.h"
+
+static gint width = 320;
+static gint height = 240;
+static gint num_frames = 300;
+static gchar *input_file = NULL;
+static gint num_blobs = 5;
+static gint blob_radius = 5;
+static gint noise = 8;
+static gint seed = 1;
+static gint blur_radius = 4;
+static gint smooth = 2;
+static gint highpass_blur = 18;
+static gint highpass_noise = 4;
+static gint amplify_shift = 3;
+static gint threshold = 25;
+static gint surface_min = 30;
+static gint surface_max = 450;
+static gint verify_iterations = 0;
+static gchar *lens_str = NULL;
+static gchar *remap_matrix_str = NULL;
+static RemapLut *remap_lut = NULL;
+
+/* Allocation counting. g_mem_set_vtable is a no-op since glib 2.46, so
+ * with glibc malloc itself is interposed, which also counts what glib
+ * allocates internally (g_array_*, g_slice magazines). Elsewhere the
+ * vtable is tried and the column reads n/a when glib ignores it. */
+static volatile gint num_allocs;
+static gboolean counting_allocs = FALSE;
+
+#ifdef __GLIBC__
+extern void *__libc_malloc (size_t n);
+extern void *__libc_calloc (size_t n, size_t size);
+extern void *__libc_realloc (void *mem, size_t n);
+
+void *
+malloc (size_t n)
+{
+  g_atomic_int_inc (&num_allocs);
+  return __libc_malloc (n);
+}
+
+void *
+calloc (size_t n, size_t size)
+{
+  g_atomic_int_inc (&num_allocs);
+  return __libc_calloc (n, size);
+}
+
+void *
+realloc (void *mem, size_t n)
+{
+  g_atomic_int_inc (&num_allocs);
+  return __libc_realloc (mem, n);
+}
+
+static void
+counting_init (void)
+{
+  counting_allocs = TRUE;
+}
+#else
+static gpointer
+counting_malloc (gsize n)
+{
+  g_atomic_int_inc (&num_allocs);
+  return malloc (n);
+}
+
+static gpointer
+counting_realloc (gpointer mem, gsize n)
+{
+  g_atomic_int_inc (&num_allocs);
+  return realloc (mem, n);
+}
+
+static GMemVTable counting_vtable = {
+  counting_malloc,
+  counting_realloc,
+  free,
+  NULL,
+  NULL,
+  NULL,
+};
+
+static void
+counting_init (void)
+{
+  g_mem_set_vtable (&counting_vtable);
+  counting_allocs = !g_mem_is_system_malloc ();
+}
+#endif
+
+/* frames of a grayrecord capture, which carries its own size */
+static guint8 *
+load_capture (void)
+{
+  GrayCaptureReader *reader;
+  const GrayCaptureInfo *info;
+  GError *error = NULL;
+  guint8 *frames;
+  gint n, y;
+
+  reader = gray_capture_reader_new (input_file, &error);
+  if (!reader)
+    g_error ("%s", error->message);
+  info = gray_capture_reader_get_info (reader);
+  if (info->num_frames == 0)
+    g_error ("%s holds no frame", input_file);
+
+  width = info->width;
+  height = info->height;
+  num_frames = MIN ((guint64) num_frames, info->num_frames);
+
+  frames = g_malloc ((gsize) width * height * num_frames);
+  for (n = 0; n < num_frames; n++) {
+    const guint8 *frame = gray_capture_reader_get_frame (reader, n, NULL,
+        NULL);
+    for (y = 0; y < height; y++)
+      memcpy (frames + ((gsize) n * height + y) * width,
+          frame + y * info->stride, width);
+  }
+  gray_capture_reader_free (reader);
+  return frames;
+}
+
+static guint8 *
+load_frames (void)
+{
+  guint8 *frames;
+  gsize frame_size = width * height;
+  FILE *f;
+  gint n;
+
+  frames = g_malloc (frame_size * num_frames);
+  f = fopen (input_file, "rb");
+  if (!f)
+    g_error ("Cannot open %s", input_file);
+
+  for (n = 0; n < num_frames; n++) {
+    if (fread (frames + n * frame_size, 1, frame_size, f) != frame_size)
+      break;
+  }
+  fclose (f);
+
+  if (n == 0)
+    g_error ("%s holds no complete %dx%d GRAY8 frame", input_file, width,
+        height);
+  num_frames = n;
+  return frames;
+}
+
+/* dim gradient background with noise and bright discs drifting around */
+static guint8 *
+synth_frames (void)
+{
+  guint8 *frames;
+  gsize frame_size = width * height;
+  GRand *rand;
+  gdouble *bx, *by, *vx, *vy;
+  gint n, i, x, y;
+
+  rand = g_rand_new_with_seed (seed);
+  frames = g_malloc (frame_size * num_frames);
+  bx = g_new (gdouble, num_blobs);
+  by = g_new (gdouble, num_blobs);
+  vx = g_new (gdouble, num_blobs);
+  vy = g_new (gdouble, num_blobs);
+
+  for (i = 0; i < num_blobs; i++) {
+    bx[i] = g_rand_double_range (rand, blob_radius, width - blob_radius);
+    by[i] = g_rand_double_range (rand, blob_radius, height - blob_radius);
+    vx[i] = g_rand_double_range (rand, -2, 2);
+    vy[i] = g_rand_double_range (rand, -2, 2);
+  }
+
+  for (n = 0; n < num_frames; n++) {
+    guint8 *p = frames + n * frame_size;
+
+    for (y = 0; y < height; y++) {
+      for (x = 0; x < width; x++) {
+        gint v = 40 + (x * 40) / width;
+        if (noise)
+          v += g_rand_int_range (rand, -noise, noise + 1);
+        p[y * width + x] = CLAMP (v, 0, 255);
+      }
+    }
+
+    for (i = 0; i < num_blobs; i++) {
+      gint x0 = MAX ((gint) bx[i] - blob_radius, 0);
+      gint x1 = MIN ((gint) bx[i] + blob_radius, width - 1);
+      gint y0 = MAX ((gint) by[i] - blob_radius, 0);
+      gint y1 = MIN ((gint) by[i] + blob_radius, height - 1);
+
+      for (y = y0; y <= y1; y++) {
+        for (x = x0; x <= x1; x++) {
+          gdouble dx = x - bx[i], dy = y - by[i];
+          if (dx * dx + dy * dy <= blob_radius * blob_radius)
+            p[y * width + x] = 220;
+        }
+      }
+
+      bx[i] += vx[i];
+      by[i] += vy[i];
+      if ((bx[i] < blob_radius) || (bx[i] > width - blob_radius))
+        vx[i] = -vx[i];
+      if ((by[i] < blob_radius) || (by[i] > height - blob_radius))
+        vy[i] = -vy[i];
+    }
+  }
+
+  g_free (bx);
+  g_free (by);
+  g_free (vx);
+  g_free (vy);
+  g_rand_free (rand);
+  return frames;
+}
+
+static void
+report (const gchar *impl, const gchar *what, guint64 ns, gint frames,
+    gint allocs)
+{
+  gdouble pixels = (gdouble) width * height * frames;
+
+  if (!counting_allocs) {
+    printf ("%-8s %-24s %10.3f ns/pixel %10.1f frames/s %8s allocs/frame\n",
+        impl, what, ns / pixels, frames * 1e9 / ns, "n/a");
+    return;
+  }
+  printf ("%-8s %-24s %10.3f ns/pixel %10.1f frames/s %8.2f allocs/frame\n",
+      impl, what, ns / pixels, frames * 1e9 / ns, (gdouble) allocs / frames);
+}
+
+static void
+bench_kernels (const ImageUtilsImpl *impl, const guint8 *frames)
+{
+  gsize frame_size = width * height;
+  guint8 *bg, *out, *tmp, *fx, *fy;
+  guint16 *bg_frac;
+  guint64 t;
+  gint n, i;
+
+  bg = g_malloc (frame_size);
+  bg_frac = g_malloc0 (frame_size * sizeof (guint16));
+  out = g_malloc (frame_size);
+  tmp = g_malloc (frame_size);
+  memcpy (bg, frames, frame_size);
+
+  if (impl->update_background_buf) {
+    t = stage_stats_now ();
+    for (n = 0; n < num_frames; n++)
+      impl->update_background_buf (frames + n * frame_size, bg, bg_frac,
+          width, width, height);
+    report (impl->name, "update_background_buf", stage_stats_now () - t,
+        num_frames, 0);
+  }
+
+  if (impl->image8_subtract) {
+    t = stage_stats_now ();
+    for (n = 0; n < num_frames; n++)
+      impl->image8_subtract (frames + n * frame_size, bg, out, width, width,
+          height);
+    report (impl->name, "image8_subtract", stage_stats_now () - t,
+        num_frames, 0);
+  }
+
+  if (impl->image8_box_blur) {
+    t = stage_stats_now ();
+    for (n = 0; n < num_frames; n++)
+      impl->image8_box_blur (frames + n * frame_size, out, width, width,
+          height, tmp, blur_radius);
+    report (impl->name, "image8_box_blur", stage_stats_now () - t,
+        num_frames, 0);
+  }
+
+  if (impl->image8_amplify) {
+    t = stage_stats_now ();
+    for (n = 0; n < num_frames; n++)
+      impl->image8_amplify (frames + n * frame_size, out, width, width,
+          height, amplify_shift);
+    report (impl->name, "image8_amplify", stage_stats_now () - t,
+        num_frames, 0);
+  }
+
+  if (impl->image8_threshold) {
+    t = stage_stats_now ();
+    for (n = 0; n < num_frames; n++)
+      impl->image8_threshold (frames + n * frame_size, out, width, width,
+          height, threshold);
+    report (impl->name, "image8_threshold", stage_stats_now () - t,
+        num_frames, 0);
+  }
+
+  if (impl->image8_downsample2) {
+    t = stage_stats_now ();
+    for (n = 0; n < num_frames; n++)
+      impl->image8_downsample2 (frames + n * frame_size, out, width, width,
+          height);
+    report (impl->name, "image8_downsample2", stage_stats_now () - t,
+        num_frames, 0);
+  }
+
+  if (impl->image8_bilinear) {
+    /* the 2x2 neighbourhood of every pixel but the last row and column,
+     * the remap gathers its taps into planes like these */
+    gint taps = frame_size - width - 1;
+    const guint8 *f;
+
+    fx = g_malloc (frame_size);
+    fy = g_malloc (frame_size);
+    for (i = 0; i < frame_size; i++) {
+      fx[i] = (i * 37) % 129;
+      fy[i] = (i * 59) % 129;
+    }
+    t = stage_stats_now ();
+    for (n = 0; n < num_frames; n++) {
+      f = frames + n * frame_size;
+      impl->image8_bilinear (f, f + 1, f + width, f + width + 1, fx, fy,
+          out, taps);
+    }
+    report (impl->name, "image8_bilinear", stage_stats_now () - t,
+        num_frames, 0);
+    g_free (fx);
+    g_free (fy);
+  }
+
+  g_free (bg);
+  g_free (bg_frac);
+  g_free (out);
+  g_free (tmp);
+}
+
+/* the same sequence of operations as gst_blobs_to_tuio_chain, the
+ * processed frames are kept when out is not NULL */
+static guint64
+run_pipeline (const guint8 *frames, guint8 *out, gint *allocs,
+    guint *zones_found)
+{
+  gsize frame_size = width * height;
+  guint8 *bg, *buf1, *buf2, *blur_tmp;
+  guint16 *bg_frac;
+  gint *markbuf;
+  guint64 t, total = 0;
+  gint n;
+
+  bg = g_malloc (frame_size);
+  bg_frac = g_malloc0 (frame_size * sizeof (guint16));
+  buf1 = g_malloc (frame_size);
+  buf2 = g_malloc (frame_size);
+  blur_tmp = g_malloc (frame_size);
+  markbuf = g_malloc (frame_size * sizeof (gint));
+  memcpy (bg, frames, frame_size);
+
+  *allocs = 0;
+  *zones_found = 0;
+  for (n = 0; n < num_frames; n++) {
+    const guint8 *p = frames + n * frame_size;
+    guint8 *image_buf = buf1, *image_buf_temp = buf2, *swap;
+    GArray *zones;
+    gint allocs_before;
+
+    allocs_before = g_atomic_int_get (&num_allocs);
+    t = stage_stats_now ();
+
+    if (remap_lut) {
+      image8_remap_subtract (p, remap_lut, bg, bg_frac, image_buf, FALSE,
+          FALSE);
+    } else {
+      pf_update_background_buf (p, bg, bg_frac, width, width, height);
+      pf_image8_subtract (p, bg, image_buf, width, width, height);
+    }
+    if (smooth) {
+      pf_image8_box_blur (image_buf, image_buf_temp, width, width, height,
+          blur_tmp, smooth);
+      swap = image_buf; image_buf = image_buf_temp; image_buf_temp = swap;
+    }
+    if (highpass_blur) {
+      pf_image8_box_blur (image_buf, image_buf_temp, width, width, height,
+          blur_tmp, highpass_blur);
+      pf_image8_subtract (image_buf, image_buf_temp, image_buf, width, width,
+          height);
+      if (highpass_noise) {
+        pf_image8_box_blur (image_buf, image_buf_temp, width, width, height,
+            blur_tmp, highpass_noise);
+        swap = image_buf; image_buf = image_buf_temp; image_buf_temp = swap;
+      }
+    }
+    if (amplify_shift < 8)
+      pf_image8_amplify (image_buf, image_buf, width, width, height,
+          amplify_shift);
+    find_zones (image_buf, width, height, threshold, surface_min,
+        surface_max, markbuf, &zones);
+    *zones_found += zones->len;
+    g_array_free (zones, TRUE);
+
+    total += stage_stats_now () - t;
+    *allocs += g_atomic_int_get (&num_allocs) - allocs_before;
+
+    if (out)
+      memcpy (out + n * frame_size, image_buf, frame_size);
+  }
+
+  g_free (bg);
+  g_free (bg_frac);
+  g_free (buf1);
+  g_free (buf2);
+  g_free (blur_tmp);
+  g_free (markbuf);
+  return total;
+}
+
+/* fused remap stage against remap followed by the separate passes, with
+ * the pf_* kernels select_impl pointed to impl */
+static void
+bench_remap (const ImageUtilsImpl *impl, const guint8 *frames)
+{
+  gsize frame_size = width * height;
+  guint8 *bg[2], *out[2], *remapped;
+  guint16 *bg_frac[2];
+  guint64 t;
+  gint i, n, allocs;
+
+  remapped = g_malloc (frame_size);
+  for (i = 0; i < 2; i++) {
+    bg[i] = g_malloc (frame_size);
+    bg_frac[i] = g_malloc0 (frame_size * sizeof (guint16));
+    out[i] = g_malloc (frame_size);
+    image8_remap (frames, remap_lut, bg[i]);
+  }
+
+  allocs = g_atomic_int_get (&num_allocs);
+  t = stage_stats_now ();
+  for (n = 0; n < num_frames; n++) {
+    image8_remap (frames + n * frame_size, remap_lut, remapped);
+    pf_update_background_buf (remapped, bg[0], bg_frac[0], width, width,
+        height);
+    pf_image8_subtract (remapped, bg[0], out[0], width, width, height);
+  }
+  report (impl->name, "remap+bg+subtract", stage_stats_now () - t, num_frames,
+      g_atomic_int_get (&num_allocs) - allocs);
+
+  allocs = g_atomic_int_get (&num_allocs);
+  t = stage_stats_now ();
+  for (n = 0; n < num_frames; n++)
+    image8_remap_subtract (frames + n * frame_size, remap_lut, bg[1],
+        bg_frac[1], out[1], FALSE, FALSE);
+  report (impl->name, "remap_subtract (fused)", stage_stats_now () - t, num_frames,
+      g_atomic_int_get (&num_allocs) - allocs);
+
+  if (memcmp (out[0], out[1], frame_size) || memcmp (bg[0], bg[1],
+          frame_size))
+    printf ("fused remap_subtract differs from the separate passes\n");
+
+  for (i = 0; i < 2; i++) {
+    g_free (bg[i]);
+    g_free (bg_frac[i]);
+    g_free (out[i]);
+  }
+  g_free (remapped);
+}
+
+static void
+bench_find_zones (const guint8 *processed)
+{
+  gsize frame_size = width * height;
+  gint *markbuf;
+  guint64 t;
+  gint n, allocs;
+  GArray *zones, *moments;
+
+  markbuf = g_malloc (frame_size * sizeof (gint));
+  allocs = g_atomic_int_get (&num_allocs);
+  t = stage_stats_now ();
+  for (n = 0; n < num_frames; n++) {
+    find_zones ((guint8 *) processed + n * frame_size, width, height,
+        threshold, surface_min, surface_max, markbuf, &zones);
+    g_array_free (zones, TRUE);
+  }
+  t = stage_stats_now () - t;
+  report ("-", "find_zones", t, num_frames,
+      g_atomic_int_get (&num_allocs) - allocs);
+
+  /* what the plugin runs, with the weighted centroids and shape */
+  allocs = g_atomic_int_get (&num_allocs);
+  t = stage_stats_now ();
+  for (n = 0; n < num_frames; n++) {
+    find_zones_moments ((guint8 *) processed + n * frame_size, width, height,
+        threshold, surface_min, surface_max, markbuf, &zones, &moments);
+    g_array_free (zones, TRUE);
+    g_array_free (moments, TRUE);
+  }
+  t = stage_stats_now () - t;
+  report ("-", "find_zones_moments", t, num_frames,
+      g_atomic_int_get (&num_allocs) - allocs);
+  g_free (markbuf);
+}
+
+/* point the pf_* kernels to impl, falling back to c for missing ones */
+static void
+select_impl (const ImageUtilsImpl *impl)
+{
+  const ImageUtilsImpl *c = image_utils_get_impl (0);
+
+  pf_update_background_buf = impl->update_background_buf ?
+      impl->update_background_buf : c->update_background_buf;
+  pf_image8_box_blur = impl->image8_box_blur ?
+      impl->image8_box_blur : c->image8_box_blur;
+  pf_image8_subtract = impl->image8_subtract ?
+      impl->image8_subtract : c->image8_subtract;
+  pf_image8_amplify = impl->image8_amplify ?
+      impl->image8_amplify : c->image8_amplify;
+  pf_image8_threshold = impl->image8_threshold ?
+      impl->image8_threshold : c->image8_threshold;
+  pf_image8_downsample2 = impl->image8_downsample2 ?
+      impl->image8_downsample2 : c->image8_downsample2;
+  pf_image8_bilinear = impl->image8_bilinear ?
+      impl->image8_bilinear : c->image8_bilinear;
+}
+
+/* differential check of every registered variant, returns the number of
+ * failing kernels */
+static gint
+verify (gint iterations)
+{
+  const ImageUtilsImpl *impl;
+  gchar *failure;
+  gint i, k, failed = 0;
+
+  for (i = 1; (impl = image_utils_get_impl (i)) != NULL; i++) {
+    for (k = 0; k < IMAGE_UTILS_NUM_KERNELS; k++) {
+      if (!image_utils_has_kernel (impl, k))
+        continue;
+      failure = NULL;
+      if (image_utils_check_kernel (impl, k, seed, iterations, &failure)) {
+        printf ("PASS %-8s %s\n", impl->name, image_utils_kernel_name (k));
+      } else {
+        printf ("FAIL %s\n", failure);
+        g_free (failure);
+        failed++;
+      }
+    }
+  }
+  return failed;
+}
+
+static gboolean
+parse_size (const gchar *name, const gchar *value, gpointer data,
+    GError **error)
+{
+  if ((sscanf (value, "%dx%d", &width, &height) != 2) ||
+      (width <= 2) || (height <= 2)) {
+    g_set_error (error, G_OPTION_ERROR, G_OPTION_ERROR_BAD_VALUE,
+        "invalid size %s", value);
+    return FALSE;
+  }
+  return TRUE;
+}
+
+static GOptionEntry entries[] = {
+  { "size", 's', 0, G_OPTION_ARG_CALLBACK, parse_size,
+    "Frame size WxH (default 320x240)", "WxH" },
+  { "frames", 'n', 0, G_OPTION_ARG_INT, &num_frames,
+    "Number of frames (default 300)", "N" },
+  { "input", 'i', 0, G_OPTION_ARG_FILENAME, &input_file,
+    "Capture or raw GRAY8 frames to load instead of the synthetic pattern",
+    "FILE" },
+  { "blobs", 'b', 0, G_OPTION_ARG_INT, &num_blobs,
+    "Synthetic touches per frame (default 5)", "N" },
+  { "blob-radius", 'r', 0, G_OPTION_ARG_INT, &blob_radius,
+    "Synthetic touch radius in pixels (default 5)", "R" },
+  { "noise", 'a', 0, G_OPTION_ARG_INT, &noise,
+    "Synthetic noise amplitude (default 8)", "A" },
+  { "seed", 0, 0, G_OPTION_ARG_INT, &seed,
+    "Random seed of the synthetic pattern (default 1)", "S" },
+  { "blur-radius", 0, 0, G_OPTION_ARG_INT, &blur_radius,
+    "Radius for the isolated box blur (default 4)", "R" },
+  { "smooth", 0, 0, G_OPTION_ARG_INT, &smooth,
+    "Pipeline smooth radius (default 2)", "R" },
+  { "highpass-blur", 0, 0, G_OPTION_ARG_INT, &highpass_blur,
+    "Pipeline highpass blur radius (default 18)", "R" },
+  { "highpass-noise", 0, 0, G_OPTION_ARG_INT, &highpass_noise,
+    "Pipeline highpass noise radius (default 4)", "R" },
+  { "threshold", 't', 0, G_OPTION_ARG_INT, &threshold,
+    "Pipeline threshold (default 25)", "T" },
+  { "lens", 0, 0, G_OPTION_ARG_STRING, &lens_str,
+    "Remap through fx,fy,cx,cy,k1,k2,p1,p2 before background subtraction",
+    "COEFFS" },
+  { "remap-matrix", 0, 0, G_OPTION_ARG_STRING, &remap_matrix_str,
+    "6 or 9 coeffs of the remap perspective correction", "COEFFS" },
+  { "verify", 0, 0, G_OPTION_ARG_INT, &verify_iterations,
+    "Check the variants against c with N random rounds and exit", "N" },
+  { NULL }
+};
+
+int
+main (int argc, char *argv[])
+{
+  GOptionContext *ctx;
+  GError *error = NULL;
+  const ImageUtilsImpl *impl;
+  guint8 *frames, *processed;
+  guint zones_found;
+  guint64 t;
+  gint i, allocs;
+
+  /* must come before anything allocates through glib */
+  counting_init ();
+
+  ctx = g_option_context_new ("- benchmark the blobstotuio image pipeline");
+  g_option_context_add_main_entries (ctx, entries, NULL);
+  if (!g_option_context_parse (ctx, &argc, &argv, &error)) {
+    g_printerr ("%s\n", error->message);
+    return 1;
+  }
+  g_option_context_free (ctx);
+
+  if (verify_iterations > 0)
+    return verify (verify_iterations) ? 1 : 0;
+
+  if (num_frames <= 0)
+    num_frames = 1;
+
+  if (!input_file)
+    frames = synth_frames ();
+  else if (gray_capture_is_capture (input_file))
+    frames = load_capture ();
+  else
+    frames = load_frames ();
+  processed = g_malloc ((gsize) width * height * num_frames);
+
+  printf ("%dx%d, %d frames, %s\n", width, height, num_frames,
+      input_file ? input_file : "synthetic");
+
+  if (lens_str || remap_matrix_str) {
+    LensModel lens;
+    gfloat m[9];
+
+    homography_identity (m);
+    if (!lens_model_parse (&lens, lens_str) ||
+        (remap_matrix_str && !homography_parse (m, remap_matrix_str))) {
+      g_printerr ("invalid --lens or --remap-matrix\n");
+      return 1;
+    }
+    remap_lut = remap_lut_new (width, height, &lens, m);
+    if (!remap_lut) {
+      g_printerr ("--remap-matrix is singular\n");
+      return 1;
+    }
+    for (i = 0; (impl = image_utils_get_impl (i)) != NULL; i++) {
+      select_impl (impl);
+      bench_remap (impl, frames);
+    }
+  }
+
+  for (i = 0; (impl = image_utils_get_impl (i)) != NULL; i++)
+    bench_kernels (impl, frames);
+
+  select_impl (image_utils_get_impl (0));
+  run_pipeline (frames, processed, &allocs, &zones_found);
+  bench_find_zones (processed);
+
+  for (i = 0; (impl = image_utils_get_impl (i)) != NULL; i++) {
+    select_impl (impl);
+    t = run_pipeline (frames, NULL, &allocs, &zones_found);
+    report (impl->name, "end to end", t, num_frames, allocs);
+  }
+  printf ("%.2f zones/frame\n", (gdouble) zones_found / num_frames);
+
+  remap_lut_free (remap_lut);
+  g_free (frames);
+  g_free (processed);
+  return 0;
+}
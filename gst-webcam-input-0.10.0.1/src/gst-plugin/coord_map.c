@@ -0,0 +1,290 @@
+/*
+ *  gst-tuio - Gstreamer to tuio computer vision plugin
+ *
+ *  Copyright (C) 2010 Keith Mok <ek9852@gmail.com>
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+
+#ifdef HAVE_CONFIG_H
+#  include <config.h>
+#endif
+
+#include <stdio.h>
+#include <string.h>
+#include <glib.h>
+#include "coord_map.h"
+
+/* fixed point iterations to invert the distortion, as undistortPoints */
+#define UNDISTORT_ITERATIONS 5
+
+gboolean
+homography_parse (gfloat *m, const gchar *str)
+{
+  gfloat v[9];
+  gint n;
+
+  n = sscanf (str, "%f,%f,%f,%f,%f,%f,%f,%f,%f",
+    &v[0], &v[1], &v[2], &v[3], &v[4], &v[5], &v[6], &v[7], &v[8]);
+  if (n == 6) {
+    v[6] = 0;
+    v[7] = 0;
+    v[8] = 1;
+  } else if (n != 9 || v[8] == 0) {
+    return FALSE;
+  }
+
+  memcpy (m, v, sizeof(v));
+  return TRUE;
+}
+
+gchar *
+homography_to_string (const gfloat *m)
+{
+  if (homography_is_affine (m))
+    return g_strdup_printf ("%g,%g,%g,%g,%g,%g", m[0], m[1], m[2],
+        m[3], m[4], m[5]);
+
+  return g_strdup_printf ("%g,%g,%g,%g,%g,%g,%g,%g,%g", m[0], m[1], m[2],
+      m[3], m[4], m[5], m[6], m[7], m[8]);
+}
+
+void
+homography_identity (gfloat *m)
+{
+  memset (m, 0, 9 * sizeof(gfloat));
+  m[0] = 1;
+  m[4] = 1;
+  m[8] = 1;
+}
+
+gboolean
+homography_is_affine (const gfloat *m)
+{
+  return (m[6] == 0 && m[7] == 0 && m[8] == 1);
+}
+
+gboolean
+homography_invert (const gfloat *m, gfloat *inv)
+{
+  gdouble a[9], det;
+  gint i;
+
+  /* adjugate over determinant */
+  a[0] = (gdouble)m[4] * m[8] - (gdouble)m[5] * m[7];
+  a[1] = (gdouble)m[2] * m[7] - (gdouble)m[1] * m[8];
+  a[2] = (gdouble)m[1] * m[5] - (gdouble)m[2] * m[4];
+  a[3] = (gdouble)m[5] * m[6] - (gdouble)m[3] * m[8];
+  a[4] = (gdouble)m[0] * m[8] - (gdouble)m[2] * m[6];
+  a[5] = (gdouble)m[2] * m[3] - (gdouble)m[0] * m[5];
+  a[6] = (gdouble)m[3] * m[7] - (gdouble)m[4] * m[6];
+  a[7] = (gdouble)m[1] * m[6] - (gdouble)m[0] * m[7];
+  a[8] = (gdouble)m[0] * m[4] - (gdouble)m[1] * m[3];
+
+  det = m[0] * a[0] + m[1] * a[3] + m[2] * a[6];
+  if (det == 0)
+    return FALSE;
+
+  for (i = 0; i < 9; i++)
+    inv[i] = a[i] / det;
+  return TRUE;
+}
+
+void
+homography_apply (const gfloat *m, gfloat x, gfloat y,
+    gfloat *xdst, gfloat *ydst)
+{
+  gfloat w;
+
+  w = m[6] * x + m[7] * y + m[8];
+  /* point on the horizon line, keep it finite */
+  if (w == 0)
+    w = G_MINFLOAT;
+
+  *xdst = (m[0] * x + m[1] * y + m[2]) / w;
+  *ydst = (m[3] * x + m[4] * y + m[5]) / w;
+}
+
+/* Frames scaled by scale keep their pixel centres: x' = (x + 0.5) * scale
+ * - 0.5. The same mapping in scaled pixels is T m T^-1. */
+void
+homography_rescale (const gfloat *m, gfloat scale, gfloat *dst)
+{
+  gfloat o = (scale - 1) / 2;
+  gfloat t[9];
+  gint i;
+
+  /* m T^-1 */
+  for (i = 0; i < 3; i++) {
+    t[3 * i] = m[3 * i] / scale;
+    t[3 * i + 1] = m[3 * i + 1] / scale;
+    t[3 * i + 2] = m[3 * i + 2] - (m[3 * i] + m[3 * i + 1]) * o / scale;
+  }
+  /* T (m T^-1) */
+  for (i = 0; i < 3; i++) {
+    dst[i] = scale * t[i] + o * t[6 + i];
+    dst[3 + i] = scale * t[3 + i] + o * t[6 + i];
+    dst[6 + i] = t[6 + i];
+  }
+}
+
+/* "fx,fy,cx,cy,k1,k2,p1,p2", k2 p1 p2 may be omitted, "" disables */
+gboolean
+lens_model_parse (LensModel *lens, const gchar *str)
+{
+  LensModel l;
+  gint n;
+
+  memset (&l, 0, sizeof(l));
+  if (str == NULL || *str == '\0') {
+    *lens = l;
+    return TRUE;
+  }
+
+  n = sscanf (str, "%f,%f,%f,%f,%f,%f,%f,%f", &l.fx, &l.fy, &l.cx, &l.cy,
+      &l.k1, &l.k2, &l.p1, &l.p2);
+  if (n < 5 || l.fx == 0 || l.fy == 0)
+    return FALSE;
+
+  *lens = l;
+  return TRUE;
+}
+
+gchar *
+lens_model_to_string (const LensModel *lens)
+{
+  if (!lens_model_enabled (lens))
+    return g_strdup ("");
+
+  return g_strdup_printf ("%g,%g,%g,%g,%g,%g,%g,%g", lens->fx, lens->fy,
+      lens->cx, lens->cy, lens->k1, lens->k2, lens->p1, lens->p2);
+}
+
+gboolean
+lens_model_enabled (const LensModel *lens)
+{
+  return lens->fx != 0;
+}
+
+/* the same lens on frames scaled like homography_rescale, the distortion
+ * coefficients work on normalized coordinates and stay */
+void
+lens_model_rescale (const LensModel *lens, gfloat scale, LensModel *dst)
+{
+  gfloat o = (scale - 1) / 2;
+
+  *dst = *lens;
+  if (!lens_model_enabled (lens))
+    return;
+
+  dst->fx = lens->fx * scale;
+  dst->fy = lens->fy * scale;
+  dst->cx = lens->cx * scale + o;
+  dst->cy = lens->cy * scale + o;
+}
+
+/* pixel of an ideal pinhole camera to the distorted camera pixel */
+void
+lens_model_distort (const LensModel *lens, gfloat x, gfloat y,
+    gfloat *xdst, gfloat *ydst)
+{
+  gfloat xn, yn, r2, radial;
+
+  if (!lens_model_enabled (lens)) {
+    *xdst = x;
+    *ydst = y;
+    return;
+  }
+
+  xn = (x - lens->cx) / lens->fx;
+  yn = (y - lens->cy) / lens->fy;
+  r2 = xn * xn + yn * yn;
+  radial = 1 + (lens->k1 + lens->k2 * r2) * r2;
+
+  *xdst = (xn * radial + 2 * lens->p1 * xn * yn +
+      lens->p2 * (r2 + 2 * xn * xn)) * lens->fx + lens->cx;
+  *ydst = (yn * radial + lens->p1 * (r2 + 2 * yn * yn) +
+      2 * lens->p2 * xn * yn) * lens->fy + lens->cy;
+}
+
+/* distorted camera pixel to the pixel an ideal pinhole camera would see */
+void
+lens_model_undistort (const LensModel *lens, gfloat x, gfloat y,
+    gfloat *xdst, gfloat *ydst)
+{
+  gfloat x0, y0, xu, yu, r2, radial, dx, dy;
+  gint i;
+
+  if (!lens_model_enabled (lens)) {
+    *xdst = x;
+    *ydst = y;
+    return;
+  }
+
+  x0 = xu = (x - lens->cx) / lens->fx;
+  y0 = yu = (y - lens->cy) / lens->fy;
+
+  for (i = 0; i < UNDISTORT_ITERATIONS; i++) {
+    r2 = xu * xu + yu * yu;
+    radial = 1 + (lens->k1 + lens->k2 * r2) * r2;
+    dx = 2 * lens->p1 * xu * yu + lens->p2 * (r2 + 2 * xu * xu);
+    dy = lens->p1 * (r2 + 2 * yu * yu) + 2 * lens->p2 * xu * yu;
+    xu = (x0 - dx) / radial;
+    yu = (y0 - dy) / radial;
+  }
+
+  *xdst = xu * lens->fx + lens->cx;
+  *ydst = yu * lens->fy + lens->cy;
+}
+
+/* The undistortion iterations and the projective divide cost far more than
+ * finding the zones of a blob, precompute them once per frame size and
+ * parameter change instead of per centroid. */
+CoordLut *
+coord_lut_new (gint width, gint height, const LensModel *lens,
+    const gfloat *m)
+{
+  CoordLut *lut;
+  gfloat *p, xu, yu;
+  gint x, y;
+
+  lut = g_new (CoordLut, 1);
+  lut->width = width;
+  lut->height = height;
+  lut->xy = g_new (gfloat, 2 * width * height);
+
+  p = lut->xy;
+  for (y = 0; y < height; y++) {
+    for (x = 0; x < width; x++) {
+      lens_model_undistort (lens, x, y, &xu, &yu);
+      homography_apply (m, xu, yu, &p[0], &p[1]);
+      p += 2;
+    }
+  }
+
+  return lut;
+}
+
+void
+coord_lut_free (CoordLut *lut)
+{
+  if (lut == NULL)
+    return;
+
+  g_free (lut->xy);
+  g_free (lut);
+}
@@ -0,0 +1,101 @@
+/*
+ *  gst-tuio - Gstreamer to tuio computer vision plugin
+ *
+ *  Copyright (C) 2010 Keith Mok <ek9852@gmail.com>
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+
+#ifndef __COORD_MAP_H__
+#define __COORD_MAP_H__
+
+#include <glib.h>
+
+G_BEGIN_DECLS
+
+typedef struct _LensModel LensModel;
+typedef struct _CoordLut  CoordLut;
+
+/* Pinhole camera with Brown-Conrady distortion, the same parameters as
+ * OpenCV's camera matrix and (k1,k2,p1,p2) distortion coefficients.
+ * fx == 0 means no lens correction. */
+struct _LensModel
+{
+  gfloat fx, fy, cx, cy;
+  gfloat k1, k2, p1, p2;
+};
+
+/* Camera pixel to target coordinates for every pixel of a frame */
+struct _CoordLut
+{
+  gint width;
+  gint height;
+  gfloat *xy; /* x,y pairs, row major */
+};
+
+/* 3x3 row major homography, 6 coefficients are the affine top 2 rows */
+gboolean homography_parse (gfloat *m, const gchar *str);
+gchar *homography_to_string (const gfloat *m);
+void homography_identity (gfloat *m);
+gboolean homography_is_affine (const gfloat *m);
+gboolean homography_invert (const gfloat *m, gfloat *inv);
+void homography_apply (const gfloat *m, gfloat x, gfloat y,
+    gfloat *xdst, gfloat *ydst);
+void homography_rescale (const gfloat *m, gfloat scale, gfloat *dst);
+
+gboolean lens_model_parse (LensModel *lens, const gchar *str);
+gchar *lens_model_to_string (const LensModel *lens);
+gboolean lens_model_enabled (const LensModel *lens);
+void lens_model_rescale (const LensModel *lens, gfloat scale,
+    LensModel *dst);
+void lens_model_distort (const LensModel *lens, gfloat x, gfloat y,
+    gfloat *xdst, gfloat *ydst);
+void lens_model_undistort (const LensModel *lens, gfloat x, gfloat y,
+    gfloat *xdst, gfloat *ydst);
+
+CoordLut *coord_lut_new (gint width, gint height, const LensModel *lens,
+    const gfloat *m);
+void coord_lut_free (CoordLut *lut);
+
+/* bilinear between the 4 pixels around a sub-pixel position, the frame
+ * must be at least 2x2 */
+static inline void
+coord_lut_map (const CoordLut *lut, gfloat x, gfloat y, gfloat *xdst,
+    gfloat *ydst)
+{
+  const gfloat *p, *q;
+  gfloat fx, fy;
+  gint x0, y0;
+
+  x = CLAMP (x, 0, lut->width - 1);
+  y = CLAMP (y, 0, lut->height - 1);
+  x0 = MIN ((gint)x, lut->width - 2);
+  y0 = MIN ((gint)y, lut->height - 2);
+  fx = x - x0;
+  fy = y - y0;
+
+  p = lut->xy + 2 * (y0 * lut->width + x0);
+  q = p + 2 * lut->width;
+  *xdst = (p[0] * (1 - fx) + p[2] * fx) * (1 - fy) +
+      (q[0] * (1 - fx) + q[2] * fx) * fy;
+  *ydst = (p[1] * (1 - fx) + p[3] * fx) * (1 - fy) +
+      (q[1] * (1 - fx) + q[3] * fx) * fy;
+}
+
+G_END_DECLS
+
+#endif /* __COORD_MAP_H__ */
@@ -0,0 +1,315 @@
+/*
+ *  gst-tuio - Gstreamer to tuio computer vision plugin
+ *
+ *  Copyright (C) 2010 Keith Mok <ek9852@gmail.com>
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+
+#ifdef HAVE_CONFIG_H
+#  include <config.h>
+#endif
+
+#include <math.h>
+#include <glib.h>
+#include "fiducial.h"
+
+typedef struct _Region Region;
+
+/* connected component of either colour in the thresholded frame */
+struct _Region
+{
+  gint parent; /* enclosing region, -1 outside of the frame */
+  gint first_child;
+  gint next_sibling;
+  gint count;
+  gint64 sx, sy;
+  gint xstart, xend;
+  gint ystart, yend;
+  gboolean open; /* touches the frame border */
+};
+
+static gint
+bg_root (GArray *bgid, gint i)
+{
+  while (i != g_array_index (bgid, gint, i)) {
+    g_array_index (bgid, gint, i) =
+        g_array_index (bgid, gint, g_array_index (bgid, gint, i));
+    i = g_array_index (bgid, gint, i);
+  }
+  return i;
+}
+
+static void
+bg_unite (GArray *bgid, gint p, gint q)
+{
+  gint i = bg_root (bgid, p);
+  gint j = bg_root (bgid, q);
+
+  if (i != j)
+    g_array_index (bgid, gint, i) = j;
+}
+
+/* Background is labelled 4-connected, the complement of the 8-connected
+ * foreground of find_zones, so that regions nest into a tree. The labels
+ * go into markbuf as negative numbers, returns their union-find table
+ * (zero based). */
+static GArray *
+label_background (gint *markbuf, gint width, gint height)
+{
+  GArray *bgid;
+  gint x, y, left, up, id;
+  gint *m = markbuf;
+
+  bgid = g_array_new (FALSE, FALSE, sizeof(gint));
+
+  for (y = 0; y < height; y++) {
+    for (x = 0; x < width; x++, m++) {
+      if (*m > 0)
+        continue;
+
+      left = (x > 0 && m[-1] < 0) ? -m[-1] : 0;
+      up = (y > 0 && m[-width] < 0) ? -m[-width] : 0;
+      if (left) {
+        id = left;
+        if (up && up != left)
+          bg_unite (bgid, left - 1, up - 1);
+      } else if (up) {
+        id = up;
+      } else {
+        id = bgid->len;
+        g_array_append_val (bgid, id);
+        id++;
+      }
+      *m = -id;
+    }
+  }
+
+  return bgid;
+}
+
+/* All regions with their pixel sums and the region enclosing them. The
+ * pixel above the first pixel (in raster order) of a region always belongs
+ * to the region enclosing it: nothing of the region itself or of what it
+ * encloses can be above it. */
+static Region *
+build_regions (gint *markbuf, gint width, gint height, gint num_marks,
+    GArray *bgid, gint *ret_num_regions)
+{
+  Region *regions, *r;
+  gint *bg;
+  gint num_regions, x, y, i, id;
+
+  /* foreground marks first, then the background roots */
+  bg = g_new (gint, bgid->len);
+  for (i = 0; i < bgid->len; i++)
+    bg[i] = num_marks + bg_root (bgid, i);
+
+  num_regions = num_marks + bgid->len;
+  regions = g_new0 (Region, num_regions);
+
+  /* region index of every pixel, kept in the same buffer */
+  for (i = 0; i < width * height; i++) {
+    id = markbuf[i];
+    markbuf[i] = (id > 0) ? id - 1 : bg[-id - 1];
+  }
+  g_free (bg);
+
+  for (y = 0; y < height; y++) {
+    for (x = 0; x < width; x++) {
+      r = &regions[markbuf[y * width + x]];
+      if (r->count == 0) {
+        r->parent = (y > 0) ? markbuf[(y - 1) * width + x] : -1;
+        r->first_child = -1;
+        r->next_sibling = -1;
+        r->xstart = x;
+        r->xend = x;
+        r->ystart = y;
+        r->yend = y;
+      }
+      r->count++;
+      r->sx += x;
+      r->sy += y;
+      if (x < r->xstart)
+        r->xstart = x;
+      if (x > r->xend)
+        r->xend = x;
+      r->yend = y;
+      if ((x == 0) || (y == 0) || (x == width - 1) || (y == height - 1))
+        r->open = TRUE;
+    }
+  }
+
+  /* background touching the border is all outside of the frame */
+  for (i = num_marks; i < num_regions; i++) {
+    if (regions[i].open)
+      regions[i].parent = -1;
+  }
+  for (i = 0; i < num_regions; i++) {
+    r = &regions[i];
+    if ((r->count == 0) || (r->parent < 0))
+      continue;
+    r->next_sibling = regions[r->parent].first_child;
+    regions[r->parent].first_child = i;
+  }
+
+  *ret_num_regions = num_regions;
+  return regions;
+}
+
+/* checks the tree below root, fills the fiducial on a match */
+static gboolean
+match_fiducial (const Region *regions, const Region *root,
+    Fiducial *fiducial)
+{
+  const Region *branch, *leaf;
+  gint leaves[FIDUCIAL_MAX_BRANCHES];
+  gint num_branches = 0, num_leaves = 0;
+  gint64 sx, sy, lx, ly, lcount;
+  gint count, b, l, i, j, t;
+
+  sx = root->sx;
+  sy = root->sy;
+  count = root->count;
+  lx = ly = lcount = 0;
+
+  for (b = root->first_child; b >= 0; b = branch->next_sibling) {
+    branch = &regions[b];
+    if (num_branches == FIDUCIAL_MAX_BRANCHES)
+      return FALSE;
+
+    leaves[num_branches] = 0;
+    for (l = branch->first_child; l >= 0; l = leaf->next_sibling) {
+      leaf = &regions[l];
+      /* deeper trees are something else */
+      if ((leaf->first_child >= 0) ||
+          (leaves[num_branches] == FIDUCIAL_MAX_LEAVES))
+        return FALSE;
+      leaves[num_branches]++;
+      lx += leaf->sx;
+      ly += leaf->sy;
+      lcount += leaf->count;
+    }
+
+    sx += branch->sx;
+    sy += branch->sy;
+    count += branch->count;
+    num_leaves += leaves[num_branches];
+    num_branches++;
+  }
+
+  if ((num_branches < 2) || (num_leaves == 0))
+    return FALSE;
+
+  sx += lx;
+  sy += ly;
+  count += lcount;
+
+  /* branches by number of leaves, most first */
+  for (i = 1; i < num_branches; i++) {
+    t = leaves[i];
+    for (j = i; (j > 0) && (leaves[j - 1] < t); j--)
+      leaves[j] = leaves[j - 1];
+    leaves[j] = t;
+  }
+  fiducial->id = 0;
+  for (i = 0; i < num_branches; i++)
+    fiducial->id = (fiducial->id << 4) | (leaves[i] + 1);
+
+  fiducial->x = (gfloat)sx / count;
+  fiducial->y = (gfloat)sy / count;
+  fiducial->angle = atan2 ((gfloat)ly / lcount - fiducial->y,
+      (gfloat)lx / lcount - fiducial->x);
+  if (fiducial->angle < 0)
+    fiducial->angle += 2 * G_PI;
+  fiducial->size = count;
+  fiducial->xstart = root->xstart;
+  fiducial->xend = root->xend;
+  fiducial->ystart = root->ystart;
+  fiducial->yend = root->yend;
+
+  return TRUE;
+}
+
+/* Markers in the marks find_zones_regions left in markbuf, which is
+ * overwritten. Roots smaller than size_min pixels (with what they
+ * enclose) are ignored. The root may be of either colour, so markers
+ * work with trackdark as well. */
+void
+find_fiducials (gint *markbuf, gint width, gint height, gint num_marks,
+    gint size_min, GArray **ret_fiducials)
+{
+  GArray *fiducials;
+  GArray *bgid;
+  Region *regions;
+  Fiducial fiducial;
+  gint num_regions, i;
+
+  fiducials = g_array_new (FALSE, FALSE, sizeof(Fiducial));
+  *ret_fiducials = fiducials;
+  if ((width < 3) || (height < 3))
+    return;
+
+  bgid = label_background (markbuf, width, height);
+  regions = build_regions (markbuf, width, height, num_marks, bgid,
+      &num_regions);
+  g_array_free (bgid, TRUE);
+
+  for (i = 0; i < num_regions; i++) {
+    if ((regions[i].count == 0) || regions[i].open ||
+        (regions[i].first_child < 0))
+      continue;
+    if (match_fiducial (regions, &regions[i], &fiducial) &&
+        (fiducial.size >= size_min))
+      g_array_append_val (fiducials, fiducial);
+  }
+
+  g_free (regions);
+}
+
+/* coarse pixel x covers the full resolution pixels x*d .. x*d+d-1 */
+void
+fiducial_undecimate (Fiducial *fiducial, gint decimate)
+{
+  fiducial->x = (fiducial->x + 0.5f) * decimate - 0.5f;
+  fiducial->y = (fiducial->y + 0.5f) * decimate - 0.5f;
+  fiducial->size *= decimate * decimate;
+}
+
+/* The angle is carried over by a point on the marker edge in its
+ * direction, the size and bounding box stay in source pixels. */
+void
+fiducial_map (const Fiducial *fiducial, BlobMapFunc map, gpointer data,
+    Fiducial *dst)
+{
+  gfloat r, x, y, ax, ay;
+
+  r = sqrt (fiducial->size / G_PI);
+  if (r < 1)
+    r = 1;
+
+  map (data, fiducial->x, fiducial->y, &x, &y);
+  map (data, fiducial->x + r * cos (fiducial->angle),
+      fiducial->y + r * sin (fiducial->angle), &ax, &ay);
+
+  *dst = *fiducial;
+  dst->x = x;
+  dst->y = y;
+  dst->angle = atan2 (ay - y, ax - x);
+  if (dst->angle < 0)
+    dst->angle += 2 * G_PI;
+}
@@ -0,0 +1,67 @@
+/*
+ *  gst-tuio - Gstreamer to tuio computer vision plugin
+ *
+ *  Copyright (C) 2010 Keith Mok <ek9852@gmail.com>
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+
+#ifndef __FIDUCIAL_H__
+#define __FIDUCIAL_H__
+
+#include <glib.h>
+#include "blob_moments.h"
+
+G_BEGIN_DECLS
+
+/* limits of the class id encoding, one hex digit per branch */
+#define FIDUCIAL_MAX_BRANCHES 7
+#define FIDUCIAL_MAX_LEAVES 14
+
+typedef struct _Fiducial Fiducial;
+
+/* A marker found in the region adjacency tree of the thresholded frame:
+ * a closed root region enclosing at least 2 branch regions, which enclose
+ * nothing but leaf regions, at least one leaf in total.
+ *
+ * The class id has one hex digit per branch, its number of leaves plus
+ * one, branches sorted from the most leaves, e.g. 0x321 for branches with
+ * 2, 1 and 0 leaves. The position is the centroid of the root with
+ * everything it encloses, the angle in radian in [0, 2pi) points from
+ * there to the centroid of the leaves, so markers need their leaves off
+ * centre. */
+struct _Fiducial
+{
+  gint id;
+  gfloat x;
+  gfloat y;
+  gfloat angle;
+  gint size; /* pixels of the root and everything it encloses */
+  gint xstart, xend; /* bounding box of the root */
+  gint ystart, yend;
+};
+
+void find_fiducials (gint *markbuf, gint width, gint height, gint num_marks,
+    gint size_min, GArray **ret_fiducials);
+
+void fiducial_undecimate (Fiducial *fiducial, gint decimate);
+void fiducial_map (const Fiducial *fiducial, BlobMapFunc map, gpointer data,
+    Fiducial *dst);
+
+G_END_DECLS
+
+#endif /* __FIDUCIAL_H__ */
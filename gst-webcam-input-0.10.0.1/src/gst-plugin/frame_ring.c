@@ -0,0 +1,689 @@
+/*
+ *  gst-tuio - Gstreamer to tuio computer vision plugin
+ *
+ *  Copyright (C) 2010 Keith Mok <ek9852@gmail.com>
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+
+#ifdef HAVE_CONFIG_H
+#  include <config.h>
+#endif
+
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/syscall.h>
+#include <sys/un.h>
+#include <glib.h>
+#include <glib/gstdio.h>
+#include "frame_ring.h"
+
+#ifndef MFD_CLOEXEC
+#define MFD_CLOEXEC 0x0001U
+#endif
+
+/* how long a consumer waits for the fd, the producer only answers
+ * between two frames */
+#define CONNECT_TIMEOUT_MS 5000
+
+typedef struct _RingHeader RingHeader;
+typedef struct _RingSlot   RingSlot;
+
+/* both live in the shared memory, FRAME_RING_HEADER_SIZE and
+ * FRAME_RING_SLOT_HEADER_SIZE bytes */
+struct _RingHeader
+{
+  guint32 magic;
+  guint32 version;
+  gint32 width;
+  gint32 height;
+  gint32 stride;
+  gint32 bpp;
+  gint32 fps_n;
+  gint32 fps_d;
+  gint32 num_slots;
+  gint32 slot_size;
+  guint32 reserved[6];
+};
+
+/* seq is even once a frame is committed, odd while the producer writes
+ * it, 0 before the first frame. It wraps around, so only ever compare it
+ * for equality. */
+struct _RingSlot
+{
+  volatile guint32 seq;
+  volatile gint busy; /* consumers holding the slot */
+  guint32 size;
+  guint32 reserved0;
+  guint64 timestamp;
+  guint64 stage_ns[FRAME_RING_STAGES];
+};
+
+struct _FrameRingProducer
+{
+  FrameRingInfo info;
+  gchar *socket_path;
+
+  gint memfd;
+  gsize map_size;
+  guint8 *map;
+  RingSlot *slots;
+  guint8 *data;
+
+  gint listen_fd;
+  GArray *clients; /* connected sockets */
+
+  gint slot; /* acquired, -1 if none */
+  guint32 old_seq; /* of the acquired slot */
+  gint next;
+  guint32 seq;
+};
+
+struct _FrameRingConsumer
+{
+  volatile gint ref_count;
+  FrameRingInfo info;
+
+  gint fd;
+  gint wake[2]; /* readable while flushing */
+
+  gsize map_size;
+  guint8 *map; /* writable, header and slot headers */
+  RingSlot *slots;
+  gsize frames_size;
+  guint8 *frames; /* read only, the whole ring */
+  const guint8 *data;
+};
+
+/* g_atomic_int_* on the unsigned seq */
+#define SEQ_ATOMIC(slot) ((volatile gint *) &(slot)->seq)
+
+static void
+set_socket_error (GError **error, const gchar *what, const gchar *path)
+{
+  gint saved_errno = errno;
+
+  g_set_error (error, G_FILE_ERROR, g_file_error_from_errno (saved_errno),
+      "%s %s: %s", what, path, g_strerror (saved_errno));
+}
+
+static gboolean
+set_nonblock (gint fd)
+{
+  gint flags = fcntl (fd, F_GETFL);
+
+  return (flags >= 0) && (fcntl (fd, F_SETFL, flags | O_NONBLOCK) == 0);
+}
+
+static gboolean
+make_address (struct sockaddr_un *addr, const gchar *path, GError **error)
+{
+  memset (addr, 0, sizeof(*addr));
+  addr->sun_family = AF_UNIX;
+  if (strlen (path) >= sizeof(addr->sun_path)) {
+    g_set_error (error, G_FILE_ERROR, G_FILE_ERROR_NAMETOOLONG,
+        "Socket path %s is too long", path);
+    return FALSE;
+  }
+  strcpy (addr->sun_path, path);
+  return TRUE;
+}
+
+/* anonymous memory file, a tmp file unlinked right away on kernels
+ * without memfd_create */
+static gint
+create_shared_memory (gsize size, GError **error)
+{
+  gchar *name = NULL;
+  gint fd = -1;
+
+#ifdef SYS_memfd_create
+  fd = syscall (SYS_memfd_create, "frame_ring", MFD_CLOEXEC);
+#endif
+  if (fd < 0) {
+    fd = g_file_open_tmp ("frame_ring-XXXXXX", &name, error);
+    if (fd < 0)
+      return -1;
+    g_unlink (name);
+    g_free (name);
+    fcntl (fd, F_SETFD, FD_CLOEXEC);
+  }
+
+  if (ftruncate (fd, size) < 0) {
+    set_socket_error (error, "Cannot size", "frame ring memory");
+    close (fd);
+    return -1;
+  }
+  return fd;
+}
+
+static gsize
+ring_map_size (const FrameRingInfo *info)
+{
+  return FRAME_RING_HEADER_SIZE +
+      (gsize) info->num_slots * FRAME_RING_SLOT_HEADER_SIZE +
+      (gsize) info->num_slots * info->slot_size;
+}
+
+static gboolean
+send_fd (gint sock, gint fd)
+{
+  struct msghdr msg;
+  struct iovec iov;
+  struct cmsghdr *cmsg;
+  guint32 magic = FRAME_RING_MAGIC;
+  union
+  {
+    struct cmsghdr align;
+    gchar buf[CMSG_SPACE (sizeof(gint))];
+  } control;
+
+  memset (&msg, 0, sizeof(msg));
+  memset (&control, 0, sizeof(control));
+  iov.iov_base = &magic;
+  iov.iov_len = sizeof(magic);
+  msg.msg_iov = &iov;
+  msg.msg_iovlen = 1;
+  msg.msg_control = control.buf;
+  msg.msg_controllen = sizeof(control.buf);
+
+  cmsg = CMSG_FIRSTHDR (&msg);
+  cmsg->cmsg_level = SOL_SOCKET;
+  cmsg->cmsg_type = SCM_RIGHTS;
+  cmsg->cmsg_len = CMSG_LEN (sizeof(gint));
+  memcpy (CMSG_DATA (cmsg), &fd, sizeof(gint));
+
+  return sendmsg (sock, &msg, MSG_NOSIGNAL) == sizeof(magic);
+}
+
+static gint
+receive_fd (gint sock)
+{
+  struct msghdr msg;
+  struct iovec iov;
+  struct cmsghdr *cmsg;
+  guint32 magic = 0;
+  gint fd = -1;
+  union
+  {
+    struct cmsghdr align;
+    gchar buf[CMSG_SPACE (sizeof(gint))];
+  } control;
+
+  memset (&msg, 0, sizeof(msg));
+  iov.iov_base = &magic;
+  iov.iov_len = sizeof(magic);
+  msg.msg_iov = &iov;
+  msg.msg_iovlen = 1;
+  msg.msg_control = control.buf;
+  msg.msg_controllen = sizeof(control.buf);
+
+  if (recvmsg (sock, &msg, MSG_CMSG_CLOEXEC) != sizeof(magic))
+    return -1;
+
+  for (cmsg = CMSG_FIRSTHDR (&msg); cmsg; cmsg = CMSG_NXTHDR (&msg, cmsg)) {
+    if ((cmsg->cmsg_level == SOL_SOCKET) && (cmsg->cmsg_type == SCM_RIGHTS))
+      memcpy (&fd, CMSG_DATA (cmsg), sizeof(gint));
+  }
+  if ((magic != FRAME_RING_MAGIC) && (fd >= 0)) {
+    close (fd);
+    fd = -1;
+  }
+  return fd;
+}
+
+FrameRingProducer *
+frame_ring_producer_new (const gchar *socket_path, const FrameRingInfo *info,
+    GError **error)
+{
+  FrameRingProducer *ring;
+  struct sockaddr_un addr;
+  RingHeader *header;
+
+  g_return_val_if_fail (socket_path != NULL, NULL);
+  g_return_val_if_fail (info->width > 0 && info->height > 0, NULL);
+  g_return_val_if_fail (info->bpp == 8 || info->bpp == 16, NULL);
+
+  if (!make_address (&addr, socket_path, error))
+    return NULL;
+
+  ring = g_new0 (FrameRingProducer, 1);
+  ring->info = *info;
+  /* rows 4 byte aligned, as GStreamer expects of raw video */
+  if (ring->info.stride < ((info->width * info->bpp / 8 + 3) & ~3))
+    ring->info.stride = (info->width * info->bpp / 8 + 3) & ~3;
+  if (ring->info.num_slots <= 0)
+    ring->info.num_slots = FRAME_RING_DEFAULT_SLOTS;
+  ring->info.slot_size = (ring->info.stride * ring->info.height + 63) & ~63;
+  ring->socket_path = g_strdup (socket_path);
+  ring->memfd = -1;
+  ring->listen_fd = -1;
+  ring->map = MAP_FAILED;
+  ring->clients = g_array_new (FALSE, FALSE, sizeof(gint));
+  ring->slot = -1;
+
+  ring->map_size = ring_map_size (&ring->info);
+  ring->memfd = create_shared_memory (ring->map_size, error);
+  if (ring->memfd < 0)
+    goto failed;
+  ring->map = mmap (NULL, ring->map_size, PROT_READ | PROT_WRITE,
+      MAP_SHARED, ring->memfd, 0);
+  if (ring->map == MAP_FAILED) {
+    set_socket_error (error, "Cannot map", "frame ring memory");
+    goto failed;
+  }
+  ring->slots = (RingSlot *) (ring->map + FRAME_RING_HEADER_SIZE);
+  ring->data = ring->map + FRAME_RING_HEADER_SIZE +
+      ring->info.num_slots * FRAME_RING_SLOT_HEADER_SIZE;
+
+  header = (RingHeader *) ring->map;
+  header->magic = FRAME_RING_MAGIC;
+  header->version = FRAME_RING_VERSION;
+  header->width = ring->info.width;
+  header->height = ring->info.height;
+  header->stride = ring->info.stride;
+  header->bpp = ring->info.bpp;
+  header->fps_n = ring->info.fps_n;
+  header->fps_d = ring->info.fps_d;
+  header->num_slots = ring->info.num_slots;
+  header->slot_size = ring->info.slot_size;
+
+  ring->listen_fd = socket (AF_UNIX, SOCK_SEQPACKET, 0);
+  if (ring->listen_fd < 0) {
+    set_socket_error (error, "Cannot create socket", socket_path);
+    goto failed;
+  }
+  fcntl (ring->listen_fd, F_SETFD, FD_CLOEXEC);
+  /* left over by a producer that died */
+  g_unlink (socket_path);
+  if ((bind (ring->listen_fd, (struct sockaddr *) &addr, sizeof(addr)) < 0) ||
+      (listen (ring->listen_fd, 8) < 0) || !set_nonblock (ring->listen_fd)) {
+    set_socket_error (error, "Cannot listen on", socket_path);
+    goto failed;
+  }
+
+  return ring;
+
+failed:
+  frame_ring_producer_free (ring);
+  return NULL;
+}
+
+void
+frame_ring_producer_free (FrameRingProducer *ring)
+{
+  gint i;
+
+  if (!ring)
+    return;
+
+  for (i = 0; i < ring->clients->len; i++)
+    close (g_array_index (ring->clients, gint, i));
+  g_array_free (ring->clients, TRUE);
+
+  if (ring->listen_fd >= 0) {
+    close (ring->listen_fd);
+    g_unlink (ring->socket_path);
+  }
+  if (ring->map != MAP_FAILED)
+    munmap (ring->map, ring->map_size);
+  if (ring->memfd >= 0)
+    close (ring->memfd);
+
+  g_free (ring->socket_path);
+  g_free (ring);
+}
+
+static void
+remove_client (FrameRingProducer *ring, gint i)
+{
+  gint n;
+
+  close (g_array_index (ring->clients, gint, i));
+  g_array_remove_index_fast (ring->clients, i);
+
+  /* slots held by a consumer that went away are never released */
+  if (ring->clients->len == 0) {
+    for (n = 0; n < ring->info.num_slots; n++)
+      g_atomic_int_set (&ring->slots[n].busy, 0);
+  }
+}
+
+static void
+accept_clients (FrameRingProducer *ring)
+{
+  gint fd;
+
+  while ((fd = accept (ring->listen_fd, NULL, NULL)) >= 0) {
+    fcntl (fd, F_SETFD, FD_CLOEXEC);
+    if (!set_nonblock (fd) || !send_fd (fd, ring->memfd)) {
+      close (fd);
+      continue;
+    }
+    g_array_append_val (ring->clients, fd);
+  }
+}
+
+/* Slot to write the next frame into, NULL when every slot is held by a
+ * consumer and the frame has to be dropped. Marking the slot odd before
+ * looking at busy, while a consumer raises busy before looking at seq,
+ * means one of the two always sees the other. */
+guint8 *
+frame_ring_producer_acquire (FrameRingProducer *ring)
+{
+  RingSlot *slot;
+  guint32 old;
+  gint i, n;
+
+  if (ring->slot >= 0)
+    return ring->data + (gsize) ring->slot * ring->info.slot_size;
+
+  accept_clients (ring);
+
+  for (i = 0; i < ring->info.num_slots; i++) {
+    n = (ring->next + i) % ring->info.num_slots;
+    slot = &ring->slots[n];
+    old = g_atomic_int_get (SEQ_ATOMIC (slot));
+    g_atomic_int_compare_and_exchange (SEQ_ATOMIC (slot), old, old | 1);
+    if (g_atomic_int_get (&slot->busy) == 0) {
+      ring->slot = n;
+      ring->old_seq = old;
+      memset (slot->stage_ns, 0, sizeof(slot->stage_ns));
+      return ring->data + (gsize) n * ring->info.slot_size;
+    }
+    g_atomic_int_compare_and_exchange (SEQ_ATOMIC (slot), old | 1, old);
+  }
+  return NULL;
+}
+
+/* of the frame acquired, call before committing it */
+void
+frame_ring_producer_set_stage_time (FrameRingProducer *ring,
+    FrameRingStage stage, guint64 ns)
+{
+  g_return_if_fail (stage < FRAME_RING_STAGES);
+
+  if (ring->slot >= 0)
+    ring->slots[ring->slot].stage_ns[stage] = ns;
+}
+
+void
+frame_ring_producer_commit (FrameRingProducer *ring, guint64 timestamp)
+{
+  FrameRingNotify notify;
+  RingSlot *slot;
+  gint i;
+
+  if (ring->slot < 0)
+    return;
+
+  slot = &ring->slots[ring->slot];
+  ring->seq += 2;
+  if (ring->seq == 0)
+    ring->seq = 2;
+  slot->timestamp = timestamp;
+  slot->size = ring->info.stride * ring->info.height;
+  g_atomic_int_compare_and_exchange (SEQ_ATOMIC (slot), ring->old_seq | 1,
+      ring->seq);
+
+  notify.slot = ring->slot;
+  notify.seq = ring->seq;
+  for (i = ring->clients->len - 1; i >= 0; i--) {
+    /* a consumer too slow to read its notifications misses frames */
+    if ((send (g_array_index (ring->clients, gint, i), &notify,
+                sizeof(notify), MSG_DONTWAIT | MSG_NOSIGNAL) < 0) &&
+        (errno != EAGAIN) && (errno != EWOULDBLOCK) && (errno != EINTR))
+      remove_client (ring, i);
+  }
+
+  ring->next = (ring->slot + 1) % ring->info.num_slots;
+  ring->slot = -1;
+}
+
+FrameRingConsumer *
+frame_ring_consumer_new (const gchar *socket_path, GError **error)
+{
+  FrameRingConsumer *ring;
+  struct sockaddr_un addr;
+  struct pollfd pfd;
+  RingHeader *header;
+  gint memfd;
+
+  g_return_val_if_fail (socket_path != NULL, NULL);
+
+  if (!make_address (&addr, socket_path, error))
+    return NULL;
+
+  ring = g_new0 (FrameRingConsumer, 1);
+  ring->ref_count = 1;
+  ring->wake[0] = ring->wake[1] = -1;
+  ring->map = MAP_FAILED;
+  ring->frames = MAP_FAILED;
+
+  ring->fd = socket (AF_UNIX, SOCK_SEQPACKET, 0);
+  if (ring->fd < 0) {
+    set_socket_error (error, "Cannot create socket", socket_path);
+    goto failed;
+  }
+  fcntl (ring->fd, F_SETFD, FD_CLOEXEC);
+  if (connect (ring->fd, (struct sockaddr *) &addr, sizeof(addr)) < 0) {
+    set_socket_error (error, "Cannot connect to", socket_path);
+    goto failed;
+  }
+
+  pfd.fd = ring->fd;
+  pfd.events = POLLIN;
+  if (poll (&pfd, 1, CONNECT_TIMEOUT_MS) <= 0) {
+    g_set_error (error, G_FILE_ERROR, G_FILE_ERROR_AGAIN,
+        "No frames from %s", socket_path);
+    goto failed;
+  }
+  memfd = receive_fd (ring->fd);
+  if (memfd < 0) {
+    g_set_error (error, G_FILE_ERROR, G_FILE_ERROR_INVAL,
+        "%s is not a frame ring", socket_path);
+    goto failed;
+  }
+
+  /* the header first, it has the size of everything */
+  header = mmap (NULL, FRAME_RING_HEADER_SIZE, PROT_READ, MAP_SHARED, memfd,
+      0);
+  if (header == MAP_FAILED) {
+    set_socket_error (error, "Cannot map frame ring of", socket_path);
+    close (memfd);
+    goto failed;
+  }
+  ring->info.width = header->width;
+  ring->info.height = header->height;
+  ring->info.stride = header->stride;
+  ring->info.bpp = header->bpp;
+  ring->info.fps_n = header->fps_n;
+  ring->info.fps_d = header->fps_d;
+  ring->info.num_slots = header->num_slots;
+  ring->info.slot_size = header->slot_size;
+  if ((header->magic != FRAME_RING_MAGIC) ||
+      (header->version != FRAME_RING_VERSION) ||
+      (ring->info.num_slots <= 0) ||
+      (ring->info.slot_size < ring->info.stride * ring->info.height)) {
+    g_set_error (error, G_FILE_ERROR, G_FILE_ERROR_INVAL,
+        "%s is not a frame ring", socket_path);
+    munmap (header, FRAME_RING_HEADER_SIZE);
+    close (memfd);
+    goto failed;
+  }
+  munmap (header, FRAME_RING_HEADER_SIZE);
+
+  /* the slot headers writable for the busy counts, the frames read only
+   * so a buffer written to downstream can not scribble over the ring */
+  ring->map_size = FRAME_RING_HEADER_SIZE +
+      (gsize) ring->info.num_slots * FRAME_RING_SLOT_HEADER_SIZE;
+  ring->map = mmap (NULL, ring->map_size, PROT_READ | PROT_WRITE, MAP_SHARED,
+      memfd, 0);
+  ring->frames_size = ring_map_size (&ring->info);
+  ring->frames = mmap (NULL, ring->frames_size, PROT_READ, MAP_SHARED, memfd,
+      0);
+  close (memfd);
+  if ((ring->map == MAP_FAILED) || (ring->frames == MAP_FAILED)) {
+    set_socket_error (error, "Cannot map frame ring of", socket_path);
+    goto failed;
+  }
+  ring->slots = (RingSlot *) (ring->map + FRAME_RING_HEADER_SIZE);
+  ring->data = ring->frames + ring->map_size;
+
+  if (pipe (ring->wake) < 0) {
+    set_socket_error (error, "Cannot create pipe for", socket_path);
+    goto failed;
+  }
+  set_nonblock (ring->wake[0]);
+  set_nonblock (ring->wake[1]);
+
+  return ring;
+
+failed:
+  frame_ring_consumer_unref (ring);
+  return NULL;
+}
+
+FrameRingConsumer *
+frame_ring_consumer_ref (FrameRingConsumer *ring)
+{
+  g_atomic_int_inc (&ring->ref_count);
+  return ring;
+}
+
+/* every frame handed out holds a reference, the memory stays mapped
+ * until the last one is released */
+void
+frame_ring_consumer_unref (FrameRingConsumer *ring)
+{
+  if (!g_atomic_int_dec_and_test (&ring->ref_count))
+    return;
+
+  if (ring->wake[0] >= 0)
+    close (ring->wake[0]);
+  if (ring->wake[1] >= 0)
+    close (ring->wake[1]);
+  if (ring->map != MAP_FAILED)
+    munmap (ring->map, ring->map_size);
+  if (ring->frames != MAP_FAILED)
+    munmap (ring->frames, ring->frames_size);
+  if (ring->fd >= 0)
+    close (ring->fd);
+  g_free (ring);
+}
+
+const FrameRingInfo *
+frame_ring_consumer_get_info (FrameRingConsumer *ring)
+{
+  return &ring->info;
+}
+
+/* Blocks for the next frame and holds its slot, returns the slot to pass
+ * to frame_ring_consumer_release. Older frames still queued are skipped,
+ * the newest is the one worth processing. Returns -1 when flushing, or
+ * with error set when the producer went away. */
+gint
+frame_ring_consumer_wait (FrameRingConsumer *ring, const guint8 **data,
+    guint64 *timestamp, GError **error)
+{
+  FrameRingNotify notify, next;
+  struct pollfd pfd[2];
+  RingSlot *slot;
+  gssize len;
+
+  for (;;) {
+    pfd[0].fd = ring->fd;
+    pfd[0].events = POLLIN;
+    pfd[0].revents = 0;
+    pfd[1].fd = ring->wake[0];
+    pfd[1].events = POLLIN;
+    pfd[1].revents = 0;
+    if (poll (pfd, 2, -1) < 0) {
+      if (errno == EINTR)
+        continue;
+      set_socket_error (error, "Cannot wait for", "frames");
+      return -1;
+    }
+    if (pfd[1].revents)
+      return -1;
+
+    len = recv (ring->fd, &notify, sizeof(notify), MSG_DONTWAIT);
+    if ((len < 0) && ((errno == EAGAIN) || (errno == EINTR)))
+      continue;
+    if (len != sizeof(notify)) {
+      g_set_error (error, G_FILE_ERROR, G_FILE_ERROR_IO,
+          "Frame producer went away");
+      return -1;
+    }
+    while (recv (ring->fd, &next, sizeof(next), MSG_DONTWAIT) ==
+        sizeof(next))
+      notify = next;
+
+    if (notify.slot >= ring->info.num_slots)
+      continue;
+    slot = &ring->slots[notify.slot];
+    g_atomic_int_inc (&slot->busy);
+    if ((guint32) g_atomic_int_get (SEQ_ATOMIC (slot)) == notify.seq)
+      break;
+    /* overwritten already */
+    g_atomic_int_add (&slot->busy, -1);
+  }
+
+  *data = ring->data + (gsize) notify.slot * ring->info.slot_size;
+  if (timestamp)
+    *timestamp = slot->timestamp;
+  return notify.slot;
+}
+
+/* FRAME_RING_STAGES times of a held slot, 0 for untimed stages */
+void
+frame_ring_consumer_get_stage_times (FrameRingConsumer *ring, gint slot,
+    guint64 *stage_ns)
+{
+  g_return_if_fail (slot >= 0 && slot < ring->info.num_slots);
+
+  memcpy (stage_ns, ring->slots[slot].stage_ns,
+      sizeof(ring->slots[slot].stage_ns));
+}
+
+void
+frame_ring_consumer_release (FrameRingConsumer *ring, gint slot)
+{
+  g_return_if_fail (slot >= 0 && slot < ring->info.num_slots);
+
+  g_atomic_int_add (&ring->slots[slot].busy, -1);
+}
+
+/* wakes frame_ring_consumer_wait up and keeps it from blocking until
+ * flushing is turned off again */
+void
+frame_ring_consumer_set_flushing (FrameRingConsumer *ring, gboolean flushing)
+{
+  gchar c = 0;
+
+  if (flushing) {
+    if (write (ring->wake[1], &c, 1) < 0)
+      return;
+  } else {
+    while (read (ring->wake[0], &c, 1) > 0);
+  }
+}
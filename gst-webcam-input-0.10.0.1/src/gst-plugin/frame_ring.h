@@ -0,0 +1,117 @@
+/*
+ *  gst-tuio - Gstreamer to tuio computer vision plugin
+ *
+ *  Copyright (C) 2010 Keith Mok <ek9852@gmail.com>
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+
+#ifndef __FRAME_RING_H__
+#define __FRAME_RING_H__
+
+#include <glib.h>
+
+G_BEGIN_DECLS
+
+/* Ring of frame slots in one shared memory file (memfd), handed from a
+ * capture process (e.g. a libfreenect2 frame listener) to ringsrc with no
+ * copy. The producer listens on a unix seqpacket socket, every consumer
+ * connecting gets the memory fd once (SCM_RIGHTS) and then one
+ * FrameRingNotify per committed frame. Only depends on glib, so capture
+ * programs can link it directly.
+ *
+ *   header     FRAME_RING_HEADER_SIZE bytes, see FrameRingInfo
+ *   slots      num_slots slot headers of FRAME_RING_SLOT_HEADER_SIZE
+ *   data       num_slots frames of slot_size bytes, 64 byte aligned
+ *
+ * A consumer holds a slot by raising its busy count, the producer never
+ * writes into a busy slot and drops the frame when all slots are busy.
+ * Consumers map the frames read only.
+ * Busy counts are reset when the last consumer disconnects.
+ *
+ * The producer calls acquire, writes the frame into the slot returned and
+ * commits it, all from its capture thread; nothing blocks. Timestamps are
+ * CLOCK_MONOTONIC nanoseconds of the capture, like stage_stats_now, and
+ * the time each capture stage took can go along with the frame. */
+
+#define FRAME_RING_MAGIC 0x474e5246 /* "FRNG" */
+#define FRAME_RING_VERSION 1
+#define FRAME_RING_HEADER_SIZE 64
+#define FRAME_RING_SLOT_HEADER_SIZE 64
+#define FRAME_RING_DEFAULT_SLOTS 4
+
+/* capture stages the producer may time for every frame, untimed stages
+ * are left at 0 */
+typedef enum
+{
+  FRAME_RING_STAGE_USB, /* USB transfers of the packet */
+  FRAME_RING_STAGE_PARSER, /* stream parser assembling the packet */
+  FRAME_RING_STAGE_RGB, /* colour decode */
+  FRAME_RING_STAGE_DEPTH, /* depth decode */
+  FRAME_RING_STAGE_DELIVERY, /* frame listener delivery */
+  FRAME_RING_STAGES
+} FrameRingStage;
+
+typedef struct _FrameRingInfo     FrameRingInfo;
+typedef struct _FrameRingNotify   FrameRingNotify;
+typedef struct _FrameRingProducer FrameRingProducer;
+typedef struct _FrameRingConsumer FrameRingConsumer;
+
+struct _FrameRingInfo
+{
+  gint width;
+  gint height;
+  gint stride; /* bytes per row */
+  gint bpp; /* 8 grey or 16 depth, little endian */
+  gint fps_n;
+  gint fps_d;
+  gint num_slots;
+  gint slot_size;
+};
+
+/* sent for every committed frame, seq tells a reused slot apart */
+struct _FrameRingNotify
+{
+  guint32 slot;
+  guint32 seq;
+};
+
+FrameRingProducer *frame_ring_producer_new (const gchar *socket_path,
+    const FrameRingInfo *info, GError **error);
+void frame_ring_producer_free (FrameRingProducer *ring);
+guint8 *frame_ring_producer_acquire (FrameRingProducer *ring);
+void frame_ring_producer_set_stage_time (FrameRingProducer *ring,
+    FrameRingStage stage, guint64 ns);
+void frame_ring_producer_commit (FrameRingProducer *ring,
+    guint64 timestamp);
+
+FrameRingConsumer *frame_ring_consumer_new (const gchar *socket_path,
+    GError **error);
+FrameRingConsumer *frame_ring_consumer_ref (FrameRingConsumer *ring);
+void frame_ring_consumer_unref (FrameRingConsumer *ring);
+const FrameRingInfo *frame_ring_consumer_get_info (FrameRingConsumer *ring);
+gint frame_ring_consumer_wait (FrameRingConsumer *ring, const guint8 **data,
+    guint64 *timestamp, GError **error);
+void frame_ring_consumer_get_stage_times (FrameRingConsumer *ring,
+    gint slot, guint64 *stage_ns);
+void frame_ring_consumer_release (FrameRingConsumer *ring, gint slot);
+void frame_ring_consumer_set_flushing (FrameRingConsumer *ring,
+    gboolean flushing);
+
+G_END_DECLS
+
+#endif /* __FRAME_RING_H__ */
@@ -0,0 +1,357 @@
+/*
+ *  gst-tuio - Gstreamer to tuio computer vision plugin
+ *
+ *  Copyright (C) 2010 Keith Mok <ek9852@gmail.com>
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+
+#ifdef HAVE_CONFIG_H
+#  include <config.h>
+#endif
+
+#include <errno.h>
+#include <stdio.h>
+#include <string.h>
+#include "gray_capture.h"
+
+struct _GrayCaptureWriter
+{
+  FILE *file;
+  gchar *filename;
+  GrayCaptureInfo info;
+  gsize frame_size;
+  GArray *index; /* record offset, timestamp pairs */
+  guint8 *padding;
+};
+
+struct _GrayCaptureReader
+{
+  GMappedFile *file;
+  const guint8 *data;
+  gsize size;
+  GrayCaptureInfo info;
+  gsize frame_size;
+  guint64 *timestamps;
+};
+
+static void
+put_u32 (guint8 *p, guint32 v)
+{
+  v = GUINT32_TO_LE (v);
+  memcpy (p, &v, sizeof (v));
+}
+
+static void
+put_u64 (guint8 *p, guint64 v)
+{
+  v = GUINT64_TO_LE (v);
+  memcpy (p, &v, sizeof (v));
+}
+
+static guint32
+get_u32 (const guint8 *p)
+{
+  guint32 v;
+  memcpy (&v, p, sizeof (v));
+  return GUINT32_FROM_LE (v);
+}
+
+static guint64
+get_u64 (const guint8 *p)
+{
+  guint64 v;
+  memcpy (&v, p, sizeof (v));
+  return GUINT64_FROM_LE (v);
+}
+
+static gsize
+frame_size_for (gint stride, gint height)
+{
+  gsize size = GRAY_CAPTURE_RECORD_HEADER_SIZE + (gsize) stride * height;
+  return (size + 7) & ~((gsize) 7);
+}
+
+static void
+set_io_error (GError **error, const gchar *what, const gchar *filename)
+{
+  gint saved_errno = errno;
+
+  g_set_error (error, G_FILE_ERROR, g_file_error_from_errno (saved_errno),
+      "%s %s: %s", what, filename, g_strerror (saved_errno));
+}
+
+static gboolean
+write_header (GrayCaptureWriter *writer, guint64 index_offset)
+{
+  guint8 header[GRAY_CAPTURE_HEADER_SIZE];
+
+  memset (header, 0, sizeof (header));
+  memcpy (header, GRAY_CAPTURE_MAGIC, 8);
+  put_u32 (header + 8, GRAY_CAPTURE_VERSION);
+  put_u32 (header + 12, GRAY_CAPTURE_HEADER_SIZE);
+  put_u32 (header + 16, writer->info.width);
+  put_u32 (header + 20, writer->info.height);
+  put_u32 (header + 24, writer->info.stride);
+  put_u32 (header + 28, writer->frame_size);
+  put_u32 (header + 32, writer->info.fps_n);
+  put_u32 (header + 36, writer->info.fps_d);
+  put_u64 (header + 40, writer->info.num_frames);
+  put_u64 (header + 48, index_offset);
+
+  return fwrite (header, sizeof (header), 1, writer->file) == 1;
+}
+
+GrayCaptureWriter *
+gray_capture_writer_new (const gchar *filename, gint width, gint height,
+    gint fps_n, gint fps_d, GError **error)
+{
+  GrayCaptureWriter *writer;
+
+  g_return_val_if_fail ((width > 0) && (height > 0), NULL);
+
+  writer = g_new0 (GrayCaptureWriter, 1);
+  writer->filename = g_strdup (filename);
+  writer->info.width = width;
+  writer->info.height = height;
+  writer->info.stride = width;
+  writer->info.fps_n = fps_n;
+  writer->info.fps_d = fps_d;
+  writer->frame_size = frame_size_for (width, height);
+  writer->index = g_array_new (FALSE, FALSE, 2 * sizeof (guint64));
+  writer->padding = g_malloc0 (8);
+
+  writer->file = fopen (filename, "wb");
+  if (!writer->file || !write_header (writer, 0)) {
+    set_io_error (error, "Cannot write", filename);
+    if (writer->file)
+      fclose (writer->file);
+    g_array_free (writer->index, TRUE);
+    g_free (writer->padding);
+    g_free (writer->filename);
+    g_free (writer);
+    return NULL;
+  }
+  return writer;
+}
+
+gboolean
+gray_capture_writer_add (GrayCaptureWriter *writer, const guint8 *data,
+    gint stride, guint64 timestamp, guint64 duration, GError **error)
+{
+  guint8 record[GRAY_CAPTURE_RECORD_HEADER_SIZE];
+  guint64 entry[2];
+  gsize pad;
+  gint y;
+
+  entry[0] = GRAY_CAPTURE_HEADER_SIZE +
+      writer->info.num_frames * writer->frame_size;
+  entry[1] = timestamp;
+
+  put_u64 (record, timestamp);
+  put_u64 (record + 8, duration);
+  if (fwrite (record, sizeof (record), 1, writer->file) != 1)
+    goto write_error;
+
+  for (y = 0; y < writer->info.height; y++) {
+    if (fwrite (data + y * stride, writer->info.width, 1, writer->file) != 1)
+      goto write_error;
+  }
+
+  pad = writer->frame_size - GRAY_CAPTURE_RECORD_HEADER_SIZE -
+      (gsize) writer->info.width * writer->info.height;
+  if (pad && (fwrite (writer->padding, pad, 1, writer->file) != 1))
+    goto write_error;
+
+  g_array_append_val (writer->index, entry);
+  writer->info.num_frames++;
+  return TRUE;
+
+write_error:
+  set_io_error (error, "Cannot write", writer->filename);
+  return FALSE;
+}
+
+/* append the index, fill in the header and free the writer */
+gboolean
+gray_capture_writer_close (GrayCaptureWriter *writer, GError **error)
+{
+  guint8 entry[2 * sizeof (guint64)];
+  guint64 index_offset, *e;
+  gboolean ok = TRUE;
+  guint i;
+
+  index_offset = GRAY_CAPTURE_HEADER_SIZE +
+      writer->info.num_frames * writer->frame_size;
+
+  for (i = 0; ok && (i < writer->index->len); i++) {
+    e = (guint64 *) (writer->index->data + i * 2 * sizeof (guint64));
+    put_u64 (entry, e[0]);
+    put_u64 (entry + 8, e[1]);
+    ok = fwrite (entry, sizeof (entry), 1, writer->file) == 1;
+  }
+  if (ok)
+    ok = (fseek (writer->file, 0, SEEK_SET) == 0) &&
+        write_header (writer, index_offset);
+  if (!ok)
+    set_io_error (error, "Cannot write", writer->filename);
+
+  if ((fclose (writer->file) != 0) && ok) {
+    set_io_error (error, "Cannot close", writer->filename);
+    ok = FALSE;
+  }
+
+  g_array_free (writer->index, TRUE);
+  g_free (writer->padding);
+  g_free (writer->filename);
+  g_free (writer);
+  return ok;
+}
+
+GrayCaptureReader *
+gray_capture_reader_new (const gchar *filename, GError **error)
+{
+  GrayCaptureReader *reader;
+  const guint8 *h;
+  guint64 index_offset, n;
+
+  reader = g_new0 (GrayCaptureReader, 1);
+  reader->file = g_mapped_file_new (filename, FALSE, error);
+  if (!reader->file) {
+    g_free (reader);
+    return NULL;
+  }
+  reader->data = (const guint8 *) g_mapped_file_get_contents (reader->file);
+  reader->size = g_mapped_file_get_length (reader->file);
+
+  h = reader->data;
+  if ((reader->size < GRAY_CAPTURE_HEADER_SIZE) ||
+      memcmp (h, GRAY_CAPTURE_MAGIC, 8) ||
+      (get_u32 (h + 8) != GRAY_CAPTURE_VERSION))
+    goto invalid;
+
+  reader->info.width = get_u32 (h + 16);
+  reader->info.height = get_u32 (h + 20);
+  reader->info.stride = get_u32 (h + 24);
+  reader->frame_size = get_u32 (h + 28);
+  reader->info.fps_n = get_u32 (h + 32);
+  reader->info.fps_d = get_u32 (h + 36);
+  reader->info.num_frames = get_u64 (h + 40);
+  index_offset = get_u64 (h + 48);
+
+  if ((get_u32 (h + 12) != GRAY_CAPTURE_HEADER_SIZE) ||
+      (reader->info.width <= 0) || (reader->info.height <= 0) ||
+      (reader->info.stride < reader->info.width) ||
+      (reader->frame_size !=
+          frame_size_for (reader->info.stride, reader->info.height)))
+    goto invalid;
+
+  if ((index_offset < GRAY_CAPTURE_HEADER_SIZE) ||
+      (index_offset > reader->size) ||
+      ((reader->size - index_offset) / 16 < reader->info.num_frames)) {
+    /* not closed cleanly, use every complete record */
+    reader->info.num_frames = (reader->size - GRAY_CAPTURE_HEADER_SIZE) /
+        reader->frame_size;
+    index_offset = 0;
+  } else {
+    /* a corrupt header may claim more records than lie before the index */
+    reader->info.num_frames = MIN (reader->info.num_frames,
+        (index_offset - GRAY_CAPTURE_HEADER_SIZE) / reader->frame_size);
+  }
+
+  /* the index avoids touching every record just to learn the timestamps */
+  reader->timestamps = g_new (guint64, MAX (reader->info.num_frames, 1));
+  for (n = 0; n < reader->info.num_frames; n++) {
+    if (index_offset)
+      reader->timestamps[n] = get_u64 (h + index_offset + n * 16 + 8);
+    else
+      reader->timestamps[n] = get_u64 (h + GRAY_CAPTURE_HEADER_SIZE +
+          n * reader->frame_size);
+  }
+  return reader;
+
+invalid:
+  g_set_error (error, G_FILE_ERROR, G_FILE_ERROR_INVAL,
+      "%s is not a GRAY8 capture", filename);
+  g_mapped_file_free (reader->file);
+  g_free (reader);
+  return NULL;
+}
+
+void
+gray_capture_reader_free (GrayCaptureReader *reader)
+{
+  g_mapped_file_free (reader->file);
+  g_free (reader->timestamps);
+  g_free (reader);
+}
+
+const GrayCaptureInfo *
+gray_capture_reader_get_info (GrayCaptureReader *reader)
+{
+  return &reader->info;
+}
+
+/* pointer into the mapping, valid until the reader is freed */
+const guint8 *
+gray_capture_reader_get_frame (GrayCaptureReader *reader, guint64 n,
+    guint64 *timestamp, guint64 *duration)
+{
+  const guint8 *record;
+
+  if (n >= reader->info.num_frames)
+    return NULL;
+
+  record = reader->data + GRAY_CAPTURE_HEADER_SIZE + n * reader->frame_size;
+  if (timestamp)
+    *timestamp = get_u64 (record);
+  if (duration)
+    *duration = get_u64 (record + 8);
+  return record + GRAY_CAPTURE_RECORD_HEADER_SIZE;
+}
+
+/* first frame at or after timestamp, num_frames if there is none */
+guint64
+gray_capture_reader_find (GrayCaptureReader *reader, guint64 timestamp)
+{
+  guint64 low = 0, high = reader->info.num_frames, mid;
+
+  while (low < high) {
+    mid = low + (high - low) / 2;
+    if (reader->timestamps[mid] < timestamp)
+      low = mid + 1;
+    else
+      high = mid;
+  }
+  return low;
+}
+
+gboolean
+gray_capture_is_capture (const gchar *filename)
+{
+  gchar magic[8];
+  gboolean is_capture = FALSE;
+  FILE *f;
+
+  f = fopen (filename, "rb");
+  if (f) {
+    is_capture = (fread (magic, sizeof (magic), 1, f) == 1) &&
+        !memcmp (magic, GRAY_CAPTURE_MAGIC, sizeof (magic));
+    fclose (f);
+  }
+  return is_capture;
+}
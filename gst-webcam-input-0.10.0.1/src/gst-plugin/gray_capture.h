@@ -0,0 +1,86 @@
+/*
+ *  gst-tuio - Gstreamer to tuio computer vision plugin
+ *
+ *  Copyright (C) 2010 Keith Mok <ek9852@gmail.com>
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+#ifndef __GRAY_CAPTURE_H__
+#define __GRAY_CAPTURE_H__
+
+#include <glib.h>
+
+G_BEGIN_DECLS
+
+/* Raw GRAY8 capture file, written by grayrecord and read back by
+ * grayreplay and blobs-bench. All fields are little endian.
+ *
+ *   header     64 bytes, see GrayCaptureHeader
+ *   frames     num_frames records of frame_size bytes each: the
+ *              timestamp and duration in ns (guint64, G_MAXUINT64 when
+ *              unknown) followed by height rows of stride pixels, padded
+ *              to a multiple of 8 bytes
+ *   index      num_frames pairs of record offset and timestamp (guint64)
+ *
+ * Records have a fixed size so the file can be mapped and a frame found
+ * without parsing. num_frames and index_offset are only filled in when
+ * the recording is closed cleanly; a capture cut short is still readable,
+ * the reader then counts the complete records and rebuilds the index. */
+
+#define GRAY_CAPTURE_MAGIC "GRAYCAP1"
+#define GRAY_CAPTURE_VERSION 1
+#define GRAY_CAPTURE_HEADER_SIZE 64
+#define GRAY_CAPTURE_RECORD_HEADER_SIZE 16
+#define GRAY_CAPTURE_TIME_NONE G_MAXUINT64
+
+typedef struct _GrayCaptureInfo   GrayCaptureInfo;
+typedef struct _GrayCaptureWriter GrayCaptureWriter;
+typedef struct _GrayCaptureReader GrayCaptureReader;
+
+struct _GrayCaptureInfo
+{
+  gint width;
+  gint height;
+  gint stride;
+  gint fps_n;
+  gint fps_d;
+  guint64 num_frames;
+};
+
+GrayCaptureWriter *gray_capture_writer_new (const gchar *filename,
+    gint width, gint height, gint fps_n, gint fps_d, GError **error);
+gboolean gray_capture_writer_add (GrayCaptureWriter *writer,
+    const guint8 *data, gint stride, guint64 timestamp, guint64 duration,
+    GError **error);
+gboolean gray_capture_writer_close (GrayCaptureWriter *writer,
+    GError **error);
+
+GrayCaptureReader *gray_capture_reader_new (const gchar *filename,
+    GError **error);
+void gray_capture_reader_free (GrayCaptureReader *reader);
+const GrayCaptureInfo *gray_capture_reader_get_info (
+    GrayCaptureReader *reader);
+const guint8 *gray_capture_reader_get_frame (GrayCaptureReader *reader,
+    guint64 n, guint64 *timestamp, guint64 *duration);
+guint64 gray_capture_reader_find (GrayCaptureReader *reader,
+    guint64 timestamp);
+
+gboolean gray_capture_is_capture (const gchar *filename);
+
+G_END_DECLS
+
+#endif /* __GRAY_CAPTURE_H__ */
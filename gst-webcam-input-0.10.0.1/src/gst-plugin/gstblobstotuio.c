@@ -37,10 +37,22 @@
 #include <unistd.h>
 
 #include "gstblobstotuio.h"
+#include "gstgrayrecord.h"
+#include "gstgrayreplay.h"
+#include "gstframeringsrc.h"
 #include "blob_detector.h"
+#include "blob_moments.h"
+#include "fiducial.h"
 #include "image_utils.h"
+#include "image_utils_impl.h"
+#include "triple_buffer.h"
+#include "stage_stats.h"
+#include "coord_map.h"
+#include "image_remap.h"
+#include "image_depth.h"
 
 GST_DEBUG_CATEGORY_STATIC (gst_blobs_to_tuio_debug);
+GST_DEBUG_CATEGORY_STATIC (gst_blobs_to_tuio_stats_debug);
 
 #define GST_CAT_DEFAULT gst_blobs_to_tuio_debug
 
@@ -50,6 +62,10 @@ GST_DEBUG_CATEGORY_STATIC (gst_blobs_to_tuio_debug);
 
 typedef struct _Blob                Blob;
 typedef struct _BlobList            BlobList;
+typedef struct _BlobSnapshot        BlobSnapshot;
+typedef struct _BlobPoint           BlobPoint;
+typedef struct _GstBlobsToTUIOPad   GstBlobsToTUIOPad;
+typedef struct _GstBlobsToTUIOPadClass GstBlobsToTUIOPadClass;
 
 /* hal for xserver-xorg don't like ABS_PRESSURE,
  * otherwise it think it is a synaptics driver */
@@ -65,9 +81,21 @@ typedef struct _BlobList            BlobList;
 struct _Blob
 {
   gint id;
+  gint class_id; /* fiducial class, -1 for a touch */
   gfloat x;
   gfloat y;
   gfloat major;
+  gfloat angle; /* of the equivalent ellipse, see BlobShape */
+  gfloat width;
+  gfloat height;
+};
+
+/* copy of the tracked blobs handed over to the output thread */
+struct _BlobSnapshot
+{
+  gint num_of_frame;
+  GArray *blobs;
+  GArray *objects; /* tracked fiducials */
 };
 
 enum {
@@ -79,11 +107,74 @@ enum {
   MAX_SRC_PAD,
 };
 
-struct _GstBlobsToTUIOPrivate
+/* timed processing stages */
+enum {
+  STAGE_BG = 0,
+  STAGE_SMOOTH,
+  STAGE_HIGHPASS,
+  STAGE_AMPLIFY,
+  STAGE_FIND_ZONES,
+  STAGE_FIDUCIALS,
+  STAGE_BLOB_LIST_UPDATE,
+  STAGE_SEND,
+  MAX_STAGE,
+};
+
+static const gchar *stage_names[MAX_STAGE] = {
+  "bg",
+  "smooth",
+  "highpass",
+  "amplify",
+  "find-zones",
+  "fiducials",
+  "blob-list-update",
+  "send",
+};
+
+#define DEFAULT_STATS_INTERVAL 300
+#define DEFAULT_LEARN_BACKGROUND_COUNTER 60
+#define DEFAULT_MERGE_DISTANCE 10
+#define DEFAULT_DECIMATE 1
+#define DEFAULT_DEPTH_MIN 5
+#define DEFAULT_DEPTH_MAX 25
+
+/* cameras are told apart by a bit in BlobPoint.cameras */
+#define MAX_CAMERAS 32
+/* merges a camera may miss before its last zones are dropped */
+#define MAX_MISSED_MERGES 2
+
+/* touch candidate in blob space, the coordinate space all cameras are
+ * mapped into by their pad matrix */
+struct _BlobPoint
 {
-  GstPad *processing_srcpad[MAX_SRC_PAD];
-  GstPad *sinkpad;
+  gfloat x;
+  gfloat y;
+  gfloat major;
+  gfloat angle;
+  gfloat width;
+  gfloat height;
+  gint class_id; /* fiducial class, -1 for a touch */
+  guint cameras; /* bit per camera that saw it */
+  gint n; /* number of camera points fused */
+  gboolean matched;
+};
 
+#define GST_TYPE_BLOBSTOTUIO_PAD \
+  (gst_blobs_to_tuio_pad_get_type())
+#define GST_BLOBSTOTUIO_PAD(obj) \
+  (G_TYPE_CHECK_INSTANCE_CAST((obj),GST_TYPE_BLOBSTOTUIO_PAD,GstBlobsToTUIOPad))
+#define GST_IS_BLOBSTOTUIO_PAD(obj) \
+  (G_TYPE_CHECK_INSTANCE_TYPE((obj),GST_TYPE_BLOBSTOTUIO_PAD))
+
+/* Sink pad of one camera. Every camera has its own background model and
+ * working buffers and is processed in the streaming thread of its
+ * upstream, only merging the found zones into the blob list is
+ * serialized. */
+struct _GstBlobsToTUIOPad
+{
+  GstPad pad;
+
+  gint index;
   gint width;
   gint height;
   gint *markbuf;
@@ -93,13 +184,81 @@ struct _GstBlobsToTUIOPrivate
   guint8 *working_buf1;
   guint8 *working_buf2;
   guint8 *image_blur_temp;
+  guint8 *coarse_buf; /* decimated frame */
+
+  /* 16 bit depth frames, the learnt surface replaces the intensity
+   * background */
+  gint bpp;
+  guint16 *depth_background;
+  guint32 *depth_sum;
+  guint16 *depth_count;
+  guint depth_frames; /* summed into depth_sum while learning */
+  gboolean depth_learnt; /* depth_background holds a surface */
+
+  /* the image stages run on the frame decimated by this, only used by
+   * the streaming thread */
+  gint decimate;
+  GArray *shapes; /* BlobShape of the zones of the latest frame */
+
+  /* camera pixels to blob space, the lens model and the part of the
+   * frame used, protected by the pad object lock */
+  gfloat matrix[9];
+  LensModel lens;
+  gint roi[4]; /* x, y, width, height, width 0 for the whole frame */
+  gboolean remap; /* correct the image instead of the centroids */
+  gfloat remap_matrix[9];
+  gboolean lut_dirty;
+  gboolean remap_dirty;
+
+  /* lens + projective matrix per pixel, NULL when the matrix is affine
+   * and there is no lens, only used by the streaming thread */
+  CoordLut *lut;
+  /* lens + remap_matrix correction of the image, NULL without remap,
+   * only used by the streaming thread */
+  RemapLut *remap_lut;
+
+  /* protected by the element merge_lock */
+  GArray *points; /* BlobPoint of the latest frame */
+  gboolean fresh; /* points not merged yet */
+  gint missed; /* merges since the camera last delivered */
+
+  /* image stages only, merging and sending are timed by the element */
+  StageStats stage_stats[MAX_STAGE];
+};
+
+struct _GstBlobsToTUIOPadClass
+{
+  GstPadClass parent_class;
+};
+
+GType gst_blobs_to_tuio_pad_get_type (void);
+
+struct _GstBlobsToTUIOPrivate
+{
+  GstPad *processing_srcpad[MAX_SRC_PAD];
+
+  /* cameras, the always "sink" pad first, its processing images are the
+   * ones pushed to the processing src pads */
+  GstBlobsToTUIOPad *primary;
+  GSList *cameras;
+  guint camera_mask; /* used camera indexes */
+  guint background_buf_learning_init_counter;
+
+  /* protects cameras, blobs and the producer side of output_queue */
+  GMutex *merge_lock;
+  GArray *merged; /* BlobPoint of all cameras, de-duplicated */
+  guint merge_distance;
+  guint decimate;
+  gboolean fiducials;
+  guint depth_min; /* touch band above the surface, depth units */
+  guint depth_max;
   
   GSList *blobs;
   gint num_of_frame;
   
-  /* matrix to transform from camera coordinate */
-  /* to 0-1,0-1 */
-  gfloat matrix[6];
+  /* homography to transform from blob coordinate to screen coordinate,
+   * protected by output_lock */
+  gfloat matrix[9];
   
   gboolean trackdark;
   guint smooth;
@@ -132,6 +291,18 @@ struct _GstBlobsToTUIOPrivate
   guint surface_min;
   guint surface_max;
   guint distance_max;
+
+  /* event emission runs in its own thread so that a slow network send or
+   * a blocked uinput write does not stall the streaming thread */
+  BlobSnapshot snapshots[3];
+  TripleBuffer *output_queue;
+  GThread *output_thread;
+  GMutex *output_lock; /* protects ufile and loaddress */
+  guint output_coalesced;
+
+  /* per stage latency, rolled over every stats_interval frames */
+  StageStats stage_stats[MAX_STAGE];
+  guint stats_interval;
 };
 
 /* Filter signals and args */
@@ -164,13 +335,41 @@ enum
   PROP_PORT,
   PROP_SURFACEMIN,
   PROP_SURFACEMAX,
-  PROP_DISTANCEMAX
+  PROP_DISTANCEMAX,
+  PROP_STATS,
+  PROP_STATS_INTERVAL,
+  PROP_MERGE_DISTANCE,
+  PROP_DECIMATE,
+  PROP_FIDUCIALS,
+  PROP_DEPTH_MIN,
+  PROP_DEPTH_MAX
 };
 
+enum
+{
+  PROP_PAD_0,
+  PROP_PAD_MATRIX,
+  PROP_PAD_LENS,
+  PROP_PAD_REMAP,
+  PROP_PAD_REMAP_MATRIX,
+  PROP_PAD_ROI
+};
+
+/* 8 bit intensity or 16 bit depth, e.g. Kinect v2 depth in mm */
+#define SINK_CAPS "video/x-raw-gray,bpp=8,depth=8; " \
+    "video/x-raw-gray,bpp=16,depth=16,endianness=1234"
+
 static GstStaticPadTemplate sink_factory = GST_STATIC_PAD_TEMPLATE ("sink",
     GST_PAD_SINK,
     GST_PAD_ALWAYS,
-    GST_STATIC_CAPS ("video/x-raw-gray,bpp=8,depth=8")
+    GST_STATIC_CAPS (SINK_CAPS)
+    );
+
+static GstStaticPadTemplate sink_request_factory =
+    GST_STATIC_PAD_TEMPLATE ("sink%d",
+    GST_PAD_SINK,
+    GST_PAD_REQUEST,
+    GST_STATIC_CAPS (SINK_CAPS)
     );
 
 static GstStaticPadTemplate src_factory = GST_STATIC_PAD_TEMPLATE ("src%s",
@@ -191,6 +390,8 @@ static GstPad *gst_blobs_to_tuio_request_new_pad (GstElement * element,
 static void gst_blobs_to_tuio_release_pad (GstElement * element,
     GstPad * pad);
 static void gst_blobs_to_tuio_finalize (GstBlobsToTUIO * filter);
+static GstStateChangeReturn gst_blobs_to_tuio_change_state (GstElement *
+    element, GstStateChange transition);
 static GstFlowReturn gst_blobs_to_tuio_chain(GstPad * pad, GstBuffer * buf);
 
 static gboolean gst_blobs_to_tuio_set_caps (GstPad * pad, GstCaps * caps);
@@ -199,15 +400,49 @@ static void
 convert_coord(GstBlobsToTUIOPrivate * priv, gfloat xsrc, gfloat ysrc,
     gfloat *xdst, gfloat *ydst)
 {
-  *xdst = priv->matrix[0] * xsrc + priv->matrix[1] * ysrc + priv->matrix[2];
-  *ydst = priv->matrix[3] * xsrc + priv->matrix[4] * ysrc + priv->matrix[5];
+  homography_apply(priv->matrix, xsrc, ysrc, xdst, ydst);
+}
+
+static void
+convert_coord_func(gpointer data, gfloat xsrc, gfloat ysrc,
+    gfloat *xdst, gfloat *ydst)
+{
+  convert_coord((GstBlobsToTUIOPrivate *)data, xsrc, ysrc, xdst, ydst);
+}
+
+/* the ellipse of a blob in output coordinates */
+static void
+convert_shape(GstBlobsToTUIOPrivate * priv, Blob *blob, BlobShape *shape)
+{
+  BlobShape s;
+
+  s.x = blob->x;
+  s.y = blob->y;
+  s.angle = blob->angle;
+  s.width = blob->width;
+  s.height = blob->height;
+  blob_shape_map(&s, convert_coord_func, priv, shape);
+}
+
+/* position and angle of a marker in output coordinates */
+static void
+convert_object(GstBlobsToTUIOPrivate * priv, Blob *blob, Fiducial *f)
+{
+  Fiducial s;
+
+  s.id = blob->class_id;
+  s.x = blob->x;
+  s.y = blob->y;
+  s.angle = blob->angle;
+  s.size = blob->major;
+  fiducial_map(&s, convert_coord_func, priv, f);
 }
 
 static void
-blob_list_update(GstBlobsToTUIOPrivate * priv, GArray *zones)
+blob_list_update(GstBlobsToTUIOPrivate * priv, GArray *points)
 {
   static gint next_blob_id = 0;
-  Zone *z;
+  BlobPoint *p;
   Blob *b;
   GSList *node, *nextnode;
   gint i;
@@ -215,37 +450,40 @@ blob_list_update(GstBlobsToTUIOPrivate * priv, GArray *zones)
 
   ++priv->num_of_frame;
 
-  /* go through all the blob, found the nearest zone, if not found delete it */
+  /* go through all the blob, found the nearest point, if not found delete it */
   /* any good speed up algorithm ?! */
   for (node = priv->blobs; node; node = nextnode) {
-    Zone *zone = NULL;
+    BlobPoint *point = NULL;
     gint dist = G_MAXINT;
 
     nextnode = g_slist_next(node);
     b = (Blob *)node->data;
 
-    for (i = 0; i < zones->len; i++) {
-      gint zx, zy;
-      z = &g_array_index(zones, Zone, i);
-      zx = z->total_x / z->surface_size;
-      zy = z->total_y / z->surface_size;
+    for (i = 0; i < points->len; i++) {
+      p = &g_array_index(points, BlobPoint, i);
+      /* a touch never turns into a marker, nor one marker into another */
+      if (p->class_id != b->class_id)
+        continue;
 
-      d = (b->x - zx)*(b->x - zx) + (b->y - zy)*(b->y - zy);
+      d = (b->x - p->x)*(b->x - p->x) + (b->y - p->y)*(b->y - p->y);
       if (d > (priv->distance_max*priv->distance_max))
         continue;
       /* REVISIT do we need to match the size also for a better match ? */
       if (d < dist) {
         dist = d;
-        zone = z;
+        point = p;
       }
     }
-    /* we need to mark that zone as used to prevent it match to other blob */
-    if ((zone != NULL) && !zone->matched) {
+    /* we need to mark that point as used to prevent it match to other blob */
+    if ((point != NULL) && !point->matched) {
       /* update blob information */
-      b->x = zone->total_x / zone->surface_size;
-      b->y = zone->total_y / zone->surface_size;
-      b->major = z->surface_size;
-      zone->matched = TRUE;
+      b->x = point->x;
+      b->y = point->y;
+      b->major = point->major;
+      b->angle = point->angle;
+      b->width = point->width;
+      b->height = point->height;
+      point->matched = TRUE;
     } else {
       /* remove old unmatched blob */
       /* TODO: signal that the Blob was removed */
@@ -255,27 +493,325 @@ blob_list_update(GstBlobsToTUIOPrivate * priv, GArray *zones)
   }
 
   /* add new blob */
-  for (i = 0; i<zones->len; i++) {
-    z = &g_array_index(zones, Zone, i);
+  for (i = 0; i<points->len; i++) {
+    p = &g_array_index(points, BlobPoint, i);
     /* already matched toa previous blob */
-    if (z->matched)
+    if (p->matched)
       continue;
 
     /* TODO: signal that a new Blob was added */
     b = g_new(Blob, 1);
-    b->x = z->total_x / z->surface_size;
-    b->y = z->total_y / z->surface_size;
-    b->major = z->surface_size;
+    b->x = p->x;
+    b->y = p->y;
+    b->major = p->major;
+    b->angle = p->angle;
+    b->width = p->width;
+    b->height = p->height;
+    b->class_id = p->class_id;
     b->id = next_blob_id++;
     priv->blobs = g_slist_append(priv->blobs, b);
   }
 }
 
+/* rebuild the lookup tables after caps or mapping changes, outside of
+ * the merge lock as they take a while. Returns TRUE when the image
+ * geometry changed and the background has to be learnt again. */
+static gboolean
+camera_update_luts(GstBlobsToTUIOPad *camera)
+{
+  LensModel lens;
+  gfloat matrix[9];
+  gfloat remap_matrix[9];
+  gboolean remap, lut_dirty, remap_dirty;
+
+  GST_OBJECT_LOCK (camera);
+  lut_dirty = camera->lut_dirty;
+  remap_dirty = camera->remap_dirty;
+  camera->lut_dirty = FALSE;
+  camera->remap_dirty = FALSE;
+  lens = camera->lens;
+  remap = camera->remap;
+  memcpy(matrix, camera->matrix, sizeof(matrix));
+  memcpy(remap_matrix, camera->remap_matrix, sizeof(remap_matrix));
+  GST_OBJECT_UNLOCK (camera);
+
+  if (remap_dirty) {
+    remap_lut_free(camera->remap_lut);
+    camera->remap_lut = NULL;
+    /* the remap works on intensity frames only */
+    if (remap && (camera->bpp == 8)) {
+      /* the remap runs on the decimated frame */
+      LensModel remap_lens;
+      lens_model_rescale(&lens, 1.0f / camera->decimate, &remap_lens);
+      homography_rescale(remap_matrix, 1.0f / camera->decimate,
+          remap_matrix);
+      camera->remap_lut = remap_lut_new(camera->width / camera->decimate,
+          camera->height / camera->decimate, &remap_lens, remap_matrix);
+    }
+  }
+
+  if (lut_dirty) {
+    coord_lut_free(camera->lut);
+    camera->lut = NULL;
+
+    /* the remapped image has no lens distortion left */
+    if (camera->remap_lut)
+      memset(&lens, 0, sizeof(lens));
+    /* affine mapping alone is cheaper than the table lookup */
+    if (lens_model_enabled(&lens) || !homography_is_affine(matrix))
+      camera->lut = coord_lut_new(camera->width, camera->height, &lens,
+          matrix);
+  }
+
+  return remap_dirty;
+}
+
+/* camera pixel to blob space, called with the pad object lock held */
+static void
+camera_map_coord(gpointer data, gfloat xsrc, gfloat ysrc,
+    gfloat *xdst, gfloat *ydst)
+{
+  GstBlobsToTUIOPad *camera = (GstBlobsToTUIOPad *)data;
+
+  if (camera->lut)
+    coord_lut_map(camera->lut, xsrc, ysrc, xdst, ydst);
+  else
+    homography_apply(camera->matrix, xsrc, ysrc, xdst, ydst);
+}
+
+/* Weighted centroid and ellipse of every zone in camera pixels. Zones
+ * found on the decimated frame are measured again at full resolution
+ * inside their bounding box, or scaled up when that is not possible. */
+static void
+camera_update_shapes(GstBlobsToTUIOPad *camera, GstBlobsToTUIOPrivate *priv,
+    const guint8 *frame, GArray *zones, GArray *moments)
+{
+  ZoneMoments refined;
+  BlobShape *shape;
+  Zone *z;
+  gint i, surface;
+
+  g_array_set_size(camera->shapes, zones->len);
+  for (i = 0; i < zones->len; i++) {
+    z = &g_array_index(zones, Zone, i);
+    shape = &g_array_index(camera->shapes, BlobShape, i);
+
+    if (camera->decimate == 1) {
+      zone_moments_shape(&g_array_index(moments, ZoneMoments, i), shape);
+      continue;
+    }
+
+    /* the corrected full resolution frame does not exist with remap, nor
+     * an intensity frame with depth */
+    surface = 0;
+    if (!camera->remap_lut && (camera->bpp == 8))
+      surface = zone_moments_refine(frame, camera->width, camera->height,
+          camera->background_buf, camera->decimate, priv->trackdark,
+          priv->smooth, priv->highpass_blur, priv->highpass_noise,
+          priv->amplify_shift, priv->threshold, z, &refined);
+
+    if (surface > 0) {
+      zone_moments_shape(&refined, shape);
+      z->surface_size = surface;
+    } else {
+      zone_moments_shape(&g_array_index(moments, ZoneMoments, i), shape);
+      blob_shape_undecimate(shape, camera->decimate);
+      z->surface_size *= camera->decimate * camera->decimate;
+    }
+  }
+}
+
+/* keep the zones inside the camera roi and map their sub-pixel centroid
+ * and ellipse to blob space */
+static void
+camera_update_points(GstBlobsToTUIOPad *camera, GArray *zones)
+{
+  BlobPoint point;
+  BlobShape shape;
+  Zone *z;
+  gint i;
+
+  g_array_set_size(camera->points, 0);
+
+  GST_OBJECT_LOCK (camera);
+  for (i = 0; i < zones->len; i++) {
+    z = &g_array_index(zones, Zone, i);
+    shape = g_array_index(camera->shapes, BlobShape, i);
+
+    if ((camera->roi[2] > 0) &&
+        ((shape.x < camera->roi[0]) ||
+         (shape.x >= camera->roi[0] + camera->roi[2]) ||
+         (shape.y < camera->roi[1]) ||
+         (shape.y >= camera->roi[1] + camera->roi[3])))
+      continue;
+
+    blob_shape_map(&shape, camera_map_coord, camera, &shape);
+    point.x = shape.x;
+    point.y = shape.y;
+    point.angle = shape.angle;
+    point.width = shape.width;
+    point.height = shape.height;
+    point.major = z->surface_size;
+    point.class_id = -1;
+    point.cameras = 1u << camera->index;
+    point.n = 1;
+    point.matched = FALSE;
+    g_array_append_val(camera->points, point);
+  }
+  GST_OBJECT_UNLOCK (camera);
+}
+
+/* the markers of the latest frame go after its touches, same roi and
+ * mapping, fiducials were found on the decimated frame */
+static void
+camera_update_objects(GstBlobsToTUIOPad *camera, GArray *fiducials)
+{
+  BlobPoint point;
+  Fiducial f;
+  gint i;
+
+  GST_OBJECT_LOCK (camera);
+  for (i = 0; i < fiducials->len; i++) {
+    f = g_array_index(fiducials, Fiducial, i);
+    fiducial_undecimate(&f, camera->decimate);
+
+    if ((camera->roi[2] > 0) &&
+        ((f.x < camera->roi[0]) ||
+         (f.x >= camera->roi[0] + camera->roi[2]) ||
+         (f.y < camera->roi[1]) ||
+         (f.y >= camera->roi[1] + camera->roi[3])))
+      continue;
+
+    fiducial_map(&f, camera_map_coord, camera, &f);
+    point.x = f.x;
+    point.y = f.y;
+    point.angle = f.angle;
+    point.width = 0;
+    point.height = 0;
+    point.major = f.size;
+    point.class_id = f.id;
+    point.cameras = 1u << camera->index;
+    point.n = 1;
+    point.matched = FALSE;
+    g_array_append_val(camera->points, point);
+  }
+  GST_OBJECT_UNLOCK (camera);
+}
+
+/* the white parts of a marker are zones too, drop the ones centred
+ * inside a marker so they do not show up as touches */
+static void
+zones_remove_fiducials(GArray *zones, GArray *moments, GArray *fiducials)
+{
+  Fiducial *f;
+  Zone *z;
+  gint i, j, x, y;
+
+  for (i = zones->len - 1; i >= 0; i--) {
+    z = &g_array_index(zones, Zone, i);
+    x = z->total_x / z->surface_size;
+    y = z->total_y / z->surface_size;
+    for (j = 0; j < fiducials->len; j++) {
+      f = &g_array_index(fiducials, Fiducial, j);
+      if ((x >= f->xstart) && (x <= f->xend) &&
+          (y >= f->ystart) && (y <= f->yend)) {
+        g_array_remove_index(zones, i);
+        g_array_remove_index(moments, i);
+        break;
+      }
+    }
+  }
+}
+
+/* Collect the latest points of every camera into priv->merged. A touch in
+ * the overlap of two cameras shows up once per camera, points of
+ * different cameras closer than merge_distance are fused into their mean.
+ * Points of the same camera are never fused, they are distinct zones.
+ * Markers are only fused with markers of the same class. */
+static void
+merge_camera_points(GstBlobsToTUIOPrivate *priv)
+{
+  GstBlobsToTUIOPad *camera;
+  BlobPoint *p, *q, *nearest;
+  GSList *node;
+  gfloat d, dist, max_dist;
+  gint i, j;
+
+  max_dist = (gfloat)priv->merge_distance * priv->merge_distance;
+  g_array_set_size(priv->merged, 0);
+
+  for (node = priv->cameras; node; node = g_slist_next(node)) {
+    camera = (GstBlobsToTUIOPad *)node->data;
+
+    if (camera->fresh)
+      camera->missed = 0;
+    else
+      camera->missed++;
+    camera->fresh = FALSE;
+
+    /* camera stopped delivering, forget its touches */
+    if (camera->missed > MAX_MISSED_MERGES)
+      continue;
+
+    for (i = 0; i < camera->points->len; i++) {
+      p = &g_array_index(camera->points, BlobPoint, i);
+      nearest = NULL;
+      dist = max_dist;
+
+      for (j = 0; j < priv->merged->len; j++) {
+        q = &g_array_index(priv->merged, BlobPoint, j);
+        if ((q->cameras & p->cameras) || (q->class_id != p->class_id))
+          continue;
+        d = (p->x - q->x)*(p->x - q->x) + (p->y - q->y)*(p->y - q->y);
+        if (d <= dist) {
+          dist = d;
+          nearest = q;
+        }
+      }
+
+      if (nearest) {
+        nearest->x = (nearest->x * nearest->n + p->x) / (nearest->n + 1);
+        nearest->y = (nearest->y * nearest->n + p->y) / (nearest->n + 1);
+        /* the camera seeing more of the touch has the better shape */
+        if (p->major > nearest->major) {
+          nearest->major = p->major;
+          nearest->angle = p->angle;
+          nearest->width = p->width;
+          nearest->height = p->height;
+        }
+        nearest->cameras |= p->cameras;
+        nearest->n++;
+      } else {
+        g_array_append_val(priv->merged, *p);
+      }
+    }
+  }
+}
+
+/* merge once every camera delivered a frame, or earlier when a camera
+ * delivers its next frame before the others (different rates, stalls) */
+static gboolean
+merge_due(GstBlobsToTUIOPrivate *priv, gboolean was_fresh)
+{
+  GstBlobsToTUIOPad *camera;
+  GSList *node;
+
+  if (was_fresh)
+    return TRUE;
+
+  for (node = priv->cameras; node; node = g_slist_next(node)) {
+    camera = (GstBlobsToTUIOPad *)node->data;
+    if (!camera->fresh && (camera->missed <= MAX_MISSED_MERGES) &&
+        (camera->width > 0))
+      return FALSE;
+  }
+  return TRUE;
+}
+
 #if !defined(G_OS_WIN32)
 static void
-send_uinput (GstBlobsToTUIOPrivate *priv)
+send_uinput (GstBlobsToTUIOPrivate *priv, BlobSnapshot *snapshot)
 {
-  GSList *blobCursor;
   Blob *blob;
   struct input_event event;
   gfloat x, y;
@@ -285,9 +821,7 @@ send_uinput (GstBlobsToTUIOPrivate *priv)
     return;
 
   /* we only send the first blob in the list for single touch input event */
-  blobCursor = priv->blobs;
-
-  if (blobCursor == NULL) {
+  if (snapshot->blobs->len == 0) {
     if (!priv->uinput_up) {
       gettimeofday(&event.time, NULL);
       event.type = EV_KEY;
@@ -318,7 +852,7 @@ send_uinput (GstBlobsToTUIOPrivate *priv)
       ret = write(priv->ufile, &event, sizeof(event));
       priv->uinput_up = FALSE;
     }
-    blob = (Blob *)(blobCursor->data);
+    blob = &g_array_index(snapshot->blobs, Blob, 0);
     convert_coord(priv, (float)(blob->x), (float)(blob->y), &x, &y);
 
     gettimeofday(&event.time, NULL);
@@ -350,20 +884,20 @@ send_uinput (GstBlobsToTUIOPrivate *priv)
 
 #if defined(USE_MT_EVENT)
 static void
-send_uinput_mt (GstBlobsToTUIOPrivate *priv)
+send_uinput_mt (GstBlobsToTUIOPrivate *priv, BlobSnapshot *snapshot)
 {
-  GSList *blobCursor;
   struct input_event event;
+  gint i;
   int ret;
 
   if (priv->ufile < 0)
     return;
 
-  for (blobCursor = priv->blobs; blobCursor != NULL;
-      blobCursor = g_slist_next(blobCursor)) {
-    Blob *blob = (Blob *)(blobCursor->data);
-    gfloat x, y;
-    convert_coord(priv, (float)(blob->x), (float)(blob->y), &x, &y);
+  for (i = 0; i < snapshot->blobs->len; i++) {
+    Blob *blob = &g_array_index(snapshot->blobs, Blob, i);
+    BlobShape shape;
+    gint orientation;
+    convert_shape(priv, blob, &shape);
 
     gettimeofday(&event.time, NULL);
     event.type = EV_ABS;
@@ -371,16 +905,38 @@ send_uinput_mt (GstBlobsToTUIOPrivate *priv)
     event.value = blob->major;
     ret = write(priv->ufile, &event, sizeof(event));
             
+    gettimeofday(&event.time, NULL);
+    event.type = EV_ABS;
+    event.code = ABS_MT_WIDTH_MAJOR;
+    event.value = shape.width;
+    ret = write(priv->ufile, &event, sizeof(event));
+
+    gettimeofday(&event.time, NULL);
+    event.type = EV_ABS;
+    event.code = ABS_MT_WIDTH_MINOR;
+    event.value = shape.height;
+    ret = write(priv->ufile, &event, sizeof(event));
+
+    /* degrees clockwise from the y axis, y points down */
+    orientation = shape.angle * 180 / G_PI - 90;
+    if (orientation <= -90)
+      orientation += 180;
+    gettimeofday(&event.time, NULL);
+    event.type = EV_ABS;
+    event.code = ABS_MT_ORIENTATION;
+    event.value = orientation;
+    ret = write(priv->ufile, &event, sizeof(event));
+
     gettimeofday(&event.time, NULL);
     event.type = EV_ABS;
     event.code = ABS_MT_POSITION_X;
-    event.value = x;
+    event.value = shape.x;
     ret = write(priv->ufile, &event, sizeof(event));
             
     gettimeofday(&event.time, NULL);
     event.type = EV_ABS;
     event.code = ABS_MT_POSITION_Y;
-    event.value = y;
+    event.value = shape.y;
     ret = write(priv->ufile, &event, sizeof(event));
 
     gettimeofday(&event.time, NULL);
@@ -396,7 +952,7 @@ send_uinput_mt (GstBlobsToTUIOPrivate *priv)
     ret = write(priv->ufile, &event, sizeof(event));
   }
 
-  if ((priv->blobs == NULL) && (!priv->uinput_up)) {
+  if ((snapshot->blobs->len == 0) && (!priv->uinput_up)) {
     /* touch up event !!! */
     gettimeofday(&event.time, NULL);
     event.type = EV_ABS;
@@ -429,7 +985,7 @@ send_uinput_mt (GstBlobsToTUIOPrivate *priv)
     event.code = SYN_REPORT;
     event.value = 0;
     ret = write(priv->ufile, &event, sizeof(event));
-  } else if (priv->blobs != NULL) {
+  } else if (snapshot->blobs->len != 0) {
     priv->uinput_up = FALSE;
     gettimeofday(&event.time, NULL);
     event.type = EV_SYN;
@@ -443,53 +999,91 @@ send_uinput_mt (GstBlobsToTUIOPrivate *priv)
 
 #define MAX_BUNDLE_SET 16
 
+enum {
+  TUIO_2DCUR = 0,
+  TUIO_2DBLB,
+  TUIO_2DOBJ,
+};
+
+static const gchar *tuio_profiles[] = {
+  "/tuio/2Dcur",
+  "/tuio/2Dblb",
+  "/tuio/2Dobj",
+};
+
+/* 2Dcur carries the centroids, 2Dblb the centroids and their ellipse,
+ * 2Dobj the markers */
 static void
-send_tuio (GstBlobsToTUIOPrivate *priv)
+send_tuio_profile (GstBlobsToTUIOPrivate *priv, BlobSnapshot *snapshot,
+    gint kind)
 {
+  const gchar *profile = tuio_profiles[kind];
+  GArray *blobs;
   lo_message alivemsg;
   lo_message fseqmsg;
   gint setcount = 0;
-  gint i;
+  gint i, j;
   lo_message setmsg[MAX_BUNDLE_SET+1];
   lo_bundle  bundle;
-  GSList *blobCursor;
+
+  blobs = (kind == TUIO_2DOBJ) ? snapshot->objects : snapshot->blobs;
 
   bundle = lo_bundle_new(LO_TT_IMMEDIATE);
   /* alive message */
   alivemsg = lo_message_new();
   lo_message_add_string(alivemsg, "alive");
-  for (blobCursor = priv->blobs; blobCursor != NULL;
-    blobCursor = g_slist_next(blobCursor)) {
-    Blob *blob = (Blob *)(blobCursor->data);
+  for (j = 0; j < blobs->len; j++) {
+    Blob *blob = &g_array_index(blobs, Blob, j);
     lo_message_add_int32(alivemsg, blob->id);
   }
   /* sequence number */
   fseqmsg = lo_message_new();
   lo_message_add_string(fseqmsg, "fseq");
-  lo_message_add_int32(fseqmsg, (int)(priv->num_of_frame));
+  lo_message_add_int32(fseqmsg, (int)(snapshot->num_of_frame));
 
-  lo_bundle_add_message(bundle, "/tuio/2Dcur", alivemsg);
+  lo_bundle_add_message(bundle, profile, alivemsg);
 
   /* send set */
-  for (blobCursor = priv->blobs; blobCursor != NULL;
-    blobCursor = g_slist_next(blobCursor)) {
-    gfloat x, y;
-    Blob *blob = (Blob *)(blobCursor->data);
-    convert_coord(priv, (float)(blob->x), (float)(blob->y), &x, &y);
-    GST_DEBUG_OBJECT(priv, "blob id=%d, x=%f, y=%f\n", blob->id, x, y);
+  for (j = 0; j < blobs->len; j++) {
+    BlobShape shape;
+    Blob *blob = &g_array_index(blobs, Blob, j);
     setmsg[setcount] = lo_message_new();
     lo_message_add_string(setmsg[setcount], "set");
     lo_message_add_int32(setmsg[setcount], (int)(blob->id));
-    lo_message_add_float(setmsg[setcount], x);
-    lo_message_add_float(setmsg[setcount], y);
-    lo_message_add_float(setmsg[setcount], (float)0);
-    lo_message_add_float(setmsg[setcount], (float)0);
-    lo_message_add_float(setmsg[setcount], (float)0);
-    lo_bundle_add_message(bundle, "/tuio/2Dcur", setmsg[setcount]);
+    if (kind == TUIO_2DOBJ) {
+      Fiducial f;
+      convert_object(priv, blob, &f);
+      GST_DEBUG_OBJECT(priv, "object id=%d class=%d, x=%f, y=%f\n",
+          blob->id, blob->class_id, f.x, f.y);
+      lo_message_add_int32(setmsg[setcount], blob->class_id);
+      lo_message_add_float(setmsg[setcount], f.x);
+      lo_message_add_float(setmsg[setcount], f.y);
+      lo_message_add_float(setmsg[setcount], f.angle);
+    } else {
+      convert_shape(priv, blob, &shape);
+      GST_DEBUG_OBJECT(priv, "blob id=%d, x=%f, y=%f\n", blob->id, shape.x,
+          shape.y);
+      lo_message_add_float(setmsg[setcount], shape.x);
+      lo_message_add_float(setmsg[setcount], shape.y);
+    }
+    if (kind == TUIO_2DBLB) {
+      gfloat area = blob->major;
+      /* scale the pixel area like the axes */
+      if (blob->width * blob->height > 0)
+        area *= (shape.width * shape.height) / (blob->width * blob->height);
+      lo_message_add_float(setmsg[setcount], shape.angle);
+      lo_message_add_float(setmsg[setcount], shape.width);
+      lo_message_add_float(setmsg[setcount], shape.height);
+      lo_message_add_float(setmsg[setcount], area);
+    }
+    /* velocities and accelerations are not tracked, X Y m or X Y A m r */
+    for (i = 0; i < ((kind == TUIO_2DCUR) ? 3 : 5); i++)
+      lo_message_add_float(setmsg[setcount], (float)0);
+    lo_bundle_add_message(bundle, profile, setmsg[setcount]);
     setcount++;
     /* enought for a bundle, send it */
     if (setcount >= MAX_BUNDLE_SET) {
-      lo_bundle_add_message(bundle, "/tuio/2Dcur", fseqmsg);
+      lo_bundle_add_message(bundle, profile, fseqmsg);
       lo_send_bundle(priv->loaddress, bundle);
       /* free set and bundle */
       for (i = 0; i < setcount; i++) {
@@ -498,12 +1092,12 @@ send_tuio (GstBlobsToTUIOPrivate *priv)
       lo_bundle_free(bundle);
       /* create a new bundle */
       bundle = lo_bundle_new(LO_TT_IMMEDIATE);
-      lo_bundle_add_message(bundle, "/tuio/2Dcur", alivemsg);
+      lo_bundle_add_message(bundle, profile, alivemsg);
       setcount = 0;
     }
   }
 
-  lo_bundle_add_message(bundle, "/tuio/2Dcur", fseqmsg);
+  lo_bundle_add_message(bundle, profile, fseqmsg);
   lo_send_bundle(priv->loaddress, bundle);
   lo_message_free(alivemsg);
   lo_message_free(fseqmsg);
@@ -513,6 +1107,344 @@ send_tuio (GstBlobsToTUIOPrivate *priv)
   lo_bundle_free(bundle);
 }
 
+static void
+send_tuio (GstBlobsToTUIOPrivate *priv, BlobSnapshot *snapshot)
+{
+  send_tuio_profile(priv, snapshot, TUIO_2DCUR);
+  send_tuio_profile(priv, snapshot, TUIO_2DBLB);
+  if (priv->fiducials)
+    send_tuio_profile(priv, snapshot, TUIO_2DOBJ);
+}
+
+static void
+publish_blobs (GstBlobsToTUIOPrivate *priv)
+{
+  BlobSnapshot *snapshot;
+  GSList *node;
+
+  snapshot = (BlobSnapshot *)triple_buffer_get_back(priv->output_queue);
+  snapshot->num_of_frame = priv->num_of_frame;
+  g_array_set_size(snapshot->blobs, 0);
+  g_array_set_size(snapshot->objects, 0);
+  for (node = priv->blobs; node; node = g_slist_next(node)) {
+    Blob *blob = (Blob *)node->data;
+    if (blob->class_id < 0)
+      g_array_append_val(snapshot->blobs, *blob);
+    else
+      g_array_append_val(snapshot->objects, *blob);
+  }
+
+  /* output thread lagging, the previous snapshot is dropped */
+  if (triple_buffer_publish(priv->output_queue))
+    priv->output_coalesced++;
+}
+
+static gpointer
+output_thread_func (gpointer data)
+{
+  GstBlobsToTUIO *blobtuio = GST_BLOBSTOTUIO (data);
+  GstBlobsToTUIOPrivate *priv = GST_BLOBSTOTUIO_GET_PRIVATE (blobtuio);
+  BlobSnapshot *snapshot;
+
+  while ((snapshot = triple_buffer_wait(priv->output_queue)) != NULL) {
+    guint64 t = stage_stats_now();
+
+    g_mutex_lock(priv->output_lock);
+#if !defined(G_OS_WIN32)
+    if (priv->uinput) {
+#if defined(USE_MT_EVENT)
+      if (priv->uinput_mt)
+        send_uinput_mt(priv, snapshot);
+      else
+#endif
+        send_uinput(priv, snapshot);
+    }
+#endif
+
+    if (priv->tuio)
+      send_tuio(priv, snapshot);
+    g_mutex_unlock(priv->output_lock);
+
+    stage_stats_lap(&priv->stage_stats[STAGE_SEND], t);
+  }
+
+  return NULL;
+}
+
+/* camera sink pad */
+
+G_DEFINE_TYPE (GstBlobsToTUIOPad, gst_blobs_to_tuio_pad, GST_TYPE_PAD);
+
+static void
+gst_blobs_to_tuio_pad_free_buffers (GstBlobsToTUIOPad *camera)
+{
+  g_free(camera->markbuf);
+  g_free(camera->background_buf);
+  g_free(camera->background_buf_fractional);
+  g_free(camera->working_buf1);
+  g_free(camera->working_buf2);
+  g_free(camera->image_blur_temp);
+  g_free(camera->coarse_buf);
+  g_free(camera->depth_background);
+  g_free(camera->depth_sum);
+  g_free(camera->depth_count);
+  camera->markbuf = NULL;
+  camera->background_buf = NULL;
+  camera->background_buf_fractional = NULL;
+  camera->working_buf1 = NULL;
+  camera->working_buf2 = NULL;
+  camera->image_blur_temp = NULL;
+  camera->coarse_buf = NULL;
+  camera->depth_background = NULL;
+  camera->depth_sum = NULL;
+  camera->depth_count = NULL;
+}
+
+static void
+gst_blobs_to_tuio_pad_finalize (GObject * object)
+{
+  GstBlobsToTUIOPad *camera = GST_BLOBSTOTUIO_PAD (object);
+  gint i;
+
+  gst_blobs_to_tuio_pad_free_buffers(camera);
+  coord_lut_free(camera->lut);
+  remap_lut_free(camera->remap_lut);
+  g_array_free(camera->points, TRUE);
+  g_array_free(camera->shapes, TRUE);
+  for (i = 0; i < MAX_STAGE; i++)
+    stage_stats_clear(&camera->stage_stats[i]);
+
+  G_OBJECT_CLASS (gst_blobs_to_tuio_pad_parent_class)->finalize (object);
+}
+
+static void
+gst_blobs_to_tuio_pad_set_property (GObject * object, guint prop_id,
+    const GValue * value, GParamSpec * pspec)
+{
+  GstBlobsToTUIOPad *camera = GST_BLOBSTOTUIO_PAD (object);
+  gfloat matrix[9];
+  LensModel lens;
+  gint roi[4];
+
+  switch (prop_id) {
+    case PROP_PAD_MATRIX:
+      if (homography_parse (matrix, g_value_get_string (value))) {
+        GST_OBJECT_LOCK (camera);
+        memcpy (camera->matrix, matrix, sizeof (matrix));
+        camera->lut_dirty = TRUE;
+        GST_OBJECT_UNLOCK (camera);
+      }
+      break;
+    case PROP_PAD_LENS:
+      if (lens_model_parse (&lens, g_value_get_string (value))) {
+        GST_OBJECT_LOCK (camera);
+        camera->lens = lens;
+        camera->lut_dirty = TRUE;
+        camera->remap_dirty = camera->remap;
+        GST_OBJECT_UNLOCK (camera);
+      }
+      break;
+    case PROP_PAD_REMAP:
+      GST_OBJECT_LOCK (camera);
+      camera->remap = g_value_get_boolean (value);
+      camera->lut_dirty = TRUE;
+      camera->remap_dirty = TRUE;
+      GST_OBJECT_UNLOCK (camera);
+      break;
+    case PROP_PAD_REMAP_MATRIX:
+      if (homography_parse (matrix, g_value_get_string (value))) {
+        GST_OBJECT_LOCK (camera);
+        memcpy (camera->remap_matrix, matrix, sizeof (matrix));
+        camera->remap_dirty = camera->remap;
+        GST_OBJECT_UNLOCK (camera);
+      }
+      break;
+    case PROP_PAD_ROI:
+      if (sscanf (g_value_get_string (value), "%d,%d,%d,%d", &roi[0],
+              &roi[1], &roi[2], &roi[3]) == 4) {
+        GST_OBJECT_LOCK (camera);
+        memcpy (camera->roi, roi, sizeof (roi));
+        GST_OBJECT_UNLOCK (camera);
+      }
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+      break;
+  }
+}
+
+static void
+gst_blobs_to_tuio_pad_get_property (GObject * object, guint prop_id,
+    GValue * value, GParamSpec * pspec)
+{
+  GstBlobsToTUIOPad *camera = GST_BLOBSTOTUIO_PAD (object);
+  gchar *str;
+
+  GST_OBJECT_LOCK (camera);
+  switch (prop_id) {
+    case PROP_PAD_MATRIX:
+      g_value_take_string (value, homography_to_string (camera->matrix));
+      break;
+    case PROP_PAD_LENS:
+      g_value_take_string (value, lens_model_to_string (&camera->lens));
+      break;
+    case PROP_PAD_REMAP:
+      g_value_set_boolean (value, camera->remap);
+      break;
+    case PROP_PAD_REMAP_MATRIX:
+      g_value_take_string (value,
+          homography_to_string (camera->remap_matrix));
+      break;
+    case PROP_PAD_ROI:
+      str = g_strdup_printf ("%d,%d,%d,%d", camera->roi[0], camera->roi[1],
+          camera->roi[2], camera->roi[3]);
+      g_value_take_string (value, str);
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+      break;
+  }
+  GST_OBJECT_UNLOCK (camera);
+}
+
+static void
+gst_blobs_to_tuio_pad_class_init (GstBlobsToTUIOPadClass * klass)
+{
+  GObjectClass *gobject_class = (GObjectClass *) klass;
+
+  gobject_class->finalize = gst_blobs_to_tuio_pad_finalize;
+  gobject_class->set_property = gst_blobs_to_tuio_pad_set_property;
+  gobject_class->get_property = gst_blobs_to_tuio_pad_get_property;
+
+  g_object_class_install_property (gobject_class, PROP_PAD_MATRIX,
+      g_param_spec_string ("matrix",
+          "Transform matrix from camera to blob coordinates",
+          "6 coeffs of the 3x2 matrix or 9 of the 3x3 homography (row major) separated by comma, mapping this camera into the coordinates shared by all cameras",
+          "1,0,0,0,1,0", G_PARAM_READWRITE));
+
+  g_object_class_install_property (gobject_class, PROP_PAD_LENS,
+      g_param_spec_string ("lens",
+          "Lens distortion correction",
+          "fx,fy,cx,cy,k1,k2,p1,p2 as OpenCV camera matrix and distortion coeffs, applied before the matrix (empty-disable)",
+          "", G_PARAM_READWRITE));
+
+  g_object_class_install_property (gobject_class, PROP_PAD_REMAP,
+      g_param_spec_boolean ("remap",
+          "Correct the image before blob detection",
+          "Remap the frame through the lens and remap-matrix while subtracting the background, instead of correcting blob centroids",
+          FALSE, G_PARAM_READWRITE));
+
+  g_object_class_install_property (gobject_class, PROP_PAD_REMAP_MATRIX,
+      g_param_spec_string ("remap-matrix",
+          "Perspective correction of the remapped image",
+          "6 or 9 coeffs (row major) from undistorted camera pixels to pixels of the remapped image, e.g. the matrix of perspective.xml",
+          "1,0,0,0,1,0", G_PARAM_READWRITE));
+
+  g_object_class_install_property (gobject_class, PROP_PAD_ROI,
+      g_param_spec_string ("roi",
+          "Region of the camera frame to track blobs in",
+          "x,y,width,height in camera pixels, width 0 for the whole frame",
+          "0,0,0,0", G_PARAM_READWRITE));
+}
+
+static void
+gst_blobs_to_tuio_pad_init (GstBlobsToTUIOPad * camera)
+{
+  gint i;
+
+  homography_identity(camera->matrix);
+  homography_identity(camera->remap_matrix);
+  camera->background_buf_learning_init_counter =
+      DEFAULT_LEARN_BACKGROUND_COUNTER;
+  camera->points = g_array_new(FALSE, FALSE, sizeof(BlobPoint));
+  camera->shapes = g_array_new(FALSE, FALSE, sizeof(BlobShape));
+  camera->decimate = 1;
+  camera->bpp = 8;
+  for (i = 0; i < MAX_STAGE; i++)
+    stage_stats_init(&camera->stage_stats[i], DEFAULT_STATS_INTERVAL);
+}
+
+static GstBlobsToTUIOPad *
+gst_blobs_to_tuio_camera_new (GstBlobsToTUIO * blobtuio,
+    GstPadTemplate * templ, const gchar * name)
+{
+  GstBlobsToTUIOPrivate *priv = GST_BLOBSTOTUIO_GET_PRIVATE (blobtuio);
+  GstBlobsToTUIOPad *camera;
+  gchar *padname;
+  gint i, index;
+
+  g_mutex_lock(priv->merge_lock);
+  for (index = 0; index < MAX_CAMERAS; index++) {
+    if (!(priv->camera_mask & (1u << index)))
+      break;
+  }
+  if (index == MAX_CAMERAS) {
+    g_mutex_unlock(priv->merge_lock);
+    return NULL;
+  }
+  priv->camera_mask |= 1u << index;
+  g_mutex_unlock(priv->merge_lock);
+
+  padname = name ? g_strdup (name) : g_strdup_printf ("sink%d", index);
+  camera = g_object_new (GST_TYPE_BLOBSTOTUIO_PAD, "name", padname,
+      "direction", GST_PAD_SINK, "template", templ, NULL);
+  g_free (padname);
+
+  camera->index = index;
+  camera->background_buf_learning_init_counter =
+      priv->background_buf_learning_init_counter;
+  for (i = 0; i < MAX_STAGE; i++)
+    stage_stats_set_window(&camera->stage_stats[i], priv->stats_interval);
+
+  gst_pad_set_chain_function (GST_PAD (camera),
+      GST_DEBUG_FUNCPTR (gst_blobs_to_tuio_chain));
+  gst_pad_set_setcaps_function (GST_PAD (camera),
+      gst_blobs_to_tuio_set_caps);
+
+  g_mutex_lock(priv->merge_lock);
+  priv->cameras = g_slist_append(priv->cameras, camera);
+  g_mutex_unlock(priv->merge_lock);
+
+  return camera;
+}
+
+static GstPad *
+gst_blobs_to_tuio_request_camera (GstBlobsToTUIO * blobtuio,
+    GstPadTemplate * templ, const gchar * name)
+{
+  GstBlobsToTUIOPad *camera;
+
+  GST_DEBUG_OBJECT (blobtuio, "requesting camera pad");
+
+  camera = gst_blobs_to_tuio_camera_new (blobtuio, templ, name);
+  if (!camera)
+    return NULL;
+
+  gst_pad_activate_push (GST_PAD (camera), TRUE);
+  gst_element_add_pad (GST_ELEMENT (blobtuio), GST_PAD (camera));
+
+  return GST_PAD (camera);
+}
+
+static void
+gst_blobs_to_tuio_release_camera (GstBlobsToTUIO * blobtuio,
+    GstBlobsToTUIOPad * camera)
+{
+  GstBlobsToTUIOPrivate *priv = GST_BLOBSTOTUIO_GET_PRIVATE (blobtuio);
+
+  GST_DEBUG_OBJECT (blobtuio, "releasing camera pad");
+
+  gst_pad_set_active (GST_PAD (camera), FALSE);
+
+  /* no chain of this camera runs anymore */
+  g_mutex_lock(priv->merge_lock);
+  priv->cameras = g_slist_remove(priv->cameras, camera);
+  priv->camera_mask &= ~(1u << camera->index);
+  g_mutex_unlock(priv->merge_lock);
+
+  gst_element_remove_pad (GST_ELEMENT_CAST (blobtuio), GST_PAD (camera));
+}
+
 static GstPad *
 gst_blobs_to_tuio_request_new_pad (GstElement * element,
     GstPadTemplate * templ, const gchar * name)
@@ -524,6 +1456,9 @@ gst_blobs_to_tuio_request_new_pad (GstElement * element,
 
   blobtuio = GST_BLOBSTOTUIO (element);
   priv = GST_BLOBSTOTUIO_GET_PRIVATE (blobtuio);
+
+  if (GST_PAD_TEMPLATE_DIRECTION (templ) == GST_PAD_SINK)
+    return gst_blobs_to_tuio_request_camera (blobtuio, templ, name);
   
   GST_DEBUG_OBJECT (blobtuio, "requesting pad");
 
@@ -584,6 +1519,12 @@ gst_blobs_to_tuio_release_pad (GstElement * element, GstPad * pad)
   blobtuio = GST_BLOBSTOTUIO (element);
   priv = GST_BLOBSTOTUIO_GET_PRIVATE (blobtuio);
 
+  if (GST_IS_BLOBSTOTUIO_PAD (pad)) {
+    if (pad != GST_PAD (priv->primary))
+      gst_blobs_to_tuio_release_camera (blobtuio, GST_BLOBSTOTUIO_PAD (pad));
+    return;
+  }
+
   GST_DEBUG_OBJECT (blobtuio, "releasing pad");
 
   GST_OBJECT_LOCK (blobtuio);
@@ -616,6 +1557,8 @@ gst_blobs_to_tuio_base_init (gpointer gclass)
 
   gst_element_class_add_pad_template (element_class,
       gst_static_pad_template_get (&sink_factory));
+  gst_element_class_add_pad_template (element_class,
+      gst_static_pad_template_get (&sink_request_factory));
   gst_element_class_add_pad_template (element_class,
       gst_static_pad_template_get (&src_factory));
 }
@@ -640,11 +1583,13 @@ gst_blobs_to_tuio_class_init (GstBlobsToTUIOClass * klass)
       GST_DEBUG_FUNCPTR (gst_blobs_to_tuio_request_new_pad);
   gstelement_class->release_pad =
       GST_DEBUG_FUNCPTR (gst_blobs_to_tuio_release_pad);
+  gstelement_class->change_state =
+      GST_DEBUG_FUNCPTR (gst_blobs_to_tuio_change_state);
       
   g_object_class_install_property (gobject_class, PROP_MATRIX,
       g_param_spec_string ("matrix",
           "Tranform matrix to match screen coordinates",
-          "6 coeffs of the 3x2 matrix separated by comma",
+          "6 coeffs of the 3x2 matrix or 9 of the 3x3 homography (row major) separated by comma",
           "1,0,0,0,1,0", G_PARAM_WRITABLE));
 
   g_object_class_install_property (gobject_class, PROP_TRACK_DARK,
@@ -750,6 +1695,47 @@ gst_blobs_to_tuio_class_init (GstBlobsToTUIOClass * klass)
           "Blob max distance between 2 frames",
           "Blob max distance between 2 frames (in pixels)",
           0, G_MAXUINT, 40, G_PARAM_READWRITE));
+
+  g_object_class_install_property (gobject_class, PROP_STATS,
+      g_param_spec_boxed ("stats", "Processing stage latency statistics",
+          "Count, mean, p50, p95, p99 and max (in ns) of each processing stage over the last stats-interval frames",
+          GST_TYPE_STRUCTURE, G_PARAM_READABLE));
+
+  g_object_class_install_property (gobject_class,
+      PROP_STATS_INTERVAL, g_param_spec_uint ("stats-interval",
+          "Frames per latency statistics window",
+          "Frames per latency statistics window, a stats element message is posted on the bus after each window of frames from all sink pads (0-disable)",
+          0, G_MAXUINT, DEFAULT_STATS_INTERVAL, G_PARAM_READWRITE));
+
+  g_object_class_install_property (gobject_class,
+      PROP_MERGE_DISTANCE, g_param_spec_uint ("merge-distance",
+          "Max distance of one blob seen by 2 cameras",
+          "Points of different cameras closer than this (in blob coordinates) are merged into one blob",
+          0, G_MAXUINT, DEFAULT_MERGE_DISTANCE, G_PARAM_READWRITE));
+
+  g_object_class_install_property (gobject_class,
+      PROP_DECIMATE, g_param_spec_uint ("decimate",
+          "Decimation of the image stages",
+          "Find blobs on the frame downsampled by 2 or 4 and refine their centroids at full resolution (1-disable, 3 rounds down to 2)",
+          1, 4, DEFAULT_DECIMATE, G_PARAM_READWRITE));
+
+  g_object_class_install_property (gobject_class,
+      PROP_FIDUCIALS, g_param_spec_boolean ("fiducials",
+          "Track fiducial markers",
+          "Find markers in the region adjacency tree of the thresholded image and send them as /tuio/2Dobj, the class id has a hex digit per branch (leaves + 1)",
+          FALSE, G_PARAM_READWRITE));
+
+  g_object_class_install_property (gobject_class,
+      PROP_DEPTH_MIN, g_param_spec_uint ("depth-min",
+          "Min height of a touch above the surface",
+          "With 16 bit depth input, pixels closer than this to the learnt surface (in depth units, mm for Kinect v2) are not touched, the band maps from 255 down to 1",
+          0, G_MAXUINT16, DEFAULT_DEPTH_MIN, G_PARAM_READWRITE));
+
+  g_object_class_install_property (gobject_class,
+      PROP_DEPTH_MAX, g_param_spec_uint ("depth-max",
+          "Max height of a touch above the surface",
+          "With 16 bit depth input, pixels further than this from the learnt surface (in depth units) are hovering and ignored",
+          0, G_MAXUINT16, DEFAULT_DEPTH_MAX, G_PARAM_READWRITE));
 }
 
 /* initialize the new element
@@ -761,41 +1747,17 @@ static void
 gst_blobs_to_tuio_init (GstBlobsToTUIO * blobtuio,
     GstBlobsToTUIOClass * gclass)
 {
-  GstPad *sinkpad;
+  GstPadTemplate *templ;
   GstBlobsToTUIOPrivate *priv = GST_BLOBSTOTUIO_GET_PRIVATE (blobtuio);
-
-  sinkpad = gst_pad_new_from_static_template (&sink_factory, "sink");
-  gst_pad_set_chain_function (sinkpad,
-      GST_DEBUG_FUNCPTR (gst_blobs_to_tuio_chain));
-  gst_pad_set_setcaps_function (sinkpad,
-      gst_blobs_to_tuio_set_caps);
-
-  gst_element_add_pad (GST_ELEMENT (blobtuio), sinkpad);
-
-#if 0
-  gst_pad_set_event_function (sinkpad,
-      GST_DEBUG_FUNCPTR (gst_blobs_to_tuio_handle_sink_event));
-  gst_pad_set_bufferalloc_function (sinkpad,
-      GST_DEBUG_FUNCPTR (gst_blobs_to_tuio_buffer_alloc));
-#endif
+  gint i;
 
   GST_DEBUG_OBJECT(blobtuio, "gst_blobs_to_tuio_init\n");
-  priv->markbuf = NULL;
-  priv->background_buf = NULL;
-  priv->background_buf_fractional = NULL;
-  priv->background_buf_learning_init_counter = 60;
-  priv->working_buf1 = NULL;
-  priv->working_buf2 = NULL;
-  priv->image_blur_temp = NULL;
+  priv->background_buf_learning_init_counter =
+      DEFAULT_LEARN_BACKGROUND_COUNTER;
 
   priv->blobs = NULL;
 
-  priv->matrix[0] = 1; 
-  priv->matrix[1] = 0;
-  priv->matrix[2] = 0;
-  priv->matrix[3] = 0;
-  priv->matrix[4] = 1;
-  priv->matrix[5] = 0;
+  homography_identity(priv->matrix);
   
   priv->trackdark = FALSE;
   priv->smooth = 0;
@@ -824,14 +1786,41 @@ gst_blobs_to_tuio_init (GstBlobsToTUIO * blobtuio,
   priv->surface_min = 30;
   priv->surface_max = 450;
   priv->distance_max = 40;
-}
 
-static gboolean
-parse_matrix (GstBlobsToTUIOPrivate * priv, const gchar* matrix)
-{
-  return (sscanf (matrix, "%f,%f,%f,%f,%f,%f",
-    &(priv->matrix[0]), &(priv->matrix[1]), &(priv->matrix[2]),
-    &(priv->matrix[3]), &(priv->matrix[4]), &(priv->matrix[5])) == 6);
+  for (i = 0; i < 3; i++) {
+    priv->snapshots[i].num_of_frame = 0;
+    priv->snapshots[i].blobs = g_array_new(FALSE, FALSE, sizeof(Blob));
+    priv->snapshots[i].objects = g_array_new(FALSE, FALSE, sizeof(Blob));
+  }
+  priv->output_queue = triple_buffer_new(&priv->snapshots[0],
+      &priv->snapshots[1], &priv->snapshots[2]);
+  priv->output_lock = g_mutex_new();
+  priv->output_coalesced = 0;
+  priv->stats_interval = DEFAULT_STATS_INTERVAL;
+  for (i = 0; i < MAX_STAGE; i++)
+    stage_stats_init(&priv->stage_stats[i], priv->stats_interval);
+
+  priv->merge_lock = g_mutex_new();
+  priv->merged = g_array_new(FALSE, FALSE, sizeof(BlobPoint));
+  priv->merge_distance = DEFAULT_MERGE_DISTANCE;
+  priv->decimate = DEFAULT_DECIMATE;
+  priv->fiducials = FALSE;
+  priv->depth_min = DEFAULT_DEPTH_MIN;
+  priv->depth_max = DEFAULT_DEPTH_MAX;
+
+  /* the always pad is the first camera, more come from sink%d requests */
+  templ = gst_static_pad_template_get (&sink_factory);
+  priv->primary = gst_blobs_to_tuio_camera_new (blobtuio, templ, "sink");
+  gst_object_unref (templ);
+
+  gst_element_add_pad (GST_ELEMENT (blobtuio), GST_PAD (priv->primary));
+
+#if 0
+  gst_pad_set_event_function (sinkpad,
+      GST_DEBUG_FUNCPTR (gst_blobs_to_tuio_handle_sink_event));
+  gst_pad_set_bufferalloc_function (sinkpad,
+      GST_DEBUG_FUNCPTR (gst_blobs_to_tuio_buffer_alloc));
+#endif
 }
 
 #if !defined(G_OS_WIN32)
@@ -865,8 +1854,19 @@ gst_blobs_to_tuio_set_uinput(GstBlobsToTUIOPrivate *priv, gboolean value)
       ioctl(priv->ufile, UI_SET_ABSBIT, ABS_MT_POSITION_X);
       ioctl(priv->ufile, UI_SET_ABSBIT, ABS_MT_POSITION_Y);
       ioctl(priv->ufile, UI_SET_ABSBIT, ABS_MT_TRACKING_ID);
+      ioctl(priv->ufile, UI_SET_ABSBIT, ABS_MT_WIDTH_MAJOR);
+      ioctl(priv->ufile, UI_SET_ABSBIT, ABS_MT_WIDTH_MINOR);
+      ioctl(priv->ufile, UI_SET_ABSBIT, ABS_MT_ORIENTATION);
       uinp.absmax[ABS_MT_TOUCH_MAJOR] = 65535; /* REVISIT */
       uinp.absmin[ABS_MT_TOUCH_MAJOR] = 0;
+      /* ellipse axes in the same units as the position */
+      uinp.absmax[ABS_MT_WIDTH_MAJOR] = 65535;
+      uinp.absmin[ABS_MT_WIDTH_MAJOR] = 0;
+      uinp.absmax[ABS_MT_WIDTH_MINOR] = 65535;
+      uinp.absmin[ABS_MT_WIDTH_MINOR] = 0;
+      /* a quarter revolution either way */
+      uinp.absmax[ABS_MT_ORIENTATION] = 90;
+      uinp.absmin[ABS_MT_ORIENTATION] = -90;
       uinp.absmax[ABS_MT_POSITION_X] = priv->uinput_maxx;
       uinp.absmin[ABS_MT_POSITION_X] = priv->uinput_minx;
       uinp.absmax[ABS_MT_POSITION_Y] = priv->uinput_maxy;
@@ -930,11 +1930,18 @@ gst_blobs_to_tuio_set_property (GObject * object, guint prop_id,
   const gchar* str;
   GstBlobsToTUIO *blobtuio = GST_BLOBSTOTUIO (object);
   GstBlobsToTUIOPrivate *priv = GST_BLOBSTOTUIO_GET_PRIVATE (blobtuio);
+  gfloat matrix[9];
+  GSList *l;
+  gint i;
   
   switch (prop_id) {
     case PROP_MATRIX:
       str = g_value_get_string (value);
-      parse_matrix (priv, str);
+      if (homography_parse (matrix, str)) {
+        g_mutex_lock(priv->output_lock);
+        memcpy (priv->matrix, matrix, sizeof (matrix));
+        g_mutex_unlock(priv->output_lock);
+      }
       break;
     case PROP_TRACK_DARK:
       priv->trackdark = g_value_get_boolean(value);
@@ -956,33 +1963,49 @@ gst_blobs_to_tuio_set_property (GObject * object, guint prop_id,
       break;
     case PROP_LEARN_BACKGROUND_COUNTER:
       priv->background_buf_learning_init_counter = g_value_get_uint(value);
+      g_mutex_lock(priv->merge_lock);
+      for (l = priv->cameras; l; l = l->next) {
+        GST_BLOBSTOTUIO_PAD (l->data)->background_buf_learning_init_counter =
+            priv->background_buf_learning_init_counter;
+      }
+      g_mutex_unlock(priv->merge_lock);
       break;
 #if !defined(G_OS_WIN32)
     case PROP_UINPUT:
+      g_mutex_lock(priv->output_lock);
       gst_blobs_to_tuio_set_uinput(priv, g_value_get_boolean(value));
+      g_mutex_unlock(priv->output_lock);
       break;
     case PROP_UINPUT_DEVNAME:
+      g_mutex_lock(priv->output_lock);
       if (priv->uinput_devname)
         g_free(priv->uinput_devname);
       str = g_value_get_string(value);
       priv->uinput_devname = g_strdup(str);
       gst_blobs_to_tuio_set_uinput(priv, priv->uinput);
+      g_mutex_unlock(priv->output_lock);
       break;
 #if defined(USE_MT_EVENT)
     case PROP_UINPUT_MT:
+      g_mutex_lock(priv->output_lock);
       priv->uinput_mt = g_value_get_boolean(value);
       gst_blobs_to_tuio_set_uinput(priv, priv->uinput);
+      g_mutex_unlock(priv->output_lock);
       break;
 #endif
     case PROP_UINPUT_ABS_X_RANGE:
+      g_mutex_lock(priv->output_lock);
       sscanf (g_value_get_string(value), "%d,%d", &priv->uinput_minx,
           &priv->uinput_maxx);
       gst_blobs_to_tuio_set_uinput(priv, priv->uinput);
+      g_mutex_unlock(priv->output_lock);
       break;
     case PROP_UINPUT_ABS_Y_RANGE:
+      g_mutex_lock(priv->output_lock);
       sscanf (g_value_get_string(value), "%d,%d", &priv->uinput_miny,
           &priv->uinput_maxy);
       gst_blobs_to_tuio_set_uinput(priv, priv->uinput);
+      g_mutex_unlock(priv->output_lock);
       break;
 #endif
     case PROP_TUIO:
@@ -990,21 +2013,25 @@ gst_blobs_to_tuio_set_property (GObject * object, guint prop_id,
       break;
     case PROP_ADDRESS:
       str = g_value_get_string (value);
+      g_mutex_lock(priv->output_lock);
       if (priv->address)
         g_free(priv->address);
       priv->address = g_strdup(str);
       lo_address_free(priv->loaddress);
       priv->loaddress = lo_address_new(priv->address,
           (priv->port == NULL) ? "3333" : priv->port);
+      g_mutex_unlock(priv->output_lock);
       break;
     case PROP_PORT:
       str = g_value_get_string (value);
+      g_mutex_lock(priv->output_lock);
       if (priv->port)
         g_free(priv->port);
       priv->port = g_strdup(str);
       lo_address_free(priv->loaddress);
       priv->loaddress = lo_address_new((priv->address == NULL) ? "127.0.0.1" : 
           priv->address, priv->port);
+      g_mutex_unlock(priv->output_lock);
       break;
     case PROP_SURFACEMIN:
       priv->surface_min = g_value_get_uint (value);
@@ -1015,12 +2042,128 @@ gst_blobs_to_tuio_set_property (GObject * object, guint prop_id,
     case PROP_DISTANCEMAX:
       priv->distance_max = g_value_get_uint (value);
       break;
+    case PROP_STATS_INTERVAL:
+      priv->stats_interval = g_value_get_uint (value);
+      for (i = 0; i < MAX_STAGE; i++)
+        stage_stats_set_window(&priv->stage_stats[i], priv->stats_interval);
+      g_mutex_lock(priv->merge_lock);
+      for (l = priv->cameras; l; l = l->next) {
+        for (i = 0; i < MAX_STAGE; i++)
+          stage_stats_set_window(
+              &GST_BLOBSTOTUIO_PAD (l->data)->stage_stats[i],
+              priv->stats_interval);
+      }
+      g_mutex_unlock(priv->merge_lock);
+      break;
+    case PROP_MERGE_DISTANCE:
+      priv->merge_distance = g_value_get_uint (value);
+      break;
+    case PROP_DECIMATE:
+      priv->decimate = g_value_get_uint (value) & ~1;
+      if (priv->decimate == 0)
+        priv->decimate = 1;
+      break;
+    case PROP_FIDUCIALS:
+      priv->fiducials = g_value_get_boolean (value);
+      break;
+    case PROP_DEPTH_MIN:
+      priv->depth_min = g_value_get_uint (value);
+      break;
+    case PROP_DEPTH_MAX:
+      priv->depth_max = g_value_get_uint (value);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
   }
 }
 
+static void
+gst_blobs_to_tuio_stats_add_stage (GstStructure *s, const gchar *prefix,
+    const gchar *stage, StageStats *stats)
+{
+  StageHistogram hist;
+  gchar field[96];
+
+  stage_stats_get_last(stats, &hist);
+
+  g_snprintf(field, sizeof(field), "%s%s-count", prefix, stage);
+  gst_structure_set (s, field, G_TYPE_UINT64, hist.count, NULL);
+  g_snprintf(field, sizeof(field), "%s%s-mean", prefix, stage);
+  gst_structure_set (s, field, G_TYPE_UINT64,
+      hist.count ? hist.total_ns / hist.count : 0, NULL);
+  g_snprintf(field, sizeof(field), "%s%s-p50", prefix, stage);
+  gst_structure_set (s, field, G_TYPE_UINT64,
+      stage_histogram_percentile(&hist, 50), NULL);
+  g_snprintf(field, sizeof(field), "%s%s-p95", prefix, stage);
+  gst_structure_set (s, field, G_TYPE_UINT64,
+      stage_histogram_percentile(&hist, 95), NULL);
+  g_snprintf(field, sizeof(field), "%s%s-p99", prefix, stage);
+  gst_structure_set (s, field, G_TYPE_UINT64,
+      stage_histogram_percentile(&hist, 99), NULL);
+  g_snprintf(field, sizeof(field), "%s%s-max", prefix, stage);
+  gst_structure_set (s, field, G_TYPE_UINT64, hist.max_ns, NULL);
+}
+
+/* latency of each stage over the last complete window, the image stages
+ * come from the always sink pad, other cameras are prefixed by pad name */
+static GstStructure *
+gst_blobs_to_tuio_stats_structure (GstBlobsToTUIOPrivate *priv)
+{
+  GstStructure *s;
+  GstBlobsToTUIOPad *camera;
+  GSList *l;
+  gchar *prefix;
+  gint i;
+
+  s = gst_structure_empty_new ("blobstotuio-stats");
+  gst_structure_set (s, "coalesced", G_TYPE_UINT, priv->output_coalesced,
+      NULL);
+
+  for (i = 0; i < MAX_STAGE; i++) {
+    gst_blobs_to_tuio_stats_add_stage (s, "", stage_names[i],
+        i < STAGE_BLOB_LIST_UPDATE ? &priv->primary->stage_stats[i] :
+        &priv->stage_stats[i]);
+  }
+
+  g_mutex_lock(priv->merge_lock);
+  for (l = priv->cameras; l; l = l->next) {
+    camera = GST_BLOBSTOTUIO_PAD (l->data);
+    if (camera == priv->primary)
+      continue;
+    prefix = g_strdup_printf ("%s-", GST_PAD_NAME (camera));
+    for (i = 0; i < STAGE_BLOB_LIST_UPDATE; i++) {
+      gst_blobs_to_tuio_stats_add_stage (s, prefix, stage_names[i],
+          &camera->stage_stats[i]);
+    }
+    g_free (prefix);
+  }
+  g_mutex_unlock(priv->merge_lock);
+
+  return s;
+}
+
+static void
+gst_blobs_to_tuio_post_stats (GstBlobsToTUIO *blobtuio)
+{
+  GstBlobsToTUIOPrivate *priv = GST_BLOBSTOTUIO_GET_PRIVATE (blobtuio);
+  GstStructure *s;
+  gchar *str;
+
+  s = gst_blobs_to_tuio_stats_structure (priv);
+
+  /* GST_DEBUG=blobstotuio-stats:5 gives a trace of every window */
+  if (gst_debug_category_get_threshold (gst_blobs_to_tuio_stats_debug) >=
+      GST_LEVEL_LOG) {
+    str = gst_structure_to_string (s);
+    GST_CAT_LOG_OBJECT (gst_blobs_to_tuio_stats_debug, blobtuio, "%s", str);
+    g_free (str);
+  }
+
+  gst_element_post_message (GST_ELEMENT (blobtuio),
+      gst_message_new_element (GST_OBJECT (blobtuio), s));
+}
+
 /* transform amplify shift to amplify */
 static guint
 gst_blobs_to_tuio_get_amplify(int amplify_shift)
@@ -1065,7 +2208,8 @@ gst_blobs_to_tuio_get_property (GObject * object, guint prop_id,
       g_value_set_uint(value, priv->threshold);
       break;
     case PROP_LEARN_BACKGROUND_COUNTER:
-      g_value_set_uint(value, priv->background_buf_learning_init_counter);
+      g_value_set_uint(value,
+          priv->primary->background_buf_learning_init_counter);
       break;
 #if !defined(G_OS_WIN32)
     case PROP_UINPUT:
@@ -1098,37 +2242,122 @@ gst_blobs_to_tuio_get_property (GObject * object, guint prop_id,
     case PROP_DISTANCEMAX:
       g_value_set_uint (value, priv->distance_max);
       break;
+    case PROP_STATS:
+      g_value_take_boxed (value, gst_blobs_to_tuio_stats_structure (priv));
+      break;
+    case PROP_STATS_INTERVAL:
+      g_value_set_uint (value, priv->stats_interval);
+      break;
+    case PROP_MERGE_DISTANCE:
+      g_value_set_uint (value, priv->merge_distance);
+      break;
+    case PROP_DECIMATE:
+      g_value_set_uint (value, priv->decimate);
+      break;
+    case PROP_FIDUCIALS:
+      g_value_set_boolean (value, priv->fiducials);
+      break;
+    case PROP_DEPTH_MIN:
+      g_value_set_uint (value, priv->depth_min);
+      break;
+    case PROP_DEPTH_MAX:
+      g_value_set_uint (value, priv->depth_max);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
   }
 }
 
+/* the output thread only runs while streaming, instances made by
+ * gst-inspect or the registry scan never start one */
+static gboolean
+gst_blobs_to_tuio_start_output (GstBlobsToTUIOPrivate *priv,
+    GstBlobsToTUIO *blobtuio)
+{
+  GError *error = NULL;
+
+  triple_buffer_open(priv->output_queue);
+  priv->output_thread = g_thread_create(output_thread_func, blobtuio,
+      TRUE, &error);
+  if (!priv->output_thread) {
+    GST_ELEMENT_ERROR (blobtuio, RESOURCE, FAILED, (NULL),
+        ("output thread: %s", error->message));
+    g_error_free(error);
+    return FALSE;
+  }
+  return TRUE;
+}
+
 static void
-gst_blobs_to_tuio_finalize (GstBlobsToTUIO * blobtuio)
+gst_blobs_to_tuio_stop_output (GstBlobsToTUIOPrivate *priv)
 {
+  if (!priv->output_thread)
+    return;
+  triple_buffer_close(priv->output_queue);
+  g_thread_join(priv->output_thread);
+  priv->output_thread = NULL;
+}
+
+static GstStateChangeReturn
+gst_blobs_to_tuio_change_state (GstElement * element,
+    GstStateChange transition)
+{
+  GstBlobsToTUIO *blobtuio = GST_BLOBSTOTUIO (element);
   GstBlobsToTUIOPrivate *priv = GST_BLOBSTOTUIO_GET_PRIVATE (blobtuio);
+  GstStateChangeReturn ret;
+
+  switch (transition) {
+    case GST_STATE_CHANGE_READY_TO_PAUSED:
+      if (!gst_blobs_to_tuio_start_output (priv, blobtuio))
+        return GST_STATE_CHANGE_FAILURE;
+      break;
+    default:
+      break;
+  }
 
-  if (priv->markbuf != NULL)
-    g_free(priv->markbuf);
+  ret = GST_ELEMENT_CLASS (parent_class)->change_state (element, transition);
 
-  if (priv->background_buf!= NULL)
-    g_free(priv->background_buf);
+  switch (transition) {
+    case GST_STATE_CHANGE_PAUSED_TO_READY:
+      /* the streaming threads have stopped, nothing publishes any more */
+      gst_blobs_to_tuio_stop_output (priv);
+      break;
+    case GST_STATE_CHANGE_READY_TO_PAUSED:
+      if (ret == GST_STATE_CHANGE_FAILURE)
+        gst_blobs_to_tuio_stop_output (priv);
+      break;
+    default:
+      break;
+  }
 
-  if (priv->background_buf_fractional!= NULL)
-    g_free(priv->background_buf_fractional);
+  return ret;
+}
 
-  if (priv->working_buf1 != NULL)
-    g_free(priv->working_buf1 );
+static void
+gst_blobs_to_tuio_finalize (GstBlobsToTUIO * blobtuio)
+{
+  GstBlobsToTUIOPrivate *priv = GST_BLOBSTOTUIO_GET_PRIVATE (blobtuio);
+  gint i;
 
-  if (priv->working_buf2 != NULL)
-    g_free(priv->working_buf2);
+  /* stop output thread first, it still uses loaddress and ufile */
+  gst_blobs_to_tuio_stop_output(priv);
+  triple_buffer_free(priv->output_queue);
+  g_mutex_free(priv->output_lock);
+  for (i = 0; i < 3; i++) {
+    g_array_free(priv->snapshots[i].blobs, TRUE);
+    g_array_free(priv->snapshots[i].objects, TRUE);
+  }
+  for (i = 0; i < MAX_STAGE; i++)
+    stage_stats_clear(&priv->stage_stats[i]);
 
-  if (priv->image_blur_temp!= NULL)
-    g_free(priv->image_blur_temp);
+  GST_DEBUG_OBJECT(blobtuio, "%u snapshots coalesced by output thread",
+      priv->output_coalesced);
 
-  if (priv->sinkpad)
-    g_object_unref(priv->sinkpad);
+  /* camera pads are owned by the element and go with its pad list */
+  g_slist_free(priv->cameras);
+  g_array_free(priv->merged, TRUE);
+  g_mutex_free(priv->merge_lock);
 
   g_slist_foreach(priv->blobs, (GFunc)g_free, NULL);
   g_slist_free(priv->blobs);
@@ -1158,6 +2387,33 @@ swap_image_pointer(guint8 **img1, guint8 **img2)
   *img2 = img;
 }
 
+/* filter radius on the decimated frame, filters stay on if set */
+static inline guint
+decimated_radius(guint radius, gint decimate)
+{
+  if (radius == 0)
+    return 0;
+  return MAX((radius + decimate / 2) / decimate, 1);
+}
+
+/* nearest neighbour, the columns and rows lost to decimation repeat the
+ * last ones */
+static void
+image8_undecimate(const guint8 *src, guint8 *dst, gint width, gint height,
+    gint decimate)
+{
+  gint x, y;
+  gint src_width = width / decimate;
+  gint src_height = height / decimate;
+  const guint8 *s;
+
+  for (y = 0; y < height; y++) {
+    s = src + MIN(y / decimate, src_height - 1) * src_width;
+    for (x = 0; x < width; x++)
+      *dst++ = s[MIN(x / decimate, src_width - 1)];
+  }
+}
+
 static GstFlowReturn
 gst_blobs_to_tuio_src_processing_image(GstBlobsToTUIO *blobtuio, GstPad *pad,
   GstBuffer *buf, void *image_buf, int size,
@@ -1171,6 +2427,13 @@ gst_blobs_to_tuio_src_processing_image(GstBlobsToTUIO *blobtuio, GstPad *pad,
   priv = GST_BLOBSTOTUIO_GET_PRIVATE(blobtuio);
 
   caps = gst_buffer_get_caps(buf);
+  if (priv->primary->bpp != 8) {
+    /* processing images of depth frames are 8 bit as well */
+    caps = gst_caps_make_writable(caps);
+    gst_structure_remove_field(gst_caps_get_structure(caps, 0), "endianness");
+    gst_caps_set_simple(caps, "bpp", G_TYPE_INT, 8, "depth", G_TYPE_INT, 8,
+        NULL);
+  }
   ret = gst_pad_alloc_buffer_and_set_caps (pad,
       GST_BUFFER_OFFSET_NONE, size, caps, &newbuf);
   gst_caps_unref(caps);
@@ -1184,10 +2447,16 @@ gst_blobs_to_tuio_src_processing_image(GstBlobsToTUIO *blobtuio, GstPad *pad,
   gst_buffer_copy_metadata (newbuf, buf, GST_BUFFER_COPY_TIMESTAMPS |
       GST_BUFFER_COPY_FLAGS);
   /* TODO anything we can optimatize here not to copy, alloc buffer everytime */
+  if (priv->primary->decimate > 1) {
+    /* shown at the frame size, converted in place */
+    image8_undecimate(image_buf, GST_BUFFER_DATA(newbuf),
+        priv->primary->width, priv->primary->height, priv->primary->decimate);
+    image_buf = GST_BUFFER_DATA(newbuf);
+  }
   if (convert_function)
-    convert_function(priv, GST_BUFFER_DATA(newbuf), image_buf, priv->width, priv->height);
-  else
-    memcpy (GST_BUFFER_DATA (newbuf), image_buf, priv->width * priv->height);
+    convert_function(priv, GST_BUFFER_DATA(newbuf), image_buf, priv->primary->width, priv->primary->height);
+  else if (image_buf != GST_BUFFER_DATA(newbuf))
+    memcpy (GST_BUFFER_DATA (newbuf), image_buf, priv->primary->width * priv->primary->height);
 
   return gst_pad_push(pad, newbuf);
 }
@@ -1204,96 +2473,208 @@ gst_blobs_to_tuio_chain(GstPad * pad, GstBuffer * buf)
 {
   GstBlobsToTUIO *blobtuio;
   GstBlobsToTUIOPrivate *priv;
+  GstBlobsToTUIOPad *camera;
   GArray *zones;
+  GArray *moments;
+  GArray *fiducials = NULL;
+  guint8 *frame;
   guint8 *image_buf;
   guint8 *image_buf_temp;
+  gint width, height, decimate, num_marks;
+  guint smooth, highpass_blur, highpass_noise;
+  guint64 t;
+  gboolean stats_window_done;
+  gboolean primary;
+  gboolean was_fresh;
 
   blobtuio = GST_BLOBSTOTUIO (gst_pad_get_parent (pad));
   priv = GST_BLOBSTOTUIO_GET_PRIVATE(blobtuio);
+  camera = GST_BLOBSTOTUIO_PAD (pad);
+  /* only the always pad feeds the processing image src pads */
+  primary = (camera == priv->primary);
 
   GST_DEBUG_OBJECT(blobtuio, "gst_blobs_to_tuio_render%d\n", GST_BUFFER_SIZE (buf));
 
-  if (priv->background_buf_learning_init_counter) {
-    /* copy image to background image */
-    /* we learn background until webcam exposure is steady */
-    guint8 *p;
-    guint8 *b;
-    p = GST_BUFFER_DATA(buf);
-    b = priv->background_buf;
-    priv->background_buf_learning_init_counter--;
-    memcpy(b, p, priv->width * priv->height);
-    memset(priv->background_buf_fractional, 0, priv->width * priv->height * 2);
-  } else {
-    /* learning for background image using a fixed scale (~0.0001=~5min@30fps) */
-    pf_update_background_buf(GST_BUFFER_DATA(buf), priv->background_buf, priv->background_buf_fractional, priv->width, priv->width, priv->height);
-  }
-  /* subtract image with learnt background */
-  if (priv->trackdark) {
-    guint8 *p, *q;
-    guint8 *b;
-    p = GST_BUFFER_DATA(buf);
-    q = priv->working_buf1;
-    b = priv->background_buf;
-    pf_image8_subtract(b, p, q, priv->width, priv->width, priv->height);
+  decimate = priv->decimate;
+  if (decimate != camera->decimate) {
+    /* new geometry, relearn the background */
+    GST_OBJECT_LOCK (camera);
+    camera->decimate = decimate;
+    camera->remap_dirty = TRUE;
+    GST_OBJECT_UNLOCK (camera);
+  }
+  width = camera->width / decimate;
+  height = camera->height / decimate;
+  smooth = decimated_radius(priv->smooth, decimate);
+  highpass_blur = decimated_radius(priv->highpass_blur, decimate);
+  highpass_noise = decimated_radius(priv->highpass_noise, decimate);
+
+  if (camera_update_luts(camera)) {
+    /* the old background has the old geometry, with no learning frames
+     * configured at least this one has to replace it */
+    camera->background_buf_learning_init_counter =
+        MAX(priv->background_buf_learning_init_counter, 1);
+    camera->depth_frames = 0;
+    camera->depth_learnt = FALSE;
+  }
+
+  t = stage_stats_now();
+  /* coarse-to-fine, everything up to the labelling runs decimated */
+  frame = GST_BUFFER_DATA(buf);
+  if ((decimate > 1) && (camera->bpp == 8)) {
+    image8_downsample(frame, camera->coarse_buf, camera->working_buf2,
+        camera->width, camera->height, decimate);
+    frame = camera->coarse_buf;
+  }
+  if (camera->bpp == 16) {
+    /* touches are a band of heights above the learnt surface, the depth
+     * decimates by itself. 0.10 rows are padded to 4 bytes */
+    const guint16 *depth = (const guint16 *)frame;
+    gint stride = GST_ROUND_UP_4 (camera->width * 2) / 2;
+
+    /* without a surface every height is 0, with learn_background_counter
+     * 0 the first frame is the surface */
+    if (camera->background_buf_learning_init_counter ||
+        !camera->depth_learnt) {
+      if (camera->depth_frames++ == 0) {
+        memset(camera->depth_sum, 0, width * height * sizeof(guint32));
+        memset(camera->depth_count, 0, width * height * sizeof(guint16));
+      }
+      image16_depth_accumulate(depth, camera->depth_sum, camera->depth_count,
+          camera->width, camera->height, stride, decimate);
+      if (camera->background_buf_learning_init_counter)
+        camera->background_buf_learning_init_counter--;
+      if (camera->background_buf_learning_init_counter == 0) {
+        image16_depth_background(camera->depth_sum, camera->depth_count,
+            camera->depth_background, width * height);
+        camera->depth_frames = 0;
+        camera->depth_learnt = TRUE;
+      }
+      memset(camera->working_buf1, 0, width * height);
+    } else {
+      image16_depth_height(depth, camera->depth_background,
+          camera->working_buf1, camera->width, camera->height, stride,
+          decimate, priv->depth_min, priv->depth_max);
+    }
+  } else if (camera->remap_lut) {
+    /* geometric correction, background learning and subtraction in one
+     * pass, the corrected frame only passes through working_buf1 a row at
+     * a time */
+    image8_remap_subtract(frame, camera->remap_lut,
+        camera->background_buf, camera->background_buf_fractional,
+        camera->working_buf1, camera->background_buf_learning_init_counter > 0,
+        priv->trackdark);
+    if (camera->background_buf_learning_init_counter)
+      camera->background_buf_learning_init_counter--;
   } else {
-    guint8 *p, *q;
-    guint8 *b;
-    p = GST_BUFFER_DATA(buf);
-    q = priv->working_buf1;
-    b = priv->background_buf;
-    pf_image8_subtract(p, b, q, priv->width, priv->width, priv->height);
+    if (camera->background_buf_learning_init_counter) {
+      /* copy image to background image */
+      /* we learn background until webcam exposure is steady */
+      guint8 *p;
+      guint8 *b;
+      p = frame;
+      b = camera->background_buf;
+      camera->background_buf_learning_init_counter--;
+      memcpy(b, p, width * height);
+      memset(camera->background_buf_fractional, 0, width * height * 2);
+    } else {
+      /* learning for background image using a fixed scale (~0.0001=~5min@30fps) */
+      pf_update_background_buf(frame, camera->background_buf, camera->background_buf_fractional, width, width, height);
+    }
+    /* subtract image with learnt background */
+    if (priv->trackdark) {
+      guint8 *p, *q;
+      guint8 *b;
+      p = frame;
+      q = camera->working_buf1;
+      b = camera->background_buf;
+      pf_image8_subtract(b, p, q, width, width, height);
+    } else {
+      guint8 *p, *q;
+      guint8 *b;
+      p = frame;
+      q = camera->working_buf1;
+      b = camera->background_buf;
+      pf_image8_subtract(p, b, q, width, width, height);
+    }
   }
+  stage_stats_lap(&camera->stage_stats[STAGE_BG], t);
 
-  if (priv->processing_srcpad[BG_SRC_PADi]) {
+  if (primary && priv->processing_srcpad[BG_SRC_PADi]) {
+    /* depth has no 8 bit background, show the height band instead */
     gst_blobs_to_tuio_src_processing_image(blobtuio, priv->processing_srcpad[BG_SRC_PADi],
-      buf, priv->background_buf, priv->width*priv->height, NULL);
+      buf, (camera->bpp == 16) ? camera->working_buf1 : camera->background_buf,
+      camera->width*camera->height, NULL);
   }
 
-  image_buf = priv->working_buf1;
-  image_buf_temp = priv->working_buf2;
+  image_buf = camera->working_buf1;
+  image_buf_temp = camera->working_buf2;
 
-  if (priv->smooth) {
-    pf_image8_box_blur(image_buf, image_buf_temp, priv->width, priv->width, priv->height, priv->image_blur_temp, priv->smooth);
+  t = stage_stats_now();
+  if (smooth) {
+    pf_image8_box_blur(image_buf, image_buf_temp, width, width, height, camera->image_blur_temp, smooth);
     swap_image_pointer(&image_buf, &image_buf_temp);
   }
+  stage_stats_lap(&camera->stage_stats[STAGE_SMOOTH], t);
 
-  if (priv->processing_srcpad[SMOOTH_SRC_PAD]) {
+  if (primary && priv->processing_srcpad[SMOOTH_SRC_PAD]) {
     gst_blobs_to_tuio_src_processing_image(blobtuio, priv->processing_srcpad[SMOOTH_SRC_PAD],
-      buf, image_buf, priv->width*priv->height, NULL);
+      buf, image_buf, camera->width*camera->height, NULL);
   }
 
-  if (priv->highpass_blur) {
+  t = stage_stats_now();
+  if (highpass_blur) {
     /* blur = lowpass filter, we subtract the orignal image with lowpass image to get a highpass image */
-    pf_image8_box_blur(image_buf, image_buf_temp, priv->width, priv->width, priv->height, priv->image_blur_temp, priv->highpass_blur);
-    pf_image8_subtract(image_buf, image_buf_temp, image_buf, priv->width, priv->width, priv->height);
+    pf_image8_box_blur(image_buf, image_buf_temp, width, width, height, camera->image_blur_temp, highpass_blur);
+    pf_image8_subtract(image_buf, image_buf_temp, image_buf, width, width, height);
     /* since noise also highpassed we need blur again to minimize it */
-    if (priv->highpass_noise) {
-      pf_image8_box_blur(image_buf, image_buf_temp, priv->width, priv->width, priv->height, priv->image_blur_temp, priv->highpass_noise);
+    if (highpass_noise) {
+      pf_image8_box_blur(image_buf, image_buf_temp, width, width, height, camera->image_blur_temp, highpass_noise);
       swap_image_pointer(&image_buf, &image_buf_temp);
     }
   }
+  stage_stats_lap(&camera->stage_stats[STAGE_HIGHPASS], t);
 
-  if (priv->processing_srcpad[HIGHPASS_SRC_PAD]) {
+  if (primary && priv->processing_srcpad[HIGHPASS_SRC_PAD]) {
     gst_blobs_to_tuio_src_processing_image(blobtuio, priv->processing_srcpad[HIGHPASS_SRC_PAD],
-      buf, image_buf, priv->width*priv->height, NULL);
+      buf, image_buf, camera->width*camera->height, NULL);
   }
 
+  t = stage_stats_now();
   if (priv->amplify_shift < 8) {
-    pf_image8_amplify(image_buf, image_buf, priv->width, priv->width, priv->height, priv->amplify_shift);
+    pf_image8_amplify(image_buf, image_buf, width, width, height, priv->amplify_shift);
   }
+  stage_stats_lap(&camera->stage_stats[STAGE_AMPLIFY], t);
 
-  if (priv->processing_srcpad[AMPLIFY_SRC_PAD]) {
+  if (primary && priv->processing_srcpad[AMPLIFY_SRC_PAD]) {
     gst_blobs_to_tuio_src_processing_image(blobtuio, priv->processing_srcpad[AMPLIFY_SRC_PAD],
-      buf, image_buf, priv->width*priv->height, NULL);
+      buf, image_buf, camera->width*camera->height, NULL);
   }
 
-  if (priv->processing_srcpad[THRESHOLD_SRC_PAD]) {
+  if (primary && priv->processing_srcpad[THRESHOLD_SRC_PAD]) {
     gst_blobs_to_tuio_src_processing_image(blobtuio, priv->processing_srcpad[THRESHOLD_SRC_PAD],
-      buf, image_buf, priv->width*priv->height, gst_blobs_to_tuio_src_threadhold_convert);
+      buf, image_buf, camera->width*camera->height, gst_blobs_to_tuio_src_threadhold_convert);
   }
 
   /* find blobs zones */
-  find_zones(image_buf, priv->width, priv->height, priv->threshold, priv->surface_min, priv->surface_max, priv->markbuf, &zones);
+  t = stage_stats_now();
+  if (priv->fiducials) {
+    guint64 t_fiducials;
+
+    find_zones_regions(image_buf, width, height, priv->threshold, priv->surface_min / (decimate * decimate), priv->surface_max / (decimate * decimate), camera->markbuf, &zones, &moments, &num_marks);
+
+    /* markers come out of the same components, no second thresholding */
+    t_fiducials = stage_stats_now();
+    find_fiducials(camera->markbuf, width, height, num_marks, priv->surface_min / (decimate * decimate), &fiducials);
+    zones_remove_fiducials(zones, moments, fiducials);
+    stage_stats_lap(&camera->stage_stats[STAGE_FIDUCIALS], t_fiducials);
+    /* keep the markers out of the find-zones time */
+    t += stage_stats_now() - t_fiducials;
+  } else {
+    find_zones_moments(image_buf, width, height, priv->threshold, priv->surface_min / (decimate * decimate), priv->surface_max / (decimate * decimate), camera->markbuf, &zones, &moments);
+  }
+  camera_update_shapes(camera, priv, GST_BUFFER_DATA(buf), zones, moments);
+  stage_stats_lap(&camera->stage_stats[STAGE_FIND_ZONES], t);
 
 #if DEBUG
   {
@@ -1307,8 +2688,25 @@ gst_blobs_to_tuio_chain(GstPad * pad, GstBuffer * buf)
     }
   }
 #endif
-  /* update blobs */
-  blob_list_update(priv, zones);
+  /* each camera runs in its own streaming thread up to here, the merge
+   * and blob tracking run once all live cameras delivered a frame */
+  t = stage_stats_now();
+  g_mutex_lock(priv->merge_lock);
+  was_fresh = camera->fresh;
+  camera_update_points(camera, zones);
+  if (fiducials)
+    camera_update_objects(camera, fiducials);
+  camera->fresh = TRUE;
+  if (merge_due(priv, was_fresh)) {
+    merge_camera_points(priv);
+    blob_list_update(priv, priv->merged);
+    /* hand over to output thread, never wait for it */
+    publish_blobs(priv);
+  }
+  /* frames of every sink pad pass through here, so this window paces the
+   * stats messages even when the always pad gets no frames */
+  stats_window_done = stage_stats_add(
+      &priv->stage_stats[STAGE_BLOB_LIST_UPDATE], stage_stats_now() - t);
 #if DEBUG
   {
     GSList *l;
@@ -1323,21 +2721,15 @@ gst_blobs_to_tuio_chain(GstPad * pad, GstBuffer * buf)
   }
 #endif
 
-  g_array_free(zones, TRUE);
+  g_mutex_unlock(priv->merge_lock);
 
-#if !defined(G_OS_WIN32)
-  if (priv->uinput) {
-#if defined(USE_MT_EVENT)
-    if (priv->uinput_mt)
-      send_uinput_mt(priv);
-    else
-#endif
-      send_uinput(priv);
-  }
-#endif
+  g_array_free(zones, TRUE);
+  g_array_free(moments, TRUE);
+  if (fiducials)
+    g_array_free(fiducials, TRUE);
 
-  if (priv->tuio)
-    send_tuio(priv);
+  if (stats_window_done)
+    gst_blobs_to_tuio_post_stats(blobtuio);
 
   gst_object_unref (blobtuio);
   gst_buffer_unref (buf);
@@ -1393,25 +2785,39 @@ gst_blobs_to_tuio_set_caps (GstPad * pad, GstCaps * caps)
 {
   GstStructure *structure;
   GstBlobsToTUIO *blobtuio;
-  GstBlobsToTUIOPrivate *private;
+  GstBlobsToTUIOPad *camera = GST_BLOBSTOTUIO_PAD (pad);
 
   blobtuio = GST_BLOBSTOTUIO(gst_pad_get_parent (pad));
-
-  private = GST_BLOBSTOTUIO_GET_PRIVATE(blobtuio);
       
   structure = gst_caps_get_structure(caps, 0);
 
   /* get the with and height */
-  gst_structure_get_int(structure, "width", &(private->width));
-  gst_structure_get_int(structure, "height", &(private->height));
+  gst_structure_get_int(structure, "width", &(camera->width));
+  gst_structure_get_int(structure, "height", &(camera->height));
+  if (!gst_structure_get_int(structure, "bpp", &(camera->bpp)))
+    camera->bpp = 8;
+
+  GST_OBJECT_LOCK (camera);
+  camera->lut_dirty = TRUE;
+  camera->remap_dirty = TRUE;
+  GST_OBJECT_UNLOCK (camera);
  
-  /* allocate buffers */
-  private->markbuf = (gint*)g_malloc(private->width * private->height * sizeof(gint));
-  private->background_buf = (guint8*)g_malloc(private->width * private->height * sizeof(guint8));
-  private->background_buf_fractional = (guint16*)g_malloc(private->width * private->height * sizeof(guint16));
-  private->working_buf1 = (guint8*)g_malloc(private->width * private->height * sizeof(guint8));
-  private->working_buf2 = (guint8*)g_malloc(private->width * private->height * sizeof(guint8));
-  private->image_blur_temp = (guint8*)g_malloc(private->width * private->height * sizeof(guint8));
+  /* allocate buffers, caps may change while streaming */
+  gst_blobs_to_tuio_pad_free_buffers(camera);
+  camera->markbuf = (gint*)g_malloc(camera->width * camera->height * sizeof(gint));
+  camera->background_buf = (guint8*)g_malloc(camera->width * camera->height * sizeof(guint8));
+  camera->background_buf_fractional = (guint16*)g_malloc(camera->width * camera->height * sizeof(guint16));
+  camera->working_buf1 = (guint8*)g_malloc(camera->width * camera->height * sizeof(guint8));
+  camera->working_buf2 = (guint8*)g_malloc(camera->width * camera->height * sizeof(guint8));
+  camera->image_blur_temp = (guint8*)g_malloc(camera->width * camera->height * sizeof(guint8));
+  camera->coarse_buf = (guint8*)g_malloc((camera->width / 2) * (camera->height / 2) * sizeof(guint8));
+  if (camera->bpp == 16) {
+    camera->depth_background = (guint16*)g_malloc0(camera->width * camera->height * sizeof(guint16));
+    camera->depth_sum = (guint32*)g_malloc(camera->width * camera->height * sizeof(guint32));
+    camera->depth_count = (guint16*)g_malloc(camera->width * camera->height * sizeof(guint16));
+  }
+  camera->depth_frames = 0;
+  camera->depth_learnt = FALSE;
 
   gst_object_unref (blobtuio);
     
@@ -1429,6 +2835,21 @@ blobstotuio_init (GstPlugin * blobstotuio)
    */
   GST_DEBUG_CATEGORY_INIT (gst_blobs_to_tuio_debug, "blobstotuio",
       0, "Generate touch event from grayscale image");
+  GST_DEBUG_CATEGORY_INIT (gst_blobs_to_tuio_stats_debug,
+      "blobstotuio-stats", 0, "Per stage latency of blobstotuio");
+
+  /* only use the SIMD kernels that agree with the c reference */
+  image_utils_install_verified ();
+
+  if (!gst_element_register (blobstotuio, "grayrecord", GST_RANK_NONE,
+      GST_TYPE_GRAYRECORD))
+    return FALSE;
+  if (!gst_element_register (blobstotuio, "grayreplay", GST_RANK_NONE,
+      GST_TYPE_GRAYREPLAY))
+    return FALSE;
+  if (!gst_element_register (blobstotuio, "frameringsrc", GST_RANK_NONE,
+      GST_TYPE_FRAMERINGSRC))
+    return FALSE;
 
   return gst_element_register (blobstotuio, "blobstotuio", GST_RANK_NONE,
       GST_TYPE_BLOBSTOTUIO);
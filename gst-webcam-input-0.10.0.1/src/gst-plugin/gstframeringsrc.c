@@ -0,0 +1,479 @@
+/*
+ *  gst-tuio - Gstreamer to tuio computer vision plugin
+ *
+ *  Copyright (C) 2010 Keith Mok <ek9852@gmail.com>
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+#ifdef HAVE_CONFIG_H
+#  include <config.h>
+#endif
+
+#include <gst/gst.h>
+
+#include "gstframeringsrc.h"
+#include "frame_ring.h"
+#include "stage_stats.h"
+
+/* Frames from a capture process sharing them through a frame ring, e.g.
+ * the depth or IR stream of a Kinect v2 published by its frame listener.
+ * Buffers point into the read only shared memory and hold their slot until
+ * they are freed, nothing is copied on the way to blobstotuio:
+ *
+ *   gst-launch frameringsrc socket-path=/tmp/kinect-depth ! blobstotuio
+ *
+ * The capture stage times the producer sends along are kept in latency
+ * histograms, with the handoff through the ring as one more stage, so
+ * USB and decoder stalls show up without a profiling build of the
+ * capture library.
+ */
+
+GST_DEBUG_CATEGORY_STATIC (gst_frame_ring_src_debug);
+#define GST_CAT_DEFAULT gst_frame_ring_src_debug
+
+#define GST_FRAMERINGSRC_GET_PRIVATE(obj)  \
+   (G_TYPE_INSTANCE_GET_PRIVATE ((obj), GST_TYPE_FRAMERINGSRC, \
+   GstFrameRingSrcPrivate))
+
+#define DEFAULT_SOCKET_PATH "/tmp/frame-ring"
+#define DEFAULT_STATS_INTERVAL 300
+
+/* the capture stages, then from the capture timestamp to create */
+#define STAGE_HANDOFF FRAME_RING_STAGES
+#define MAX_STAGE (FRAME_RING_STAGES + 1)
+
+static const gchar *stage_names[MAX_STAGE] = {
+  "usb",
+  "parser",
+  "rgb-decode",
+  "depth-decode",
+  "delivery",
+  "handoff"
+};
+
+typedef struct _HeldFrame HeldFrame;
+
+struct _GstFrameRingSrcPrivate
+{
+  gchar *socket_path;
+
+  FrameRingConsumer *ring;
+  guint64 frames;
+
+  StageStats stage_stats[MAX_STAGE];
+  guint stats_interval;
+};
+
+/* malloc data of the buffers, releases the slot when they are freed */
+struct _HeldFrame
+{
+  FrameRingConsumer *ring;
+  gint slot;
+};
+
+enum
+{
+  PROP_0,
+  PROP_SOCKET_PATH,
+  PROP_STATS,
+  PROP_STATS_INTERVAL
+};
+
+static GstStaticPadTemplate src_factory = GST_STATIC_PAD_TEMPLATE ("src",
+    GST_PAD_SRC,
+    GST_PAD_ALWAYS,
+    GST_STATIC_CAPS ("video/x-raw-gray,bpp=8,depth=8; "
+        "video/x-raw-gray,bpp=16,depth=16,endianness=1234")
+    );
+
+#define DEBUG_INIT(bla) \
+  GST_DEBUG_CATEGORY_INIT (gst_frame_ring_src_debug, "frameringsrc", 0, \
+      "Frames shared by a capture process");
+
+GST_BOILERPLATE_FULL (GstFrameRingSrc, gst_frame_ring_src, GstPushSrc,
+    GST_TYPE_PUSH_SRC, DEBUG_INIT);
+
+static void gst_frame_ring_src_set_property (GObject * object, guint prop_id,
+    const GValue * value, GParamSpec * pspec);
+static void gst_frame_ring_src_get_property (GObject * object, guint prop_id,
+    GValue * value, GParamSpec * pspec);
+static void gst_frame_ring_src_finalize (GstFrameRingSrc * src);
+static gboolean gst_frame_ring_src_start (GstBaseSrc * src);
+static gboolean gst_frame_ring_src_stop (GstBaseSrc * src);
+static GstCaps *gst_frame_ring_src_get_caps (GstBaseSrc * src);
+static gboolean gst_frame_ring_src_unlock (GstBaseSrc * src);
+static gboolean gst_frame_ring_src_unlock_stop (GstBaseSrc * src);
+static GstFlowReturn gst_frame_ring_src_create (GstPushSrc * src,
+    GstBuffer ** buf);
+
+static void
+gst_frame_ring_src_base_init (gpointer gclass)
+{
+  GstElementClass *element_class = GST_ELEMENT_CLASS (gclass);
+
+  gst_element_class_set_details_simple(element_class,
+    "FrameRingSrc",
+    "Source/Video",
+    "Receive frames from a capture process through shared memory",
+    "keithmok <ek9852@gmail.com>");
+
+  gst_element_class_add_pad_template (element_class,
+      gst_static_pad_template_get (&src_factory));
+}
+
+static void
+gst_frame_ring_src_class_init (GstFrameRingSrcClass * klass)
+{
+  GObjectClass *gobject_class;
+  GstBaseSrcClass *basesrc_class;
+  GstPushSrcClass *pushsrc_class;
+
+  gobject_class = (GObjectClass *) klass;
+  basesrc_class = (GstBaseSrcClass *) klass;
+  pushsrc_class = (GstPushSrcClass *) klass;
+
+  g_type_class_add_private (klass, sizeof (GstFrameRingSrcPrivate));
+
+  gobject_class->finalize = (GObjectFinalizeFunc) gst_frame_ring_src_finalize;
+  gobject_class->set_property = gst_frame_ring_src_set_property;
+  gobject_class->get_property = gst_frame_ring_src_get_property;
+
+  g_object_class_install_property (gobject_class, PROP_SOCKET_PATH,
+      g_param_spec_string ("socket-path", "Socket path",
+          "Unix socket the capture process publishes its frame ring on",
+          DEFAULT_SOCKET_PATH, G_PARAM_READWRITE));
+
+  g_object_class_install_property (gobject_class, PROP_STATS,
+      g_param_spec_boxed ("stats", "Capture stage latency statistics",
+          "Count, mean, p50, p95, p99 and max (in ns) of each capture stage over the last stats-interval frames",
+          GST_TYPE_STRUCTURE, G_PARAM_READABLE));
+
+  g_object_class_install_property (gobject_class,
+      PROP_STATS_INTERVAL, g_param_spec_uint ("stats-interval",
+          "Frames per latency statistics window",
+          "Frames per latency statistics window, a stats element message is posted on the bus after each window (0-disable)",
+          0, G_MAXUINT, DEFAULT_STATS_INTERVAL, G_PARAM_READWRITE));
+
+  basesrc_class->start = GST_DEBUG_FUNCPTR (gst_frame_ring_src_start);
+  basesrc_class->stop = GST_DEBUG_FUNCPTR (gst_frame_ring_src_stop);
+  basesrc_class->get_caps = GST_DEBUG_FUNCPTR (gst_frame_ring_src_get_caps);
+  basesrc_class->unlock = GST_DEBUG_FUNCPTR (gst_frame_ring_src_unlock);
+  basesrc_class->unlock_stop =
+      GST_DEBUG_FUNCPTR (gst_frame_ring_src_unlock_stop);
+  pushsrc_class->create = GST_DEBUG_FUNCPTR (gst_frame_ring_src_create);
+}
+
+static void
+gst_frame_ring_src_init (GstFrameRingSrc * src, GstFrameRingSrcClass * gclass)
+{
+  GstFrameRingSrcPrivate *priv = GST_FRAMERINGSRC_GET_PRIVATE (src);
+  gint i;
+
+  priv->socket_path = g_strdup (DEFAULT_SOCKET_PATH);
+  priv->ring = NULL;
+  priv->stats_interval = DEFAULT_STATS_INTERVAL;
+  for (i = 0; i < MAX_STAGE; i++)
+    stage_stats_init (&priv->stage_stats[i], priv->stats_interval);
+
+  gst_base_src_set_format (GST_BASE_SRC (src), GST_FORMAT_TIME);
+  gst_base_src_set_live (GST_BASE_SRC (src), TRUE);
+  gst_base_src_set_do_timestamp (GST_BASE_SRC (src), TRUE);
+}
+
+static void
+gst_frame_ring_src_finalize (GstFrameRingSrc * src)
+{
+  GstFrameRingSrcPrivate *priv = GST_FRAMERINGSRC_GET_PRIVATE (src);
+  gint i;
+
+  g_free (priv->socket_path);
+  for (i = 0; i < MAX_STAGE; i++)
+    stage_stats_clear (&priv->stage_stats[i]);
+
+  G_OBJECT_CLASS (parent_class)->finalize (G_OBJECT (src));
+}
+
+static void
+gst_frame_ring_src_set_property (GObject * object, guint prop_id,
+    const GValue * value, GParamSpec * pspec)
+{
+  GstFrameRingSrcPrivate *priv = GST_FRAMERINGSRC_GET_PRIVATE (object);
+  gint i;
+
+  switch (prop_id) {
+    case PROP_SOCKET_PATH:
+      if (priv->ring) {
+        g_warning ("Cannot change socket-path while playing");
+        break;
+      }
+      g_free (priv->socket_path);
+      priv->socket_path = g_value_dup_string (value);
+      break;
+    case PROP_STATS_INTERVAL:
+      priv->stats_interval = g_value_get_uint (value);
+      for (i = 0; i < MAX_STAGE; i++)
+        stage_stats_set_window (&priv->stage_stats[i], priv->stats_interval);
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+      break;
+  }
+}
+
+static void
+gst_frame_ring_src_stats_add_stage (GstStructure *s, const gchar *stage,
+    StageStats *stats)
+{
+  StageHistogram hist;
+  gchar field[64];
+
+  stage_stats_get_last (stats, &hist);
+
+  g_snprintf (field, sizeof(field), "%s-count", stage);
+  gst_structure_set (s, field, G_TYPE_UINT64, hist.count, NULL);
+  g_snprintf (field, sizeof(field), "%s-mean", stage);
+  gst_structure_set (s, field, G_TYPE_UINT64,
+      hist.count ? hist.total_ns / hist.count : 0, NULL);
+  g_snprintf (field, sizeof(field), "%s-p50", stage);
+  gst_structure_set (s, field, G_TYPE_UINT64,
+      stage_histogram_percentile (&hist, 50), NULL);
+  g_snprintf (field, sizeof(field), "%s-p95", stage);
+  gst_structure_set (s, field, G_TYPE_UINT64,
+      stage_histogram_percentile (&hist, 95), NULL);
+  g_snprintf (field, sizeof(field), "%s-p99", stage);
+  gst_structure_set (s, field, G_TYPE_UINT64,
+      stage_histogram_percentile (&hist, 99), NULL);
+  g_snprintf (field, sizeof(field), "%s-max", stage);
+  gst_structure_set (s, field, G_TYPE_UINT64, hist.max_ns, NULL);
+}
+
+/* latency of each stage over the last complete window, stages the
+ * producer does not time have a count of 0 */
+static GstStructure *
+gst_frame_ring_src_stats_structure (GstFrameRingSrcPrivate *priv)
+{
+  GstStructure *s;
+  gint i;
+
+  s = gst_structure_empty_new ("frameringsrc-stats");
+  for (i = 0; i < MAX_STAGE; i++)
+    gst_frame_ring_src_stats_add_stage (s, stage_names[i],
+        &priv->stage_stats[i]);
+  return s;
+}
+
+static void
+gst_frame_ring_src_get_property (GObject * object, guint prop_id,
+    GValue * value, GParamSpec * pspec)
+{
+  GstFrameRingSrcPrivate *priv = GST_FRAMERINGSRC_GET_PRIVATE (object);
+
+  switch (prop_id) {
+    case PROP_SOCKET_PATH:
+      g_value_set_string (value, priv->socket_path);
+      break;
+    case PROP_STATS:
+      g_value_take_boxed (value, gst_frame_ring_src_stats_structure (priv));
+      break;
+    case PROP_STATS_INTERVAL:
+      g_value_set_uint (value, priv->stats_interval);
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+      break;
+  }
+}
+
+static gboolean
+gst_frame_ring_src_start (GstBaseSrc * src)
+{
+  GstFrameRingSrcPrivate *priv = GST_FRAMERINGSRC_GET_PRIVATE (src);
+  const FrameRingInfo *info;
+  GError *error = NULL;
+
+  if (!priv->socket_path) {
+    GST_ELEMENT_ERROR (src, RESOURCE, NOT_FOUND,
+        ("No socket path set"), (NULL));
+    return FALSE;
+  }
+
+  priv->ring = frame_ring_consumer_new (priv->socket_path, &error);
+  if (!priv->ring) {
+    GST_ELEMENT_ERROR (src, RESOURCE, OPEN_READ, (NULL),
+        ("%s", error->message));
+    g_error_free (error);
+    return FALSE;
+  }
+
+  /* buffers are the slots themselves, rows have to be what caps imply */
+  info = frame_ring_consumer_get_info (priv->ring);
+  if ((info->bpp != 8 && info->bpp != 16) ||
+      (info->stride != GST_ROUND_UP_4 (info->width * info->bpp / 8))) {
+    GST_ELEMENT_ERROR (src, STREAM, FORMAT, (NULL),
+        ("Unsupported frame ring, %d bpp with %d bytes per row of %d",
+            info->bpp, info->stride, info->width));
+    frame_ring_consumer_unref (priv->ring);
+    priv->ring = NULL;
+    return FALSE;
+  }
+
+  GST_DEBUG_OBJECT (src, "%dx%d %d bpp in %d slots", info->width,
+      info->height, info->bpp, info->num_slots);
+  priv->frames = 0;
+  return TRUE;
+}
+
+/* buffers still downstream keep the ring mapped */
+static gboolean
+gst_frame_ring_src_stop (GstBaseSrc * src)
+{
+  GstFrameRingSrcPrivate *priv = GST_FRAMERINGSRC_GET_PRIVATE (src);
+
+  if (priv->ring) {
+    frame_ring_consumer_unref (priv->ring);
+    priv->ring = NULL;
+  }
+  return TRUE;
+}
+
+static GstCaps *
+gst_frame_ring_src_get_caps (GstBaseSrc * src)
+{
+  GstFrameRingSrcPrivate *priv = GST_FRAMERINGSRC_GET_PRIVATE (src);
+  const FrameRingInfo *info;
+  GstCaps *caps;
+
+  if (!priv->ring)
+    return gst_caps_copy (gst_pad_get_pad_template_caps (
+            GST_BASE_SRC_PAD (src)));
+
+  info = frame_ring_consumer_get_info (priv->ring);
+  caps = gst_caps_new_simple ("video/x-raw-gray",
+      "bpp", G_TYPE_INT, info->bpp,
+      "depth", G_TYPE_INT, info->bpp,
+      "width", G_TYPE_INT, info->width,
+      "height", G_TYPE_INT, info->height,
+      "framerate", GST_TYPE_FRACTION, info->fps_n,
+      (info->fps_n > 0) ? info->fps_d : 1,
+      NULL);
+  if (info->bpp == 16)
+    gst_caps_set_simple (caps, "endianness", G_TYPE_INT, G_LITTLE_ENDIAN,
+        NULL);
+  return caps;
+}
+
+static gboolean
+gst_frame_ring_src_unlock (GstBaseSrc * src)
+{
+  GstFrameRingSrcPrivate *priv = GST_FRAMERINGSRC_GET_PRIVATE (src);
+
+  if (priv->ring)
+    frame_ring_consumer_set_flushing (priv->ring, TRUE);
+  return TRUE;
+}
+
+static gboolean
+gst_frame_ring_src_unlock_stop (GstBaseSrc * src)
+{
+  GstFrameRingSrcPrivate *priv = GST_FRAMERINGSRC_GET_PRIVATE (src);
+
+  if (priv->ring)
+    frame_ring_consumer_set_flushing (priv->ring, FALSE);
+  return TRUE;
+}
+
+static void
+release_frame (gpointer data)
+{
+  HeldFrame *held = data;
+
+  frame_ring_consumer_release (held->ring, held->slot);
+  frame_ring_consumer_unref (held->ring);
+  g_slice_free (HeldFrame, held);
+}
+
+/* a stats message is posted whenever a stage window is complete */
+static void
+account_stages (GstFrameRingSrc * src, gint slot, guint64 timestamp)
+{
+  GstFrameRingSrcPrivate *priv = GST_FRAMERINGSRC_GET_PRIVATE (src);
+  guint64 stage_ns[FRAME_RING_STAGES];
+  guint64 now = stage_stats_now ();
+  gboolean window_done = FALSE;
+  gint i;
+
+  frame_ring_consumer_get_stage_times (priv->ring, slot, stage_ns);
+  for (i = 0; i < FRAME_RING_STAGES; i++) {
+    if (stage_ns[i])
+      window_done |= stage_stats_add (&priv->stage_stats[i], stage_ns[i]);
+  }
+  if (timestamp && (timestamp <= now))
+    window_done |= stage_stats_add (&priv->stage_stats[STAGE_HANDOFF],
+        now - timestamp);
+
+  if (window_done)
+    gst_element_post_message (GST_ELEMENT (src),
+        gst_message_new_element (GST_OBJECT (src),
+            gst_frame_ring_src_stats_structure (priv)));
+}
+
+static GstFlowReturn
+gst_frame_ring_src_create (GstPushSrc * src, GstBuffer ** buf)
+{
+  GstFrameRingSrcPrivate *priv = GST_FRAMERINGSRC_GET_PRIVATE (src);
+  const FrameRingInfo *info = frame_ring_consumer_get_info (priv->ring);
+  GError *error = NULL;
+  HeldFrame *held;
+  guint64 timestamp;
+  const guint8 *data;
+  gint slot;
+
+  slot = frame_ring_consumer_wait (priv->ring, &data, &timestamp, &error);
+  if (slot < 0) {
+    if (!error)
+      return GST_FLOW_WRONG_STATE;
+    GST_ELEMENT_ERROR (src, RESOURCE, READ, (NULL), ("%s", error->message));
+    g_error_free (error);
+    return GST_FLOW_ERROR;
+  }
+  account_stages (GST_FRAMERINGSRC (src), slot, timestamp);
+
+  held = g_slice_new (HeldFrame);
+  held->ring = frame_ring_consumer_ref (priv->ring);
+  held->slot = slot;
+
+  /* the slot is mapped read only, writers have to copy */
+  *buf = gst_buffer_new ();
+  GST_BUFFER_FLAG_SET (*buf, GST_BUFFER_FLAG_READONLY);
+  GST_BUFFER_DATA (*buf) = (guint8 *) data;
+  GST_BUFFER_SIZE (*buf) = info->stride * info->height;
+  GST_BUFFER_MALLOCDATA (*buf) = (guint8 *) held;
+  GST_BUFFER_FREE_FUNC (*buf) = release_frame;
+  gst_buffer_set_caps (*buf, GST_PAD_CAPS (GST_BASE_SRC_PAD (src)));
+
+  /* do-timestamp stamps the buffer with the running time on return */
+  if (info->fps_n > 0)
+    GST_BUFFER_DURATION (*buf) = gst_util_uint64_scale (GST_SECOND,
+        info->fps_d, info->fps_n);
+  GST_BUFFER_OFFSET (*buf) = priv->frames;
+  GST_BUFFER_OFFSET_END (*buf) = priv->frames + 1;
+  priv->frames++;
+
+  GST_LOG_OBJECT (src, "slot %d, capture timestamp %" G_GUINT64_FORMAT,
+      slot, timestamp);
+  return GST_FLOW_OK;
+}
@@ -0,0 +1,272 @@
+/*
+ *  gst-tuio - Gstreamer to tuio computer vision plugin
+ *
+ *  Copyright (C) 2010 Keith Mok <ek9852@gmail.com>
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+#ifdef HAVE_CONFIG_H
+#  include <config.h>
+#endif
+
+#include <gst/gst.h>
+
+#include "gstgrayrecord.h"
+#include "gray_capture.h"
+
+/* Records GRAY8 frames with their timestamps into a capture file for
+ * grayreplay and blobs-bench, e.g.
+ *
+ *   gst-launch v4l2src ! ffmpegcolorspace ! \
+ *       video/x-raw-gray,width=320,height=240 ! grayrecord location=t.gray
+ */
+
+GST_DEBUG_CATEGORY_STATIC (gst_gray_record_debug);
+#define GST_CAT_DEFAULT gst_gray_record_debug
+
+#define GST_GRAYRECORD_GET_PRIVATE(obj)  \
+   (G_TYPE_INSTANCE_GET_PRIVATE ((obj), GST_TYPE_GRAYRECORD, \
+   GstGrayRecordPrivate))
+
+struct _GstGrayRecordPrivate
+{
+  gchar *location;
+  GrayCaptureWriter *writer;
+  gint width;
+  gint height;
+  gint fps_n;
+  gint fps_d;
+};
+
+enum
+{
+  PROP_0,
+  PROP_LOCATION
+};
+
+static GstStaticPadTemplate sink_factory = GST_STATIC_PAD_TEMPLATE ("sink",
+    GST_PAD_SINK,
+    GST_PAD_ALWAYS,
+    GST_STATIC_CAPS ("video/x-raw-gray,bpp=8,depth=8")
+    );
+
+#define DEBUG_INIT(bla) \
+  GST_DEBUG_CATEGORY_INIT (gst_gray_record_debug, "grayrecord", 0, \
+      "Record GRAY8 frames into a capture file");
+
+GST_BOILERPLATE_FULL (GstGrayRecord, gst_gray_record, GstBaseSink,
+    GST_TYPE_BASE_SINK, DEBUG_INIT);
+
+static void gst_gray_record_set_property (GObject * object, guint prop_id,
+    const GValue * value, GParamSpec * pspec);
+static void gst_gray_record_get_property (GObject * object, guint prop_id,
+    GValue * value, GParamSpec * pspec);
+static void gst_gray_record_finalize (GstGrayRecord * record);
+static gboolean gst_gray_record_set_caps (GstBaseSink * sink, GstCaps * caps);
+static gboolean gst_gray_record_stop (GstBaseSink * sink);
+static GstFlowReturn gst_gray_record_render (GstBaseSink * sink,
+    GstBuffer * buf);
+
+static void
+gst_gray_record_base_init (gpointer gclass)
+{
+  GstElementClass *element_class = GST_ELEMENT_CLASS (gclass);
+
+  gst_element_class_set_details_simple(element_class,
+    "GrayRecord",
+    "Sink/File",
+    "Record GRAY8 frames with timestamps for offline replay",
+    "keithmok <ek9852@gmail.com>");
+
+  gst_element_class_add_pad_template (element_class,
+      gst_static_pad_template_get (&sink_factory));
+}
+
+static void
+gst_gray_record_class_init (GstGrayRecordClass * klass)
+{
+  GObjectClass *gobject_class;
+  GstBaseSinkClass *basesink_class;
+
+  gobject_class = (GObjectClass *) klass;
+  basesink_class = (GstBaseSinkClass *) klass;
+
+  g_type_class_add_private (klass, sizeof (GstGrayRecordPrivate));
+
+  gobject_class->finalize = (GObjectFinalizeFunc) gst_gray_record_finalize;
+  gobject_class->set_property = gst_gray_record_set_property;
+  gobject_class->get_property = gst_gray_record_get_property;
+
+  g_object_class_install_property (gobject_class, PROP_LOCATION,
+      g_param_spec_string ("location", "File location",
+          "Capture file to write", NULL, G_PARAM_READWRITE));
+
+  basesink_class->set_caps = GST_DEBUG_FUNCPTR (gst_gray_record_set_caps);
+  basesink_class->stop = GST_DEBUG_FUNCPTR (gst_gray_record_stop);
+  basesink_class->render = GST_DEBUG_FUNCPTR (gst_gray_record_render);
+}
+
+static void
+gst_gray_record_init (GstGrayRecord * record, GstGrayRecordClass * gclass)
+{
+  GstGrayRecordPrivate *priv = GST_GRAYRECORD_GET_PRIVATE (record);
+
+  priv->location = NULL;
+  priv->writer = NULL;
+
+  /* write as fast as frames come, do not throttle the camera */
+  g_object_set (record, "sync", FALSE, NULL);
+}
+
+static void
+gst_gray_record_finalize (GstGrayRecord * record)
+{
+  GstGrayRecordPrivate *priv = GST_GRAYRECORD_GET_PRIVATE (record);
+
+  g_free (priv->location);
+
+  G_OBJECT_CLASS (parent_class)->finalize (G_OBJECT (record));
+}
+
+static void
+gst_gray_record_set_property (GObject * object, guint prop_id,
+    const GValue * value, GParamSpec * pspec)
+{
+  GstGrayRecordPrivate *priv = GST_GRAYRECORD_GET_PRIVATE (object);
+
+  switch (prop_id) {
+    case PROP_LOCATION:
+      if (priv->writer) {
+        g_warning ("Cannot change location while recording");
+        break;
+      }
+      g_free (priv->location);
+      priv->location = g_value_dup_string (value);
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+      break;
+  }
+}
+
+static void
+gst_gray_record_get_property (GObject * object, guint prop_id,
+    GValue * value, GParamSpec * pspec)
+{
+  GstGrayRecordPrivate *priv = GST_GRAYRECORD_GET_PRIVATE (object);
+
+  switch (prop_id) {
+    case PROP_LOCATION:
+      g_value_set_string (value, priv->location);
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+      break;
+  }
+}
+
+static gboolean
+gst_gray_record_set_caps (GstBaseSink * sink, GstCaps * caps)
+{
+  GstGrayRecordPrivate *priv = GST_GRAYRECORD_GET_PRIVATE (sink);
+  GstStructure *structure;
+  GError *error = NULL;
+  gint width, height;
+  gint fps_n = 0, fps_d = 1;
+
+  structure = gst_caps_get_structure (caps, 0);
+  if (!gst_structure_get_int (structure, "width", &width) ||
+      !gst_structure_get_int (structure, "height", &height))
+    return FALSE;
+  gst_structure_get_fraction (structure, "framerate", &fps_n, &fps_d);
+
+  /* a capture holds frames of a single size */
+  if (priv->writer)
+    return (width == priv->width) && (height == priv->height);
+
+  if (!priv->location) {
+    GST_ELEMENT_ERROR (sink, RESOURCE, NOT_FOUND,
+        ("No capture file location set"), (NULL));
+    return FALSE;
+  }
+
+  priv->writer = gray_capture_writer_new (priv->location, width, height,
+      fps_n, fps_d, &error);
+  if (!priv->writer) {
+    GST_ELEMENT_ERROR (sink, RESOURCE, OPEN_WRITE, (NULL),
+        ("%s", error->message));
+    g_error_free (error);
+    return FALSE;
+  }
+  priv->width = width;
+  priv->height = height;
+  priv->fps_n = fps_n;
+  priv->fps_d = fps_d;
+
+  GST_DEBUG_OBJECT (sink, "recording %dx%d to %s", width, height,
+      priv->location);
+  return TRUE;
+}
+
+static gboolean
+gst_gray_record_stop (GstBaseSink * sink)
+{
+  GstGrayRecordPrivate *priv = GST_GRAYRECORD_GET_PRIVATE (sink);
+  GError *error = NULL;
+
+  if (priv->writer) {
+    if (!gray_capture_writer_close (priv->writer, &error)) {
+      GST_ELEMENT_ERROR (sink, RESOURCE, CLOSE, (NULL),
+          ("%s", error->message));
+      g_error_free (error);
+    }
+    priv->writer = NULL;
+  }
+  return TRUE;
+}
+
+static GstFlowReturn
+gst_gray_record_render (GstBaseSink * sink, GstBuffer * buf)
+{
+  GstGrayRecordPrivate *priv = GST_GRAYRECORD_GET_PRIVATE (sink);
+  GError *error = NULL;
+  gint stride;
+
+  if (!priv->writer)
+    return GST_FLOW_NOT_NEGOTIATED;
+
+  /* GRAY8 rows are padded to 4 bytes, but some sources pack them */
+  stride = GST_ROUND_UP_4 (priv->width);
+  if (GST_BUFFER_SIZE (buf) < stride * priv->height)
+    stride = priv->width;
+  if (GST_BUFFER_SIZE (buf) < stride * priv->height) {
+    GST_ELEMENT_ERROR (sink, STREAM, FORMAT, (NULL),
+        ("buffer of %u bytes too small for %dx%d", GST_BUFFER_SIZE (buf),
+            priv->width, priv->height));
+    return GST_FLOW_ERROR;
+  }
+
+  /* GST_CLOCK_TIME_NONE and GRAY_CAPTURE_TIME_NONE are the same value */
+  if (!gray_capture_writer_add (priv->writer, GST_BUFFER_DATA (buf), stride,
+          GST_BUFFER_TIMESTAMP (buf), GST_BUFFER_DURATION (buf), &error)) {
+    GST_ELEMENT_ERROR (sink, RESOURCE, WRITE, (NULL),
+        ("%s", error->message));
+    g_error_free (error);
+    return GST_FLOW_ERROR;
+  }
+  return GST_FLOW_OK;
+}
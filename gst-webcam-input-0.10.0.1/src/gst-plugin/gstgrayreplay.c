@@ -0,0 +1,462 @@
+/*
+ *  gst-tuio - Gstreamer to tuio computer vision plugin
+ *
+ *  Copyright (C) 2010 Keith Mok <ek9852@gmail.com>
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+#ifdef HAVE_CONFIG_H
+#  include <config.h>
+#endif
+
+#include <string.h>
+#include <gst/gst.h>
+
+#include "gstgrayreplay.h"
+#include "gray_capture.h"
+
+/* Plays a grayrecord capture back, either at the recorded pacing like a
+ * live camera or as fast as downstream consumes it, e.g.
+ *
+ *   gst-launch grayreplay location=t.gray pace=false ! blobstotuio
+ */
+
+GST_DEBUG_CATEGORY_STATIC (gst_gray_replay_debug);
+#define GST_CAT_DEFAULT gst_gray_replay_debug
+
+#define GST_GRAYREPLAY_GET_PRIVATE(obj)  \
+   (G_TYPE_INSTANCE_GET_PRIVATE ((obj), GST_TYPE_GRAYREPLAY, \
+   GstGrayReplayPrivate))
+
+#define DEFAULT_PACE TRUE
+#define DEFAULT_LOOP FALSE
+
+struct _GstGrayReplayPrivate
+{
+  gchar *location;
+  gboolean pace;
+  gboolean loop;
+
+  GrayCaptureReader *reader;
+  guint64 next_frame;
+  guint64 first_timestamp;
+  GstClockTime loop_offset; /* added to the timestamps of every pass */
+  GstClockID clock_id; /* pending pacing wait, protected by object lock */
+};
+
+enum
+{
+  PROP_0,
+  PROP_LOCATION,
+  PROP_PACE,
+  PROP_LOOP
+};
+
+static GstStaticPadTemplate src_factory = GST_STATIC_PAD_TEMPLATE ("src",
+    GST_PAD_SRC,
+    GST_PAD_ALWAYS,
+    GST_STATIC_CAPS ("video/x-raw-gray,bpp=8,depth=8")
+    );
+
+#define DEBUG_INIT(bla) \
+  GST_DEBUG_CATEGORY_INIT (gst_gray_replay_debug, "grayreplay", 0, \
+      "Replay GRAY8 frames from a capture file");
+
+GST_BOILERPLATE_FULL (GstGrayReplay, gst_gray_replay, GstPushSrc,
+    GST_TYPE_PUSH_SRC, DEBUG_INIT);
+
+static void gst_gray_replay_set_property (GObject * object, guint prop_id,
+    const GValue * value, GParamSpec * pspec);
+static void gst_gray_replay_get_property (GObject * object, guint prop_id,
+    GValue * value, GParamSpec * pspec);
+static void gst_gray_replay_finalize (GstGrayReplay * replay);
+static gboolean gst_gray_replay_start (GstBaseSrc * src);
+static gboolean gst_gray_replay_stop (GstBaseSrc * src);
+static GstCaps *gst_gray_replay_get_caps (GstBaseSrc * src);
+static gboolean gst_gray_replay_is_seekable (GstBaseSrc * src);
+static gboolean gst_gray_replay_do_seek (GstBaseSrc * src,
+    GstSegment * segment);
+static gboolean gst_gray_replay_unlock (GstBaseSrc * src);
+static GstFlowReturn gst_gray_replay_create (GstPushSrc * src,
+    GstBuffer ** buf);
+
+static void
+gst_gray_replay_base_init (gpointer gclass)
+{
+  GstElementClass *element_class = GST_ELEMENT_CLASS (gclass);
+
+  gst_element_class_set_details_simple(element_class,
+    "GrayReplay",
+    "Source/File",
+    "Replay recorded GRAY8 frames with their original timing",
+    "keithmok <ek9852@gmail.com>");
+
+  gst_element_class_add_pad_template (element_class,
+      gst_static_pad_template_get (&src_factory));
+}
+
+static void
+gst_gray_replay_class_init (GstGrayReplayClass * klass)
+{
+  GObjectClass *gobject_class;
+  GstBaseSrcClass *basesrc_class;
+  GstPushSrcClass *pushsrc_class;
+
+  gobject_class = (GObjectClass *) klass;
+  basesrc_class = (GstBaseSrcClass *) klass;
+  pushsrc_class = (GstPushSrcClass *) klass;
+
+  g_type_class_add_private (klass, sizeof (GstGrayReplayPrivate));
+
+  gobject_class->finalize = (GObjectFinalizeFunc) gst_gray_replay_finalize;
+  gobject_class->set_property = gst_gray_replay_set_property;
+  gobject_class->get_property = gst_gray_replay_get_property;
+
+  g_object_class_install_property (gobject_class, PROP_LOCATION,
+      g_param_spec_string ("location", "File location",
+          "Capture file written by grayrecord", NULL, G_PARAM_READWRITE));
+
+  g_object_class_install_property (gobject_class, PROP_PACE,
+      g_param_spec_boolean ("pace", "Pace",
+          "Play at the recorded frame timing like a live camera, "
+          "otherwise as fast as possible", DEFAULT_PACE, G_PARAM_READWRITE));
+
+  g_object_class_install_property (gobject_class, PROP_LOOP,
+      g_param_spec_boolean ("loop", "Loop",
+          "Restart from the first frame at the end of the capture",
+          DEFAULT_LOOP, G_PARAM_READWRITE));
+
+  basesrc_class->start = GST_DEBUG_FUNCPTR (gst_gray_replay_start);
+  basesrc_class->stop = GST_DEBUG_FUNCPTR (gst_gray_replay_stop);
+  basesrc_class->get_caps = GST_DEBUG_FUNCPTR (gst_gray_replay_get_caps);
+  basesrc_class->is_seekable = GST_DEBUG_FUNCPTR (gst_gray_replay_is_seekable);
+  basesrc_class->do_seek = GST_DEBUG_FUNCPTR (gst_gray_replay_do_seek);
+  basesrc_class->unlock = GST_DEBUG_FUNCPTR (gst_gray_replay_unlock);
+  pushsrc_class->create = GST_DEBUG_FUNCPTR (gst_gray_replay_create);
+}
+
+static void
+gst_gray_replay_init (GstGrayReplay * replay, GstGrayReplayClass * gclass)
+{
+  GstGrayReplayPrivate *priv = GST_GRAYREPLAY_GET_PRIVATE (replay);
+
+  priv->location = NULL;
+  priv->pace = DEFAULT_PACE;
+  priv->loop = DEFAULT_LOOP;
+  priv->reader = NULL;
+  priv->clock_id = NULL;
+
+  gst_base_src_set_format (GST_BASE_SRC (replay), GST_FORMAT_TIME);
+}
+
+static void
+gst_gray_replay_finalize (GstGrayReplay * replay)
+{
+  GstGrayReplayPrivate *priv = GST_GRAYREPLAY_GET_PRIVATE (replay);
+
+  g_free (priv->location);
+
+  G_OBJECT_CLASS (parent_class)->finalize (G_OBJECT (replay));
+}
+
+static void
+gst_gray_replay_set_property (GObject * object, guint prop_id,
+    const GValue * value, GParamSpec * pspec)
+{
+  GstGrayReplayPrivate *priv = GST_GRAYREPLAY_GET_PRIVATE (object);
+
+  switch (prop_id) {
+    case PROP_LOCATION:
+      if (priv->reader) {
+        g_warning ("Cannot change location while playing");
+        break;
+      }
+      g_free (priv->location);
+      priv->location = g_value_dup_string (value);
+      break;
+    case PROP_PACE:
+      priv->pace = g_value_get_boolean (value);
+      break;
+    case PROP_LOOP:
+      priv->loop = g_value_get_boolean (value);
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+      break;
+  }
+}
+
+static void
+gst_gray_replay_get_property (GObject * object, guint prop_id,
+    GValue * value, GParamSpec * pspec)
+{
+  GstGrayReplayPrivate *priv = GST_GRAYREPLAY_GET_PRIVATE (object);
+
+  switch (prop_id) {
+    case PROP_LOCATION:
+      g_value_set_string (value, priv->location);
+      break;
+    case PROP_PACE:
+      g_value_set_boolean (value, priv->pace);
+      break;
+    case PROP_LOOP:
+      g_value_set_boolean (value, priv->loop);
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+      break;
+  }
+}
+
+/* stream time of frame n within one pass, recorded timestamps are made
+ * relative to the first frame, frames without one are spaced by the
+ * frame rate */
+static GstClockTime
+frame_time (GstGrayReplayPrivate * priv, guint64 n)
+{
+  const GrayCaptureInfo *info = gray_capture_reader_get_info (priv->reader);
+  guint64 timestamp;
+
+  gray_capture_reader_get_frame (priv->reader, n, &timestamp, NULL);
+  if ((timestamp != GRAY_CAPTURE_TIME_NONE) &&
+      (priv->first_timestamp != GRAY_CAPTURE_TIME_NONE) &&
+      (timestamp >= priv->first_timestamp))
+    return timestamp - priv->first_timestamp;
+
+  if (info->fps_n > 0)
+    return gst_util_uint64_scale (n, info->fps_d * GST_SECOND, info->fps_n);
+  return gst_util_uint64_scale (n, GST_SECOND, 30);
+}
+
+static GstClockTime
+frame_duration (GstGrayReplayPrivate * priv, guint64 n)
+{
+  const GrayCaptureInfo *info = gray_capture_reader_get_info (priv->reader);
+
+  if (n + 1 < info->num_frames)
+    return frame_time (priv, n + 1) - frame_time (priv, n);
+  if (info->fps_n > 0)
+    return gst_util_uint64_scale (GST_SECOND, info->fps_d, info->fps_n);
+  return GST_SECOND / 30;
+}
+
+static gboolean
+gst_gray_replay_start (GstBaseSrc * src)
+{
+  GstGrayReplayPrivate *priv = GST_GRAYREPLAY_GET_PRIVATE (src);
+  GError *error = NULL;
+
+  if (!priv->location) {
+    GST_ELEMENT_ERROR (src, RESOURCE, NOT_FOUND,
+        ("No capture file location set"), (NULL));
+    return FALSE;
+  }
+
+  priv->reader = gray_capture_reader_new (priv->location, &error);
+  if (!priv->reader) {
+    GST_ELEMENT_ERROR (src, RESOURCE, OPEN_READ, (NULL),
+        ("%s", error->message));
+    g_error_free (error);
+    return FALSE;
+  }
+  if (gray_capture_reader_get_info (priv->reader)->num_frames == 0) {
+    GST_ELEMENT_ERROR (src, RESOURCE, READ, (NULL),
+        ("%s holds no frame", priv->location));
+    gray_capture_reader_free (priv->reader);
+    priv->reader = NULL;
+    return FALSE;
+  }
+
+  gray_capture_reader_get_frame (priv->reader, 0, &priv->first_timestamp,
+      NULL);
+  priv->next_frame = 0;
+  priv->loop_offset = 0;
+
+  /* paced playback behaves like the camera it was recorded from */
+  gst_base_src_set_live (src, priv->pace);
+  return TRUE;
+}
+
+static gboolean
+gst_gray_replay_stop (GstBaseSrc * src)
+{
+  GstGrayReplayPrivate *priv = GST_GRAYREPLAY_GET_PRIVATE (src);
+
+  if (priv->reader) {
+    gray_capture_reader_free (priv->reader);
+    priv->reader = NULL;
+  }
+  return TRUE;
+}
+
+static GstCaps *
+gst_gray_replay_get_caps (GstBaseSrc * src)
+{
+  GstGrayReplayPrivate *priv = GST_GRAYREPLAY_GET_PRIVATE (src);
+  const GrayCaptureInfo *info;
+
+  if (!priv->reader)
+    return gst_caps_copy (gst_pad_get_pad_template_caps (
+            GST_BASE_SRC_PAD (src)));
+
+  info = gray_capture_reader_get_info (priv->reader);
+  return gst_caps_new_simple ("video/x-raw-gray",
+      "bpp", G_TYPE_INT, 8,
+      "depth", G_TYPE_INT, 8,
+      "width", G_TYPE_INT, info->width,
+      "height", G_TYPE_INT, info->height,
+      "framerate", GST_TYPE_FRACTION, info->fps_n,
+      (info->fps_n > 0) ? info->fps_d : 1,
+      NULL);
+}
+
+static gboolean
+gst_gray_replay_is_seekable (GstBaseSrc * src)
+{
+  return TRUE;
+}
+
+/* the index makes a seek a binary search over the frame timestamps */
+static gboolean
+gst_gray_replay_do_seek (GstBaseSrc * src, GstSegment * segment)
+{
+  GstGrayReplayPrivate *priv = GST_GRAYREPLAY_GET_PRIVATE (src);
+  const GrayCaptureInfo *info;
+  guint64 n;
+
+  if (!priv->reader)
+    return FALSE;
+
+  info = gray_capture_reader_get_info (priv->reader);
+  if (priv->first_timestamp != GRAY_CAPTURE_TIME_NONE)
+    n = gray_capture_reader_find (priv->reader,
+        priv->first_timestamp + segment->start);
+  else if (info->fps_n > 0)
+    n = gst_util_uint64_scale (segment->start, info->fps_n,
+        info->fps_d * GST_SECOND);
+  else
+    n = gst_util_uint64_scale (segment->start, 30, GST_SECOND);
+
+  priv->next_frame = n;
+  priv->loop_offset = 0;
+  segment->last_stop = segment->start;
+  segment->time = segment->start;
+
+  GST_DEBUG_OBJECT (src, "seek to %" GST_TIME_FORMAT ", frame %"
+      G_GUINT64_FORMAT, GST_TIME_ARGS (segment->start), n);
+  return TRUE;
+}
+
+static gboolean
+gst_gray_replay_unlock (GstBaseSrc * src)
+{
+  GstGrayReplayPrivate *priv = GST_GRAYREPLAY_GET_PRIVATE (src);
+
+  GST_OBJECT_LOCK (src);
+  if (priv->clock_id)
+    gst_clock_id_unschedule (priv->clock_id);
+  GST_OBJECT_UNLOCK (src);
+  return TRUE;
+}
+
+/* wait until the running time of the frame, like a camera delivering it */
+static GstFlowReturn
+wait_for_frame (GstGrayReplay * replay, GstClockTime timestamp)
+{
+  GstGrayReplayPrivate *priv = GST_GRAYREPLAY_GET_PRIVATE (replay);
+  GstBaseSrc *basesrc = GST_BASE_SRC (replay);
+  GstClockReturn ret;
+  GstClockTime running_time;
+  GstClock *clock;
+
+  running_time = gst_segment_to_running_time (&basesrc->segment,
+      GST_FORMAT_TIME, timestamp);
+  if (!GST_CLOCK_TIME_IS_VALID (running_time))
+    return GST_FLOW_OK;
+
+  GST_OBJECT_LOCK (replay);
+  clock = GST_ELEMENT_CLOCK (replay);
+  if (!clock) {
+    GST_OBJECT_UNLOCK (replay);
+    return GST_FLOW_OK;
+  }
+  priv->clock_id = gst_clock_new_single_shot_id (clock,
+      GST_ELEMENT_CAST (replay)->base_time + running_time);
+  GST_OBJECT_UNLOCK (replay);
+
+  ret = gst_clock_id_wait (priv->clock_id, NULL);
+
+  GST_OBJECT_LOCK (replay);
+  gst_clock_id_unref (priv->clock_id);
+  priv->clock_id = NULL;
+  GST_OBJECT_UNLOCK (replay);
+
+  return (ret == GST_CLOCK_UNSCHEDULED) ? GST_FLOW_WRONG_STATE : GST_FLOW_OK;
+}
+
+static GstFlowReturn
+gst_gray_replay_create (GstPushSrc * src, GstBuffer ** buf)
+{
+  GstGrayReplay *replay = GST_GRAYREPLAY (src);
+  GstGrayReplayPrivate *priv = GST_GRAYREPLAY_GET_PRIVATE (src);
+  const GrayCaptureInfo *info = gray_capture_reader_get_info (priv->reader);
+  GstPad *pad = GST_BASE_SRC_PAD (src);
+  GstClockTime timestamp;
+  GstFlowReturn ret;
+  const guint8 *frame;
+  guint8 *data;
+  gint y, stride;
+
+  if (priv->next_frame >= info->num_frames) {
+    if (!priv->loop)
+      return GST_FLOW_UNEXPECTED;
+    priv->loop_offset += frame_time (priv, info->num_frames - 1) +
+        frame_duration (priv, info->num_frames - 1);
+    priv->next_frame = 0;
+  }
+
+  timestamp = priv->loop_offset + frame_time (priv, priv->next_frame);
+  if (priv->pace) {
+    ret = wait_for_frame (replay, timestamp);
+    if (ret != GST_FLOW_OK)
+      return ret;
+  }
+
+  stride = GST_ROUND_UP_4 (info->width);
+  ret = gst_pad_alloc_buffer_and_set_caps (pad, priv->next_frame,
+      stride * info->height, GST_PAD_CAPS (pad), buf);
+  if (ret != GST_FLOW_OK)
+    return ret;
+
+  frame = gray_capture_reader_get_frame (priv->reader, priv->next_frame,
+      NULL, NULL);
+  data = GST_BUFFER_DATA (*buf);
+  if (stride == info->stride) {
+    memcpy (data, frame, stride * info->height);
+  } else {
+    for (y = 0; y < info->height; y++)
+      memcpy (data + y * stride, frame + y * info->stride, info->width);
+  }
+
+  GST_BUFFER_TIMESTAMP (*buf) = timestamp;
+  GST_BUFFER_DURATION (*buf) = frame_duration (priv, priv->next_frame);
+  GST_BUFFER_OFFSET (*buf) = priv->next_frame;
+  GST_BUFFER_OFFSET_END (*buf) = priv->next_frame + 1;
+  priv->next_frame++;
+
+  return GST_FLOW_OK;
+}
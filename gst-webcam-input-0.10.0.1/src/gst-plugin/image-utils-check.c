@@ -0,0 +1,75 @@
+/*
+ *  gst-tuio - Gstreamer to tuio computer vision plugin
+ *
+ *  Copyright (C) 2010 Keith Mok <ek9852@gmail.com>
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+
+/* make check driver: every registered SIMD variant of the image_utils
+ * kernels has to be bit-exact with the c reference, a kernel that is not
+ * fails the build instead of being skipped at plugin load.
+ *
+ *   ./image-utils-check [iterations]
+ */
+
+#ifdef HAVE_CONFIG_H
+#  include <config.h>
+#endif
+
+#include <glib.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "image_utils.h"
+#include "image_utils_impl.h"
+
+#define CHECK_SEED 0x7475696f
+#define CHECK_ITERATIONS 10
+
+int
+main (int argc, char *argv[])
+{
+  const ImageUtilsImpl *impl;
+  gchar *failure;
+  gint i, k, iterations = CHECK_ITERATIONS, checked = 0, failed = 0;
+
+  if (argc > 1)
+    iterations = atoi (argv[1]);
+
+  for (i = 1; (impl = image_utils_get_impl (i)) != NULL; i++) {
+    for (k = 0; k < IMAGE_UTILS_NUM_KERNELS; k++) {
+      if (!image_utils_has_kernel (impl, k))
+        continue;
+      failure = NULL;
+      checked++;
+      if (image_utils_check_kernel (impl, k, CHECK_SEED, iterations,
+              &failure)) {
+        printf ("PASS %-8s %s\n", impl->name, image_utils_kernel_name (k));
+      } else {
+        printf ("FAIL %s\n", failure);
+        g_free (failure);
+        failed++;
+      }
+    }
+  }
+
+  if (checked == 0)
+    printf ("no SIMD variant built, nothing to check\n");
+
+  return failed ? EXIT_FAILURE : EXIT_SUCCESS;
+}
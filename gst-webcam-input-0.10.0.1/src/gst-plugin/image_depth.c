@@ -0,0 +1,103 @@
+/*
+ *  gst-tuio - Gstreamer to tuio computer vision plugin
+ *
+ *  Copyright (C) 2010 Keith Mok <ek9852@gmail.com>
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+
+#ifdef HAVE_CONFIG_H
+#  include <config.h>
+#endif
+
+#include <glib.h>
+#include "image_depth.h"
+
+/* nearest valid reading of the block at the top left of p, 0 if none */
+static inline guint
+depth_sample (const guint16 *p, gint stride, gint decimate)
+{
+  guint v, d = 0;
+  gint x, y;
+
+  for (y = 0; y < decimate; y++) {
+    for (x = 0; x < decimate; x++) {
+      v = GUINT16_FROM_LE (p[y * stride + x]);
+      if (v && (!d || v < d))
+        d = v;
+    }
+  }
+  return d;
+}
+
+/* adds one frame to the per pixel sums of valid readings */
+void
+image16_depth_accumulate (const guint16 *src, guint32 *sum, guint16 *count,
+    gint width, gint height, gint stride, gint decimate)
+{
+  gint x, y;
+  gint dst_width = width / decimate;
+  gint dst_height = height / decimate;
+  guint d;
+
+  for (y = 0; y < dst_height; y++) {
+    for (x = 0; x < dst_width; x++, sum++, count++) {
+      d = depth_sample (src + y * decimate * stride + x * decimate, stride,
+          decimate);
+      if (d && (*count < G_MAXUINT16)) {
+        *sum += d;
+        (*count)++;
+      }
+    }
+  }
+}
+
+/* mean of the frames accumulated, 0 where there never was a reading */
+void
+image16_depth_background (const guint32 *sum, const guint16 *count,
+    guint16 *background, gint size)
+{
+  gint i;
+
+  for (i = 0; i < size; i++)
+    background[i] = count[i] ? (sum[i] + count[i] / 2) / count[i] : 0;
+}
+
+void
+image16_depth_height (const guint16 *src, const guint16 *background,
+    guint8 *dst, gint width, gint height, gint stride, gint decimate,
+    guint near, guint far)
+{
+  gint x, y, h;
+  gint dst_width = width / decimate;
+  gint dst_height = height / decimate;
+  gint range = MAX ((gint)far - (gint)near, 1);
+  guint d;
+
+  for (y = 0; y < dst_height; y++) {
+    for (x = 0; x < dst_width; x++, background++, dst++) {
+      d = depth_sample (src + y * decimate * stride + x * decimate, stride,
+          decimate);
+      /* closer to the camera than the surface is higher */
+      h = (gint)*background - (gint)d;
+      if (!d || !*background || (h < (gint)near) || (h > (gint)far))
+        *dst = 0;
+      else
+        *dst = 255 - (254 * (h - (gint)near)) / range;
+    }
+  }
+}
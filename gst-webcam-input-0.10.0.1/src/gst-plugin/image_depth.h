@@ -0,0 +1,49 @@
+/*
+ *  gst-tuio - Gstreamer to tuio computer vision plugin
+ *
+ *  Copyright (C) 2010 Keith Mok <ek9852@gmail.com>
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+
+#ifndef __IMAGE_DEPTH_H__
+#define __IMAGE_DEPTH_H__
+
+#include <glib.h>
+
+G_BEGIN_DECLS
+
+/* Depth frames are 16 bit little endian distances from the camera (mm for
+ * the Kinect v2), 0 where the camera has no reading. Decimated frames
+ * keep the nearest valid reading of every decimate x decimate block, so
+ * a fingertip is never averaged away. stride is the row length of the
+ * source in pixels, width rounded up to the row padding. */
+
+void image16_depth_accumulate (const guint16 *src, guint32 *sum,
+    guint16 *count, gint width, gint height, gint stride, gint decimate);
+void image16_depth_background (const guint32 *sum, const guint16 *count,
+    guint16 *background, gint size);
+
+/* height above the background surface mapped to 8 bit: heights in
+ * [near, far] go from 255 down to 1, everything else is 0 */
+void image16_depth_height (const guint16 *src, const guint16 *background,
+    guint8 *dst, gint width, gint height, gint stride, gint decimate,
+    guint near, guint far);
+
+G_END_DECLS
+
+#endif /* __IMAGE_DEPTH_H__ */
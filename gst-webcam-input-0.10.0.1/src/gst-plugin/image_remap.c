@@ -0,0 +1,180 @@
+/*
+ *  gst-tuio - Gstreamer to tuio computer vision plugin
+ *
+ *  Copyright (C) 2010 Keith Mok <ek9852@gmail.com>
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+
+#ifdef HAVE_CONFIG_H
+#  include <config.h>
+#endif
+
+#include <string.h>
+#include <glib.h>
+#include "image_remap.h"
+#include "image_utils_impl.h"
+
+/* The table runs backwards: for every pixel of the corrected frame, m^-1
+ * gives the undistorted camera pixel and the lens model the distorted
+ * pixel really captured. Both are closed form, no iteration needed. */
+RemapLut *
+remap_lut_new (gint width, gint height, const LensModel *lens,
+    const gfloat *m)
+{
+  RemapLut *lut;
+  gfloat inv[9], xu, yu, sx, sy;
+  gint x, y, x0, y0, fx, fy, i;
+
+  if ((width < 2) || (height < 2) || !homography_invert (m, inv))
+    return NULL;
+
+  lut = g_new (RemapLut, 1);
+  lut->width = width;
+  lut->height = height;
+  lut->offsets = g_new (guint32, width * height);
+  lut->fx = g_new (guint8, width * height);
+  lut->fy = g_new (guint8, width * height);
+  lut->taps = g_new (guint8, 4 * width);
+
+  for (y = 0, i = 0; y < height; y++) {
+    for (x = 0; x < width; x++, i++) {
+      homography_apply (inv, x, y, &xu, &yu);
+      lens_model_distort (lens, xu, yu, &sx, &sy);
+
+      if ((sx < 0) || (sy < 0) || (sx > width - 1) || (sy > height - 1)) {
+        lut->offsets[i] = REMAP_OUTSIDE;
+        lut->fx[i] = 0;
+        lut->fy[i] = 0;
+        continue;
+      }
+
+      x0 = (gint)sx;
+      y0 = (gint)sy;
+      fx = (gint)((sx - x0) * REMAP_FRAC_ONE + 0.5f);
+      fy = (gint)((sy - y0) * REMAP_FRAC_ONE + 0.5f);
+      /* keep the 2x2 neighbourhood inside the frame */
+      if (x0 == width - 1) {
+        x0--;
+        fx = REMAP_FRAC_ONE;
+      }
+      if (y0 == height - 1) {
+        y0--;
+        fy = REMAP_FRAC_ONE;
+      }
+      lut->offsets[i] = y0 * width + x0;
+      lut->fx[i] = fx;
+      lut->fy[i] = fy;
+    }
+  }
+
+  return lut;
+}
+
+void
+remap_lut_free (RemapLut *lut)
+{
+  if (lut == NULL)
+    return;
+
+  g_free (lut->offsets);
+  g_free (lut->fx);
+  g_free (lut->fy);
+  g_free (lut->taps);
+  g_free (lut);
+}
+
+/* bilinear remap of one row of the corrected frame into dst, the taps of
+ * a pixel outside the source are all black */
+static void
+remap_row (const guint8 *src, const RemapLut *lut, gint y, guint8 *dst)
+{
+  const guint32 *offsets = lut->offsets + y * lut->width;
+  guint8 *tl = lut->taps;
+  guint8 *tr = tl + lut->width;
+  guint8 *bl = tr + lut->width;
+  guint8 *br = bl + lut->width;
+  const guint8 *p;
+  gint x;
+
+  for (x = 0; x < lut->width; x++) {
+    if (offsets[x] == REMAP_OUTSIDE) {
+      tl[x] = tr[x] = bl[x] = br[x] = 0;
+      continue;
+    }
+    p = src + offsets[x];
+    tl[x] = p[0];
+    tr[x] = p[1];
+    bl[x] = p[lut->width];
+    br[x] = p[lut->width + 1];
+  }
+
+  pf_image8_bilinear (tl, tr, bl, br, lut->fx + y * lut->width,
+      lut->fy + y * lut->width, dst, lut->width);
+}
+
+void
+image8_remap (const guint8 *src, const RemapLut *lut, guint8 *dst)
+{
+  gint y;
+
+  for (y = 0; y < lut->height; y++)
+    remap_row (src, lut, y, dst + y * lut->width);
+}
+
+/* Same background arithmetic as update_background_buf in image_utils.c,
+ * the corrected row is blended into dst and replaced by the difference
+ * while it is still in cache. */
+void
+image8_remap_subtract (const guint8 *src, const RemapLut *lut,
+    guint8 *background, guint16 *background_fractional, guint8 *dst,
+    gboolean learning, gboolean trackdark)
+{
+  gint i, y, n = lut->width * lut->height;
+  guint32 v;
+  gint32 d;
+  guint8 s;
+
+  if (learning) {
+    image8_remap (src, lut, background);
+    memset (dst, 0, n);
+    memset (background_fractional, 0, n * sizeof(guint16));
+    return;
+  }
+
+  for (y = 0; y < lut->height; y++) {
+    remap_row (src, lut, y, dst + y * lut->width);
+
+    for (i = y * lut->width; i < (y + 1) * lut->width; i++) {
+      s = dst[i];
+
+      v = background[i];
+      v *= 65529; /* (9999 * 6.5536) */
+      v += ((((guint32)background_fractional[i]) * 65529) >> 16);
+      v += ((guint32)s) * (65536 - 65529);
+      if (v > (255<<16)) v = 255<<16;
+      background[i] = v >> 16;
+      background_fractional[i] = v & 0xFFFF;
+
+      if (trackdark)
+        d = background[i] - s;
+      else
+        d = s - background[i];
+      dst[i] = d < 0 ? 0 : d;
+    }
+  }
+}
@@ -0,0 +1,70 @@
+/*
+ *  gst-tuio - Gstreamer to tuio computer vision plugin
+ *
+ *  Copyright (C) 2010 Keith Mok <ek9852@gmail.com>
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+
+#ifndef __IMAGE_REMAP_H__
+#define __IMAGE_REMAP_H__
+
+#include <glib.h>
+#include "coord_map.h"
+
+G_BEGIN_DECLS
+
+/* bilinear weights in 1/128 pixel */
+#define REMAP_FRAC_BITS 7
+#define REMAP_FRAC_ONE (1 << REMAP_FRAC_BITS)
+/* destination pixel with no source pixel, reads as black */
+#define REMAP_OUTSIDE G_MAXUINT32
+
+typedef struct _RemapLut   RemapLut;
+
+/* Source pixel for every destination pixel of a frame, both frames have
+ * the same size and a stride equal to the width. offsets is the top left
+ * pixel of the 2x2 neighbourhood, fx and fy the fixed point position
+ * inside it, fx == REMAP_FRAC_ONE only happens on the last column. The
+ * neighbourhood of a row is gathered into taps, four planes of width
+ * pixels, and blended by pf_image8_bilinear. */
+struct _RemapLut
+{
+  gint width;
+  gint height;
+  guint32 *offsets;
+  guint8 *fx;
+  guint8 *fy;
+  guint8 *taps;
+};
+
+RemapLut *remap_lut_new (gint width, gint height, const LensModel *lens,
+    const gfloat *m);
+void remap_lut_free (RemapLut *lut);
+
+void image8_remap (const guint8 *src, const RemapLut *lut, guint8 *dst);
+
+/* remap, update the background model and subtract in one pass, bit-exact
+ * with image8_remap followed by update_background_buf (or a plain copy
+ * while learning) and image8_subtract */
+void image8_remap_subtract (const guint8 *src, const RemapLut *lut,
+    guint8 *background, guint16 *background_fractional, guint8 *dst,
+    gboolean learning, gboolean trackdark);
+
+G_END_DECLS
+
+#endif /* __IMAGE_REMAP_H__ */
@@ -25,6 +25,7 @@
 
 #include <string.h>
 #include "image_utils.h"
+#include "image_utils_impl.h"
 
 static void
 update_background_buf(const guint8 *s, guint8 *background,
@@ -46,12 +47,56 @@ static void
 image8_threshold(const guint8 *src, guint8 *dst, gint width, gint stride,
     gint height, guint threshold);
 
+static void
+image8_downsample2(const guint8 *src, guint8 *dst, gint width, gint stride,
+    gint height);
+
+static void
+image8_bilinear(const guint8 *tl, const guint8 *tr, const guint8 *bl,
+    const guint8 *br, const guint8 *fx, const guint8 *fy, guint8 *dst,
+    gint n);
+
 /* default function pointers */
 update_background_buf_t pf_update_background_buf = update_background_buf;
 image8_box_blur_t pf_image8_box_blur = image8_box_blur;
 image8_subtract_t pf_image8_subtract = image8_subtract;
 image8_amplify_t pf_image8_amplify = image8_amplify;
 image8_threshold_t pf_image8_threshold = image8_threshold;
+image8_downsample2_t pf_image8_downsample2 = image8_downsample2;
+image8_bilinear_t pf_image8_bilinear = image8_bilinear;
+
+/* c reference, always the first registered implementation */
+static const ImageUtilsImpl image_utils_c_impl = {
+  "c",
+  update_background_buf,
+  image8_box_blur,
+  image8_subtract,
+  image8_amplify,
+  image8_threshold,
+  image8_downsample2,
+  image8_bilinear,
+};
+
+static const ImageUtilsImpl *image_utils_impls[IMAGE_UTILS_MAX_IMPL] = {
+  &image_utils_c_impl,
+};
+static gint image_utils_num_impls = 1;
+
+void
+image_utils_register_impl (const ImageUtilsImpl *impl)
+{
+  if (image_utils_num_impls >= IMAGE_UTILS_MAX_IMPL)
+    return;
+  image_utils_impls[image_utils_num_impls++] = impl;
+}
+
+const ImageUtilsImpl *
+image_utils_get_impl (gint index)
+{
+  if ((index < 0) || (index >= image_utils_num_impls))
+    return NULL;
+  return image_utils_impls[index];
+}
 
 /* Reference: 
  * blur algorithm from Four Tricks for Fast Blurring in Software and Hardware
@@ -93,8 +138,9 @@ blur_horiz(const guint8 *src, guint8 *dst, gint w, gint h, int stride,
 {
   int y;
 
-  if (radius > w)
-    radius = w - 1;
+  /* the mirrored borders read up to 2*radius pixels */
+  if (2*radius >= w)
+    radius = (w - 1) / 2;
 
   for (y = 0; y < h; y++) {
     blur(src + y*stride, dst + y*stride, w, radius, 1);
@@ -107,8 +153,8 @@ blur_vert(const guint8 *src, guint8 *dst, gint w, gint h, int stride,
 {
   int x;
 
-  if (radius >= h)
-    radius = h - 1;
+  if (2*radius >= h)
+    radius = (h - 1) / 2;
 
   for (x = 0; x < w; x++) {
     blur(src + x, dst + x, h, radius, stride);
@@ -199,3 +245,49 @@ image8_threshold(const guint8 *src, guint8 *dst, gint width, gint stride,
   }
 }
 
+static void
+image8_downsample2(const guint8 *src, guint8 *dst, gint width, gint stride,
+    gint height)
+{
+  gint i, j;
+  const guint8 *s0, *s1;
+
+  for (i = 0; i < height / 2; i++) {
+    s0 = src + 2 * i * stride;
+    s1 = s0 + stride;
+    for (j = 0; j < width / 2; j++) {
+      *dst++ = (s0[0] + s0[1] + s1[0] + s1[1] + 2) >> 2;
+      s0 += 2;
+      s1 += 2;
+    }
+  }
+}
+
+/* the weights sum to 128 per axis, so top and bottom stay below 2^15 and
+ * the SIMD variants can blend in 16 bit lanes */
+static void
+image8_bilinear(const guint8 *tl, const guint8 *tr, const guint8 *bl,
+    const guint8 *br, const guint8 *fx, const guint8 *fy, guint8 *dst,
+    gint n)
+{
+  gint i;
+  guint32 top, bottom;
+
+  for (i = 0; i < n; i++) {
+    top = tl[i] * (128 - fx[i]) + tr[i] * fx[i];
+    bottom = bl[i] * (128 - fx[i]) + br[i] * fx[i];
+    dst[i] = (top * (128 - fy[i]) + bottom * fy[i] + 8192) >> 14;
+  }
+}
+
+void
+image8_downsample(const guint8 *src, guint8 *dst, guint8 *tmp, gint width,
+    gint height, gint decimate)
+{
+  if (decimate == 4) {
+    pf_image8_downsample2(src, tmp, width, width, height);
+    pf_image8_downsample2(tmp, dst, width / 2, width / 2, height / 2);
+  } else {
+    pf_image8_downsample2(src, dst, width, width, height);
+  }
+}
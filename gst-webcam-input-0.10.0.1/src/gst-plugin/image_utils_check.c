@@ -0,0 +1,401 @@
+/*
+ *  gst-tuio - Gstreamer to tuio computer vision plugin
+ *
+ *  Copyright (C) 2010 Keith Mok <ek9852@gmail.com>
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+
+#ifdef HAVE_CONFIG_H
+#  include <config.h>
+#endif
+
+#include <string.h>
+#include "image_utils.h"
+#include "image_utils_impl.h"
+
+/* Differential check of the hand written SIMD kernels against the c
+ * reference in image_utils.c. The outputs must be bit-exact on random
+ * images as well as on the edge cases: odd widths not a multiple of the
+ * SIMD block, radius >= width/height and saturation at 0 and 255. */
+
+typedef struct _CheckSize CheckSize;
+
+struct _CheckSize
+{
+  gint width;
+  gint height;
+};
+
+static const CheckSize check_sizes[] = {
+  { 1, 1 }, { 2, 3 }, { 3, 2 }, { 7, 5 }, { 8, 8 }, { 15, 3 }, { 16, 16 },
+  { 17, 9 }, { 31, 7 }, { 32, 4 }, { 33, 33 }, { 63, 5 }, { 64, 3 },
+  { 65, 17 }, { 127, 11 }, { 320, 240 },
+};
+
+enum {
+  FILL_RANDOM = 0,
+  FILL_ZERO,
+  FILL_SATURATED,
+  FILL_GRADIENT,
+  FILL_CHECKER,
+  NUM_FILLS,
+};
+
+static const guint check_thresholds[] = { 0, 1, 25, 127, 128, 254, 255 };
+
+static const gchar *kernel_names[IMAGE_UTILS_NUM_KERNELS] = {
+  "update_background_buf",
+  "image8_box_blur",
+  "image8_subtract",
+  "image8_amplify",
+  "image8_threshold",
+  "image8_downsample2",
+  "image8_bilinear",
+};
+
+const gchar *
+image_utils_kernel_name (ImageUtilsKernel kernel)
+{
+  return kernel_names[kernel];
+}
+
+gboolean
+image_utils_has_kernel (const ImageUtilsImpl *impl, ImageUtilsKernel kernel)
+{
+  switch (kernel) {
+    case IMAGE_UTILS_UPDATE_BACKGROUND_BUF:
+      return impl->update_background_buf != NULL;
+    case IMAGE_UTILS_BOX_BLUR:
+      return impl->image8_box_blur != NULL;
+    case IMAGE_UTILS_SUBTRACT:
+      return impl->image8_subtract != NULL;
+    case IMAGE_UTILS_AMPLIFY:
+      return impl->image8_amplify != NULL;
+    case IMAGE_UTILS_THRESHOLD:
+      return impl->image8_threshold != NULL;
+    case IMAGE_UTILS_DOWNSAMPLE2:
+      return impl->image8_downsample2 != NULL;
+    case IMAGE_UTILS_BILINEAR:
+      return impl->image8_bilinear != NULL;
+    default:
+      return FALSE;
+  }
+}
+
+static void
+fill_image (guint8 *buf, gint width, gint height, gint fill, GRand *rand)
+{
+  gint x, y;
+
+  for (y = 0; y < height; y++) {
+    for (x = 0; x < width; x++) {
+      guint8 v;
+      switch (fill) {
+        case FILL_ZERO:
+          v = 0;
+          break;
+        case FILL_SATURATED:
+          v = 255;
+          break;
+        case FILL_GRADIENT:
+          v = (x * 255) / MAX(width - 1, 1);
+          break;
+        case FILL_CHECKER:
+          v = ((x ^ y) & 1) ? 255 : 0;
+          break;
+        default:
+          v = g_rand_int_range (rand, 0, 256);
+          break;
+      }
+      buf[y * width + x] = v;
+    }
+  }
+}
+
+static gboolean
+compare (const guint8 *expected, const guint8 *got, gsize size,
+    gsize *index)
+{
+  gsize i;
+
+  for (i = 0; i < size; i++) {
+    if (expected[i] != got[i]) {
+      *index = i;
+      return FALSE;
+    }
+  }
+  return TRUE;
+}
+
+typedef struct _CheckBuffers CheckBuffers;
+
+struct _CheckBuffers
+{
+  guint8 *a;
+  guint8 *b;
+  guint8 *ref_out;
+  guint8 *out;
+  guint8 *tmp;
+  guint8 *c;
+  guint8 *d;
+  guint8 *fx;
+  guint8 *fy;
+  guint16 *ref_frac;
+  guint16 *frac;
+};
+
+/* run one kernel of impl and of the reference with the same inputs, on
+ * mismatch describe the first differing pixel in failure */
+static gboolean
+check_case (const ImageUtilsImpl *impl, const ImageUtilsImpl *ref,
+    ImageUtilsKernel kernel, const CheckSize *size, gint fill, gint param,
+    CheckBuffers *bufs, gchar **failure)
+{
+  gint w = size->width, h = size->height;
+  gint out_width = w;
+  gsize n = w * h;
+  gsize index;
+  gboolean ok = TRUE;
+
+  switch (kernel) {
+    case IMAGE_UTILS_UPDATE_BACKGROUND_BUF:
+      /* b is the learnt background, updated in place */
+      memcpy (bufs->ref_out, bufs->b, n);
+      memcpy (bufs->out, bufs->b, n);
+      memcpy (bufs->frac, bufs->ref_frac, n * sizeof (guint16));
+      ref->update_background_buf (bufs->a, bufs->ref_out, bufs->ref_frac,
+          w, w, h);
+      impl->update_background_buf (bufs->a, bufs->out, bufs->frac, w, w, h);
+      ok = compare (bufs->ref_out, bufs->out, n, &index);
+      if (ok && memcmp (bufs->ref_frac, bufs->frac, n * sizeof (guint16))) {
+        ok = FALSE;
+        index = 0;
+      }
+      break;
+    case IMAGE_UTILS_BOX_BLUR:
+      ref->image8_box_blur (bufs->a, bufs->ref_out, w, w, h, bufs->tmp,
+          param);
+      impl->image8_box_blur (bufs->a, bufs->out, w, w, h, bufs->tmp, param);
+      ok = compare (bufs->ref_out, bufs->out, n, &index);
+      break;
+    case IMAGE_UTILS_SUBTRACT:
+      ref->image8_subtract (bufs->a, bufs->b, bufs->ref_out, w, w, h);
+      impl->image8_subtract (bufs->a, bufs->b, bufs->out, w, w, h);
+      ok = compare (bufs->ref_out, bufs->out, n, &index);
+      break;
+    case IMAGE_UTILS_AMPLIFY:
+      ref->image8_amplify (bufs->a, bufs->ref_out, w, w, h, param);
+      impl->image8_amplify (bufs->a, bufs->out, w, w, h, param);
+      ok = compare (bufs->ref_out, bufs->out, n, &index);
+      break;
+    case IMAGE_UTILS_THRESHOLD:
+      ref->image8_threshold (bufs->a, bufs->ref_out, w, w, h, param);
+      impl->image8_threshold (bufs->a, bufs->out, w, w, h, param);
+      ok = compare (bufs->ref_out, bufs->out, n, &index);
+      break;
+    case IMAGE_UTILS_DOWNSAMPLE2:
+      out_width = w / 2;
+      ref->image8_downsample2 (bufs->a, bufs->ref_out, w, w, h);
+      impl->image8_downsample2 (bufs->a, bufs->out, w, w, h);
+      ok = compare (bufs->ref_out, bufs->out, out_width * (h / 2), &index);
+      break;
+    case IMAGE_UTILS_BILINEAR:
+      /* a, b, c, d are the four taps */
+      ref->image8_bilinear (bufs->a, bufs->b, bufs->c, bufs->d, bufs->fx,
+          bufs->fy, bufs->ref_out, n);
+      impl->image8_bilinear (bufs->a, bufs->b, bufs->c, bufs->d, bufs->fx,
+          bufs->fy, bufs->out, n);
+      ok = compare (bufs->ref_out, bufs->out, n, &index);
+      break;
+    default:
+      break;
+  }
+
+  if (!ok && failure) {
+    *failure = g_strdup_printf ("%s %s: %dx%d fill %d param %d, "
+        "pixel (%d,%d) expected %d got %d", impl->name, kernel_names[kernel],
+        w, h, fill, param, (gint) (index % out_width),
+        (gint) (index / out_width),
+        bufs->ref_out[index], bufs->out[index]);
+  }
+  return ok;
+}
+
+gboolean
+image_utils_check_kernel (const ImageUtilsImpl *impl,
+    ImageUtilsKernel kernel, guint32 seed, gint iterations, gchar **failure)
+{
+  const ImageUtilsImpl *ref = image_utils_get_impl (0);
+  CheckBuffers bufs;
+  GRand *rand;
+  gsize max_size = 0;
+  gboolean ok = TRUE;
+  gint s, it, fill, i;
+
+  if (!image_utils_has_kernel (impl, kernel))
+    return TRUE;
+
+  for (s = 0; s < G_N_ELEMENTS (check_sizes); s++)
+    max_size = MAX (max_size,
+        (gsize) check_sizes[s].width * check_sizes[s].height);
+
+  bufs.a = g_malloc (max_size);
+  bufs.b = g_malloc (max_size);
+  bufs.ref_out = g_malloc (max_size);
+  bufs.out = g_malloc (max_size);
+  bufs.tmp = g_malloc (max_size);
+  bufs.c = g_malloc (max_size);
+  bufs.d = g_malloc (max_size);
+  bufs.fx = g_malloc (max_size);
+  bufs.fy = g_malloc (max_size);
+  bufs.ref_frac = g_malloc (max_size * sizeof (guint16));
+  bufs.frac = g_malloc (max_size * sizeof (guint16));
+  rand = g_rand_new_with_seed (seed);
+
+  for (it = 0; ok && (it < MAX (iterations, 1)); it++) {
+    for (s = 0; ok && (s < G_N_ELEMENTS (check_sizes)); s++) {
+      const CheckSize *size = &check_sizes[s];
+      gsize n = size->width * size->height;
+
+      /* edge case fills only need to run once */
+      for (fill = 0; ok && (fill < ((it == 0) ? NUM_FILLS : 1)); fill++) {
+        fill_image (bufs.a, size->width, size->height, fill, rand);
+        fill_image (bufs.b, size->width, size->height, FILL_RANDOM, rand);
+        for (i = 0; i < n; i++)
+          bufs.ref_frac[i] = g_rand_int_range (rand, 0, 0x10000);
+
+        switch (kernel) {
+          case IMAGE_UTILS_BOX_BLUR:
+          {
+            gint dim = MIN (size->width, size->height);
+            gint radii[] = { 0, 1, 2, 4, dim / 2, dim - 1, dim, dim + 5,
+                128 };
+            for (i = 0; ok && (i < G_N_ELEMENTS (radii)); i++)
+              ok = check_case (impl, ref, kernel, size, fill, radii[i],
+                  &bufs, failure);
+            break;
+          }
+          case IMAGE_UTILS_AMPLIFY:
+            for (i = 0; ok && (i <= 8); i++)
+              ok = check_case (impl, ref, kernel, size, fill, i, &bufs,
+                  failure);
+            break;
+          case IMAGE_UTILS_THRESHOLD:
+            for (i = 0; ok && (i < G_N_ELEMENTS (check_thresholds)); i++)
+              ok = check_case (impl, ref, kernel, size, fill,
+                  check_thresholds[i], &bufs, failure);
+            break;
+          case IMAGE_UTILS_BILINEAR:
+            fill_image (bufs.c, size->width, size->height, fill, rand);
+            fill_image (bufs.d, size->width, size->height, FILL_RANDOM, rand);
+            /* param 0 and 2 put the weights at the ends of 0..128, 1 is random */
+            for (i = 0; ok && (i < 3); i++) {
+              gint j;
+              for (j = 0; j < n; j++) {
+                bufs.fx[j] = (i == 1) ? g_rand_int_range (rand, 0, 129) : i * 64;
+                bufs.fy[j] = (i == 1) ? g_rand_int_range (rand, 0, 129) :
+                    128 - i * 64;
+              }
+              ok = check_case (impl, ref, kernel, size, fill, i, &bufs,
+                  failure);
+            }
+            break;
+          default:
+            ok = check_case (impl, ref, kernel, size, fill, 0, &bufs,
+                failure);
+            break;
+        }
+      }
+    }
+  }
+
+  g_rand_free (rand);
+  g_free (bufs.a);
+  g_free (bufs.b);
+  g_free (bufs.ref_out);
+  g_free (bufs.out);
+  g_free (bufs.tmp);
+  g_free (bufs.c);
+  g_free (bufs.d);
+  g_free (bufs.fx);
+  g_free (bufs.fy);
+  g_free (bufs.ref_frac);
+  g_free (bufs.frac);
+
+  return ok;
+}
+
+static void
+install_kernel (const ImageUtilsImpl *impl, ImageUtilsKernel kernel)
+{
+  switch (kernel) {
+    case IMAGE_UTILS_UPDATE_BACKGROUND_BUF:
+      pf_update_background_buf = impl->update_background_buf;
+      break;
+    case IMAGE_UTILS_BOX_BLUR:
+      pf_image8_box_blur = impl->image8_box_blur;
+      break;
+    case IMAGE_UTILS_SUBTRACT:
+      pf_image8_subtract = impl->image8_subtract;
+      break;
+    case IMAGE_UTILS_AMPLIFY:
+      pf_image8_amplify = impl->image8_amplify;
+      break;
+    case IMAGE_UTILS_THRESHOLD:
+      pf_image8_threshold = impl->image8_threshold;
+      break;
+    case IMAGE_UTILS_DOWNSAMPLE2:
+      pf_image8_downsample2 = impl->image8_downsample2;
+      break;
+    case IMAGE_UTILS_BILINEAR:
+      pf_image8_bilinear = impl->image8_bilinear;
+      break;
+    default:
+      break;
+  }
+}
+
+/* switch the pf_* kernels to the registered variants that agree with the
+ * c reference, the others keep running the c code */
+void
+image_utils_install_verified (void)
+{
+  static gboolean done = FALSE;
+  const ImageUtilsImpl *impl;
+  gchar *failure;
+  gint i, k;
+
+  if (done)
+    return;
+  done = TRUE;
+
+  for (i = 1; (impl = image_utils_get_impl (i)) != NULL; i++) {
+    for (k = 0; k < IMAGE_UTILS_NUM_KERNELS; k++) {
+      if (!image_utils_has_kernel (impl, k))
+        continue;
+      failure = NULL;
+      if (image_utils_check_kernel (impl, k, 0x7475696f, 1, &failure)) {
+        install_kernel (impl, k);
+      } else {
+        g_warning ("%s disagrees with the c reference, not used (%s)",
+            kernel_names[k], failure);
+        g_free (failure);
+      }
+    }
+  }
+}
@@ -0,0 +1,96 @@
+/*
+ *  gst-tuio - Gstreamer to tuio computer vision plugin
+ *
+ *  Copyright (C) 2010 Keith Mok <ek9852@gmail.com>
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+
+#ifndef __IMAGE_UTILS_IMPL_H__
+#define __IMAGE_UTILS_IMPL_H__
+
+#include "image_utils.h"
+
+G_BEGIN_DECLS
+
+/* Every image_utils variant (c, mmx, sse2, neon, iwmmxt) registers the kernels
+ * it implements, so that they can be benchmarked and compared against the
+ * c reference. Kernels a variant does not implement are NULL. A variant's
+ * kernel only replaces the pf_* default once image_utils_install_verified()
+ * found it bit-exact with the c reference. */
+typedef struct _ImageUtilsImpl ImageUtilsImpl;
+
+/* 2x2 box average with rounding, dst is (width/2)x(height/2) with a
+ * stride of width/2, an odd last column or row is dropped */
+typedef void (*image8_downsample2_t) (const guint8 *src, guint8 *dst,
+    gint width, gint stride, gint height);
+
+/* bilinear blend of the 2x2 neighbourhood gathered into four planes (top
+ * left, top right, bottom left, bottom right), fx and fy are the weights
+ * of the right and bottom taps in 1/128 (0..128) */
+typedef void (*image8_bilinear_t) (const guint8 *tl, const guint8 *tr,
+    const guint8 *bl, const guint8 *br, const guint8 *fx, const guint8 *fy,
+    guint8 *dst, gint n);
+
+extern image8_downsample2_t pf_image8_downsample2;
+extern image8_bilinear_t pf_image8_bilinear;
+
+struct _ImageUtilsImpl
+{
+  const gchar *name;
+  update_background_buf_t update_background_buf;
+  image8_box_blur_t image8_box_blur;
+  image8_subtract_t image8_subtract;
+  image8_amplify_t image8_amplify;
+  image8_threshold_t image8_threshold;
+  image8_downsample2_t image8_downsample2;
+  image8_bilinear_t image8_bilinear;
+};
+
+#define IMAGE_UTILS_MAX_IMPL 8
+
+typedef enum {
+  IMAGE_UTILS_UPDATE_BACKGROUND_BUF = 0,
+  IMAGE_UTILS_BOX_BLUR,
+  IMAGE_UTILS_SUBTRACT,
+  IMAGE_UTILS_AMPLIFY,
+  IMAGE_UTILS_THRESHOLD,
+  IMAGE_UTILS_DOWNSAMPLE2,
+  IMAGE_UTILS_BILINEAR,
+  IMAGE_UTILS_NUM_KERNELS,
+} ImageUtilsKernel;
+
+void image_utils_register_impl (const ImageUtilsImpl *impl);
+const ImageUtilsImpl *image_utils_get_impl (gint index);
+
+/* decimate by 2 or 4 through pf_image8_downsample2, tmp holds the 2x
+ * image on the way to 4x */
+void image8_downsample (const guint8 *src, guint8 *dst, guint8 *tmp,
+    gint width, gint height, gint decimate);
+
+/* image_utils_check.c, differential check against the c reference */
+const gchar *image_utils_kernel_name (ImageUtilsKernel kernel);
+gboolean image_utils_has_kernel (const ImageUtilsImpl *impl,
+    ImageUtilsKernel kernel);
+gboolean image_utils_check_kernel (const ImageUtilsImpl *impl,
+    ImageUtilsKernel kernel, guint32 seed, gint iterations,
+    gchar **failure);
+void image_utils_install_verified (void);
+
+G_END_DECLS
+
+#endif /* __IMAGE_UTILS_IMPL_H__ */
@@ -26,6 +26,7 @@
 #include <string.h>
 #include <stdint.h>
 #include "image_utils.h"
+#include "image_utils_impl.h"
 
 __attribute__((constructor)) static void image_util_iwmmxt_init( void );
 
@@ -201,10 +202,18 @@ image8_threshold_iwmmxt(const guint8 *src, guint8 *dst, gint width, gint stride,
   }
 }
 
+static const ImageUtilsImpl image_utils_iwmmxt_impl = {
+  "iwmmxt",
+  NULL,
+  NULL,
+  image8_subtract_iwmmxt,
+  image8_amplify_iwmmxt,
+  image8_threshold_iwmmxt,
+};
+
 static void image_util_iwmmxt_init(void)
 {
-  pf_image8_amplify = image8_amplify_iwmmxt;
-  pf_image8_subtract = image8_subtract_iwmmxt;
-  pf_image8_threshold = image8_threshold_iwmmxt;
+  /* pf_* are switched over by image_utils_install_verified() */
+  image_utils_register_impl(&image_utils_iwmmxt_impl);
 }
 
@@ -30,6 +30,7 @@
 #include <string.h>
 #include <stdint.h>
 #include "image_utils.h"
+#include "image_utils_impl.h"
 
 __attribute__((constructor)) static void image_util_mmx_init( void );
 
@@ -98,6 +99,10 @@ static void
 image8_amplify_mmx(const guint8 *src, guint8 *dst, gint width, gint stride,
     gint height, guint amplify_shift)
 {
+  /* packuswb saturates signed words, squares above 32767 need clamping
+   * to 255 first: min(x,255) = (x +sat 0xff00) - 0xff00 */
+  const uint16_t clamp_64[4] = { 0xff00, 0xff00, 0xff00, 0xff00 };
+
   while (height--) {
     const uint8_t *s;
     uint8_t *d;
@@ -110,6 +115,7 @@ image8_amplify_mmx(const guint8 *src, guint8 *dst, gint width, gint stride,
     while (w >= 16) {
       __asm__ volatile (
           "movd %[amplify_shift], %%mm4\n\t"
+          "movq %[clamp],     %%mm5\n\t"
           "pxor       %%mm7,   %%mm7\n\t"
 
           "movd     (%[s]),   %%mm0\n\t"
@@ -132,13 +138,23 @@ image8_amplify_mmx(const guint8 *src, guint8 *dst, gint width, gint stride,
           "psrlw      %%mm4,   %%mm2\n\t"
           "psrlw      %%mm4,   %%mm3\n\t"
 
+          "paddusw    %%mm5,   %%mm0\n\t"     /* clamp to 255 */
+          "paddusw    %%mm5,   %%mm1\n\t"
+          "paddusw    %%mm5,   %%mm2\n\t"
+          "paddusw    %%mm5,   %%mm3\n\t"
+          "psubw      %%mm5,   %%mm0\n\t"
+          "psubw      %%mm5,   %%mm1\n\t"
+          "psubw      %%mm5,   %%mm2\n\t"
+          "psubw      %%mm5,   %%mm3\n\t"
+
           "packuswb   %%mm1,    %%mm0\n\t"
           "packuswb   %%mm3,    %%mm2\n\t"
 
           "movq       %%mm0,   (%[d])\n\t"
           "movq       %%mm2,  8(%[d])\n\t"
           :
-          : [s] "r" (s), [d] "r" (d), [amplify_shift] "r" (amplify_shift)
+          : [s] "r" (s), [d] "r" (d), [amplify_shift] "r" (amplify_shift),
+            [clamp] "m" (clamp_64[0])
           : "memory",
             "%mm0", "%mm1", "%mm2", "%mm3",
             "%mm4", "%mm5", "%mm6", "%mm7");
@@ -168,12 +184,14 @@ image8_threshold_mmx(const guint8 *src, guint8 *dst, gint width, gint stride,
     gint height, guint threshold)
 {
   uint32_t threshold_64[2];
+  /* the source gets its sign bit flipped for pcmpgtb, so must the
+   * threshold */
+  guint signed_threshold = (threshold & 0xff) ^ 0x80;
 
-  threshold_64[0] = threshold | threshold << 8 | threshold << 16 |
-    threshold << 24;
+  threshold_64[0] = signed_threshold | signed_threshold << 8 |
+    signed_threshold << 16 | signed_threshold << 24;
 
-  threshold_64[1] = threshold | threshold << 8 | threshold << 16 |
-    threshold << 24;
+  threshold_64[1] = threshold_64[0];
 
   while (height--) {
     const uint8_t *s;
@@ -229,10 +247,201 @@ image8_threshold_mmx(const guint8 *src, guint8 *dst, gint width, gint stride,
   __asm__ volatile ("emms\n\t");
 }
 
+static void
+image8_downsample2_mmx(const guint8 *src, guint8 *dst, gint width,
+    gint stride, gint height)
+{
+  /* even bytes by masking, odd bytes by shifting the words right */
+  const uint16_t even_64[4] = { 0x00ff, 0x00ff, 0x00ff, 0x00ff };
+  const uint16_t round_64[4] = { 2, 2, 2, 2 };
+
+  height /= 2;
+  while (height--) {
+    const uint8_t *s0;
+    const uint8_t *s1;
+    uint8_t *d;
+    int w;
+
+    s0 = src;
+    s1 = src + stride;
+    d = dst;
+    w = width / 2;
+
+    while (w >= 8) {
+      __asm__ volatile (
+          "movq %[even],      %%mm7\n\t"
+          "movq %[round],     %%mm6\n\t"
+
+          "movq     (%[s0]),  %%mm0\n\t"
+          "movq    8(%[s0]),  %%mm1\n\t"
+          "movq     (%[s1]),  %%mm2\n\t"
+          "movq    8(%[s1]),  %%mm3\n\t"
+
+          "movq       %%mm0,  %%mm4\n\t"
+          "movq       %%mm1,  %%mm5\n\t"
+          "pand       %%mm7,  %%mm0\n\t"
+          "pand       %%mm7,  %%mm1\n\t"
+          "psrlw        $8,   %%mm4\n\t"
+          "psrlw        $8,   %%mm5\n\t"
+          "paddw      %%mm4,  %%mm0\n\t" /* horizontal pairs, top row */
+          "paddw      %%mm5,  %%mm1\n\t"
+
+          "movq       %%mm2,  %%mm4\n\t"
+          "movq       %%mm3,  %%mm5\n\t"
+          "pand       %%mm7,  %%mm2\n\t"
+          "pand       %%mm7,  %%mm3\n\t"
+          "psrlw        $8,   %%mm4\n\t"
+          "psrlw        $8,   %%mm5\n\t"
+          "paddw      %%mm4,  %%mm2\n\t" /* horizontal pairs, bottom row */
+          "paddw      %%mm5,  %%mm3\n\t"
+
+          "paddw      %%mm2,  %%mm0\n\t" /* max 4*255, no overflow */
+          "paddw      %%mm3,  %%mm1\n\t"
+          "paddw      %%mm6,  %%mm0\n\t"
+          "paddw      %%mm6,  %%mm1\n\t"
+          "psrlw        $2,   %%mm0\n\t"
+          "psrlw        $2,   %%mm1\n\t"
+
+          "packuswb   %%mm1,  %%mm0\n\t"
+          "movq       %%mm0,  (%[d])\n\t"
+          :
+          : [s0] "r" (s0), [s1] "r" (s1), [d] "r" (d),
+            [even] "m" (even_64[0]), [round] "m" (round_64[0])
+          : "memory",
+            "%mm0", "%mm1", "%mm2", "%mm3",
+            "%mm4", "%mm5", "%mm6", "%mm7");
+      s0 += 16;
+      s1 += 16;
+      d += 8;
+      w -= 8;
+    }
+    while (w > 0) {
+      *d++ = (s0[0] + s0[1] + s1[0] + s1[1] + 2) >> 2;
+      s0 += 2;
+      s1 += 2;
+      w--;
+    }
+    src += 2 * stride;
+    dst += width / 2;
+  }
+  __asm__ volatile ("emms\n\t");
+}
+
+/* only built where the compiler may assume SSE2 (always on x86_64), the
+ * plugin has no run time cpu detection */
+#if defined(CAN_COMPILE_SSE2) && defined(__SSE2__)
+/* 8 pixels a round: taps and weights are widened to words and interleaved,
+ * so every pmaddwd dword is a * (128 - f) + b * f of one pixel */
+static void
+image8_bilinear_sse2(const guint8 *tl, const guint8 *tr, const guint8 *bl,
+    const guint8 *br, const guint8 *fx, const guint8 *fy, guint8 *dst,
+    gint n)
+{
+  const uint16_t one_128[8] __attribute__((aligned(16))) =
+      { 128, 128, 128, 128, 128, 128, 128, 128 };
+  const uint32_t round_128[4] __attribute__((aligned(16))) =
+      { 8192, 8192, 8192, 8192 };
+  guint32 top, bottom;
+  gint i;
+
+  for (i = 0; i + 8 <= n; i += 8) {
+    __asm__ volatile (
+        "pxor          %%xmm7,    %%xmm7\n\t"
+        "movdqa     (%[one]),     %%xmm6\n\t"
+        /* (128 - fx, fx) pairs */
+        "movq        (%[fx]),     %%xmm4\n\t"
+        "punpcklbw     %%xmm7,    %%xmm4\n\t"
+        "movdqa        %%xmm6,    %%xmm5\n\t"
+        "psubw         %%xmm4,    %%xmm5\n\t"
+        "movdqa        %%xmm5,    %%xmm3\n\t"
+        "punpcklwd     %%xmm4,    %%xmm3\n\t"
+        "punpckhwd     %%xmm4,    %%xmm5\n\t"
+        /* top = tl * (128 - fx) + tr * fx */
+        "movq        (%[tl]),     %%xmm0\n\t"
+        "movq        (%[tr]),     %%xmm1\n\t"
+        "punpcklbw     %%xmm7,    %%xmm0\n\t"
+        "punpcklbw     %%xmm7,    %%xmm1\n\t"
+        "movdqa        %%xmm0,    %%xmm2\n\t"
+        "punpcklwd     %%xmm1,    %%xmm0\n\t"
+        "punpckhwd     %%xmm1,    %%xmm2\n\t"
+        "pmaddwd       %%xmm3,    %%xmm0\n\t"
+        "pmaddwd       %%xmm5,    %%xmm2\n\t"
+        "packssdw      %%xmm2,    %%xmm0\n\t"
+        /* bottom = bl * (128 - fx) + br * fx */
+        "movq        (%[bl]),     %%xmm1\n\t"
+        "movq        (%[br]),     %%xmm4\n\t"
+        "punpcklbw     %%xmm7,    %%xmm1\n\t"
+        "punpcklbw     %%xmm7,    %%xmm4\n\t"
+        "movdqa        %%xmm1,    %%xmm2\n\t"
+        "punpcklwd     %%xmm4,    %%xmm1\n\t"
+        "punpckhwd     %%xmm4,    %%xmm2\n\t"
+        "pmaddwd       %%xmm3,    %%xmm1\n\t"
+        "pmaddwd       %%xmm5,    %%xmm2\n\t"
+        "packssdw      %%xmm2,    %%xmm1\n\t"
+        /* (128 - fy, fy) pairs */
+        "movq        (%[fy]),     %%xmm4\n\t"
+        "punpcklbw     %%xmm7,    %%xmm4\n\t"
+        "psubw         %%xmm4,    %%xmm6\n\t"
+        "movdqa        %%xmm6,    %%xmm3\n\t"
+        "punpcklwd     %%xmm4,    %%xmm3\n\t"
+        "punpckhwd     %%xmm4,    %%xmm6\n\t"
+        /* (top * (128 - fy) + bottom * fy + 8192) >> 14 */
+        "movdqa        %%xmm0,    %%xmm2\n\t"
+        "punpcklwd     %%xmm1,    %%xmm0\n\t"
+        "punpckhwd     %%xmm1,    %%xmm2\n\t"
+        "pmaddwd       %%xmm3,    %%xmm0\n\t"
+        "pmaddwd       %%xmm6,    %%xmm2\n\t"
+        "movdqa   (%[round]),     %%xmm5\n\t"
+        "paddd         %%xmm5,    %%xmm0\n\t"
+        "paddd         %%xmm5,    %%xmm2\n\t"
+        "psrld            $14,    %%xmm0\n\t"
+        "psrld            $14,    %%xmm2\n\t"
+        "packssdw      %%xmm2,    %%xmm0\n\t"
+        "packuswb      %%xmm0,    %%xmm0\n\t"
+        "movq          %%xmm0,    (%[d])\n\t"
+        :
+        : [tl] "r" (tl + i), [tr] "r" (tr + i), [bl] "r" (bl + i),
+          [br] "r" (br + i), [fx] "r" (fx + i), [fy] "r" (fy + i),
+          [d] "r" (dst + i), [one] "r" (one_128), [round] "r" (round_128)
+        : "memory",
+        "xmm0", "xmm1", "xmm2", "xmm3", "xmm4", "xmm5", "xmm6", "xmm7");
+  }
+
+  for (; i < n; i++) {
+    top = tl[i] * (128 - fx[i]) + tr[i] * fx[i];
+    bottom = bl[i] * (128 - fx[i]) + br[i] * fx[i];
+    dst[i] = (top * (128 - fy[i]) + bottom * fy[i] + 8192) >> 14;
+  }
+}
+
+static const ImageUtilsImpl image_utils_sse2_impl = {
+  "sse2",
+  NULL,
+  NULL,
+  NULL,
+  NULL,
+  NULL,
+  NULL,
+  image8_bilinear_sse2,
+};
+#endif
+
+static const ImageUtilsImpl image_utils_mmx_impl = {
+  "mmx",
+  NULL,
+  NULL,
+  image8_subtract_mmx,
+  image8_amplify_mmx,
+  image8_threshold_mmx,
+  image8_downsample2_mmx,
+};
+
 static void image_util_mmx_init(void)
 {
-  pf_image8_amplify = image8_amplify_mmx;
-  pf_image8_subtract = image8_subtract_mmx;
-  pf_image8_threshold = image8_threshold_mmx;
+  /* pf_* are switched over by image_utils_install_verified() */
+  image_utils_register_impl(&image_utils_mmx_impl);
+#if defined(CAN_COMPILE_SSE2) && defined(__SSE2__)
+  image_utils_register_impl(&image_utils_sse2_impl);
+#endif
 }
 
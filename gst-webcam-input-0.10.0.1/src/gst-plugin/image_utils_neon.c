@@ -26,6 +26,7 @@
 #include <string.h>
 #include <stdint.h>
 #include "image_utils.h"
+#include "image_utils_impl.h"
 
 __attribute__((constructor)) static void image_util_neon_init( void );
 
@@ -99,10 +100,10 @@ image8_amplify_neon(const guint8 *src, guint8 *dst, gint width, gint stride, gin
           "vshl.u16     q6, q6, q12\n\t"
           "vshl.u16     q7, q7, q12\n\t"
 
-          "vshrn.i16     d0, q4, #0\n\t"
-          "vshrn.i16     d1, q5, #0\n\t"
-          "vshrn.i16     d2, q6, #0\n\t"
-          "vshrn.i16     d3, q7, #0\n\t"
+          "vqmovn.u16    d0, q4\n\t" /* narrow, saturating to 255 */
+          "vqmovn.u16    d1, q5\n\t"
+          "vqmovn.u16    d2, q6\n\t"
+          "vqmovn.u16    d3, q7\n\t"
 
           "vst1.64      {d0-d3}, [%[d]]!\n\t"
           : [s] "+r" (s), [d] "+r" (d)
@@ -207,14 +208,14 @@ blur_vert(const guint8 *src, guint8 *dst, gint w, gint h, int stride, gint radiu
   int length;
   int inv;
 
-  if (radius >= h)
-    radius = h - 1;
+  if (2*radius >= h)
+    radius = (h - 1) / 2;
 
   length = radius*2 + 1;
   inv = ((1<<16) + length/2)/length;
 
-  /* CAUTION radius must be < w and < h */
-  while(w>=8) {
+  /* CAUTION radius must be < w and < h, the loop below needs radius > 0 */
+  while(radius > 0 && w>=8) {
       guint8 *s1, *s2;
       guint8 *d;
 
@@ -395,8 +396,9 @@ blur_horiz(const guint8 *src, guint8 *dst, gint w, gint h, int stride, gint radi
 {
   int y;
 
-  if (radius > w)
-    radius = w - 1;
+  /* the mirrored borders read up to 2*radius pixels */
+  if (2*radius >= w)
+    radius = (w - 1) / 2;
 
   /* TODO this is difficult to optimizate */
   for(y=0; y<h; y++){
@@ -509,12 +511,115 @@ update_background_buf_neon(const guint8 *src, guint8 *background, guint16 *backg
   }
 }
 
+static void
+image8_downsample2_neon(const guint8 *src, guint8 *dst, gint width, gint stride, gint height)
+{
+  height /= 2;
+  while (height--) {
+    const uint8_t *s0;
+    const uint8_t *s1;
+    uint8_t *d;
+    int w;
+
+    s0 = src;
+    s1 = src + stride;
+    d = dst;
+    w = width / 2;
+
+    while (w >= 16) {
+      __asm__ volatile (
+          "vld1.64      {d0-d3},  [%[s0]]!\n\t"
+          "vld1.64      {d4-d7},  [%[s1]]!\n\t"
+          "vpaddl.u8    q0, q0\n\t"     /* horizontal pairs, top row */
+          "vpaddl.u8    q1, q1\n\t"
+          "vpadal.u8    q0, q2\n\t"     /* accumulate the bottom row pairs */
+          "vpadal.u8    q1, q3\n\t"
+          "vrshrn.u16   d0, q0, #2\n\t" /* (sum + 2) >> 2 */
+          "vrshrn.u16   d1, q1, #2\n\t"
+          "vst1.64      {d0-d1}, [%[d]]!\n\t"
+          : [s0] "+r" (s0), [s1] "+r" (s1), [d] "+r" (d)
+          :
+          : "memory",
+          "q0", "q1", "q2", "q3");
+      w -= 16;
+    }
+    while (w > 0) {
+      *d++ = (s0[0] + s0[1] + s1[0] + s1[1] + 2) >> 2;
+      s0 += 2;
+      s1 += 2;
+      w--;
+    }
+    src += 2 * stride;
+    dst += width / 2;
+  }
+}
+
+/* 8 pixels a round, the products of the taps and weights fit 16 bits,
+ * the blend of top and bottom is done in 32 bits */
+static void
+image8_bilinear_neon(const guint8 *tl, const guint8 *tr, const guint8 *bl,
+    const guint8 *br, const guint8 *fx, const guint8 *fy, guint8 *dst,
+    gint n)
+{
+  guint32 top, bottom;
+
+  while (n >= 8) {
+    __asm__ volatile (
+        "vmov.i8      d30, #128\n\t"
+        "vld1.8       {d0},  [%[tl]]!\n\t"
+        "vld1.8       {d1},  [%[tr]]!\n\t"
+        "vld1.8       {d2},  [%[bl]]!\n\t"
+        "vld1.8       {d3},  [%[br]]!\n\t"
+        "vld1.8       {d4},  [%[fx]]!\n\t"
+        "vld1.8       {d5},  [%[fy]]!\n\t"
+        "vsub.i8      d6, d30, d4\n\t"        /* 128 - fx */
+        "vsub.i8      d7, d30, d5\n\t"        /* 128 - fy */
+        "vmull.u8     q10, d0, d6\n\t"        /* top */
+        "vmlal.u8     q10, d1, d4\n\t"
+        "vmull.u8     q11, d2, d6\n\t"        /* bottom */
+        "vmlal.u8     q11, d3, d4\n\t"
+        "vmovl.u8     q12, d7\n\t"
+        "vmovl.u8     q13, d5\n\t"
+        "vmull.u16    q8, d20, d24\n\t"
+        "vmlal.u16    q8, d22, d26\n\t"
+        "vmull.u16    q9, d21, d25\n\t"
+        "vmlal.u16    q9, d23, d27\n\t"
+        "vrshrn.u32   d0, q8, #14\n\t"        /* (sum + 8192) >> 14 */
+        "vrshrn.u32   d1, q9, #14\n\t"
+        "vmovn.i16    d0, q0\n\t"
+        "vst1.8       {d0},  [%[d]]!\n\t"
+        : [tl] "+r" (tl), [tr] "+r" (tr), [bl] "+r" (bl), [br] "+r" (br),
+          [fx] "+r" (fx), [fy] "+r" (fy), [d] "+r" (dst)
+        :
+        : "memory",
+        "q0", "q1", "q2", "q3", "q8", "q9", "q10", "q11", "q12", "q13",
+        "q15");
+    n -= 8;
+  }
+  while (n > 0) {
+    top = *tl++ * (128 - *fx) + *tr++ * *fx;
+    bottom = *bl++ * (128 - *fx) + *br++ * *fx;
+    fx++;
+    *dst++ = (top * (128 - *fy) + bottom * *fy + 8192) >> 14;
+    fy++;
+    n--;
+  }
+}
+
+static const ImageUtilsImpl image_utils_neon_impl = {
+  "neon",
+  update_background_buf_neon,
+  image8_box_blur_neon,
+  image8_subtract_neon,
+  image8_amplify_neon,
+  image8_threshold_neon,
+  image8_downsample2_neon,
+  image8_bilinear_neon,
+};
+
 static void image_util_neon_init(void)
 {
-  pf_image8_amplify = image8_amplify_neon;
-  pf_image8_subtract = image8_subtract_neon;
-  pf_image8_threshold = image8_threshold_neon;
-  pf_image8_box_blur = image8_box_blur_neon;
-  pf_update_background_buf = update_background_buf_neon;
+  /* pf_* are switched over by image_utils_install_verified() */
+  image_utils_register_impl(&image_utils_neon_impl);
 }
 
@@ -0,0 +1,140 @@
+/*
+ *  gst-tuio - Gstreamer to tuio computer vision plugin
+ *
+ *  Copyright (C) 2010 Keith Mok <ek9852@gmail.com>
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+
+#ifdef HAVE_CONFIG_H
+#  include <config.h>
+#endif
+
+#include <string.h>
+#include <glib.h>
+#if !defined(G_OS_WIN32)
+#include <time.h>
+#endif
+#include "stage_stats.h"
+
+void
+stage_stats_init (StageStats *stats, guint window)
+{
+  memset(stats, 0, sizeof(StageStats));
+  stats->window = window;
+  stats->lock = g_mutex_new();
+}
+
+void
+stage_stats_clear (StageStats *stats)
+{
+  g_mutex_free(stats->lock);
+  stats->lock = NULL;
+}
+
+void
+stage_stats_set_window (StageStats *stats, guint window)
+{
+  stats->window = window;
+}
+
+/* monotonic clock in nanoseconds */
+guint64
+stage_stats_now (void)
+{
+#if defined(G_OS_WIN32)
+  return (guint64)g_get_monotonic_time() * 1000;
+#else
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (guint64)ts.tv_sec * 1000000000 + ts.tv_nsec;
+#endif
+}
+
+static inline gint
+bucket_of (guint64 ns)
+{
+  gint i = 0;
+
+  while ((ns >>= 1) && (i < STAGE_STATS_BUCKETS - 1))
+    i++;
+  return i;
+}
+
+/* return TRUE when the window rolled over */
+gboolean
+stage_stats_add (StageStats *stats, guint64 ns)
+{
+  StageHistogram *h = &stats->current;
+
+  h->count++;
+  h->total_ns += ns;
+  if (ns > h->max_ns)
+    h->max_ns = ns;
+  h->buckets[bucket_of(ns)]++;
+
+  if ((stats->window == 0) || (h->count < stats->window))
+    return FALSE;
+
+  g_mutex_lock(stats->lock);
+  stats->last = *h;
+  g_mutex_unlock(stats->lock);
+  memset(h, 0, sizeof(StageHistogram));
+
+  return TRUE;
+}
+
+/* account the time since start, return now for chaining the next stage */
+guint64
+stage_stats_lap (StageStats *stats, guint64 start)
+{
+  guint64 now = stage_stats_now();
+
+  stage_stats_add(stats, now - start);
+  return now;
+}
+
+void
+stage_stats_get_last (StageStats *stats, StageHistogram *hist)
+{
+  g_mutex_lock(stats->lock);
+  *hist = stats->last;
+  g_mutex_unlock(stats->lock);
+}
+
+/* upper bound of the bucket holding the given percentile (0-100) */
+guint64
+stage_histogram_percentile (const StageHistogram *hist, gdouble percent)
+{
+  guint64 target, seen = 0;
+  gint i;
+
+  if (hist->count == 0)
+    return 0;
+
+  target = (guint64)(hist->count * percent / 100.0);
+  if (target == 0)
+    target = 1;
+
+  for (i = 0; i < STAGE_STATS_BUCKETS; i++) {
+    seen += hist->buckets[i];
+    if (seen >= target)
+      return MIN((G_GUINT64_CONSTANT(2) << i) - 1, hist->max_ns);
+  }
+  return hist->max_ns;
+}
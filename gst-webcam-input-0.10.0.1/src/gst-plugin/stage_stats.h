@@ -0,0 +1,69 @@
+/*
+ *  gst-tuio - Gstreamer to tuio computer vision plugin
+ *
+ *  Copyright (C) 2010 Keith Mok <ek9852@gmail.com>
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+
+#ifndef __STAGE_STATS_H__
+#define __STAGE_STATS_H__
+
+#include <glib.h>
+
+G_BEGIN_DECLS
+
+/* log2 buckets in nanoseconds, bucket i holds [2^i, 2^(i+1)) */
+#define STAGE_STATS_BUCKETS 32
+
+typedef struct _StageHistogram StageHistogram;
+typedef struct _StageStats     StageStats;
+
+struct _StageHistogram
+{
+  guint64 count;
+  guint64 total_ns;
+  guint64 max_ns;
+  guint buckets[STAGE_STATS_BUCKETS];
+};
+
+/* Rolling histogram of one processing stage. Samples are added by a single
+ * thread into the current window, once the window is full it is copied
+ * into the last window which can be read from any thread. */
+struct _StageStats
+{
+  guint window;
+  StageHistogram current;
+  StageHistogram last;
+  GMutex *lock; /* protects last */
+};
+
+void stage_stats_init (StageStats *stats, guint window);
+void stage_stats_clear (StageStats *stats);
+void stage_stats_set_window (StageStats *stats, guint window);
+
+guint64 stage_stats_now (void);
+gboolean stage_stats_add (StageStats *stats, guint64 ns);
+guint64 stage_stats_lap (StageStats *stats, guint64 start);
+
+void stage_stats_get_last (StageStats *stats, StageHistogram *hist);
+guint64 stage_histogram_percentile (const StageHistogram *hist,
+    gdouble percent);
+
+G_END_DECLS
+
+#endif /* __STAGE_STATS_H__ */
@@ -0,0 +1,164 @@
+/*
+ *  gst-tuio - Gstreamer to tuio computer vision plugin
+ *
+ *  Copyright (C) 2010 Keith Mok <ek9852@gmail.com>
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+
+#ifdef HAVE_CONFIG_H
+#  include <config.h>
+#endif
+
+#include "triple_buffer.h"
+
+/* the shared (middle) index carries a fresh flag so that the consumer knows
+ * whether the producer has published anything since the last swap */
+#define SLOT_MASK   0x3
+#define SLOT_FRESH  0x4
+
+struct _TripleBuffer
+{
+  gpointer slots[3];
+
+  gint back;                 /* owned by producer */
+  gint front;                /* owned by consumer */
+  volatile gint middle;      /* shared, swapped atomically */
+
+  /* only used to put an idle consumer to sleep, the producer takes the
+   * lock only when the consumer is known to be waiting */
+  GMutex *lock;
+  GCond *cond;
+  volatile gint waiting;
+  volatile gint closed;
+};
+
+TripleBuffer *
+triple_buffer_new (gpointer slot0, gpointer slot1, gpointer slot2)
+{
+  TripleBuffer *tb;
+
+  tb = g_new0 (TripleBuffer, 1);
+  tb->slots[0] = slot0;
+  tb->slots[1] = slot1;
+  tb->slots[2] = slot2;
+  tb->back = 0;
+  tb->middle = 1;
+  tb->front = 2;
+  tb->lock = g_mutex_new ();
+  tb->cond = g_cond_new ();
+
+  return tb;
+}
+
+void
+triple_buffer_free (TripleBuffer *tb)
+{
+  g_mutex_free (tb->lock);
+  g_cond_free (tb->cond);
+  g_free (tb);
+}
+
+gpointer
+triple_buffer_get_back (TripleBuffer *tb)
+{
+  return tb->slots[tb->back];
+}
+
+/* hand the back slot over to the consumer, return TRUE if an unread
+ * snapshot got overwritten (consumer lagging) */
+gboolean
+triple_buffer_publish (TripleBuffer *tb)
+{
+  gint old;
+
+  do {
+    old = g_atomic_int_get (&tb->middle);
+  } while (!g_atomic_int_compare_and_exchange (&tb->middle, old,
+        tb->back | SLOT_FRESH));
+
+  tb->back = old & SLOT_MASK;
+
+  if (g_atomic_int_get (&tb->waiting)) {
+    g_mutex_lock (tb->lock);
+    g_cond_signal (tb->cond);
+    g_mutex_unlock (tb->lock);
+  }
+
+  return (old & SLOT_FRESH) != 0;
+}
+
+static gboolean
+triple_buffer_try_swap_front (TripleBuffer *tb)
+{
+  gint old;
+
+  do {
+    old = g_atomic_int_get (&tb->middle);
+    if (!(old & SLOT_FRESH))
+      return FALSE;
+  } while (!g_atomic_int_compare_and_exchange (&tb->middle, old, tb->front));
+
+  tb->front = old & SLOT_MASK;
+  return TRUE;
+}
+
+/* block until a new snapshot is published, return NULL once closed */
+gpointer
+triple_buffer_wait (TripleBuffer *tb)
+{
+  while (!triple_buffer_try_swap_front (tb)) {
+    g_mutex_lock (tb->lock);
+    g_atomic_int_set (&tb->waiting, 1);
+    while (!(g_atomic_int_get (&tb->middle) & SLOT_FRESH) &&
+        !g_atomic_int_get (&tb->closed))
+      g_cond_wait (tb->cond, tb->lock);
+    g_atomic_int_set (&tb->waiting, 0);
+    g_mutex_unlock (tb->lock);
+
+    if (g_atomic_int_get (&tb->closed))
+      return NULL;
+  }
+
+  return tb->slots[tb->front];
+}
+
+/* undo a close, for a new consumer. A snapshot published before the
+ * close is stale, the new consumer only gets what comes after. */
+void
+triple_buffer_open (TripleBuffer *tb)
+{
+  gint old;
+
+  do {
+    old = g_atomic_int_get (&tb->middle);
+  } while (!g_atomic_int_compare_and_exchange (&tb->middle, old,
+        old & SLOT_MASK));
+
+  g_mutex_lock (tb->lock);
+  g_atomic_int_set (&tb->closed, 0);
+  g_mutex_unlock (tb->lock);
+}
+
+void
+triple_buffer_close (TripleBuffer *tb)
+{
+  g_mutex_lock (tb->lock);
+  g_atomic_int_set (&tb->closed, 1);
+  g_cond_signal (tb->cond);
+  g_mutex_unlock (tb->lock);
+}
@@ -0,0 +1,50 @@
+/*
+ *  gst-tuio - Gstreamer to tuio computer vision plugin
+ *
+ *  Copyright (C) 2010 Keith Mok <ek9852@gmail.com>
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+
+#ifndef __TRIPLE_BUFFER_H__
+#define __TRIPLE_BUFFER_H__
+
+#include <glib.h>
+
+G_BEGIN_DECLS
+
+/* Single producer / single consumer hand over of the latest snapshot.
+ * The producer never blocks: if the consumer lags, the unread snapshot is
+ * simply replaced by the newer one (latest wins). */
+typedef struct _TripleBuffer TripleBuffer;
+
+TripleBuffer *triple_buffer_new (gpointer slot0, gpointer slot1,
+    gpointer slot2);
+void triple_buffer_free (TripleBuffer *tb);
+
+/* producer side */
+gpointer triple_buffer_get_back (TripleBuffer *tb);
+gboolean triple_buffer_publish (TripleBuffer *tb);
+
+/* consumer side */
+gpointer triple_buffer_wait (TripleBuffer *tb);
+void triple_buffer_open (TripleBuffer *tb);
+void triple_buffer_close (TripleBuffer *tb);
+
+G_END_DECLS
+
+#endif /* __TRIPLE_BUFFER_H__ */
@@ -1,4 +1,5 @@
 //# 3 mixers with 3 sources :-O
+// was three videomixers fed through tees, blending every source up to three times:
 // gst-launch-1.0 -vt \
 //  videomixer name=mix1 ! videoconvert ! fpsdisplaysink sync=false \
 //  videomixer name=mix2 sink_0::zorder=1 sink_1::zorder=0 ! videoconvert ! fpsdisplaysink sync=false \
@@ -9,13 +10,20 @@
 //  col.  ! queue ! mix3. \
 //  snow. ! queue ! mix2. \
 //  net.  ! queue ! mix3.
+// now one multimixer (multimixer.c) blends the three outputs in one pass,
+// and chromakey (chromakey.c) keys the decoded I420 straight into AYUV.
+// surfacesrc (surfacesrc.c) receives the streams through an adaptive jitter
+// buffer; JPEG frames pass whole or not at all.
+// usage: 3mixer [jpeg|h264|vp8], the encoding surfacesend streams with.
+// build: gcc -Wall -O2 3mixertemplate.c ../multimixer.c ../mixer_blend.c ../chromakey.c ../key_convert.c ../surfacesrc.c ../frameguard.c ../surfaceprofile.c -o 3mixertemplate $(pkg-config --cflags --libs gstreamer-1.0 gstreamer-video-1.0 gstreamer-rtp-1.0) -lm
 #include <gst/gst.h>
 #include <glib.h>
-#include <gst/audio/audio.h>
 #include <string.h>
 
-#define CHUNK_SIZE 1024   /* Amount of bytes we are sending in each buffer */
-#define SAMPLE_RATE 44100 /* Samples per second we are sending */
+#include "../multimixer.h"
+#include "../chromakey.h"
+#include "../surfacesrc.h"
+#include "../surfaceprofile.h"
 
 /**
  * Structure to contain all our information,
@@ -23,92 +31,14 @@
  **/
 typedef struct _CustomData {
 	GstElement *pipeline;
-	GstElement *fpssink;
-	GstElement *source1,*source2,*source3; //the input sources
-	GstElement *convert;
-	GstElement *sink1, *sink2,*sink3;
-	GstElement *playbin;   /* the simple way to start a pipeline */
-	GstElement *scale,*filter,*tee;
-	GstElement *videobox1,*videobox2,*videobox3;
-	GstElement *mixer1,*mixer2,*mixer3;
-	GstElement **clrspace,*sink, *video_queue, *audio_queue;
+	GstElement *playbin;   /* the pipeline, watched by handle_message */
 	gboolean playing;      /* Are we in the PLAYING state? */
 	gboolean terminate;    /* Should we terminate execution? */
 	gboolean seek_enabled; /* Is seeking enabled for this media? */
 	gboolean seek_done;    /* Have we performed the seek already? */
 	gint64 duration;       /* How long does this media last, in nanoseconds */
-	gboolean flag_fps;
 	} CustomData;
 
-/*************************************************************************
- * Handler for the pad-added signal
- * Since this tutorial (and most real applications) involves callbacks,
- * we will group all our data in a structure for easier handling.
- *************************************************************************/
-static void pad_added_handler (GstElement *src, GstPad *pad, CustomData *data);
-/**
- * This function will be called by the pad-added signal
- * if time is needed to process the convertor
- * src is the GstElement which triggered the signal.
- * new_pad is the GstPad that has just been added to the src element
- * data is the pointer we provided when attaching to the signal
- **/
-static void pad_added_handler (GstElement *src, GstPad *new_pad, CustomData *data) {
-	GstPad *sink_pad = gst_element_get_static_pad (data->convert, "sink");
-	GstPadLinkReturn ret;
-	GstCaps *new_pad_caps = NULL;
-	GstStructure *new_pad_struct = NULL;
-	const gchar *new_pad_type = NULL;
-
-	g_print ("Received new pad '%s' from '%s':\n", GST_PAD_NAME (new_pad), GST_ELEMENT_NAME (src));
-
-	/**
-	 * Previous we linked element against element,this one links them directly
-	 * If our converter is already linked, we have nothing to do here
-	 * */
-	if (gst_pad_is_linked (sink_pad)) {
-		g_print ("We are already linked. Ignoring.\n");
-		goto exit;
-	}
-
-	/**
-	 * Check the new pad's type
-	 * uridecodebin can create as many pads as it sees fit,
-	 * and for each one, this callback will be called.
-	 * These lines of code will prevent us from trying to link to a new pad once we are already linked.
-	 **/
-	// gst_pad_get_current_caps() retrieves the current capabilities of the pad (that is, the kind of data it currently outputs), wrapped in a GstCaps structure
-	new_pad_caps = gst_pad_get_current_caps (new_pad);
-	// we know that the pad we want only had one capability (audio), we retrieve the first GstStructure with gst_caps_get_structure()
-	new_pad_struct = gst_caps_get_structure (new_pad_caps, 0);
-	//gst_structure_get_name() we recover the name of the structure, which contains the main description of the format (its media type, actually)
-	new_pad_type = gst_structure_get_name (new_pad_struct);
-	if (!g_str_has_prefix (new_pad_type, "audio/x-raw")) {
-		g_print ("It has type '%s' which is not raw audio. Ignoring.\n", new_pad_type);
-		goto exit;
-	}
-
-	/**
-	 * Attempt the link
-	 * gst_pad_link() tries to link two pads. As it was the case with gst_element_link(),
-	 * the link must be specified from source to sink, and both pads must be owned by elements residing in the same bin (or pipeline).
-	 **/
-	ret = gst_pad_link (new_pad, sink_pad);
-	if (GST_PAD_LINK_FAILED (ret)) {
-		g_print ("Type is '%s' but link failed.\n", new_pad_type);
-	} else {
-		g_print ("Link succeeded (type '%s').\n", new_pad_type);
-	}
-
-	exit:
-	/* Unreference the new pad's caps, if we got them */
-	if (new_pad_caps != NULL)
-		gst_caps_unref (new_pad_caps);
-
-	/* Unreference the sink pad */
-	gst_object_unref (sink_pad);
-}
-
 /*****************************************************************************
  * Forward definition of the message processing function
  ****************************************************************************/
@@ -133,6 +63,10 @@ static void handle_message (CustomData *data, GstMessage *msg) {
 			g_print ("End-Of-Stream reached.\n");
 			data->terminate = TRUE;
 			break;
+		case GST_MESSAGE_LATENCY:
+			/* a surfacesrc adapted its jitter buffer */
+			gst_bin_recalculate_latency (GST_BIN (data->playbin));
+			break;
 		case GST_MESSAGE_DURATION:
 			/* The duration has changed, mark the current one as invalid */
 			data->duration = GST_CLOCK_TIME_NONE;
@@ -190,12 +124,12 @@ int main(int argc, char *argv[]) {
 	CustomData data;
 	GstBus *bus;
 	GstMessage *msg;
-	GstCaps *filtercaps;
 	GstStateChangeReturn ret;
-	gboolean terminate = FALSE;
-	GMainLoop *loop;
+	GError *error = NULL;
+	const gchar *encoding = argc > 1 ? argv[1] : "jpeg";
+	const gchar *decoder = surface_profile_decoder (encoding);
+	gchar *description;
 	//
-	data.flag_fps =0;
 	data.playing = FALSE;
 	data.terminate = FALSE;
 	data.seek_enabled = FALSE;
@@ -207,178 +141,57 @@ int main(int argc, char *argv[]) {
 	gst_init (&argc, &argv);
 
 	/**
-	* create a GMainLoop
-	*/
-	loop = g_main_loop_new (NULL, FALSE);
-
-	/**
-	 * 2) Create the elements that are needed
-	 * using gst_element_factory_make
-	 * Source is the input, sink is the output
-	 **/
-	// the input needed
-	// data.source = gst_element_factory_make ("uridecodebin", "source"); //the method to use Uri/URL
-	data.source1 = gst_element_factory_make ("videotestsrc", "source1");
-	data.source2 = gst_element_factory_make ("videotestsrc", "source2");
-	data.source3 = gst_element_factory_make ("videotestsrc", "source3");
-	data.scale   = gst_element_factory_make ("videoscale", "scale");
-	data.filter = gst_element_factory_make("capsfilter","filter");
-	data.videobox1 = gst_element_factory_make ("videobox", "videobox1");
-  data.videobox2 = gst_element_factory_make ("videobox", "videobox2");
-	data.videobox3 = gst_element_factory_make ("videobox", "videobox3");
-	//videomixer name=mix1,2,3
-	data.mixer1 = gst_element_factory_make ("videomixer", "mixer1");
-	data.mixer2 = gst_element_factory_make ("videomixer", "mixer2");
-	data.mixer3 = gst_element_factory_make ("videomixer", "mixer3");
-	// fpsdisplaysink sync=false naybe just one needed?
-	data.fpssink = gst_element_factory_make ("fpsdisplaysink", NULL);
-	// the convector element needed
-	data.convert = gst_element_factory_make ("audioconvert", "convert");
-	// the output element needed
-	//   data.sink = gst_element_factory_make ("autoaudiosink", "sink"); //this is for audio
-	// sink_0::zorder=1 sink_1::zorder=0
-	data.sink1 = gst_element_factory_make ("fpsdisplaysink", "sink1");
-	data.sink2 = gst_element_factory_make ("fpsdisplaysink", "sink2");
-	data.sink3 = gst_element_factory_make ("fpsdisplaysink", "sink3");
-	//data.tee name=snow;
-	data.tee = gst_element_factory_make ("tee", "snow");
-	data.video_queue = gst_element_factory_make ("queue", "video_queue");
-	/**
-	 * 3) Create the empty pipeline
-	 **/
-	data.pipeline = gst_pipeline_new ("player");
-
-	/**
-	 * 4) check if the pipeline or elements have problems
+	 * 2) Register the multimixer, chromakey and surfacesrc
+	 * they are compiled into this program, not installed as a plugin
 	 **/
-	if (!data.pipeline) {
-		g_printerr ("pipeline could not be created.\n");
-		return -1;
-	}else if (!data.source1 || !data.source2 || !data.source3) {
-		g_printerr ("source could not be created.\n");
-		return -1;
-	} else if (!data.sink1 || !data.sink2) {
-		g_printerr ("sink could not be created.\n");
-		return -1;
-	}else if (!data.convert) {
-		g_printerr ("converter could not be created.\n");
-		return -1;
-	}else if (!data.fpssink) {
-		g_printerr ("fpssink could not be created.\n");
-		return -1;
-	}else if (!data.scale) {
-		g_printerr ("scale could not be created.\n");
-		return -1;
-	}else if (!data.filter) {
-		g_printerr ("filter could not be created.\n");
-		return -1;
-	}else if (!data.videobox1 || !data.videobox2 || !data.videobox3) {
-		g_printerr ("videobox could not be created.\n");
-		return -1;
-	}else if (!data.mixer1 || !data.mixer2 || !data.mixer3) {
-		g_printerr ("mixer could not be created.\n");
+	if (!multi_mixer_register () || !chroma_key_register () || !surface_src_register ()) {
+		g_printerr ("multimixer, chromakey or surfacesrc could not be registered.\n");
 		return -1;
 	}
 
-	/**
-	* filtercaps
-	* video/x-raw,width=1280,height=720
-	*/
-    filtercaps = gst_caps_new_simple ("video/x-raw-yuv",
-          "width", G_TYPE_INT, 1280,
-          "height", G_TYPE_INT, 720,
-          NULL);
-  g_object_set (G_OBJECT (data.filter), "caps", filtercaps, NULL);
-
-	/**
-	* Manually link the mixer, which has "Request" pads
-	* If you look at the documentation for the videomixer element,
-	* you'll see that videomixer's sink pads are request pads.
-	* You need to create these pads before linking them.
-	*/
-	GstPadTemplate* mixer_sink_pad_template = gst_element_class_get_pad_template (GST_ELEMENT_GET_CLASS (data.mixer1), "sink_%u");
-	GstPad* mixer_sink_pad = gst_element_request_pad (data.mixer1, mixer_sink_pad_template, NULL, NULL);
-	GstPad* sink_pad = gst_element_get_static_pad (data.clrspace, "src");
-	gst_pad_link ( sink_pad,mixer_sink_pad);
+	if (!decoder) {
+		g_printerr ("unknown encoding %s, use jpeg, h264 or vp8\n", encoding);
+		return -1;
+	}
 
 	/**
-	 * 5) Build the pipeline or add all the elementas to the pipeline
+	 * 3) Build the pipeline, one multimixer with three outputs:
+	 * src_0 is snow under net, src_1 snow under col,
+	 * src_2 col under net on black.
+	 * snow is sink_0 and drives all three, is-live paces it like the cameras.
 	 **/
-	// simple version:
-	//	pipeline = gst_parse_launch ("playbin uri=https://www.freedesktop.org/software/gstreamer-sdk/data/media/sintel_trailer-480p.webm", NULL);
-	// building with multiple items
-	// has to be similar to the cli one
-	gst_bin_add_many (GST_BIN (data.pipeline), data.source1, data.convert, data.sink1, NULL);
+	description = g_strdup_printf (
+		"multimixer name=mix"
+		"  src_0::order=\"0,1\""
+		"  src_1::order=\"0,2\""
+		"  src_2::order=\"2,1\" src_2::background=black "
+		"mix.src_0 ! videoconvert ! fpsdisplaysink sync=false "
+		"mix.src_1 ! videoconvert ! fpsdisplaysink sync=false "
+		"mix.src_2 ! videoconvert ! fpsdisplaysink sync=false "
+		"videotestsrc pattern=snow is-live=true ! video/x-raw,width=1280,height=720 ! videoconvert ! mix.sink_0 "
+		"surfacesrc port=5000 encoding=%s ! %s ! chromakey method=green ! mix.sink_1 "
+		"surfacesrc port=5001 encoding=%s ! %s ! chromakey method=green ! mix.sink_2",
+		encoding, decoder, encoding, decoder);
+	data.pipeline = gst_parse_launch (description, &error);
+	g_free (description);
 
 	/**
-	 * 6) check if the output (sink) and input (source) can be linked
-	 * or if the converter can be linked to the output
+	 * 4) check if the pipeline has problems
 	 **/
-	// always start with this
-	if (!gst_element_link (data.convert, data.sink1)) {
-		g_printerr ("converter and sink could not be linked.\n");
-		gst_object_unref (data.pipeline);
+	if (!data.pipeline) {
+		g_printerr ("pipeline could not be created: %s\n", error->message);
+		g_clear_error (&error);
 		return -1;
 	}
+	data.playbin = data.pipeline;
 
 	/**
-	 * 7) Modify the source's properties
-	 * Properties are read from with g_object_get() and written to with g_object_set()
-	 **/
-	 // videotestsrc pattern=snow
-	 g_object_set (G_OBJECT (data.source1), "pattern", "snow", NULL);
-
-	 /* Add feature FPS for video-sink */
-  if (data.flag_fps) {
-    g_object_set (G_OBJECT (data.fpssink), "text-overlay", FALSE, "video-sink", data.sink, NULL); }
-
-		/* Link the elements together */
-  /* file-source -> h264-parser -> h264-decoder -> video-output */
-  if (data.flag_fps) {
-    if (gst_element_link_many (data.source1, data.filter, data.videobox1, data.mixer1, data.fpssink, NULL)) {
-      g_printerr ("Elements could not be linked.\n");
-      gst_object_unref (data.pipeline);
-      return -1;
-    }
-  } else {
-    if (gst_element_link_many (data.source1, data.filter, data.videobox1, data.mixer1, data.sink1, NULL) != TRUE) {
-      g_printerr ("Elements could not be linked.\n");
-      gst_object_unref (data.pipeline);
-      return -1;
-    }
-  }
-
-
-
-	/** 8) Connect to the pad-added signal
-	 * this is needed if there is a delay between the input stream and the data converted form the codex
-	 * this calls the external functions that handles the data
-	 **/
-	g_signal_connect (data.source1, "pad-added", G_CALLBACK (pad_added_handler), &data);
-
-	/* Manually link the Tee, which has "Request" pads */
-	  GstPad* tee_audio_pad = gst_element_get_request_pad (data.tee, "src_%u");
-	  g_print ("Obtained request pad %s for audio branch.\n", gst_pad_get_name (tee_audio_pad));
-	  GstPad* queue_audio_pad = gst_element_get_static_pad (data.audio_queue, "sink");
-	  GstPad* tee_video_pad = gst_element_get_request_pad (data.tee, "src_%u");
-	  g_print ("Obtained request pad %s for video branch.\n", gst_pad_get_name (tee_video_pad));
-	  GstPad* queue_video_pad = gst_element_get_static_pad (data.video_queue, "sink");
-	  if (gst_pad_link (tee_audio_pad, queue_audio_pad) != GST_PAD_LINK_OK ||
-	      gst_pad_link (tee_video_pad, queue_video_pad) != GST_PAD_LINK_OK) {
-	    g_printerr ("Tee could not be linked.\n");
-	    gst_object_unref (data.pipeline);
-	    return -1;
-	  }
-	  gst_object_unref (queue_audio_pad);
-	  gst_object_unref (queue_video_pad);
-
-	/**
-	 * 9) Start playing
+	 * 5) Start playing
 	 **/
 	ret = gst_element_set_state (data.pipeline, GST_STATE_PLAYING);
 
 	/**
-	 * 10) Check if there is an error playing
+	 * 6) Check if there is an error playing
 	 **/
 	if (ret == GST_STATE_CHANGE_FAILURE) {
 		g_printerr ("Unable to set the pipeline to the playing state.\n");
@@ -388,12 +201,13 @@ int main(int argc, char *argv[]) {
 
 
 	/**
-	 * 11) Listen to the bus
+	 * 7) Listen to the bus
 	 **/
 	bus = gst_element_get_bus (data.pipeline);
 	do {
 		msg = gst_bus_timed_pop_filtered (bus, 100 * GST_MSECOND,
-		                                  GST_MESSAGE_STATE_CHANGED | GST_MESSAGE_ERROR | GST_MESSAGE_EOS);
+		                                  GST_MESSAGE_STATE_CHANGED | GST_MESSAGE_ERROR | GST_MESSAGE_EOS |
+		                                  GST_MESSAGE_LATENCY);
 		/**
 		 * Parse message
 		 * */
@@ -433,7 +247,7 @@ int main(int argc, char *argv[]) {
 	} while (!data.terminate);
 
 	/**
-	 * 13) Free resources
+	 * 8) Free resources
 	 **/
 	gst_object_unref (bus);
 	gst_element_set_state (data.pipeline, GST_STATE_NULL);
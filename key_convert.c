@@ -0,0 +1,274 @@
+/**
+ * Chroma keying of I420 rows into AYUV for the chromakey element.
+ *
+ * The classic angle keyer: a chroma sample is turned into x along the key
+ * direction and z across it, samples inside the accept angle around the
+ * key are made transparent in proportion to how far they reach past the
+ * foreground part x1, and that part is what is kept of their chroma and
+ * luma (spill suppression). Every intermediate stays within 16 bits, so
+ * eight samples go through SSE2 at once; the dot products use madd.
+ **/
+#include <math.h>
+#include <glib.h>
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <immintrin.h>
+#define HAVE_X86_DISPATCH 1
+#endif
+
+#include "key_convert.h"
+
+KeyChromaRowFunc key_chroma_row = key_chroma_row_c;
+KeyPackRowFunc key_pack_row = key_pack_row_c;
+static const gchar *impl_name = "c";
+
+void
+key_params_init (KeyParams *p, guint8 r, guint8 g, guint8 b, gfloat angle,
+		gfloat noise_level, guint black_sensitivity, guint white_sensitivity)
+{
+	gdouble ky, ku, kv, len, t;
+
+	/* BT.601 studio range, what the decoders produce */
+	ky = 16 + (65.738 * r + 129.057 * g + 25.064 * b) / 256;
+	ku = (-37.945 * r - 74.494 * g + 112.439 * b) / 256;
+	kv = (112.439 * r - 94.154 * g - 18.285 * b) / 256;
+	len = sqrt (ku * ku + kv * kv);
+	if (len < 1) {
+		/* a grey key has no hue, key on blue */
+		ku = len = 1;
+		kv = 0;
+	}
+
+	p->cb = (gint16) lrint (127 * ku / len);
+	p->cr = (gint16) lrint (127 * kv / len);
+	p->kg = (gint16) MIN (lrint (len), 127);
+
+	angle = CLAMP (angle, 7.5, 80);
+	t = tan (angle * G_PI / 180);
+	p->tg = (gint16) MIN (lrint (16 * t), 127);
+	p->ctg = (gint16) MIN (lrint (16 / t), 127);
+
+	/* reaching the key colour itself is fully transparent and darkened
+	 * by its own luma */
+	p->gain = (gint16) MIN (16 * 255 / p->kg, 127);
+	p->kfgy = (gint16) MIN (lrint (16 * ky / p->kg), 127);
+	p->noise2 = (gint16) MIN (lrint (noise_level * noise_level), 32767);
+
+	p->smin = 128 - MIN (black_sensitivity, 128);
+	p->smax = 128 + MIN (white_sensitivity, 127);
+}
+
+void
+key_chroma_row_c (KeyRow *out, const guint8 *u, const guint8 *v, gint n,
+		const KeyParams *p)
+{
+	gint i, cu, cv, x, z, az, x1, excess, a, zc, d;
+
+	for (i = 0; i < n; i++) {
+		cu = u[i] - 128;
+		cv = v[i] - 128;
+		x = (cu * p->cb + cv * p->cr) >> 7;
+		z = (cv * p->cb - cu * p->cr) >> 7;
+		az = ABS (z);
+		if (x <= 0 || az * 16 > x * p->tg) {
+			out->ka[i] = 255;
+			out->ky[i] = 0;
+			out->ku[i] = u[i];
+			out->kv[i] = v[i];
+			continue;
+		}
+
+		x1 = MIN ((az * p->ctg) >> 4, x);
+		excess = x - x1;
+		a = 255 - MIN ((excess * p->gain) >> 4, 255);
+		zc = CLAMP (z, -127, 127);
+		d = CLAMP (x - p->kg, -127, 127);
+		if (zc * zc + d * d < p->noise2)
+			a = 0;
+
+		out->ka[i] = a;
+		out->ky[i] = MIN ((excess * p->kfgy) >> 4, 255);
+		out->ku[i] = CLAMP (((x1 * p->cb - z * p->cr) >> 7) + 128, 0, 255);
+		out->kv[i] = CLAMP (((x1 * p->cr + z * p->cb) >> 7) + 128, 0, 255);
+	}
+}
+
+void
+key_pack_row_c (guint8 *dst, const guint8 *y, const guint8 *u,
+		const guint8 *v, const KeyRow *key, gint width, const KeyParams *p)
+{
+	gint i, c;
+
+	for (i = 0; i < width; i++, dst += 4) {
+		c = i >> 1;
+		if (y[i] >= p->smin && y[i] <= p->smax) {
+			dst[0] = key->ka[c];
+			dst[1] = MAX (y[i] - key->ky[c], 0);
+			dst[2] = key->ku[c];
+			dst[3] = key->kv[c];
+		} else {
+			dst[0] = 255;
+			dst[1] = y[i];
+			dst[2] = u[c];
+			dst[3] = v[c];
+		}
+	}
+}
+
+#ifdef HAVE_X86_DISPATCH
+
+/* a 16 bit pair for madd */
+#define PAIR(a, b) _mm_set1_epi32 ((guint16) (a) | ((guint32) (guint16) (b) << 16))
+
+__attribute__((target ("sse2")))
+static inline __m128i
+madd_shift7 (__m128i lo, __m128i hi, __m128i k)
+{
+	return _mm_packs_epi32 (_mm_srai_epi32 (_mm_madd_epi16 (lo, k), 7),
+			_mm_srai_epi32 (_mm_madd_epi16 (hi, k), 7));
+}
+
+__attribute__((target ("sse2")))
+static inline __m128i
+select_epi (__m128i mask, __m128i a, __m128i b)
+{
+	return _mm_or_si128 (_mm_and_si128 (mask, a), _mm_andnot_si128 (mask, b));
+}
+
+__attribute__((target ("sse2")))
+static void
+key_chroma_row_sse2 (KeyRow *out, const guint8 *u, const guint8 *v, gint n,
+		const KeyParams *p)
+{
+	const __m128i zero = _mm_setzero_si128 ();
+	const __m128i c127 = _mm_set1_epi16 (127);
+	const __m128i c128 = _mm_set1_epi16 (128);
+	const __m128i c255 = _mm_set1_epi16 (255);
+	const __m128i kx = PAIR (p->cb, p->cr);
+	const __m128i kz = PAIR (-p->cr, p->cb);
+	const __m128i kun = PAIR (p->cb, -p->cr);
+	const __m128i kvn = PAIR (p->cr, p->cb);
+	const __m128i tg = _mm_set1_epi16 (p->tg);
+	const __m128i ctg = _mm_set1_epi16 (p->ctg);
+	const __m128i gain = _mm_set1_epi16 (p->gain);
+	const __m128i kfgy = _mm_set1_epi16 (p->kfgy);
+	const __m128i kg = _mm_set1_epi16 (p->kg);
+	const __m128i noise2 = _mm_set1_epi16 (p->noise2);
+	__m128i vu, vv, lo, hi, x, z, az, keyed, x1, excess, a, zc, d, ky, ku, kv;
+	KeyRow tail;
+	gint i;
+
+	for (i = 0; i + 8 <= n; i += 8) {
+		vu = _mm_unpacklo_epi8 (_mm_loadl_epi64 ((const __m128i *) (u + i)), zero);
+		vv = _mm_unpacklo_epi8 (_mm_loadl_epi64 ((const __m128i *) (v + i)), zero);
+		lo = _mm_unpacklo_epi16 (_mm_sub_epi16 (vu, c128), _mm_sub_epi16 (vv, c128));
+		hi = _mm_unpackhi_epi16 (_mm_sub_epi16 (vu, c128), _mm_sub_epi16 (vv, c128));
+		x = madd_shift7 (lo, hi, kx);
+		z = madd_shift7 (lo, hi, kz);
+		az = _mm_max_epi16 (z, _mm_sub_epi16 (zero, z));
+		keyed = _mm_andnot_si128 (_mm_cmpgt_epi16 (_mm_slli_epi16 (az, 4),
+					_mm_mullo_epi16 (x, tg)), _mm_cmpgt_epi16 (x, zero));
+
+		x1 = _mm_min_epi16 (_mm_srai_epi16 (_mm_mullo_epi16 (az, ctg), 4), x);
+		excess = _mm_sub_epi16 (x, x1);
+		a = _mm_sub_epi16 (c255, _mm_min_epi16 (_mm_srai_epi16 (
+						_mm_mullo_epi16 (excess, gain), 4), c255));
+		zc = _mm_max_epi16 (_mm_min_epi16 (z, c127), _mm_sub_epi16 (zero, c127));
+		d = _mm_sub_epi16 (x, kg);
+		d = _mm_max_epi16 (_mm_min_epi16 (d, c127), _mm_sub_epi16 (zero, c127));
+		a = _mm_andnot_si128 (_mm_cmplt_epi16 (_mm_add_epi16 (_mm_mullo_epi16 (zc, zc),
+						_mm_mullo_epi16 (d, d)), noise2), a);
+		ky = _mm_min_epi16 (_mm_srai_epi16 (_mm_mullo_epi16 (excess, kfgy), 4), c255);
+
+		lo = _mm_unpacklo_epi16 (x1, z);
+		hi = _mm_unpackhi_epi16 (x1, z);
+		ku = _mm_add_epi16 (madd_shift7 (lo, hi, kun), c128);
+		kv = _mm_add_epi16 (madd_shift7 (lo, hi, kvn), c128);
+
+		/* samples outside the angle pass through */
+		a = select_epi (keyed, a, c255);
+		ky = _mm_and_si128 (keyed, ky);
+		ku = select_epi (keyed, ku, vu);
+		kv = select_epi (keyed, kv, vv);
+		_mm_storel_epi64 ((__m128i *) (out->ka + i), _mm_packus_epi16 (a, a));
+		_mm_storel_epi64 ((__m128i *) (out->ky + i), _mm_packus_epi16 (ky, ky));
+		_mm_storel_epi64 ((__m128i *) (out->ku + i), _mm_packus_epi16 (ku, ku));
+		_mm_storel_epi64 ((__m128i *) (out->kv + i), _mm_packus_epi16 (kv, kv));
+	}
+
+	tail.ka = out->ka + i;
+	tail.ky = out->ky + i;
+	tail.ku = out->ku + i;
+	tail.kv = out->kv + i;
+	key_chroma_row_c (&tail, u + i, v + i, n - i, p);
+}
+
+/* eight chroma bytes to sixteen, one per luma pixel */
+__attribute__((target ("sse2")))
+static inline __m128i
+load_dup (const guint8 *p)
+{
+	__m128i t = _mm_loadl_epi64 ((const __m128i *) p);
+
+	return _mm_unpacklo_epi8 (t, t);
+}
+
+__attribute__((target ("sse2")))
+static void
+key_pack_row_sse2 (guint8 *dst, const guint8 *y, const guint8 *u,
+		const guint8 *v, const KeyRow *key, gint width, const KeyParams *p)
+{
+	const __m128i ff = _mm_set1_epi8 (-1);
+	const __m128i smin = _mm_set1_epi8 (p->smin);
+	const __m128i smax = _mm_set1_epi8 (p->smax);
+	__m128i vy, in, a, yy, uu, vv, ay, uv;
+	KeyRow tail;
+	gint i, c;
+
+	for (i = 0; i + 16 <= width; i += 16) {
+		c = i >> 1;
+		vy = _mm_loadu_si128 ((const __m128i *) (y + i));
+		in = _mm_and_si128 (_mm_cmpeq_epi8 (_mm_max_epu8 (vy, smin), vy),
+				_mm_cmpeq_epi8 (_mm_min_epu8 (vy, smax), vy));
+		a = select_epi (in, load_dup (key->ka + c), ff);
+		yy = select_epi (in, _mm_subs_epu8 (vy, load_dup (key->ky + c)), vy);
+		uu = select_epi (in, load_dup (key->ku + c), load_dup (u + c));
+		vv = select_epi (in, load_dup (key->kv + c), load_dup (v + c));
+
+		ay = _mm_unpacklo_epi8 (a, yy);
+		uv = _mm_unpacklo_epi8 (uu, vv);
+		_mm_storeu_si128 ((__m128i *) (dst + i * 4), _mm_unpacklo_epi16 (ay, uv));
+		_mm_storeu_si128 ((__m128i *) (dst + i * 4 + 16), _mm_unpackhi_epi16 (ay, uv));
+		ay = _mm_unpackhi_epi8 (a, yy);
+		uv = _mm_unpackhi_epi8 (uu, vv);
+		_mm_storeu_si128 ((__m128i *) (dst + i * 4 + 32), _mm_unpacklo_epi16 (ay, uv));
+		_mm_storeu_si128 ((__m128i *) (dst + i * 4 + 48), _mm_unpackhi_epi16 (ay, uv));
+	}
+
+	c = i >> 1;
+	tail.ka = key->ka + c;
+	tail.ky = key->ky + c;
+	tail.ku = key->ku + c;
+	tail.kv = key->kv + c;
+	key_pack_row_c (dst + i * 4, y + i, u + c, v + c, &tail, width - i, p);
+}
+
+#endif /* HAVE_X86_DISPATCH */
+
+void
+key_init (void)
+{
+#ifdef HAVE_X86_DISPATCH
+	__builtin_cpu_init ();
+	if (__builtin_cpu_supports ("sse2")) {
+		key_chroma_row = key_chroma_row_sse2;
+		key_pack_row = key_pack_row_sse2;
+		impl_name = "sse2";
+	}
+#endif
+}
+
+const gchar *
+key_impl_name (void)
+{
+	return impl_name;
+}
@@ -0,0 +1,53 @@
+/**
+ * Row kernels of the chromakey element: I420 in, keyed AYUV out in one
+ * pass. The key only depends on the chroma, so it is computed once per
+ * chroma sample by key_chroma_row and then spread over its luma pixels by
+ * key_pack_row. key_init picks the SIMD versions, all versions give the
+ * same bytes.
+ **/
+#ifndef __KEY_CONVERT_H__
+#define __KEY_CONVERT_H__
+
+#include <glib.h>
+
+G_BEGIN_DECLS
+
+/* fixed point, see key_params_init */
+typedef struct {
+	gint16 cb, cr;         /* key direction in the UV plane, length 127 */
+	gint16 kg;             /* chroma length of the key colour */
+	gint16 tg, ctg;        /* tan and cotan of the accept angle, 4 bit fraction */
+	gint16 gain;           /* key distance to alpha, 4 bit fraction */
+	gint16 kfgy;           /* key distance to luma spill, 4 bit fraction */
+	gint16 noise2;         /* squared radius keyed out completely */
+	guint8 smin, smax;     /* luma range that is keyed at all */
+} KeyParams;
+
+/* what one chroma sample becomes, ka = 255 and ky = 0 when not keyed */
+typedef struct {
+	guint8 *ka, *ky, *ku, *kv;
+} KeyRow;
+
+typedef void (*KeyChromaRowFunc) (KeyRow *out, const guint8 *u, const guint8 *v,
+		gint n, const KeyParams *p);
+typedef void (*KeyPackRowFunc) (guint8 *dst, const guint8 *y, const guint8 *u,
+		const guint8 *v, const KeyRow *key, gint width, const KeyParams *p);
+
+extern KeyChromaRowFunc key_chroma_row;
+extern KeyPackRowFunc key_pack_row;
+
+void key_init (void);
+const gchar *key_impl_name (void);
+
+/* angle in degrees (7.5 to 80), sensitivities and noise as in the alpha element */
+void key_params_init (KeyParams *p, guint8 r, guint8 g, guint8 b, gfloat angle,
+		gfloat noise_level, guint black_sensitivity, guint white_sensitivity);
+
+void key_chroma_row_c (KeyRow *out, const guint8 *u, const guint8 *v, gint n,
+		const KeyParams *p);
+void key_pack_row_c (guint8 *dst, const guint8 *y, const guint8 *u,
+		const guint8 *v, const KeyRow *key, gint width, const KeyParams *p);
+
+G_END_DECLS
+
+#endif /* __KEY_CONVERT_H__ */
@@ -0,0 +1,206 @@
+/**
+ * Alpha blending of AYUV rows for the multimixer element.
+ *
+ * Every channel is mixed as (s * a + d * (255 - a)) / 255, rounded, with
+ * the alpha channel of src taken as 255 so that the result alpha is the
+ * usual a + dA * (255 - a) / 255 of "over". Division by 255 is
+ * (t + 128 + ((t + 128) >> 8)) >> 8, exact for t up to 255 * 255, which
+ * keeps every step in 16 bit lanes.
+ **/
+#include <string.h>
+#include <glib.h>
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <immintrin.h>
+#define HAVE_X86_DISPATCH 1
+#endif
+
+#include "mixer_blend.h"
+
+BlendRowFunc blend_ayuv_row = blend_ayuv_row_c;
+static const gchar *impl_name = "c";
+
+static inline guint
+div255 (guint t)
+{
+	t += 128;
+	return (t + (t >> 8)) >> 8;
+}
+
+void
+blend_ayuv_row_c (guint8 *dst, const guint8 *src, gint n, guint alpha)
+{
+	guint a, na;
+	gint i;
+
+	if (alpha == 0)
+		return;
+
+	for (i = 0; i < n; i++, src += 4, dst += 4) {
+		a = div255 (src[0] * alpha);
+		if (a == 0)
+			continue;
+		na = 255 - a;
+		dst[0] = div255 (255 * a + dst[0] * na);
+		dst[1] = div255 (src[1] * a + dst[1] * na);
+		dst[2] = div255 (src[2] * a + dst[2] * na);
+		dst[3] = div255 (src[3] * a + dst[3] * na);
+	}
+}
+
+#ifdef HAVE_X86_DISPATCH
+
+__attribute__((target ("sse2")))
+static inline __m128i
+div255_epu16 (__m128i t)
+{
+	t = _mm_add_epi16 (t, _mm_set1_epi16 (128));
+	return _mm_srli_epi16 (_mm_add_epi16 (t, _mm_srli_epi16 (t, 8)), 8);
+}
+
+/* two pixels unpacked to 16 bit lanes, A in lanes 0 and 4 */
+__attribute__((target ("sse2")))
+static inline __m128i
+blend_2px_sse2 (__m128i s, __m128i d, __m128i alpha)
+{
+	__m128i a, na;
+
+	a = _mm_shufflehi_epi16 (_mm_shufflelo_epi16 (s, 0x00), 0x00);
+	a = div255_epu16 (_mm_mullo_epi16 (a, alpha));
+	na = _mm_sub_epi16 (_mm_set1_epi16 (255), a);
+	s = _mm_or_si128 (s, _mm_set_epi16 (0, 0, 0, 255, 0, 0, 0, 255));
+	return div255_epu16 (_mm_add_epi16 (_mm_mullo_epi16 (s, a),
+			_mm_mullo_epi16 (d, na)));
+}
+
+__attribute__((target ("sse2")))
+static void
+blend_ayuv_row_sse2 (guint8 *dst, const guint8 *src, gint n, guint alpha)
+{
+	const __m128i zero = _mm_setzero_si128 ();
+	const __m128i amask = _mm_set1_epi32 (0xff);
+	__m128i va = _mm_set1_epi16 (alpha);
+	__m128i s, d, lo, hi;
+	gint i;
+
+	if (alpha == 0)
+		return;
+
+	for (i = 0; i + 4 <= n; i += 4) {
+		s = _mm_loadu_si128 ((const __m128i *) (src + i * 4));
+		/* keyed out backgrounds are mostly fully transparent */
+		if (_mm_movemask_epi8 (_mm_cmpeq_epi8 (_mm_and_si128 (s, amask),
+				zero)) == 0xffff)
+			continue;
+		d = _mm_loadu_si128 ((const __m128i *) (dst + i * 4));
+		lo = blend_2px_sse2 (_mm_unpacklo_epi8 (s, zero),
+				_mm_unpacklo_epi8 (d, zero), va);
+		hi = blend_2px_sse2 (_mm_unpackhi_epi8 (s, zero),
+				_mm_unpackhi_epi8 (d, zero), va);
+		_mm_storeu_si128 ((__m128i *) (dst + i * 4), _mm_packus_epi16 (lo, hi));
+	}
+	blend_ayuv_row_c (dst + i * 4, src + i * 4, n - i, alpha);
+}
+
+__attribute__((target ("avx2")))
+static inline __m256i
+div255_epu16_avx2 (__m256i t)
+{
+	t = _mm256_add_epi16 (t, _mm256_set1_epi16 (128));
+	return _mm256_srli_epi16 (_mm256_add_epi16 (t, _mm256_srli_epi16 (t, 8)),
+			8);
+}
+
+/* unpack and pack work within 128 bit lanes, which keeps pixel order */
+__attribute__((target ("avx2")))
+static inline __m256i
+blend_4px_avx2 (__m256i s, __m256i d, __m256i alpha)
+{
+	__m256i a, na;
+
+	a = _mm256_shufflehi_epi16 (_mm256_shufflelo_epi16 (s, 0x00), 0x00);
+	a = div255_epu16_avx2 (_mm256_mullo_epi16 (a, alpha));
+	na = _mm256_sub_epi16 (_mm256_set1_epi16 (255), a);
+	s = _mm256_or_si256 (s, _mm256_set1_epi64x (255));
+	return div255_epu16_avx2 (_mm256_add_epi16 (_mm256_mullo_epi16 (s, a),
+			_mm256_mullo_epi16 (d, na)));
+}
+
+__attribute__((target ("avx2")))
+static void
+blend_ayuv_row_avx2 (guint8 *dst, const guint8 *src, gint n, guint alpha)
+{
+	const __m256i zero = _mm256_setzero_si256 ();
+	const __m256i amask = _mm256_set1_epi32 (0xff);
+	__m256i va = _mm256_set1_epi16 (alpha);
+	__m256i s, d, lo, hi;
+	gint i;
+
+	if (alpha == 0)
+		return;
+
+	for (i = 0; i + 8 <= n; i += 8) {
+		s = _mm256_loadu_si256 ((const __m256i *) (src + i * 4));
+		if (_mm256_movemask_epi8 (_mm256_cmpeq_epi8 (_mm256_and_si256 (s, amask),
+				zero)) == -1)
+			continue;
+		d = _mm256_loadu_si256 ((const __m256i *) (dst + i * 4));
+		lo = blend_4px_avx2 (_mm256_unpacklo_epi8 (s, zero),
+				_mm256_unpacklo_epi8 (d, zero), va);
+		hi = blend_4px_avx2 (_mm256_unpackhi_epi8 (s, zero),
+				_mm256_unpackhi_epi8 (d, zero), va);
+		_mm256_storeu_si256 ((__m256i *) (dst + i * 4),
+				_mm256_packus_epi16 (lo, hi));
+	}
+	blend_ayuv_row_sse2 (dst + i * 4, src + i * 4, n - i, alpha);
+}
+
+#endif /* HAVE_X86_DISPATCH */
+
+void
+blend_init (void)
+{
+#ifdef HAVE_X86_DISPATCH
+	__builtin_cpu_init ();
+	if (__builtin_cpu_supports ("avx2")) {
+		blend_ayuv_row = blend_ayuv_row_avx2;
+		impl_name = "avx2";
+	} else if (__builtin_cpu_supports ("sse2")) {
+		blend_ayuv_row = blend_ayuv_row_sse2;
+		impl_name = "sse2";
+	}
+#endif
+}
+
+const gchar *
+blend_impl_name (void)
+{
+	return impl_name;
+}
+
+void
+blend_fill_row (guint8 *dst, gint n, guint32 ayuv)
+{
+	guint8 px[4];
+	gint i;
+
+	px[0] = ayuv >> 24;
+	px[1] = ayuv >> 16;
+	px[2] = ayuv >> 8;
+	px[3] = ayuv;
+	for (i = 0; i < n; i++, dst += 4)
+		memcpy (dst, px, 4);
+}
+
+/* 8x8 grey squares, like the videomixer checker background */
+void
+blend_fill_checker_row (guint8 *dst, gint n, gint y)
+{
+	gint i;
+
+	for (i = 0; i < n; i++, dst += 4) {
+		dst[0] = 255;
+		dst[1] = (((i >> 3) + (y >> 3)) & 1) ? 160 : 80;
+		dst[2] = 128;
+		dst[3] = 128;
+	}
+}
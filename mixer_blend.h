@@ -0,0 +1,29 @@
+/**
+ * Row kernels of the multimixer element, on AYUV rows (bytes A, Y, U, V).
+ * blend_init picks the widest SIMD version the CPU running the program
+ * has, not the one that built it. All versions give the same bytes.
+ **/
+#ifndef __MIXER_BLEND_H__
+#define __MIXER_BLEND_H__
+
+#include <glib.h>
+
+G_BEGIN_DECLS
+
+/* src over dst for n pixels, the alpha of src scaled by alpha (0-255) */
+typedef void (*BlendRowFunc) (guint8 *dst, const guint8 *src, gint n,
+		guint alpha);
+
+extern BlendRowFunc blend_ayuv_row;
+
+void blend_init (void);
+const gchar *blend_impl_name (void);
+
+void blend_ayuv_row_c (guint8 *dst, const guint8 *src, gint n, guint alpha);
+
+void blend_fill_row (guint8 *dst, gint n, guint32 ayuv);
+void blend_fill_checker_row (guint8 *dst, gint n, gint y);
+
+G_END_DECLS
+
+#endif /* __MIXER_BLEND_H__ */
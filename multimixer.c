@@ -0,0 +1,957 @@
+/**
+ * multimixer element, see multimixer.h
+ **/
+#include <string.h>
+#include <gst/gst.h>
+#include <gst/video/video.h>
+
+#include "multimixer.h"
+#include "mixer_blend.h"
+
+GST_DEBUG_CATEGORY_STATIC (multi_mixer_debug);
+#define GST_CAT_DEFAULT multi_mixer_debug
+
+typedef enum {
+	MULTI_MIXER_BACKGROUND_CHECKER,
+	MULTI_MIXER_BACKGROUND_BLACK,
+	MULTI_MIXER_BACKGROUND_WHITE,
+	MULTI_MIXER_BACKGROUND_TRANSPARENT
+} MultiMixerBackground;
+
+#define DEFAULT_BACKGROUND MULTI_MIXER_BACKGROUND_CHECKER
+#define DEFAULT_XPOS 0
+#define DEFAULT_YPOS 0
+#define DEFAULT_ALPHA 1.0
+
+#define GST_TYPE_MULTI_MIXER_BACKGROUND (gst_multi_mixer_background_get_type ())
+#define GST_TYPE_MULTI_MIXER_SINK_PAD (gst_multi_mixer_sink_pad_get_type ())
+#define GST_MULTI_MIXER_SINK_PAD(obj) \
+	(G_TYPE_CHECK_INSTANCE_CAST ((obj), GST_TYPE_MULTI_MIXER_SINK_PAD, GstMultiMixerSinkPad))
+#define GST_TYPE_MULTI_MIXER_SRC_PAD (gst_multi_mixer_src_pad_get_type ())
+#define GST_MULTI_MIXER_SRC_PAD(obj) \
+	(G_TYPE_CHECK_INSTANCE_CAST ((obj), GST_TYPE_MULTI_MIXER_SRC_PAD, GstMultiMixerSrcPad))
+
+typedef struct _GstMultiMixerSinkPad      GstMultiMixerSinkPad;
+typedef struct _GstMultiMixerSinkPadClass GstMultiMixerSinkPadClass;
+typedef struct _GstMultiMixerSrcPad       GstMultiMixerSrcPad;
+typedef struct _GstMultiMixerSrcPadClass  GstMultiMixerSrcPadClass;
+
+struct _GstMultiMixerSinkPad {
+	GstPad parent;
+
+	guint index;
+	/* properties, protected by the object lock */
+	gint xpos, ypos;
+	gdouble alpha;
+
+	/* protected by the mixer lock */
+	GstVideoInfo info;
+	gboolean have_info;
+	GstBuffer *buffer;     /* latest frame */
+};
+
+struct _GstMultiMixerSinkPadClass {
+	GstPadClass parent_class;
+};
+
+struct _GstMultiMixerSrcPad {
+	GstPad parent;
+
+	guint index;
+	/* properties, protected by the object lock */
+	MultiMixerBackground background;
+	gchar *order;
+	GArray *layers;        /* sink pad numbers bottom to top, NULL for all */
+
+	/* sticky events still to send, protected by the mixer lock */
+	gboolean need_stream_start;
+	gboolean need_caps;
+	gboolean need_segment;
+};
+
+struct _GstMultiMixerSrcPadClass {
+	GstPadClass parent_class;
+};
+
+struct _GstMultiMixer {
+	GstElement parent;
+
+	GMutex lock;           /* pad lists, their frames and the output format */
+	GList *sinkpads;       /* by number, the first one drives */
+	GList *srcpads;
+	GstVideoInfo info;     /* of the outputs, from the driving pad */
+	gboolean have_info;
+	GstSegment segment;
+};
+
+struct _GstMultiMixerClass {
+	GstElementClass parent_class;
+};
+
+enum {
+	PROP_SINK_0,
+	PROP_SINK_XPOS,
+	PROP_SINK_YPOS,
+	PROP_SINK_ALPHA
+};
+
+enum {
+	PROP_SRC_0,
+	PROP_SRC_BACKGROUND,
+	PROP_SRC_ORDER
+};
+
+static GstStaticPadTemplate sink_template = GST_STATIC_PAD_TEMPLATE ("sink_%u",
+		GST_PAD_SINK,
+		GST_PAD_REQUEST,
+		GST_STATIC_CAPS (GST_VIDEO_CAPS_MAKE ("AYUV")));
+
+static GstStaticPadTemplate src_template = GST_STATIC_PAD_TEMPLATE ("src_%u",
+		GST_PAD_SRC,
+		GST_PAD_REQUEST,
+		GST_STATIC_CAPS (GST_VIDEO_CAPS_MAKE ("AYUV")));
+
+static GType
+gst_multi_mixer_background_get_type (void)
+{
+	static GType type = 0;
+	static const GEnumValue values[] = {
+		{MULTI_MIXER_BACKGROUND_CHECKER, "Checker pattern", "checker"},
+		{MULTI_MIXER_BACKGROUND_BLACK, "Black", "black"},
+		{MULTI_MIXER_BACKGROUND_WHITE, "White", "white"},
+		{MULTI_MIXER_BACKGROUND_TRANSPARENT, "Transparent", "transparent"},
+		{0, NULL, NULL}
+	};
+
+	if (!type)
+		type = g_enum_register_static ("GstMultiMixerBackground", values);
+	return type;
+}
+
+/*************************************************************************
+ * Sink pads
+ *************************************************************************/
+GType gst_multi_mixer_sink_pad_get_type (void);
+G_DEFINE_TYPE (GstMultiMixerSinkPad, gst_multi_mixer_sink_pad, GST_TYPE_PAD);
+
+static void
+gst_multi_mixer_sink_pad_set_property (GObject *object, guint prop_id,
+		const GValue *value, GParamSpec *pspec)
+{
+	GstMultiMixerSinkPad *pad = GST_MULTI_MIXER_SINK_PAD (object);
+
+	GST_OBJECT_LOCK (pad);
+	switch (prop_id) {
+		case PROP_SINK_XPOS:
+			pad->xpos = g_value_get_int (value);
+			break;
+		case PROP_SINK_YPOS:
+			pad->ypos = g_value_get_int (value);
+			break;
+		case PROP_SINK_ALPHA:
+			pad->alpha = g_value_get_double (value);
+			break;
+		default:
+			G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+			break;
+	}
+	GST_OBJECT_UNLOCK (pad);
+}
+
+static void
+gst_multi_mixer_sink_pad_get_property (GObject *object, guint prop_id,
+		GValue *value, GParamSpec *pspec)
+{
+	GstMultiMixerSinkPad *pad = GST_MULTI_MIXER_SINK_PAD (object);
+
+	GST_OBJECT_LOCK (pad);
+	switch (prop_id) {
+		case PROP_SINK_XPOS:
+			g_value_set_int (value, pad->xpos);
+			break;
+		case PROP_SINK_YPOS:
+			g_value_set_int (value, pad->ypos);
+			break;
+		case PROP_SINK_ALPHA:
+			g_value_set_double (value, pad->alpha);
+			break;
+		default:
+			G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+			break;
+	}
+	GST_OBJECT_UNLOCK (pad);
+}
+
+static void
+gst_multi_mixer_sink_pad_finalize (GObject *object)
+{
+	GstMultiMixerSinkPad *pad = GST_MULTI_MIXER_SINK_PAD (object);
+
+	gst_buffer_replace (&pad->buffer, NULL);
+
+	G_OBJECT_CLASS (gst_multi_mixer_sink_pad_parent_class)->finalize (object);
+}
+
+static void
+gst_multi_mixer_sink_pad_class_init (GstMultiMixerSinkPadClass *klass)
+{
+	GObjectClass *gobject_class = G_OBJECT_CLASS (klass);
+
+	gobject_class->set_property = gst_multi_mixer_sink_pad_set_property;
+	gobject_class->get_property = gst_multi_mixer_sink_pad_get_property;
+	gobject_class->finalize = gst_multi_mixer_sink_pad_finalize;
+
+	g_object_class_install_property (gobject_class, PROP_SINK_XPOS,
+			g_param_spec_int ("xpos", "X position", "X position of the picture on every output",
+				G_MININT, G_MAXINT, DEFAULT_XPOS, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+	g_object_class_install_property (gobject_class, PROP_SINK_YPOS,
+			g_param_spec_int ("ypos", "Y position", "Y position of the picture on every output",
+				G_MININT, G_MAXINT, DEFAULT_YPOS, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+	g_object_class_install_property (gobject_class, PROP_SINK_ALPHA,
+			g_param_spec_double ("alpha", "Alpha", "Alpha of the picture",
+				0.0, 1.0, DEFAULT_ALPHA, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+}
+
+static void
+gst_multi_mixer_sink_pad_init (GstMultiMixerSinkPad *pad)
+{
+	pad->xpos = DEFAULT_XPOS;
+	pad->ypos = DEFAULT_YPOS;
+	pad->alpha = DEFAULT_ALPHA;
+}
+
+/*************************************************************************
+ * Source pads
+ *************************************************************************/
+GType gst_multi_mixer_src_pad_get_type (void);
+G_DEFINE_TYPE (GstMultiMixerSrcPad, gst_multi_mixer_src_pad, GST_TYPE_PAD);
+
+/* "2,0,1" to the sink pad numbers 2, 0 and 1, NULL shows every input */
+static GArray *
+parse_order (const gchar *order)
+{
+	GArray *layers;
+	gchar **tokens;
+	gchar *end;
+	guint index;
+	gint i;
+
+	if (!order || !*order)
+		return NULL;
+
+	layers = g_array_new (FALSE, FALSE, sizeof (guint));
+	tokens = g_strsplit (order, ",", -1);
+	for (i = 0; tokens[i]; i++) {
+		g_strstrip (tokens[i]);
+		if (!*tokens[i])
+			continue;
+		index = g_ascii_strtoull (tokens[i], &end, 10);
+		if (*end) {
+			GST_WARNING ("ignoring '%s' in order, not a sink pad number", tokens[i]);
+			continue;
+		}
+		g_array_append_val (layers, index);
+	}
+	g_strfreev (tokens);
+	return layers;
+}
+
+static void
+gst_multi_mixer_src_pad_set_property (GObject *object, guint prop_id,
+		const GValue *value, GParamSpec *pspec)
+{
+	GstMultiMixerSrcPad *pad = GST_MULTI_MIXER_SRC_PAD (object);
+
+	GST_OBJECT_LOCK (pad);
+	switch (prop_id) {
+		case PROP_SRC_BACKGROUND:
+			pad->background = g_value_get_enum (value);
+			break;
+		case PROP_SRC_ORDER:
+			g_free (pad->order);
+			pad->order = g_value_dup_string (value);
+			if (pad->layers)
+				g_array_free (pad->layers, TRUE);
+			pad->layers = parse_order (pad->order);
+			break;
+		default:
+			G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+			break;
+	}
+	GST_OBJECT_UNLOCK (pad);
+}
+
+static void
+gst_multi_mixer_src_pad_get_property (GObject *object, guint prop_id,
+		GValue *value, GParamSpec *pspec)
+{
+	GstMultiMixerSrcPad *pad = GST_MULTI_MIXER_SRC_PAD (object);
+
+	GST_OBJECT_LOCK (pad);
+	switch (prop_id) {
+		case PROP_SRC_BACKGROUND:
+			g_value_set_enum (value, pad->background);
+			break;
+		case PROP_SRC_ORDER:
+			g_value_set_string (value, pad->order);
+			break;
+		default:
+			G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+			break;
+	}
+	GST_OBJECT_UNLOCK (pad);
+}
+
+static void
+gst_multi_mixer_src_pad_finalize (GObject *object)
+{
+	GstMultiMixerSrcPad *pad = GST_MULTI_MIXER_SRC_PAD (object);
+
+	g_free (pad->order);
+	if (pad->layers)
+		g_array_free (pad->layers, TRUE);
+
+	G_OBJECT_CLASS (gst_multi_mixer_src_pad_parent_class)->finalize (object);
+}
+
+static void
+gst_multi_mixer_src_pad_class_init (GstMultiMixerSrcPadClass *klass)
+{
+	GObjectClass *gobject_class = G_OBJECT_CLASS (klass);
+
+	gobject_class->set_property = gst_multi_mixer_src_pad_set_property;
+	gobject_class->get_property = gst_multi_mixer_src_pad_get_property;
+	gobject_class->finalize = gst_multi_mixer_src_pad_finalize;
+
+	g_object_class_install_property (gobject_class, PROP_SRC_BACKGROUND,
+			g_param_spec_enum ("background", "Background", "Background of this output",
+				GST_TYPE_MULTI_MIXER_BACKGROUND, DEFAULT_BACKGROUND,
+				G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+	g_object_class_install_property (gobject_class, PROP_SRC_ORDER,
+			g_param_spec_string ("order", "Order",
+				"Sink pad numbers shown on this output from bottom to top, e.g. \"2,0\" (empty shows all in pad order)",
+				NULL, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+}
+
+static void
+gst_multi_mixer_src_pad_init (GstMultiMixerSrcPad *pad)
+{
+	pad->background = DEFAULT_BACKGROUND;
+	pad->need_stream_start = TRUE;
+	pad->need_caps = TRUE;
+	pad->need_segment = TRUE;
+}
+
+/*************************************************************************
+ * The element
+ *************************************************************************/
+static void gst_multi_mixer_child_proxy_init (gpointer g_iface, gpointer iface_data);
+
+G_DEFINE_TYPE_WITH_CODE (GstMultiMixer, gst_multi_mixer, GST_TYPE_ELEMENT,
+		G_IMPLEMENT_INTERFACE (GST_TYPE_CHILD_PROXY, gst_multi_mixer_child_proxy_init));
+
+static gint
+compare_sink_index (gconstpointer a, gconstpointer b)
+{
+	return (gint) ((const GstMultiMixerSinkPad *) a)->index -
+		(gint) ((const GstMultiMixerSinkPad *) b)->index;
+}
+
+static gint
+compare_src_index (gconstpointer a, gconstpointer b)
+{
+	return (gint) ((const GstMultiMixerSrcPad *) a)->index -
+		(gint) ((const GstMultiMixerSrcPad *) b)->index;
+}
+
+/* the outputs follow the format of the first sink pad, call with the lock */
+static void
+update_output_info (GstMultiMixer *mixer)
+{
+	GstMultiMixerSinkPad *drive;
+	GList *l;
+
+	drive = mixer->sinkpads ? mixer->sinkpads->data : NULL;
+	if (!drive || !drive->have_info) {
+		mixer->have_info = FALSE;
+		return;
+	}
+	if (mixer->have_info && gst_video_info_is_equal (&mixer->info, &drive->info))
+		return;
+
+	mixer->info = drive->info;
+	mixer->have_info = TRUE;
+	for (l = mixer->srcpads; l; l = l->next)
+		((GstMultiMixerSrcPad *) l->data)->need_caps = TRUE;
+}
+
+typedef struct {
+	guint index;
+	GstBuffer *buffer;
+	GstVideoFrame frame;
+	gboolean mapped;
+	gint xpos, ypos;
+	guint alpha;
+} Input;
+
+typedef struct {
+	GstPad *pad;
+	GstBuffer *buffer;
+	GstVideoFrame frame;
+	gboolean mapped;
+	MultiMixerBackground background;
+	gint *layers;          /* positions in the inputs, bottom to top */
+	gint n_layers;
+	gboolean stream_start, caps, segment;
+} Output;
+
+static void
+push_sticky_events (GstMultiMixer *mixer, Output *out, GstCaps *caps,
+		const GstSegment *segment)
+{
+	gchar *stream_id;
+
+	if (out->stream_start) {
+		stream_id = gst_pad_create_stream_id (out->pad, GST_ELEMENT_CAST (mixer), NULL);
+		gst_pad_push_event (out->pad, gst_event_new_stream_start (stream_id));
+		g_free (stream_id);
+	}
+	if (out->caps)
+		gst_pad_push_event (out->pad, gst_event_new_caps (caps));
+	if (out->segment)
+		gst_pad_push_event (out->pad, gst_event_new_segment (segment));
+}
+
+static void
+blend_output_row (Output *out, Input *inputs, gint y, gint width)
+{
+	guint8 *row;
+	Input *in;
+	gint k, sy, x0, x1;
+
+	row = (guint8 *) GST_VIDEO_FRAME_PLANE_DATA (&out->frame, 0) +
+		y * GST_VIDEO_FRAME_PLANE_STRIDE (&out->frame, 0);
+
+	switch (out->background) {
+		case MULTI_MIXER_BACKGROUND_CHECKER:
+			blend_fill_checker_row (row, width, y);
+			break;
+		case MULTI_MIXER_BACKGROUND_BLACK:
+			blend_fill_row (row, width, 0xff108080);
+			break;
+		case MULTI_MIXER_BACKGROUND_WHITE:
+			blend_fill_row (row, width, 0xffeb8080);
+			break;
+		case MULTI_MIXER_BACKGROUND_TRANSPARENT:
+			blend_fill_row (row, width, 0x00108080);
+			break;
+	}
+
+	for (k = 0; k < out->n_layers; k++) {
+		in = &inputs[out->layers[k]];
+		sy = y - in->ypos;
+		if (sy < 0 || sy >= GST_VIDEO_FRAME_HEIGHT (&in->frame))
+			continue;
+		x0 = MAX (in->xpos, 0);
+		x1 = MIN (in->xpos + GST_VIDEO_FRAME_WIDTH (&in->frame), width);
+		if (x1 <= x0)
+			continue;
+		blend_ayuv_row (row + x0 * 4,
+				(const guint8 *) GST_VIDEO_FRAME_PLANE_DATA (&in->frame, 0) +
+				sy * GST_VIDEO_FRAME_PLANE_STRIDE (&in->frame, 0) + (x0 - in->xpos) * 4,
+				x1 - x0, in->alpha);
+	}
+}
+
+/* takes the latest frame of every input and the layout of every output
+ * under the lock, then blends without it */
+static GstFlowReturn
+gst_multi_mixer_render (GstMultiMixer *mixer, GstBuffer *drive_buffer)
+{
+	GstFlowReturn ret, result = GST_FLOW_OK, last = GST_FLOW_NOT_LINKED;
+	gboolean pushed = FALSE;
+	GstVideoInfo info;
+	GstSegment segment;
+	GstCaps *caps;
+	Input *inputs;
+	Output *outputs, *out;
+	gint n_inputs = 0, n_outputs = 0;
+	gint i, k, y, width, height;
+	GList *l;
+
+	g_mutex_lock (&mixer->lock);
+	if (!mixer->have_info) {
+		g_mutex_unlock (&mixer->lock);
+		return GST_FLOW_NOT_NEGOTIATED;
+	}
+	info = mixer->info;
+	segment = mixer->segment;
+
+	inputs = g_new0 (Input, g_list_length (mixer->sinkpads));
+	for (l = mixer->sinkpads; l; l = l->next) {
+		GstMultiMixerSinkPad *pad = l->data;
+		Input *in = &inputs[n_inputs];
+
+		if (!pad->buffer || !pad->have_info)
+			continue;
+		in->index = pad->index;
+		in->buffer = gst_buffer_ref (pad->buffer);
+		in->frame.info = pad->info;
+		GST_OBJECT_LOCK (pad);
+		in->xpos = pad->xpos;
+		in->ypos = pad->ypos;
+		in->alpha = (guint) (pad->alpha * 255 + 0.5);
+		GST_OBJECT_UNLOCK (pad);
+		n_inputs++;
+	}
+
+	outputs = g_new0 (Output, g_list_length (mixer->srcpads));
+	for (l = mixer->srcpads; l; l = l->next) {
+		GstMultiMixerSrcPad *pad = l->data;
+
+		if (!gst_pad_is_linked (GST_PAD (pad)))
+			continue;
+		out = &outputs[n_outputs++];
+		out->pad = gst_object_ref (pad);
+		out->layers = g_new (gint, n_inputs);
+		GST_OBJECT_LOCK (pad);
+		out->background = pad->background;
+		if (!pad->layers) {
+			for (i = 0; i < n_inputs; i++)
+				out->layers[out->n_layers++] = i;
+		} else {
+			for (k = 0; k < pad->layers->len && out->n_layers < n_inputs; k++) {
+				for (i = 0; i < n_inputs; i++) {
+					if (inputs[i].index == g_array_index (pad->layers, guint, k)) {
+						out->layers[out->n_layers++] = i;
+						break;
+					}
+				}
+			}
+		}
+		GST_OBJECT_UNLOCK (pad);
+
+		out->stream_start = pad->need_stream_start;
+		out->caps = pad->need_caps;
+		out->segment = pad->need_segment;
+		pad->need_stream_start = pad->need_caps = pad->need_segment = FALSE;
+	}
+	g_mutex_unlock (&mixer->lock);
+
+	for (i = 0; i < n_inputs; i++) {
+		GstVideoInfo in_info = inputs[i].frame.info;
+
+		inputs[i].mapped = gst_video_frame_map (&inputs[i].frame, &in_info,
+				inputs[i].buffer, GST_MAP_READ);
+		if (!inputs[i].mapped)
+			inputs[i].frame.info.height = 0; /* never blended */
+	}
+	for (i = 0; i < n_outputs; i++) {
+		out = &outputs[i];
+		out->buffer = gst_buffer_new_allocate (NULL, GST_VIDEO_INFO_SIZE (&info), NULL);
+		out->mapped = gst_video_frame_map (&out->frame, &info, out->buffer, GST_MAP_WRITE);
+	}
+
+	/* row by row over all outputs, the input rows stay in cache */
+	width = GST_VIDEO_INFO_WIDTH (&info);
+	height = GST_VIDEO_INFO_HEIGHT (&info);
+	for (y = 0; y < height; y++) {
+		for (i = 0; i < n_outputs; i++) {
+			if (outputs[i].mapped)
+				blend_output_row (&outputs[i], inputs, y, width);
+		}
+	}
+
+	for (i = 0; i < n_inputs; i++) {
+		if (inputs[i].mapped)
+			gst_video_frame_unmap (&inputs[i].frame);
+		gst_buffer_unref (inputs[i].buffer);
+	}
+	g_free (inputs);
+
+	caps = gst_video_info_to_caps (&info);
+	for (i = 0; i < n_outputs; i++) {
+		out = &outputs[i];
+		if (out->mapped)
+			gst_video_frame_unmap (&out->frame);
+		GST_BUFFER_PTS (out->buffer) = GST_BUFFER_PTS (drive_buffer);
+		GST_BUFFER_DTS (out->buffer) = GST_BUFFER_DTS (drive_buffer);
+		GST_BUFFER_DURATION (out->buffer) = GST_BUFFER_DURATION (drive_buffer);
+		GST_BUFFER_OFFSET (out->buffer) = GST_BUFFER_OFFSET (drive_buffer);
+
+		push_sticky_events (mixer, out, caps, &segment);
+		ret = gst_pad_push (out->pad, out->buffer);
+		gst_object_unref (out->pad);
+		g_free (out->layers);
+
+		/* one output gone does not stop the others */
+		if (ret == GST_FLOW_OK)
+			pushed = TRUE;
+		else if (ret == GST_FLOW_FLUSHING || ret <= GST_FLOW_NOT_NEGOTIATED)
+			result = ret;
+		else
+			last = ret;
+	}
+	gst_caps_unref (caps);
+	g_free (outputs);
+
+	if (result != GST_FLOW_OK)
+		return result;
+	return (pushed || n_outputs == 0) ? GST_FLOW_OK : last;
+}
+
+static GstFlowReturn
+gst_multi_mixer_sink_chain (GstPad *pad, GstObject *parent, GstBuffer *buffer)
+{
+	GstMultiMixer *mixer = GST_MULTI_MIXER (parent);
+	GstMultiMixerSinkPad *sinkpad = GST_MULTI_MIXER_SINK_PAD (pad);
+	GstFlowReturn ret = GST_FLOW_OK;
+	gboolean drive;
+
+	g_mutex_lock (&mixer->lock);
+	gst_buffer_replace (&sinkpad->buffer, buffer);
+	drive = mixer->sinkpads && mixer->sinkpads->data == sinkpad;
+	g_mutex_unlock (&mixer->lock);
+
+	if (drive)
+		ret = gst_multi_mixer_render (mixer, buffer);
+	gst_buffer_unref (buffer);
+	return ret;
+}
+
+static gboolean
+gst_multi_mixer_sink_event (GstPad *pad, GstObject *parent, GstEvent *event)
+{
+	GstMultiMixer *mixer = GST_MULTI_MIXER (parent);
+	GstMultiMixerSinkPad *sinkpad = GST_MULTI_MIXER_SINK_PAD (pad);
+	gboolean drive, ret = TRUE;
+	GstVideoInfo info;
+	GstCaps *caps;
+	GList *l;
+
+	g_mutex_lock (&mixer->lock);
+	drive = mixer->sinkpads && mixer->sinkpads->data == sinkpad;
+	switch (GST_EVENT_TYPE (event)) {
+		case GST_EVENT_CAPS:
+			gst_event_parse_caps (event, &caps);
+			if (!gst_video_info_from_caps (&info, caps)) {
+				ret = FALSE;
+				break;
+			}
+			sinkpad->info = info;
+			sinkpad->have_info = TRUE;
+			if (drive)
+				update_output_info (mixer);
+			break;
+		case GST_EVENT_SEGMENT:
+			if (drive) {
+				gst_event_copy_segment (event, &mixer->segment);
+				for (l = mixer->srcpads; l; l = l->next)
+					((GstMultiMixerSrcPad *) l->data)->need_segment = TRUE;
+			}
+			break;
+		case GST_EVENT_FLUSH_STOP:
+			gst_buffer_replace (&sinkpad->buffer, NULL);
+			break;
+		default:
+			break;
+	}
+	g_mutex_unlock (&mixer->lock);
+
+	switch (GST_EVENT_TYPE (event)) {
+		case GST_EVENT_CAPS:
+		case GST_EVENT_SEGMENT:
+		case GST_EVENT_STREAM_START:
+			/* the outputs get their own, with the first buffer */
+			gst_event_unref (event);
+			return ret;
+		default:
+			/* eos, flushes and the rest come from the driving input only */
+			if (drive)
+				return gst_pad_event_default (pad, parent, event);
+			gst_event_unref (event);
+			return TRUE;
+	}
+}
+
+static gboolean
+gst_multi_mixer_sink_query (GstPad *pad, GstObject *parent, GstQuery *query)
+{
+	GstCaps *filter, *caps, *templ;
+
+	switch (GST_QUERY_TYPE (query)) {
+		case GST_QUERY_CAPS:
+			gst_query_parse_caps (query, &filter);
+			caps = gst_pad_get_pad_template_caps (pad);
+			if (filter) {
+				templ = caps;
+				caps = gst_caps_intersect_full (filter, templ, GST_CAPS_INTERSECT_FIRST);
+				gst_caps_unref (templ);
+			}
+			gst_query_set_caps_result (query, caps);
+			gst_caps_unref (caps);
+			return TRUE;
+		case GST_QUERY_ACCEPT_CAPS:
+			gst_query_parse_accept_caps (query, &caps);
+			templ = gst_pad_get_pad_template_caps (pad);
+			gst_query_set_accept_caps_result (query, gst_caps_is_subset (caps, templ));
+			gst_caps_unref (templ);
+			return TRUE;
+		case GST_QUERY_ALLOCATION:
+			/* one allocator per output downstream, none of them ours */
+			return FALSE;
+		default:
+			return gst_pad_query_default (pad, parent, query);
+	}
+}
+
+static gboolean
+gst_multi_mixer_src_query (GstPad *pad, GstObject *parent, GstQuery *query)
+{
+	GstMultiMixer *mixer = GST_MULTI_MIXER (parent);
+	GstCaps *filter, *caps, *tmp;
+
+	switch (GST_QUERY_TYPE (query)) {
+		case GST_QUERY_CAPS:
+			gst_query_parse_caps (query, &filter);
+			g_mutex_lock (&mixer->lock);
+			if (mixer->have_info)
+				caps = gst_video_info_to_caps (&mixer->info);
+			else
+				caps = gst_pad_get_pad_template_caps (pad);
+			g_mutex_unlock (&mixer->lock);
+			if (filter) {
+				tmp = caps;
+				caps = gst_caps_intersect_full (filter, tmp, GST_CAPS_INTERSECT_FIRST);
+				gst_caps_unref (tmp);
+			}
+			gst_query_set_caps_result (query, caps);
+			gst_caps_unref (caps);
+			return TRUE;
+		default:
+			return gst_pad_query_default (pad, parent, query);
+	}
+}
+
+/* sink_%u and src_%u, the number given or the next free one */
+static gboolean
+pick_index (GList *pads, gsize offset, const gchar *req_name,
+		const gchar *prefix, guint *index)
+{
+	GList *l;
+	guint max = 0;
+	gchar *end;
+
+	for (l = pads; l; l = l->next)
+		max = MAX (max, G_STRUCT_MEMBER (guint, l->data, offset) + 1);
+
+	if (!req_name || !g_str_has_prefix (req_name, prefix)) {
+		*index = max;
+		return TRUE;
+	}
+
+	*index = g_ascii_strtoull (req_name + strlen (prefix), &end, 10);
+	if (*end)
+		return FALSE;
+	for (l = pads; l; l = l->next) {
+		if (G_STRUCT_MEMBER (guint, l->data, offset) == *index)
+			return FALSE;
+	}
+	return TRUE;
+}
+
+static GstPad *
+gst_multi_mixer_request_new_pad (GstElement *element, GstPadTemplate *templ,
+		const gchar *req_name, const GstCaps *caps)
+{
+	GstMultiMixer *mixer = GST_MULTI_MIXER (element);
+	GstPad *pad;
+	gchar *name;
+	guint index;
+
+	g_mutex_lock (&mixer->lock);
+	if (GST_PAD_TEMPLATE_DIRECTION (templ) == GST_PAD_SINK) {
+		if (!pick_index (mixer->sinkpads, G_STRUCT_OFFSET (GstMultiMixerSinkPad, index),
+					req_name, "sink_", &index))
+			goto taken;
+		name = g_strdup_printf ("sink_%u", index);
+		pad = g_object_new (GST_TYPE_MULTI_MIXER_SINK_PAD, "name", name,
+				"direction", GST_PAD_SINK, "template", templ, NULL);
+		g_free (name);
+		GST_MULTI_MIXER_SINK_PAD (pad)->index = index;
+		gst_pad_set_chain_function (pad, GST_DEBUG_FUNCPTR (gst_multi_mixer_sink_chain));
+		gst_pad_set_event_function (pad, GST_DEBUG_FUNCPTR (gst_multi_mixer_sink_event));
+		gst_pad_set_query_function (pad, GST_DEBUG_FUNCPTR (gst_multi_mixer_sink_query));
+		mixer->sinkpads = g_list_insert_sorted (mixer->sinkpads, pad, compare_sink_index);
+		update_output_info (mixer);
+	} else {
+		if (!pick_index (mixer->srcpads, G_STRUCT_OFFSET (GstMultiMixerSrcPad, index),
+					req_name, "src_", &index))
+			goto taken;
+		name = g_strdup_printf ("src_%u", index);
+		pad = g_object_new (GST_TYPE_MULTI_MIXER_SRC_PAD, "name", name,
+				"direction", GST_PAD_SRC, "template", templ, NULL);
+		g_free (name);
+		GST_MULTI_MIXER_SRC_PAD (pad)->index = index;
+		gst_pad_set_query_function (pad, GST_DEBUG_FUNCPTR (gst_multi_mixer_src_query));
+		mixer->srcpads = g_list_insert_sorted (mixer->srcpads, pad, compare_src_index);
+	}
+	g_mutex_unlock (&mixer->lock);
+
+	gst_element_add_pad (element, pad);
+	gst_child_proxy_child_added (GST_CHILD_PROXY (element), G_OBJECT (pad),
+			GST_OBJECT_NAME (pad));
+	return pad;
+
+taken:
+	g_mutex_unlock (&mixer->lock);
+	GST_WARNING_OBJECT (mixer, "pad %s is taken or invalid", req_name);
+	return NULL;
+}
+
+static void
+gst_multi_mixer_release_pad (GstElement *element, GstPad *pad)
+{
+	GstMultiMixer *mixer = GST_MULTI_MIXER (element);
+
+	g_mutex_lock (&mixer->lock);
+	if (GST_PAD_DIRECTION (pad) == GST_PAD_SINK) {
+		mixer->sinkpads = g_list_remove (mixer->sinkpads, pad);
+		gst_buffer_replace (&GST_MULTI_MIXER_SINK_PAD (pad)->buffer, NULL);
+		update_output_info (mixer);
+	} else {
+		mixer->srcpads = g_list_remove (mixer->srcpads, pad);
+	}
+	g_mutex_unlock (&mixer->lock);
+
+	gst_child_proxy_child_removed (GST_CHILD_PROXY (element), G_OBJECT (pad),
+			GST_OBJECT_NAME (pad));
+	gst_element_remove_pad (element, pad);
+}
+
+static GstStateChangeReturn
+gst_multi_mixer_change_state (GstElement *element, GstStateChange transition)
+{
+	GstMultiMixer *mixer = GST_MULTI_MIXER (element);
+	GstStateChangeReturn ret;
+	GList *l;
+
+	ret = GST_ELEMENT_CLASS (gst_multi_mixer_parent_class)->change_state (element, transition);
+
+	if (transition == GST_STATE_CHANGE_PAUSED_TO_READY) {
+		g_mutex_lock (&mixer->lock);
+		for (l = mixer->sinkpads; l; l = l->next) {
+			GstMultiMixerSinkPad *pad = l->data;
+
+			gst_buffer_replace (&pad->buffer, NULL);
+			pad->have_info = FALSE;
+		}
+		for (l = mixer->srcpads; l; l = l->next) {
+			GstMultiMixerSrcPad *pad = l->data;
+
+			pad->need_stream_start = pad->need_caps = pad->need_segment = TRUE;
+		}
+		mixer->have_info = FALSE;
+		gst_segment_init (&mixer->segment, GST_FORMAT_TIME);
+		g_mutex_unlock (&mixer->lock);
+	}
+	return ret;
+}
+
+static void
+gst_multi_mixer_finalize (GObject *object)
+{
+	GstMultiMixer *mixer = GST_MULTI_MIXER (object);
+
+	g_list_free (mixer->sinkpads);
+	g_list_free (mixer->srcpads);
+	g_mutex_clear (&mixer->lock);
+
+	G_OBJECT_CLASS (gst_multi_mixer_parent_class)->finalize (object);
+}
+
+static void
+gst_multi_mixer_class_init (GstMultiMixerClass *klass)
+{
+	GObjectClass *gobject_class = G_OBJECT_CLASS (klass);
+	GstElementClass *element_class = GST_ELEMENT_CLASS (klass);
+
+	gobject_class->finalize = gst_multi_mixer_finalize;
+
+	gst_element_class_add_pad_template (element_class,
+			gst_static_pad_template_get (&sink_template));
+	gst_element_class_add_pad_template (element_class,
+			gst_static_pad_template_get (&src_template));
+	gst_element_class_set_static_metadata (element_class,
+			"Multi output video mixer", "Filter/Editor/Video/Compositor",
+			"Composites one set of inputs into several outputs in one pass",
+			"surface-streams");
+
+	element_class->request_new_pad = GST_DEBUG_FUNCPTR (gst_multi_mixer_request_new_pad);
+	element_class->release_pad = GST_DEBUG_FUNCPTR (gst_multi_mixer_release_pad);
+	element_class->change_state = GST_DEBUG_FUNCPTR (gst_multi_mixer_change_state);
+}
+
+static void
+gst_multi_mixer_init (GstMultiMixer *mixer)
+{
+	g_mutex_init (&mixer->lock);
+	gst_segment_init (&mixer->segment, GST_FORMAT_TIME);
+}
+
+/* lets gst-launch style "src_1::order=..." reach the pads */
+static GObject *
+gst_multi_mixer_child_proxy_get_child_by_index (GstChildProxy *proxy, guint index)
+{
+	GstElement *element = GST_ELEMENT_CAST (proxy);
+	GObject *obj;
+
+	GST_OBJECT_LOCK (element);
+	obj = g_list_nth_data (element->pads, index);
+	if (obj)
+		gst_object_ref (obj);
+	GST_OBJECT_UNLOCK (element);
+	return obj;
+}
+
+static guint
+gst_multi_mixer_child_proxy_get_children_count (GstChildProxy *proxy)
+{
+	GstElement *element = GST_ELEMENT_CAST (proxy);
+	guint count;
+
+	GST_OBJECT_LOCK (element);
+	count = element->numpads;
+	GST_OBJECT_UNLOCK (element);
+	return count;
+}
+
+static void
+gst_multi_mixer_child_proxy_init (gpointer g_iface, gpointer iface_data)
+{
+	GstChildProxyInterface *iface = g_iface;
+
+	iface->get_child_by_index = gst_multi_mixer_child_proxy_get_child_by_index;
+	iface->get_children_count = gst_multi_mixer_child_proxy_get_children_count;
+}
+
+static gboolean
+plugin_init (GstPlugin *plugin)
+{
+	GST_DEBUG_CATEGORY_INIT (multi_mixer_debug, "multimixer", 0,
+			"Multi output video mixer");
+
+	blend_init ();
+	GST_INFO ("blending with %s", blend_impl_name ());
+
+	return gst_element_register (plugin, "multimixer", GST_RANK_NONE,
+			GST_TYPE_MULTI_MIXER);
+}
+
+gboolean
+multi_mixer_register (void)
+{
+	return gst_plugin_register_static (GST_VERSION_MAJOR, GST_VERSION_MINOR,
+			"multimixer", "Multi output video mixer", plugin_init, "1.0",
+			"LGPL", "3mixer", "3mixer", "https://gstreamer.freedesktop.org/");
+}
@@ -0,0 +1,43 @@
+/**
+ * multimixer: one set of AYUV inputs, any number of composited outputs.
+ *
+ * Replaces a videomixer per output fed through tees from the same
+ * sources. Each src_%u pad has its own stacking order and background,
+ * all outputs are blended row by row in a single pass over the inputs so
+ * every source row is read from memory once.
+ *
+ *   multimixer name=mix src_0::order="0,1" src_2::background=black \
+ *       src_2::order="2,1"
+ *
+ * The order lists sink pad numbers from bottom to top, inputs not listed
+ * are not shown on that output, no order shows all inputs in pad order.
+ * sink_%u pads have xpos, ypos and alpha, shared by all outputs. The
+ * first sink pad drives the mixer: the outputs have its size and frame
+ * rate and are produced whenever it gets a frame, with the latest frame
+ * of every other input, so a stalled network input never stalls them.
+ **/
+#ifndef __MULTI_MIXER_H__
+#define __MULTI_MIXER_H__
+
+#include <gst/gst.h>
+
+G_BEGIN_DECLS
+
+#define GST_TYPE_MULTI_MIXER \
+  (gst_multi_mixer_get_type())
+#define GST_MULTI_MIXER(obj) \
+  (G_TYPE_CHECK_INSTANCE_CAST((obj),GST_TYPE_MULTI_MIXER,GstMultiMixer))
+#define GST_IS_MULTI_MIXER(obj) \
+  (G_TYPE_CHECK_INSTANCE_TYPE((obj),GST_TYPE_MULTI_MIXER))
+
+typedef struct _GstMultiMixer      GstMultiMixer;
+typedef struct _GstMultiMixerClass GstMultiMixerClass;
+
+GType gst_multi_mixer_get_type (void);
+
+/* registers the element with the application, call after gst_init */
+gboolean multi_mixer_register (void);
+
+G_END_DECLS
+
+#endif /* __MULTI_MIXER_H__ */
@@ -0,0 +1,199 @@
+//# the surface streams of many tables in one receiving process
+// was one 3mixer (or surfacesrc branch) per pair of tables, every stream with
+// its own socket, thread and decoder thread.
+// now slotsrc (slotsrc.c) receives all slots on one thread with recvmmsg and
+// decodes them on a thread pool of one thread per core, and one multimixer
+// blends what every table sees in one pass:
+//   slotserver [--slots=8] [--port=5000] [--profile=jpeg|h264|vp8] [--threads=N]
+// slot n is port+n, the 5000+SLOT surfacesend and dualstream send to.
+// output n shows the surfaces of all other slots over snow, the picture
+// table n would get back.
+// build: gcc -Wall -O2 slotserver.c slotsrc.c frameguard.c surfaceprofile.c multimixer.c mixer_blend.c chromakey.c key_convert.c -o slotserver $(pkg-config --cflags --libs gstreamer-1.0 gstreamer-video-1.0 gstreamer-rtp-1.0) -lm
+#include <gst/gst.h>
+#include <glib.h>
+#include <glib-unix.h>
+#include <signal.h>
+
+#include "multimixer.h"
+#include "chromakey.h"
+#include "slotsrc.h"
+#include "surfaceprofile.h"
+
+#define REPORT_INTERVAL 5      /* seconds */
+
+static gint opt_slots = 8;
+static gint opt_port = 5000;
+static gchar *opt_profile = "jpeg";
+static gint opt_threads = 0;
+
+static GOptionEntry entries[] = {
+	{"slots", 'n', 0, G_OPTION_ARG_INT, &opt_slots, "Tables to receive (default 8)", "N"},
+	{"port", 'p', 0, G_OPTION_ARG_INT, &opt_port, "Port of slot 0 (default 5000)", "PORT"},
+	{"profile", 0, 0, G_OPTION_ARG_STRING, &opt_profile, "Streaming profile: jpeg, h264 or vp8 (default jpeg)", "NAME"},
+	{"threads", 't', 0, G_OPTION_ARG_INT, &opt_threads, "Decoding threads, 0 for one per core (default 0)", "N"},
+	{NULL}
+};
+
+static GstElement *pipeline;
+static GMainLoop *loop;
+
+static gchar *
+server_description (void)
+{
+	const gchar *depayloader = surface_profile_depayloader (opt_profile);
+	const gchar *decoder = surface_profile_decoder (opt_profile);
+	GString *description = g_string_new ("multimixer name=mix");
+	gint i, j;
+
+	/* sink_0 is snow, slot n is sink_n+1, output n leaves slot n out */
+	for (i = 0; i < opt_slots; i++) {
+		g_string_append_printf (description, " src_%d::order=\"0", i);
+		for (j = 0; j < opt_slots; j++)
+			if (j != i)
+				g_string_append_printf (description, ",%d", j + 1);
+		g_string_append (description, "\"");
+	}
+	g_string_append (description, " ");
+	for (i = 0; i < opt_slots; i++)
+		g_string_append_printf (description,
+				"mix.src_%d ! videoconvert ! fpsdisplaysink sync=false ", i);
+
+	/* snow drives all outputs, is-live paces it like the cameras */
+	g_string_append (description,
+			"videotestsrc pattern=snow is-live=true ! video/x-raw,width=1280,height=720 ! "
+			"videoconvert ! mix.sink_0 ");
+
+	g_string_append_printf (description,
+			"slotsrc name=slots port=%d slots=%d encoding=%s threads=%d ",
+			opt_port, opt_slots, opt_profile, opt_threads);
+	/* linked when the first packet of the slot comes in */
+	for (i = 0; i < opt_slots; i++)
+		g_string_append_printf (description,
+				"slots.src_%d ! %s ! %s ! chromakey method=green ! mix.sink_%d ",
+				i, depayloader, decoder, i + 1);
+
+	return g_string_free (description, FALSE);
+}
+
+static gboolean
+bus_cb (GstBus *bus, GstMessage *msg, gpointer user_data)
+{
+	GError *err;
+	gchar *debug_info;
+
+	switch (GST_MESSAGE_TYPE (msg)) {
+		case GST_MESSAGE_ERROR:
+			gst_message_parse_error (msg, &err, &debug_info);
+			g_printerr ("Error received from element %s: %s\n", GST_OBJECT_NAME (msg->src), err->message);
+			g_printerr ("Debugging information: %s\n", debug_info ? debug_info : "none");
+			g_clear_error (&err);
+			g_free (debug_info);
+			g_main_loop_quit (loop);
+			break;
+		case GST_MESSAGE_EOS:
+			g_main_loop_quit (loop);
+			break;
+		default:
+			break;
+	}
+	return TRUE;
+}
+
+static gboolean
+report_cb (gpointer user_data)
+{
+	GstElement *slots = gst_bin_get_by_name (GST_BIN (pipeline), "slots");
+	GstStructure *stats = NULL;
+	gchar *text;
+
+	if (!slots)
+		return G_SOURCE_CONTINUE;
+	g_object_get (slots, "stats", &stats, NULL);
+	if (stats) {
+		text = gst_structure_to_string (stats);
+		g_print ("%s\n", text);
+		g_free (text);
+		gst_structure_free (stats);
+	}
+	gst_object_unref (slots);
+	return G_SOURCE_CONTINUE;
+}
+
+static gboolean
+quit_cb (gpointer user_data)
+{
+	g_main_loop_quit (loop);
+	return G_SOURCE_REMOVE;
+}
+
+int main(int argc, char *argv[]) {
+	GOptionContext *context;
+	GError *error = NULL;
+	gchar *description;
+
+	/**
+	 * 1) Parse the options, gst_init is part of it
+	 **/
+	context = g_option_context_new ("- receive and mix the surface streams of many tables");
+	g_option_context_add_main_entries (context, entries, NULL);
+	g_option_context_add_group (context, gst_init_get_option_group ());
+	if (!g_option_context_parse (context, &argc, &argv, &error)) {
+		g_printerr ("%s\n", error->message);
+		g_clear_error (&error);
+		return -1;
+	}
+	g_option_context_free (context);
+	if (!surface_profile_decoder (opt_profile)) {
+		g_printerr ("unknown profile %s, use jpeg, h264 or vp8\n", opt_profile);
+		return -1;
+	}
+	if (opt_slots < 1 || opt_port < 0 || opt_port + opt_slots > 65536 || opt_threads < 0) {
+		g_printerr ("bad --slots, --port or --threads\n");
+		return -1;
+	}
+
+	/**
+	 * 2) Register the multimixer, chromakey and slotsrc
+	 * they are compiled into this program, not installed as a plugin
+	 **/
+	if (!multi_mixer_register () || !chroma_key_register () || !slot_src_register ()) {
+		g_printerr ("multimixer, chromakey or slotsrc could not be registered.\n");
+		return -1;
+	}
+
+	/**
+	 * 3) One pipeline for all slots
+	 **/
+	description = server_description ();
+	pipeline = gst_parse_launch (description, &error);
+	g_free (description);
+	if (!pipeline) {
+		g_printerr ("pipeline could not be created: %s\n", error->message);
+		g_clear_error (&error);
+		return -1;
+	}
+
+	/**
+	 * 4) Start playing
+	 **/
+	if (gst_element_set_state (pipeline, GST_STATE_PLAYING) == GST_STATE_CHANGE_FAILURE) {
+		g_printerr ("Unable to set the pipeline to the playing state.\n");
+		gst_object_unref (pipeline);
+		return -1;
+	}
+
+	loop = g_main_loop_new (NULL, FALSE);
+	gst_bus_add_watch (GST_ELEMENT_BUS (pipeline), bus_cb, NULL);
+	g_timeout_add_seconds (REPORT_INTERVAL, report_cb, NULL);
+	g_unix_signal_add (SIGINT, quit_cb, NULL);
+	g_unix_signal_add (SIGTERM, quit_cb, NULL);
+	g_main_loop_run (loop);
+
+	/**
+	 * 5) Free resources
+	 **/
+	gst_element_set_state (pipeline, GST_STATE_NULL);
+	gst_object_unref (pipeline);
+	g_main_loop_unref (loop);
+	return 0;
+}
@@ -0,0 +1,648 @@
+/**
+ * slotsrc element, see slotsrc.h
+ **/
+#define _GNU_SOURCE            /* recvmmsg */
+#include <errno.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <gst/gst.h>
+
+#include "slotsrc.h"
+#include "surfaceprofile.h"
+#include "frameguard.h"
+
+GST_DEBUG_CATEGORY_STATIC (slot_src_debug);
+#define GST_CAT_DEFAULT slot_src_debug
+
+#define DEFAULT_PORT 5000
+#define DEFAULT_SLOTS 8
+#define DEFAULT_ENCODING "jpeg"
+#define DEFAULT_THREADS 0
+#define DEFAULT_QUEUE_SIZE 512
+#define DEFAULT_BUFFER_SIZE (1 << 20)
+
+#define BATCH 32               /* packets per recvmmsg */
+#define MAX_PACKET 1500        /* an ethernet frame, the senders stay below */
+
+typedef struct {
+	GstSlotSrc *src;
+	guint index;
+	gint fd;
+	GstPollFD pollfd;
+
+	/* filled by the receive thread, emptied by a pool thread */
+	GMutex lock;
+	GQueue queue;
+	gboolean scheduled;    /* pushed to the pool, not yet done */
+	FrameGuard guard;
+
+	/* only the one pool thread running the slot touches it */
+	GstPad *pad;
+} Slot;
+
+struct _GstSlotSrc {
+	GstElement parent;
+
+	/* properties, protected by the object lock */
+	gint port;
+	guint n_slots;
+	gchar *encoding;
+	guint threads;
+	guint queue_size;
+	gint buffer_size;
+
+	/* from NULL to READY */
+	Slot *slots;
+	GstPoll *poll;
+	GstTask *task;
+	GRecMutex task_lock;
+	GThreadPool *pool;
+	GstBuffer *spare[BATCH];
+	volatile gint flushing;
+
+	/* protected by the object lock */
+	guint64 packets_received;
+	guint64 packets_overflowed;
+};
+
+struct _GstSlotSrcClass {
+	GstElementClass parent_class;
+};
+
+enum {
+	PROP_0,
+	PROP_PORT,
+	PROP_SLOTS,
+	PROP_ENCODING,
+	PROP_THREADS,
+	PROP_QUEUE_SIZE,
+	PROP_BUFFER_SIZE,
+	PROP_STATS
+};
+
+static GstStaticPadTemplate src_template = GST_STATIC_PAD_TEMPLATE ("src_%u",
+		GST_PAD_SRC,
+		GST_PAD_SOMETIMES,
+		GST_STATIC_CAPS ("application/x-rtp"));
+
+G_DEFINE_TYPE (GstSlotSrc, gst_slot_src, GST_TYPE_ELEMENT);
+
+/*************************************************************************
+ * Pushing, on the thread pool
+ *************************************************************************/
+static gboolean
+gst_slot_src_pad_query (GstPad *pad, GstObject *parent, GstQuery *query)
+{
+	switch (GST_QUERY_TYPE (query)) {
+		case GST_QUERY_LATENCY:
+			/* packets leave as soon as they arrived */
+			gst_query_set_latency (query, TRUE, 0, GST_CLOCK_TIME_NONE);
+			return TRUE;
+		default:
+			return gst_pad_query_default (pad, parent, query);
+	}
+}
+
+/* with the first packet of the slot, on its pool thread */
+static void
+gst_slot_src_add_pad (GstSlotSrc *src, Slot *slot)
+{
+	GstSegment segment;
+	GstCaps *caps;
+	gchar *name, *stream_id;
+
+	name = g_strdup_printf ("src_%u", slot->index);
+	slot->pad = gst_pad_new_from_static_template (&src_template, name);
+	g_free (name);
+	gst_pad_set_query_function (slot->pad, gst_slot_src_pad_query);
+	gst_pad_use_fixed_caps (slot->pad);
+	gst_pad_set_active (slot->pad, TRUE);
+
+	stream_id = gst_pad_create_stream_id_printf (slot->pad, GST_ELEMENT (src),
+			"%u", slot->index);
+	gst_pad_store_sticky_event (slot->pad, gst_event_new_stream_start (stream_id));
+	g_free (stream_id);
+
+	GST_OBJECT_LOCK (src);
+	caps = gst_caps_from_string (surface_profile_rtp_caps (src->encoding));
+	GST_OBJECT_UNLOCK (src);
+	gst_pad_store_sticky_event (slot->pad, gst_event_new_caps (caps));
+	gst_caps_unref (caps);
+
+	gst_segment_init (&segment, GST_FORMAT_TIME);
+	gst_pad_store_sticky_event (slot->pad, gst_event_new_segment (&segment));
+
+	/* links it when parse-launch asked for slots.src_N */
+	gst_element_add_pad (GST_ELEMENT (src), slot->pad);
+	GST_INFO_OBJECT (src, "slot %u started", slot->index);
+}
+
+/* runs one slot until its queue is empty, never two threads on one slot */
+static void
+gst_slot_src_work (gpointer data, gpointer user_data)
+{
+	Slot *slot = data;
+	GstSlotSrc *src = user_data;
+	GstBuffer *buffer;
+	GstFlowReturn ret;
+	gboolean pass;
+
+	for (;;) {
+		g_mutex_lock (&slot->lock);
+		buffer = g_queue_pop_head (&slot->queue);
+		if (!buffer || g_atomic_int_get (&src->flushing)) {
+			slot->scheduled = FALSE;
+			g_mutex_unlock (&slot->lock);
+			if (buffer)
+				gst_buffer_unref (buffer);
+			return;
+		}
+		pass = frame_guard_process (&slot->guard, &buffer, NULL);
+		g_mutex_unlock (&slot->lock);
+
+		if (!pass) {
+			gst_buffer_unref (buffer);
+			continue;
+		}
+		if (!slot->pad)
+			gst_slot_src_add_pad (src, slot);
+
+		/* depayloading and decoding happen here, on this thread */
+		ret = gst_pad_push (slot->pad, buffer);
+		/* nothing linked to a slot is no error, the table is not shown */
+		if (ret < GST_FLOW_EOS && ret != GST_FLOW_NOT_LINKED && ret != GST_FLOW_FLUSHING)
+			GST_ELEMENT_FLOW_ERROR (src, ret);
+	}
+}
+
+/*************************************************************************
+ * Receiving, on the task
+ *************************************************************************/
+static void
+gst_slot_src_queue (GstSlotSrc *src, Slot *slot, GstBuffer *buffer)
+{
+	GstBuffer *old = NULL;
+	gboolean schedule;
+
+	g_mutex_lock (&slot->lock);
+	/* a stalled slot loses its oldest packets, the guard sees the gap */
+	if (slot->queue.length >= src->queue_size)
+		old = g_queue_pop_head (&slot->queue);
+	g_queue_push_tail (&slot->queue, buffer);
+	schedule = !slot->scheduled;
+	slot->scheduled = TRUE;
+	g_mutex_unlock (&slot->lock);
+
+	if (old) {
+		gst_buffer_unref (old);
+		GST_OBJECT_LOCK (src);
+		src->packets_overflowed++;
+		GST_OBJECT_UNLOCK (src);
+	}
+	if (schedule)
+		g_thread_pool_push (src->pool, slot, NULL);
+}
+
+/* takes all pending packets of the slot, BATCH at a time */
+static void
+gst_slot_src_receive (GstSlotSrc *src, Slot *slot)
+{
+	struct mmsghdr msgs[BATCH];
+	struct iovec iovs[BATCH];
+	GstMapInfo maps[BATCH];
+	GstClockTime now = GST_CLOCK_TIME_NONE;
+	GstClock *clock;
+	GstBuffer *buffer;
+	gint i, n;
+
+	do {
+		memset (msgs, 0, sizeof (msgs));
+		for (i = 0; i < BATCH; i++) {
+			if (!src->spare[i])
+				src->spare[i] = gst_buffer_new_allocate (NULL, MAX_PACKET, NULL);
+			gst_buffer_map (src->spare[i], &maps[i], GST_MAP_WRITE);
+			iovs[i].iov_base = maps[i].data;
+			iovs[i].iov_len = MAX_PACKET;
+			msgs[i].msg_hdr.msg_iov = &iovs[i];
+			msgs[i].msg_hdr.msg_iovlen = 1;
+		}
+		n = recvmmsg (slot->fd, msgs, BATCH, MSG_DONTWAIT, NULL);
+		for (i = 0; i < BATCH; i++)
+			gst_buffer_unmap (src->spare[i], &maps[i]);
+		if (n <= 0)
+			return;
+
+		/* arrival time, as udpsrc stamps it */
+		clock = gst_element_get_clock (GST_ELEMENT (src));
+		if (clock) {
+			now = gst_clock_get_time (clock) - gst_element_get_base_time (GST_ELEMENT (src));
+			gst_object_unref (clock);
+		}
+
+		for (i = 0; i < n; i++) {
+			buffer = src->spare[i];
+			if (msgs[i].msg_hdr.msg_flags & MSG_TRUNC)
+				continue; /* keep the buffer, the packet is useless */
+			src->spare[i] = NULL;
+			gst_buffer_set_size (buffer, msgs[i].msg_len);
+			GST_BUFFER_PTS (buffer) = GST_BUFFER_DTS (buffer) = now;
+			gst_slot_src_queue (src, slot, buffer);
+		}
+
+		GST_OBJECT_LOCK (src);
+		src->packets_received += n;
+		GST_OBJECT_UNLOCK (src);
+	} while (n == BATCH);
+}
+
+static void
+gst_slot_src_loop (gpointer user_data)
+{
+	GstSlotSrc *src = GST_SLOT_SRC (user_data);
+	guint i;
+
+	/* fails when flushing, the task is then being paused or stopped */
+	if (gst_poll_wait (src->poll, GST_CLOCK_TIME_NONE) < 0)
+		return;
+	for (i = 0; i < src->n_slots; i++)
+		if (gst_poll_fd_can_read (src->poll, &src->slots[i].pollfd))
+			gst_slot_src_receive (src, &src->slots[i]);
+}
+
+/*************************************************************************
+ * States
+ *************************************************************************/
+static void
+gst_slot_src_close (GstSlotSrc *src)
+{
+	guint i;
+
+	if (src->task) {
+		gst_task_join (src->task);
+		gst_object_unref (src->task);
+		src->task = NULL;
+	}
+	for (i = 0; i < src->n_slots && src->slots; i++) {
+		Slot *slot = &src->slots[i];
+
+		if (slot->fd >= 0)
+			close (slot->fd);
+		g_mutex_clear (&slot->lock);
+	}
+	g_clear_pointer (&src->slots, g_free);
+	for (i = 0; i < BATCH; i++)
+		gst_buffer_replace (&src->spare[i], NULL);
+	g_clear_pointer (&src->poll, gst_poll_free);
+}
+
+static gboolean
+gst_slot_src_open (GstSlotSrc *src)
+{
+	struct sockaddr_in addr;
+	gint one = 1;
+	guint i;
+
+	src->poll = gst_poll_new (TRUE);
+	src->slots = g_new0 (Slot, src->n_slots);
+	for (i = 0; i < src->n_slots; i++) {
+		Slot *slot = &src->slots[i];
+
+		slot->src = src;
+		slot->index = i;
+		g_mutex_init (&slot->lock);
+		g_queue_init (&slot->queue);
+		slot->guard.whole_frames = strcmp (src->encoding, "jpeg") == 0;
+
+		slot->fd = socket (AF_INET, SOCK_DGRAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+		memset (&addr, 0, sizeof (addr));
+		addr.sin_family = AF_INET;
+		addr.sin_addr.s_addr = htonl (INADDR_ANY);
+		addr.sin_port = htons (src->port + i);
+		if (slot->fd < 0 ||
+				setsockopt (slot->fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof (one)) < 0 ||
+				bind (slot->fd, (struct sockaddr *) &addr, sizeof (addr)) < 0) {
+			GST_ELEMENT_ERROR (src, RESOURCE, OPEN_READ, (NULL),
+					("UDP port %d: %s", src->port + i, g_strerror (errno)));
+			/* the slots after this one have no fd yet */
+			for (i++; i < src->n_slots; i++) {
+				src->slots[i].fd = -1;
+				g_mutex_init (&src->slots[i].lock);
+			}
+			gst_slot_src_close (src);
+			return FALSE;
+		}
+		/* a burst of every table at once must fit */
+		if (src->buffer_size > 0)
+			setsockopt (slot->fd, SOL_SOCKET, SO_RCVBUF, &src->buffer_size,
+					sizeof (src->buffer_size));
+
+		gst_poll_fd_init (&slot->pollfd);
+		slot->pollfd.fd = slot->fd;
+		gst_poll_add_fd (src->poll, &slot->pollfd);
+		gst_poll_fd_ctl_read (src->poll, &slot->pollfd, TRUE);
+	}
+
+	src->task = gst_task_new (gst_slot_src_loop, src, NULL);
+	gst_object_set_name (GST_OBJECT (src->task), "slotsrc:receive");
+	gst_task_set_lock (src->task, &src->task_lock);
+	return TRUE;
+}
+
+static gboolean
+gst_slot_src_start (GstSlotSrc *src)
+{
+	GError *error = NULL;
+	guint threads;
+
+	/* one thread per core decodes for all slots */
+	threads = src->threads ? src->threads : g_get_num_processors ();
+	src->pool = g_thread_pool_new (gst_slot_src_work, src, threads, TRUE, &error);
+	if (!src->pool) {
+		GST_ELEMENT_ERROR (src, RESOURCE, FAILED, (NULL), ("%s", error->message));
+		g_clear_error (&error);
+		return FALSE;
+	}
+	g_atomic_int_set (&src->flushing, FALSE);
+	return TRUE;
+}
+
+static void
+gst_slot_src_stop (GstSlotSrc *src)
+{
+	GstBuffer *buffer;
+	guint i;
+
+	g_atomic_int_set (&src->flushing, TRUE);
+	gst_poll_set_flushing (src->poll, TRUE);
+	gst_task_join (src->task);
+	/* waits for the slots being pushed, the others return at once */
+	g_thread_pool_free (src->pool, FALSE, TRUE);
+	src->pool = NULL;
+
+	for (i = 0; i < src->n_slots; i++) {
+		Slot *slot = &src->slots[i];
+
+		while ((buffer = g_queue_pop_head (&slot->queue)))
+			gst_buffer_unref (buffer);
+		slot->scheduled = FALSE;
+		frame_guard_reset (&slot->guard);
+		if (slot->pad) {
+			gst_pad_set_active (slot->pad, FALSE);
+			gst_element_remove_pad (GST_ELEMENT (src), slot->pad);
+			slot->pad = NULL;
+		}
+	}
+	GST_OBJECT_LOCK (src);
+	src->packets_received = 0;
+	src->packets_overflowed = 0;
+	GST_OBJECT_UNLOCK (src);
+}
+
+static GstStateChangeReturn
+gst_slot_src_change_state (GstElement *element, GstStateChange transition)
+{
+	GstSlotSrc *src = GST_SLOT_SRC (element);
+	GstStateChangeReturn ret;
+
+	switch (transition) {
+		case GST_STATE_CHANGE_NULL_TO_READY:
+			/* port, slots and encoding are read here */
+			if (!gst_slot_src_open (src))
+				return GST_STATE_CHANGE_FAILURE;
+			break;
+		case GST_STATE_CHANGE_READY_TO_PAUSED:
+			if (!gst_slot_src_start (src))
+				return GST_STATE_CHANGE_FAILURE;
+			break;
+		case GST_STATE_CHANGE_PAUSED_TO_PLAYING:
+			gst_poll_set_flushing (src->poll, FALSE);
+			gst_task_start (src->task);
+			break;
+		case GST_STATE_CHANGE_PLAYING_TO_PAUSED:
+			gst_poll_set_flushing (src->poll, TRUE);
+			gst_task_pause (src->task);
+			break;
+		case GST_STATE_CHANGE_PAUSED_TO_READY:
+			gst_slot_src_stop (src);
+			break;
+		default:
+			break;
+	}
+
+	ret = GST_ELEMENT_CLASS (gst_slot_src_parent_class)->change_state (element, transition);
+
+	switch (transition) {
+		case GST_STATE_CHANGE_READY_TO_PAUSED:
+		case GST_STATE_CHANGE_PLAYING_TO_PAUSED:
+			/* live, nothing comes before PLAYING */
+			if (ret != GST_STATE_CHANGE_FAILURE)
+				ret = GST_STATE_CHANGE_NO_PREROLL;
+			break;
+		case GST_STATE_CHANGE_READY_TO_NULL:
+			gst_slot_src_close (src);
+			break;
+		default:
+			break;
+	}
+	return ret;
+}
+
+/*************************************************************************
+ * Properties
+ *************************************************************************/
+static GstStructure *
+gst_slot_src_stats_structure (GstSlotSrc *src)
+{
+	guint64 lost = 0, delivered = 0, dropped = 0, damaged = 0;
+	guint i, active = 0;
+
+	for (i = 0; src->slots && i < src->n_slots; i++) {
+		Slot *slot = &src->slots[i];
+
+		g_mutex_lock (&slot->lock);
+		lost += slot->guard.packets_lost;
+		delivered += slot->guard.frames_delivered;
+		dropped += slot->guard.frames_dropped;
+		damaged += slot->guard.frames_damaged;
+		if (slot->guard.have_seq)
+			active++;
+		g_mutex_unlock (&slot->lock);
+	}
+	return gst_structure_new ("slotsrc-stats",
+			"slots-active", G_TYPE_UINT, active,
+			"packets-received", G_TYPE_UINT64, src->packets_received,
+			"packets-overflowed", G_TYPE_UINT64, src->packets_overflowed,
+			"packets-lost", G_TYPE_UINT64, lost,
+			"frames-delivered", G_TYPE_UINT64, delivered,
+			"frames-dropped", G_TYPE_UINT64, dropped,
+			"frames-damaged", G_TYPE_UINT64, damaged,
+			NULL);
+}
+
+static void
+gst_slot_src_set_property (GObject *object, guint prop_id,
+		const GValue *value, GParamSpec *pspec)
+{
+	GstSlotSrc *src = GST_SLOT_SRC (object);
+
+	GST_OBJECT_LOCK (src);
+	switch (prop_id) {
+		case PROP_PORT:
+			src->port = g_value_get_int (value);
+			break;
+		case PROP_SLOTS:
+			/* the slot array is sized when the sockets open */
+			if (!src->slots)
+				src->n_slots = g_value_get_uint (value);
+			break;
+		case PROP_ENCODING:
+			if (surface_profile_rtp_caps (g_value_get_string (value))) {
+				g_free (src->encoding);
+				src->encoding = g_value_dup_string (value);
+			} else {
+				GST_WARNING_OBJECT (src, "unknown encoding %s", g_value_get_string (value));
+			}
+			break;
+		case PROP_THREADS:
+			src->threads = g_value_get_uint (value);
+			break;
+		case PROP_QUEUE_SIZE:
+			src->queue_size = g_value_get_uint (value);
+			break;
+		case PROP_BUFFER_SIZE:
+			src->buffer_size = g_value_get_int (value);
+			break;
+		default:
+			G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+			break;
+	}
+	GST_OBJECT_UNLOCK (src);
+}
+
+static void
+gst_slot_src_get_property (GObject *object, guint prop_id, GValue *value,
+		GParamSpec *pspec)
+{
+	GstSlotSrc *src = GST_SLOT_SRC (object);
+
+	GST_OBJECT_LOCK (src);
+	switch (prop_id) {
+		case PROP_PORT:
+			g_value_set_int (value, src->port);
+			break;
+		case PROP_SLOTS:
+			g_value_set_uint (value, src->n_slots);
+			break;
+		case PROP_ENCODING:
+			g_value_set_string (value, src->encoding);
+			break;
+		case PROP_THREADS:
+			g_value_set_uint (value, src->threads);
+			break;
+		case PROP_QUEUE_SIZE:
+			g_value_set_uint (value, src->queue_size);
+			break;
+		case PROP_BUFFER_SIZE:
+			g_value_set_int (value, src->buffer_size);
+			break;
+		case PROP_STATS:
+			g_value_take_boxed (value, gst_slot_src_stats_structure (src));
+			break;
+		default:
+			G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+			break;
+	}
+	GST_OBJECT_UNLOCK (src);
+}
+
+static void
+gst_slot_src_finalize (GObject *object)
+{
+	GstSlotSrc *src = GST_SLOT_SRC (object);
+
+	g_free (src->encoding);
+	g_rec_mutex_clear (&src->task_lock);
+
+	G_OBJECT_CLASS (gst_slot_src_parent_class)->finalize (object);
+}
+
+static void
+gst_slot_src_class_init (GstSlotSrcClass *klass)
+{
+	GObjectClass *gobject_class = G_OBJECT_CLASS (klass);
+	GstElementClass *element_class = GST_ELEMENT_CLASS (klass);
+
+	gobject_class->set_property = gst_slot_src_set_property;
+	gobject_class->get_property = gst_slot_src_get_property;
+	gobject_class->finalize = gst_slot_src_finalize;
+
+	g_object_class_install_property (gobject_class, PROP_PORT,
+			g_param_spec_int ("port", "Port", "UDP port of slot 0, slot n is on port+n",
+				0, 65535, DEFAULT_PORT, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+	g_object_class_install_property (gobject_class, PROP_SLOTS,
+			g_param_spec_uint ("slots", "Slots", "Number of slots, one per table",
+				1, 1024, DEFAULT_SLOTS, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+	g_object_class_install_property (gobject_class, PROP_ENCODING,
+			g_param_spec_string ("encoding", "Encoding",
+				"Streaming profile of the senders: jpeg, h264 or vp8",
+				DEFAULT_ENCODING, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+	g_object_class_install_property (gobject_class, PROP_THREADS,
+			g_param_spec_uint ("threads", "Threads",
+				"Threads pushing and decoding for all slots (0 - one per core)",
+				0, 256, DEFAULT_THREADS, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+	g_object_class_install_property (gobject_class, PROP_QUEUE_SIZE,
+			g_param_spec_uint ("queue-size", "Queue size",
+				"Packets a slot may have waiting before the oldest are dropped",
+				1, G_MAXUINT, DEFAULT_QUEUE_SIZE, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+	g_object_class_install_property (gobject_class, PROP_BUFFER_SIZE,
+			g_param_spec_int ("buffer-size", "Buffer size",
+				"Kernel receive buffer of each socket (0 - system default)",
+				0, G_MAXINT, DEFAULT_BUFFER_SIZE, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+	g_object_class_install_property (gobject_class, PROP_STATS,
+			g_param_spec_boxed ("stats", "Statistics",
+				"Active slots, packets received, overflowed and lost, frames delivered, dropped and damaged",
+				GST_TYPE_STRUCTURE, G_PARAM_READABLE | G_PARAM_STATIC_STRINGS));
+
+	gst_element_class_add_pad_template (element_class,
+			gst_static_pad_template_get (&src_template));
+	gst_element_class_set_static_metadata (element_class,
+			"Surface slot source", "Source/Network",
+			"Receives the surface streams of many slots with recvmmsg and pushes them from a shared thread pool",
+			"surface-streams");
+
+	element_class->change_state = GST_DEBUG_FUNCPTR (gst_slot_src_change_state);
+}
+
+static void
+gst_slot_src_init (GstSlotSrc *src)
+{
+	src->port = DEFAULT_PORT;
+	src->n_slots = DEFAULT_SLOTS;
+	src->encoding = g_strdup (DEFAULT_ENCODING);
+	src->threads = DEFAULT_THREADS;
+	src->queue_size = DEFAULT_QUEUE_SIZE;
+	src->buffer_size = DEFAULT_BUFFER_SIZE;
+	g_rec_mutex_init (&src->task_lock);
+
+	GST_OBJECT_FLAG_SET (src, GST_ELEMENT_FLAG_SOURCE);
+}
+
+static gboolean
+plugin_init (GstPlugin *plugin)
+{
+	GST_DEBUG_CATEGORY_INIT (slot_src_debug, "slotsrc", 0,
+			"Surface slot source");
+
+	return gst_element_register (plugin, "slotsrc", GST_RANK_NONE,
+			GST_TYPE_SLOT_SRC);
+}
+
+gboolean
+slot_src_register (void)
+{
+	return gst_plugin_register_static (GST_VERSION_MAJOR, GST_VERSION_MINOR,
+			"slotsrc", "Surface slot source", plugin_init, "1.0",
+			"LGPL", "3mixer", "3mixer", "https://gstreamer.freedesktop.org/");
+}
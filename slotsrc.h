@@ -0,0 +1,42 @@
+/**
+ * slotsrc: receives the surface streams of many tables in one element.
+ *
+ * Slot n is the stream on UDP port port+n, the 5000+SLOT of the start
+ * scripts. One thread waits on the sockets of all slots and takes the
+ * packets off each in batches with recvmmsg. The packets of each slot go
+ * through a frame guard (frameguard.h) and are pushed on its src_%u pad
+ * by a pool of threads shared by all slots, so the depayloaders and
+ * decoders linked to the pads run on those threads, one slot at a time
+ * per thread, instead of a receiver process or a thread per slot.
+ *
+ *   slotsrc name=slots slots=8 encoding=jpeg \
+ *     slots.src_0 ! rtpgstdepay ! jpegdec ! chromakey ! mix.sink_1 ...
+ *
+ * A src_%u pad appears with the first packet of its slot. The "stats"
+ * property sums packets and frames over all slots.
+ **/
+#ifndef __SLOT_SRC_H__
+#define __SLOT_SRC_H__
+
+#include <gst/gst.h>
+
+G_BEGIN_DECLS
+
+#define GST_TYPE_SLOT_SRC \
+  (gst_slot_src_get_type())
+#define GST_SLOT_SRC(obj) \
+  (G_TYPE_CHECK_INSTANCE_CAST((obj),GST_TYPE_SLOT_SRC,GstSlotSrc))
+#define GST_IS_SLOT_SRC(obj) \
+  (G_TYPE_CHECK_INSTANCE_TYPE((obj),GST_TYPE_SLOT_SRC))
+
+typedef struct _GstSlotSrc      GstSlotSrc;
+typedef struct _GstSlotSrcClass GstSlotSrcClass;
+
+GType gst_slot_src_get_type (void);
+
+/* registers the element with the application, call after gst_init */
+gboolean slot_src_register (void);
+
+G_END_DECLS
+
+#endif /* __SLOT_SRC_H__ */
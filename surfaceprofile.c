@@ -0,0 +1,109 @@
+/**
+ * streaming profiles, see surfaceprofile.h
+ **/
+#include <string.h>
+
+#include "surfaceprofile.h"
+
+gchar *
+surface_profile_payloader (const gchar *profile,
+		const SurfaceProfileOptions *options)
+{
+	/* rate control may not hold more than one frame back */
+	gint frame_ms = 1000 / MAX (options->fps, 1);
+	gint refresh = options->refresh > 0 ? options->refresh : options->fps;
+
+	if (strcmp (profile, "jpeg") == 0)
+		return g_strdup_printf ("videoconvert ! jpegenc quality=%d ! "
+				"rtpgstpay config-interval=1 mtu=%d",
+				options->quality, options->mtu);
+
+	if (strcmp (profile, "h264") == 0)
+		/* slice-max-size leaves room for the RTP and FU headers. With intra
+		 * refresh only the first frame is an IDR, so SPS/PPS are repeated
+		 * every second for receivers that join or restart later */
+		return g_strdup_printf ("videoconvert ! x264enc tune=zerolatency speed-preset=ultrafast "
+				"bitrate=%d vbv-buf-capacity=%d key-int-max=%d intra-refresh=true "
+				"sliced-threads=true option-string=\"slice-max-size=%d\" ! "
+				"video/x-h264,profile=constrained-baseline ! "
+				"rtph264pay mtu=%d config-interval=1 aggregate-mode=zero-latency",
+				options->bitrate, frame_ms, refresh, options->mtu - 100,
+				options->mtu);
+
+	if (strcmp (profile, "vp8") == 0)
+		/* vp8enc has no intra refresh, keyframes come every refresh frames */
+		return g_strdup_printf ("videoconvert ! vp8enc deadline=1 cpu-used=8 lag-in-frames=0 "
+				"end-usage=cbr target-bitrate=%d keyframe-max-dist=%d "
+				"error-resilient=default+partitions token-partitions=2 "
+				"buffer-size=%d buffer-initial-size=%d buffer-optimal-size=%d ! "
+				"rtpvp8pay mtu=%d picture-id-mode=15-bit",
+				options->bitrate * 1000, refresh, frame_ms, frame_ms, frame_ms,
+				options->mtu);
+
+	return NULL;
+}
+
+gchar *
+surface_profile_sender (const gchar *profile,
+		const SurfaceProfileOptions *options, const gchar *host, gint port)
+{
+	gchar *payloader = surface_profile_payloader (profile, options);
+	gchar *sender;
+
+	if (!payloader)
+		return NULL;
+	sender = g_strdup_printf ("%s ! udpsink host=%s port=%d sync=false",
+			payloader, host, port);
+	g_free (payloader);
+	return sender;
+}
+
+/* what the receiving side needs for each profile */
+static const struct {
+	const gchar *name;
+	const gchar *rtp_caps;
+	const gchar *depayloader;
+	const gchar *decoder;      /* all of them give chromakey I420 */
+} receivers[] = {
+	{"jpeg", "application/x-rtp,media=application,clock-rate=90000,encoding-name=X-GST",
+		"rtpgstdepay", "jpegdec"},
+	{"h264", "application/x-rtp,media=video,clock-rate=90000,encoding-name=H264",
+		"rtph264depay", "avdec_h264"},
+	{"vp8", "application/x-rtp,media=video,clock-rate=90000,encoding-name=VP8",
+		"rtpvp8depay", "vp8dec"}
+};
+
+static gint
+surface_profile_receiver (const gchar *profile)
+{
+	guint i;
+
+	for (i = 0; i < G_N_ELEMENTS (receivers); i++)
+		if (strcmp (profile, receivers[i].name) == 0)
+			return i;
+	return -1;
+}
+
+const gchar *
+surface_profile_decoder (const gchar *profile)
+{
+	gint i = surface_profile_receiver (profile);
+
+	return i < 0 ? NULL : receivers[i].decoder;
+}
+
+const gchar *
+surface_profile_rtp_caps (const gchar *profile)
+{
+	gint i = surface_profile_receiver (profile);
+
+	return i < 0 ? NULL : receivers[i].rtp_caps;
+}
+
+const gchar *
+surface_profile_depayloader (const gchar *profile)
+{
+	gint i = surface_profile_receiver (profile);
+
+	return i < 0 ? NULL : receivers[i].depayloader;
+}
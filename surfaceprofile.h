@@ -0,0 +1,48 @@
+/**
+ * Streaming profiles of the surface streams, shared by the senders
+ * (surfacesend, dualstream) and the receivers (surfacesrc, slotsrc and
+ * the programs using them):
+ *
+ *   jpeg  every frame a JPEG in rtpgstpay
+ *   h264  x264 in zero latency mode with intra refresh and sliced frames
+ *   vp8   libvpx realtime with error resilient token partitions
+ *
+ * The name is also the "encoding" of surfacesrc on the receiving side.
+ **/
+#ifndef __SURFACE_PROFILE_H__
+#define __SURFACE_PROFILE_H__
+
+#include <glib.h>
+
+G_BEGIN_DECLS
+
+typedef struct {
+	gint fps;              /* frame rate of the source */
+	gint bitrate;          /* kbit/s, h264 and vp8 */
+	gint refresh;          /* frames per intra refresh or keyframe, 0 for one second */
+	gint mtu;              /* largest RTP packet */
+	gint quality;          /* jpeg */
+} SurfaceProfileOptions;
+
+#define SURFACE_PROFILE_OPTIONS_DEFAULT { 15, 2000, 0, 1200, 75 }
+
+/* the pipeline from videoconvert to the RTP payloader, for a transport
+ * of the caller's own (rtpbin), NULL for an unknown profile */
+gchar *surface_profile_payloader (const gchar *profile,
+		const SurfaceProfileOptions *options);
+
+/* the pipeline from videoconvert to udpsink, NULL for an unknown profile */
+gchar *surface_profile_sender (const gchar *profile,
+		const SurfaceProfileOptions *options, const gchar *host, gint port);
+
+/* the decoder for the profile, NULL for an unknown one */
+const gchar *surface_profile_decoder (const gchar *profile);
+
+/* the RTP caps and the depayloader of the profile's stream,
+ * NULL for an unknown profile */
+const gchar *surface_profile_rtp_caps (const gchar *profile);
+const gchar *surface_profile_depayloader (const gchar *profile);
+
+G_END_DECLS
+
+#endif /* __SURFACE_PROFILE_H__ */
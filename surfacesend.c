@@ -0,0 +1,125 @@
+//# streams one camera or surface to a surfacesrc (surfacesrc.c)
+// usage: surfacesend [--profile=jpeg|h264|vp8] [--fps=15] [--bitrate=2000] HOST PORT [SOURCE]
+// SOURCE is the head of a pipeline, by default "v4l2src device=/dev/video-surf".
+// every v4l2src in it is captured without copies, see v4l2capture.h.
+// --print writes only the tail, from videoconvert to udpsink, for programs that
+// take a pipeline of their own:
+//   Protonect -gstpipe "videorate ! video/x-raw,framerate=15/1 ! $(./surfacesend --print --profile=h264 host 5000)"
+// profiles (surfaceprofile.c):
+//   jpeg  every frame a JPEG in rtpgstpay, as start_dual_src.sh always sent
+//   h264  x264 in zero latency mode: no B frames or lookahead, a VBV of one
+//         frame, intra refresh sweeping over --refresh frames instead of
+//         keyframes, and slices that each fit one RTP packet
+//   vp8   libvpx realtime with error resilient token partitions
+// build: gcc -Wall -O2 surfacesend.c surfaceprofile.c v4l2capture.c -o surfacesend $(pkg-config --cflags --libs gstreamer-1.0)
+#include <gst/gst.h>
+#include <glib.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "surfaceprofile.h"
+#include "v4l2capture.h"
+
+#define DEFAULT_SOURCE "v4l2src device=/dev/video-surf"
+
+static gchar *opt_profile = "jpeg";
+static SurfaceProfileOptions options = SURFACE_PROFILE_OPTIONS_DEFAULT;
+static gboolean opt_print = FALSE;
+static gchar *opt_io_mode = V4L2_CAPTURE_IO_MODE_DEFAULT;
+static gint opt_capture_buffers = V4L2_CAPTURE_BUFFERS_DEFAULT;
+
+static GOptionEntry entries[] = {
+	{"profile", 'p', 0, G_OPTION_ARG_STRING, &opt_profile, "Streaming profile: jpeg, h264 or vp8 (default jpeg)", "NAME"},
+	{"fps", 'f', 0, G_OPTION_ARG_INT, &options.fps, "Frame rate of the source (default 15)", "N"},
+	{"bitrate", 'b', 0, G_OPTION_ARG_INT, &options.bitrate, "Bitrate of h264 and vp8 in kbit/s (default 2000)", "KBIT"},
+	{"refresh", 'r', 0, G_OPTION_ARG_INT, &options.refresh, "Frames per intra refresh or keyframe (default one second)", "N"},
+	{"mtu", 'm', 0, G_OPTION_ARG_INT, &options.mtu, "Largest RTP packet (default 1200)", "BYTES"},
+	{"quality", 'q', 0, G_OPTION_ARG_INT, &options.quality, "JPEG quality (default 75)", "N"},
+	{"print", 0, 0, G_OPTION_ARG_NONE, &opt_print, "Print the pipeline tail and exit", NULL},
+	{"io-mode", 0, 0, G_OPTION_ARG_STRING, &opt_io_mode, "io-mode of v4l2src: mmap, dmabuf, rw... (default mmap)", "MODE"},
+	{"capture-buffers", 0, 0, G_OPTION_ARG_INT, &opt_capture_buffers, "Buffers of v4l2src on top of the driver minimum, 0 leaves it to v4l2src (default 4)", "N"},
+	{NULL}
+};
+
+int main(int argc, char *argv[]) {
+	GOptionContext *context;
+	GstElement *pipeline;
+	GstBus *bus;
+	GstMessage *msg;
+	GError *error = NULL;
+	gchar *tail, *description;
+	const gchar *source;
+
+	/**
+	 * 1) Parse the options, gst_init is part of it
+	 **/
+	context = g_option_context_new ("HOST PORT [SOURCE] - stream a surface to surfacesrc");
+	g_option_context_add_main_entries (context, entries, NULL);
+	g_option_context_add_group (context, gst_init_get_option_group ());
+	if (!g_option_context_parse (context, &argc, &argv, &error)) {
+		g_printerr ("%s\n", error->message);
+		g_clear_error (&error);
+		return -1;
+	}
+	g_option_context_free (context);
+	if (argc < 3) {
+		g_printerr ("usage: %s [options] HOST PORT [SOURCE]\n", argv[0]);
+		return -1;
+	}
+	source = argc > 3 ? argv[3] : DEFAULT_SOURCE;
+
+	/**
+	 * 2) Put the profile's encoder and payloader behind the source
+	 **/
+	tail = surface_profile_sender (opt_profile, &options, argv[1], atoi (argv[2]));
+	if (!tail) {
+		g_printerr ("unknown profile %s, use jpeg, h264 or vp8\n", opt_profile);
+		return -1;
+	}
+	if (opt_print) {
+		g_print ("%s\n", tail);
+		g_free (tail);
+		return 0;
+	}
+	description = g_strdup_printf ("%s ! videorate ! video/x-raw,framerate=%d/1 ! %s",
+			source, options.fps, tail);
+	g_free (tail);
+
+	pipeline = gst_parse_launch (description, &error);
+	if (!pipeline) {
+		g_printerr ("pipeline could not be created: %s\n", error->message);
+		g_clear_error (&error);
+		g_free (description);
+		return -1;
+	}
+	g_print ("%s\n", description);
+	g_free (description);
+	v4l2_capture_tune (GST_BIN (pipeline), opt_io_mode, MAX (opt_capture_buffers, 0));
+
+	/**
+	 * 3) Stream until an error or the end of the source
+	 **/
+	if (gst_element_set_state (pipeline, GST_STATE_PLAYING) == GST_STATE_CHANGE_FAILURE) {
+		g_printerr ("Unable to set the pipeline to the playing state.\n");
+		gst_object_unref (pipeline);
+		return -1;
+	}
+	bus = gst_element_get_bus (pipeline);
+	msg = gst_bus_timed_pop_filtered (bus, GST_CLOCK_TIME_NONE,
+	                                  GST_MESSAGE_ERROR | GST_MESSAGE_EOS);
+	if (GST_MESSAGE_TYPE (msg) == GST_MESSAGE_ERROR) {
+		gchar *debug_info;
+
+		gst_message_parse_error (msg, &error, &debug_info);
+		g_printerr ("Error received from element %s: %s\n", GST_OBJECT_NAME (msg->src), error->message);
+		g_printerr ("Debugging information: %s\n", debug_info ? debug_info : "none");
+		g_clear_error (&error);
+		g_free (debug_info);
+	}
+	gst_message_unref (msg);
+	gst_object_unref (bus);
+
+	gst_element_set_state (pipeline, GST_STATE_NULL);
+	gst_object_unref (pipeline);
+	return 0;
+}
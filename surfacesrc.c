@@ -0,0 +1,663 @@
+/**
+ * surfacesrc element, see surfacesrc.h
+ **/
+#include <math.h>
+#include <gst/gst.h>
+#include <gst/rtp/gstrtpbuffer.h>
+
+#include "surfacesrc.h"
+#include "surfaceprofile.h"
+#include "frameguard.h"
+
+GST_DEBUG_CATEGORY_STATIC (surface_src_debug);
+#define GST_CAT_DEFAULT surface_src_debug
+
+typedef enum {
+	SURFACE_SRC_ENCODING_JPEG,
+	SURFACE_SRC_ENCODING_H264,
+	SURFACE_SRC_ENCODING_VP8
+} SurfaceSrcEncoding;
+
+typedef enum {
+	SURFACE_SRC_FEC_NONE,
+	SURFACE_SRC_FEC_ULPFEC,
+	SURFACE_SRC_FEC_ST2022_1
+} SurfaceSrcFec;
+
+#define DEFAULT_PORT 5000
+#define DEFAULT_ENCODING SURFACE_SRC_ENCODING_JPEG
+#define DEFAULT_LATENCY_MIN 10
+#define DEFAULT_LATENCY_MAX 100
+#define DEFAULT_FEC SURFACE_SRC_FEC_NONE
+#define DEFAULT_FEC_PT 122
+#define DEFAULT_STATS_INTERVAL 300
+#define DEFAULT_RTCP_PORT 0
+
+#define RTP_CLOCK_RATE 90000
+#define ADAPT_FRAMES 30        /* frames between latency updates */
+#define JITTER_FACTOR 4        /* latency per ms of mean jitter */
+
+#define GST_TYPE_SURFACE_SRC_ENCODING (gst_surface_src_encoding_get_type ())
+#define GST_TYPE_SURFACE_SRC_FEC (gst_surface_src_fec_get_type ())
+
+struct _GstSurfaceSrc {
+	GstBin parent;
+
+	GstPad *srcpad;
+	GstElement *jitterbuffer;  /* rtpjitterbuffer, or rtpbin with RTCP */
+	gboolean built;
+
+	/* properties, protected by the object lock */
+	gint port;
+	SurfaceSrcEncoding encoding;
+	guint latency_min, latency_max;
+	SurfaceSrcFec fec;
+	guint fec_pt;
+	guint stats_interval;
+	gint rtcp_port;
+
+	/* streaming state and statistics, protected by the object lock */
+	FrameGuard guard;
+	gboolean have_transit;
+	gint64 last_transit;
+	gdouble jitter;        /* RFC 3550 interarrival jitter of whole frames, in RTP units */
+	guint latency;         /* current jitter buffer latency in ms */
+	guint adapt_frames;
+	guint window_frames;
+	guint64 packets_received;
+};
+
+struct _GstSurfaceSrcClass {
+	GstBinClass parent_class;
+};
+
+enum {
+	PROP_0,
+	PROP_PORT,
+	PROP_ENCODING,
+	PROP_LATENCY_MIN,
+	PROP_LATENCY_MAX,
+	PROP_FEC,
+	PROP_FEC_PT,
+	PROP_STATS,
+	PROP_STATS_INTERVAL,
+	PROP_RTCP_PORT
+};
+
+static GstStaticPadTemplate src_template = GST_STATIC_PAD_TEMPLATE ("src",
+		GST_PAD_SRC,
+		GST_PAD_ALWAYS,
+		GST_STATIC_CAPS_ANY);
+
+G_DEFINE_TYPE (GstSurfaceSrc, gst_surface_src, GST_TYPE_BIN);
+
+static GType
+gst_surface_src_encoding_get_type (void)
+{
+	static GType type = 0;
+	static const GEnumValue values[] = {
+		{SURFACE_SRC_ENCODING_JPEG, "JPEG frames in rtpgstpay", "jpeg"},
+		{SURFACE_SRC_ENCODING_H264, "H.264 with intra refresh and slices", "h264"},
+		{SURFACE_SRC_ENCODING_VP8, "VP8 with error resilient partitions", "vp8"},
+		{0, NULL, NULL}
+	};
+
+	if (!type)
+		type = g_enum_register_static ("GstSurfaceSrcEncoding", values);
+	return type;
+}
+
+static GType
+gst_surface_src_fec_get_type (void)
+{
+	static GType type = 0;
+	static const GEnumValue values[] = {
+		{SURFACE_SRC_FEC_NONE, "No forward error correction", "none"},
+		{SURFACE_SRC_FEC_ULPFEC, "ULPFEC (RFC 5109) in the media stream", "ulpfec"},
+		{SURFACE_SRC_FEC_ST2022_1, "SMPTE 2022-1 row and column FEC on port+2 and port+4", "st2022-1"},
+		{0, NULL, NULL}
+	};
+
+	if (!type)
+		type = g_enum_register_static ("GstSurfaceSrcFec", values);
+	return type;
+}
+
+/*************************************************************************
+ * Statistics
+ *************************************************************************/
+/* call with the object lock */
+static GstStructure *
+gst_surface_src_stats_structure (GstSurfaceSrc *src)
+{
+	return gst_structure_new ("surfacesrc-stats",
+			"packets-received", G_TYPE_UINT64, src->packets_received,
+			"packets-lost", G_TYPE_UINT64, src->guard.packets_lost,
+			"frames-delivered", G_TYPE_UINT64, src->guard.frames_delivered,
+			"frames-dropped", G_TYPE_UINT64, src->guard.frames_dropped,
+			"frames-damaged", G_TYPE_UINT64, src->guard.frames_damaged,
+			"jitter-ms", G_TYPE_DOUBLE, src->jitter * 1000.0 / RTP_CLOCK_RATE,
+			"latency-ms", G_TYPE_UINT, src->latency,
+			NULL);
+}
+
+/* the latency in ms the jitter buffer should have for the jitter seen,
+ * call with the object lock */
+static guint
+gst_surface_src_target_latency (GstSurfaceSrc *src)
+{
+	gdouble jitter_ms = src->jitter * 1000.0 / RTP_CLOCK_RATE;
+	guint target;
+
+	target = (guint) ceil (JITTER_FACTOR * jitter_ms);
+	target = CLAMP (target, src->latency_min, src->latency_max);
+
+	/* grow at once, shrink halfway per step so a quiet second does not
+	 * undo what a burst needed */
+	if (target < src->latency)
+		target = src->latency - (src->latency - target + 1) / 2;
+	return target;
+}
+
+/* before the jitter buffer: arrival jitter of complete frames */
+static GstPadProbeReturn
+gst_surface_src_arrival_probe (GstPad *pad, GstPadProbeInfo *info,
+		gpointer user_data)
+{
+	GstSurfaceSrc *src = GST_SURFACE_SRC (user_data);
+	GstRTPBuffer rtp = GST_RTP_BUFFER_INIT;
+	gboolean marker;
+	guint32 timestamp;
+	gint64 transit, d;
+	guint latency = 0;
+
+	if (!gst_rtp_buffer_map (GST_PAD_PROBE_INFO_BUFFER (info), GST_MAP_READ, &rtp))
+		return GST_PAD_PROBE_OK;
+	marker = gst_rtp_buffer_get_marker (&rtp);
+	timestamp = gst_rtp_buffer_get_timestamp (&rtp);
+	gst_rtp_buffer_unmap (&rtp);
+
+	GST_OBJECT_LOCK (src);
+	src->packets_received++;
+	if (marker) {
+		transit = g_get_monotonic_time () * RTP_CLOCK_RATE / G_USEC_PER_SEC -
+			timestamp;
+		if (src->have_transit) {
+			/* the RTP timestamp wraps, the difference of two does not */
+			d = (gint32) ((guint32) transit - (guint32) src->last_transit);
+			src->jitter += (ABS (d) - src->jitter) / 16;
+		}
+		src->last_transit = transit;
+		src->have_transit = TRUE;
+
+		if (++src->adapt_frames >= ADAPT_FRAMES) {
+			src->adapt_frames = 0;
+			latency = gst_surface_src_target_latency (src);
+			if (latency == src->latency)
+				latency = 0;
+			else
+				src->latency = latency;
+		}
+	}
+	GST_OBJECT_UNLOCK (src);
+
+	/* the jitter buffer posts a latency message, the application has to
+	 * answer it with gst_bin_recalculate_latency on the pipeline */
+	if (latency) {
+		GST_DEBUG_OBJECT (src, "jitter buffer latency now %u ms", latency);
+		g_object_set (src->jitterbuffer, "latency", latency, NULL);
+	}
+	return GST_PAD_PROBE_OK;
+}
+
+/* after the jitter buffer and FEC, in front of the depayloader */
+static GstPadProbeReturn
+gst_surface_src_guard_probe (GstPad *pad, GstPadProbeInfo *info,
+		gpointer user_data)
+{
+	GstSurfaceSrc *src = GST_SURFACE_SRC (user_data);
+	GstBuffer *buffer = GST_PAD_PROBE_INFO_BUFFER (info);
+	GstStructure *stats = NULL;
+	gboolean pass, marker;
+
+	GST_OBJECT_LOCK (src);
+	pass = frame_guard_process (&src->guard, &buffer, &marker);
+	if (marker && src->stats_interval && ++src->window_frames >= src->stats_interval) {
+		src->window_frames = 0;
+		stats = gst_surface_src_stats_structure (src);
+	}
+	GST_OBJECT_UNLOCK (src);
+
+	if (stats)
+		gst_element_post_message (GST_ELEMENT (src),
+				gst_message_new_element (GST_OBJECT (src), stats));
+
+	if (!pass)
+		return GST_PAD_PROBE_DROP;
+	GST_PAD_PROBE_INFO_DATA (info) = buffer;
+	return GST_PAD_PROBE_OK;
+}
+
+/*************************************************************************
+ * The bin
+ *************************************************************************/
+/* the profile name in surfaceprofile.c */
+static const gchar *
+gst_surface_src_encoding_name (SurfaceSrcEncoding encoding)
+{
+	GEnumClass *klass = g_type_class_ref (GST_TYPE_SURFACE_SRC_ENCODING);
+	const gchar *name = g_enum_get_value (klass, encoding)->value_nick;
+
+	g_type_class_unref (klass);
+	return name;
+}
+
+static GstElement *
+gst_surface_src_make (GstSurfaceSrc *src, const gchar *factory)
+{
+	GstElement *element = gst_element_factory_make (factory, NULL);
+
+	if (element)
+		gst_bin_add (GST_BIN (src), element);
+	return element;
+}
+
+static GstElement *
+gst_surface_src_make_udpsrc (GstSurfaceSrc *src, gint port,
+		SurfaceSrcEncoding encoding)
+{
+	GstElement *udpsrc = gst_surface_src_make (src, "udpsrc");
+
+	if (!udpsrc)
+		return NULL;
+	g_object_set (udpsrc, "port", port, NULL);
+	gst_util_set_object_arg (G_OBJECT (udpsrc), "caps",
+			surface_profile_rtp_caps (gst_surface_src_encoding_name (encoding)));
+	return udpsrc;
+}
+
+/* a new SSRC is a restarted sender, it replaces the old stream */
+static void
+gst_surface_src_rtpbin_pad_added (GstElement *rtpbin, GstPad *pad,
+		gpointer user_data)
+{
+	GstSurfaceSrc *src = GST_SURFACE_SRC (GST_OBJECT_PARENT (rtpbin));
+	GstElement *downstream = GST_ELEMENT (user_data);
+	GstPad *sinkpad, *peer;
+
+	if (!g_str_has_prefix (GST_PAD_NAME (pad), "recv_rtp_src_"))
+		return;
+	/* its sequence numbers start anywhere */
+	GST_OBJECT_LOCK (src);
+	frame_guard_reset (&src->guard);
+	GST_OBJECT_UNLOCK (src);
+	sinkpad = gst_element_get_static_pad (downstream, "sink");
+	peer = gst_pad_get_peer (sinkpad);
+	if (peer) {
+		gst_pad_unlink (peer, sinkpad);
+		gst_object_unref (peer);
+	}
+	gst_pad_link (pad, sinkpad);
+	gst_object_unref (sinkpad);
+}
+
+/* upstream ! jitter buffer ! downstream. rtpbin takes the sender reports
+ * of rtcp_port and times the frames by them on the pipeline clock, its
+ * side to downstream is linked once the stream has come in. */
+static gboolean
+gst_surface_src_link_jitterbuffer (GstSurfaceSrc *src, GstElement *upstream,
+		GstElement *downstream, gint rtcp_port)
+{
+	GstElement *rtcpsrc;
+	GstPad *srcpad, *sinkpad;
+	gboolean linked;
+
+	if (!rtcp_port)
+		return gst_element_link_many (upstream, src->jitterbuffer, downstream, NULL);
+
+	rtcpsrc = gst_surface_src_make (src, "udpsrc");
+	if (!rtcpsrc)
+		return FALSE;
+	g_object_set (rtcpsrc, "port", rtcp_port, NULL);
+	gst_util_set_object_arg (G_OBJECT (rtcpsrc), "caps", "application/x-rtcp");
+
+	srcpad = gst_element_get_static_pad (upstream, "src");
+	sinkpad = gst_element_get_request_pad (src->jitterbuffer, "recv_rtp_sink_0");
+	linked = sinkpad && gst_pad_link (srcpad, sinkpad) == GST_PAD_LINK_OK;
+	gst_object_unref (srcpad);
+	if (sinkpad)
+		gst_object_unref (sinkpad);
+
+	srcpad = gst_element_get_static_pad (rtcpsrc, "src");
+	sinkpad = gst_element_get_request_pad (src->jitterbuffer, "recv_rtcp_sink_0");
+	linked = linked && sinkpad && gst_pad_link (srcpad, sinkpad) == GST_PAD_LINK_OK;
+	gst_object_unref (srcpad);
+	if (sinkpad)
+		gst_object_unref (sinkpad);
+
+	g_signal_connect_object (src->jitterbuffer, "pad-added",
+			G_CALLBACK (gst_surface_src_rtpbin_pad_added), downstream, 0);
+	return linked;
+}
+
+/* the FEC decoder is left out with a warning when its plugin is missing */
+static gboolean
+gst_surface_src_build (GstSurfaceSrc *src)
+{
+	GstElement *udpsrc, *depay, *storage, *fecdec = NULL, *fecsrc;
+	GstObject *internal_storage;
+	GstPad *pad, *fecpad;
+	SurfaceSrcEncoding encoding;
+	SurfaceSrcFec fec;
+	gint port, rtcp_port, i;
+	guint fec_pt;
+
+	GST_OBJECT_LOCK (src);
+	port = src->port;
+	encoding = src->encoding;
+	/* JPEG cannot be decoded in part, H.264 and VP8 slices can */
+	src->guard.whole_frames = encoding == SURFACE_SRC_ENCODING_JPEG;
+	fec = src->fec;
+	fec_pt = src->fec_pt;
+	rtcp_port = src->rtcp_port;
+	src->latency = src->latency_min;
+	GST_OBJECT_UNLOCK (src);
+
+	udpsrc = gst_surface_src_make_udpsrc (src, port, encoding);
+	src->jitterbuffer = gst_surface_src_make (src, rtcp_port ? "rtpbin" : "rtpjitterbuffer");
+	depay = gst_surface_src_make (src,
+			surface_profile_depayloader (gst_surface_src_encoding_name (encoding)));
+	if (!udpsrc || !src->jitterbuffer || !depay) {
+		GST_ELEMENT_ERROR (src, CORE, MISSING_PLUGIN, (NULL),
+				("udpsrc, rtpjitterbuffer, rtpbin or the depayloader of %s is missing",
+				 gst_surface_src_encoding_name (encoding)));
+		return FALSE;
+	}
+	/* late packets are lost packets, the guard sees the gap they leave */
+	g_object_set (src->jitterbuffer, "latency", src->latency, "do-lost", TRUE,
+			"drop-on-latency", TRUE, NULL);
+	/* the NTP times of the sender reports are its pipeline clock, which is
+	 * ours too when the sender slaves to it (dualstream --sync) */
+	if (rtcp_port) {
+		g_object_set (src->jitterbuffer, "ntp-sync", TRUE, NULL);
+		gst_util_set_object_arg (G_OBJECT (src->jitterbuffer), "ntp-time-source", "clock-time");
+	}
+
+	switch (fec) {
+		case SURFACE_SRC_FEC_ULPFEC:
+			storage = gst_surface_src_make (src, "rtpstorage");
+			fecdec = gst_surface_src_make (src, "rtpulpfecdec");
+			if (!storage || !fecdec) {
+				GST_ELEMENT_WARNING (src, CORE, MISSING_PLUGIN, (NULL),
+						("rtpstorage or rtpulpfecdec missing, receiving without FEC"));
+				if (storage)
+					gst_bin_remove (GST_BIN (src), storage);
+				if (fecdec)
+					gst_bin_remove (GST_BIN (src), fecdec);
+				fecdec = NULL;
+				break;
+			}
+			g_object_get (storage, "internal-storage", &internal_storage, NULL);
+			g_object_set (fecdec, "storage", internal_storage, "pt", fec_pt, NULL);
+			g_object_unref (internal_storage);
+			/* recovers from the lost events of the jitter buffer */
+			gst_element_link (udpsrc, storage);
+			gst_surface_src_link_jitterbuffer (src, storage, fecdec, rtcp_port);
+			gst_element_link (fecdec, depay);
+			break;
+		case SURFACE_SRC_FEC_ST2022_1:
+			fecdec = gst_surface_src_make (src, "rtpst2022-1-fecdec");
+			if (!fecdec) {
+				GST_ELEMENT_WARNING (src, CORE, MISSING_PLUGIN, (NULL),
+						("rtpst2022-1-fecdec missing, receiving without FEC"));
+				break;
+			}
+			/* row and column FEC come on their own ports */
+			for (i = 0; i < 2; i++) {
+				fecsrc = gst_surface_src_make_udpsrc (src, port + 2 + 2 * i, encoding);
+				if (!fecsrc)
+					break;
+				pad = gst_element_get_static_pad (fecsrc, "src");
+				fecpad = gst_element_get_request_pad (fecdec, "fec_%u");
+				if (fecpad) {
+					gst_pad_link (pad, fecpad);
+					gst_object_unref (fecpad);
+				}
+				gst_object_unref (pad);
+			}
+			/* recovered packets come out of order, the jitter buffer sorts them */
+			gst_element_link (udpsrc, fecdec);
+			gst_surface_src_link_jitterbuffer (src, fecdec, depay, rtcp_port);
+			break;
+		case SURFACE_SRC_FEC_NONE:
+			break;
+	}
+	if (!fecdec && !gst_surface_src_link_jitterbuffer (src, udpsrc, depay, rtcp_port)) {
+		GST_ELEMENT_ERROR (src, CORE, NEGOTIATION, (NULL),
+				("the jitter buffer could not be linked"));
+		return FALSE;
+	}
+
+	pad = gst_element_get_static_pad (udpsrc, "src");
+	gst_pad_add_probe (pad, GST_PAD_PROBE_TYPE_BUFFER,
+			gst_surface_src_arrival_probe, src, NULL);
+	gst_object_unref (pad);
+
+	pad = gst_element_get_static_pad (depay, "sink");
+	gst_pad_add_probe (pad, GST_PAD_PROBE_TYPE_BUFFER,
+			gst_surface_src_guard_probe, src, NULL);
+	gst_object_unref (pad);
+
+	pad = gst_element_get_static_pad (depay, "src");
+	gst_ghost_pad_set_target (GST_GHOST_PAD (src->srcpad), pad);
+	gst_object_unref (pad);
+
+	src->built = TRUE;
+	return TRUE;
+}
+
+static void
+gst_surface_src_reset (GstSurfaceSrc *src)
+{
+	GST_OBJECT_LOCK (src);
+	frame_guard_reset (&src->guard);
+	src->have_transit = FALSE;
+	src->jitter = 0;
+	src->adapt_frames = 0;
+	src->window_frames = 0;
+	src->packets_received = 0;
+	GST_OBJECT_UNLOCK (src);
+}
+
+static GstStateChangeReturn
+gst_surface_src_change_state (GstElement *element, GstStateChange transition)
+{
+	GstSurfaceSrc *src = GST_SURFACE_SRC (element);
+
+	switch (transition) {
+		case GST_STATE_CHANGE_NULL_TO_READY:
+			/* port, encoding, fec and rtcp-port are read here, the chain is built once */
+			if (!src->built && !gst_surface_src_build (src))
+				return GST_STATE_CHANGE_FAILURE;
+			break;
+		case GST_STATE_CHANGE_READY_TO_PAUSED:
+			gst_surface_src_reset (src);
+			break;
+		default:
+			break;
+	}
+	return GST_ELEMENT_CLASS (gst_surface_src_parent_class)->change_state (element, transition);
+}
+
+static void
+gst_surface_src_set_property (GObject *object, guint prop_id,
+		const GValue *value, GParamSpec *pspec)
+{
+	GstSurfaceSrc *src = GST_SURFACE_SRC (object);
+
+	GST_OBJECT_LOCK (src);
+	switch (prop_id) {
+		case PROP_PORT:
+			src->port = g_value_get_int (value);
+			break;
+		case PROP_ENCODING:
+			src->encoding = g_value_get_enum (value);
+			break;
+		case PROP_LATENCY_MIN:
+			src->latency_min = g_value_get_uint (value);
+			break;
+		case PROP_LATENCY_MAX:
+			src->latency_max = g_value_get_uint (value);
+			break;
+		case PROP_FEC:
+			src->fec = g_value_get_enum (value);
+			break;
+		case PROP_FEC_PT:
+			src->fec_pt = g_value_get_uint (value);
+			break;
+		case PROP_STATS_INTERVAL:
+			src->stats_interval = g_value_get_uint (value);
+			break;
+		case PROP_RTCP_PORT:
+			src->rtcp_port = g_value_get_int (value);
+			break;
+		default:
+			G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+			break;
+	}
+	/* keep min <= max whichever was set last */
+	if (src->latency_max < src->latency_min)
+		src->latency_max = src->latency_min;
+	GST_OBJECT_UNLOCK (src);
+}
+
+static void
+gst_surface_src_get_property (GObject *object, guint prop_id, GValue *value,
+		GParamSpec *pspec)
+{
+	GstSurfaceSrc *src = GST_SURFACE_SRC (object);
+
+	GST_OBJECT_LOCK (src);
+	switch (prop_id) {
+		case PROP_PORT:
+			g_value_set_int (value, src->port);
+			break;
+		case PROP_ENCODING:
+			g_value_set_enum (value, src->encoding);
+			break;
+		case PROP_LATENCY_MIN:
+			g_value_set_uint (value, src->latency_min);
+			break;
+		case PROP_LATENCY_MAX:
+			g_value_set_uint (value, src->latency_max);
+			break;
+		case PROP_FEC:
+			g_value_set_enum (value, src->fec);
+			break;
+		case PROP_FEC_PT:
+			g_value_set_uint (value, src->fec_pt);
+			break;
+		case PROP_STATS:
+			g_value_take_boxed (value, gst_surface_src_stats_structure (src));
+			break;
+		case PROP_STATS_INTERVAL:
+			g_value_set_uint (value, src->stats_interval);
+			break;
+		case PROP_RTCP_PORT:
+			g_value_set_int (value, src->rtcp_port);
+			break;
+		default:
+			G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+			break;
+	}
+	GST_OBJECT_UNLOCK (src);
+}
+
+static void
+gst_surface_src_class_init (GstSurfaceSrcClass *klass)
+{
+	GObjectClass *gobject_class = G_OBJECT_CLASS (klass);
+	GstElementClass *element_class = GST_ELEMENT_CLASS (klass);
+
+	gobject_class->set_property = gst_surface_src_set_property;
+	gobject_class->get_property = gst_surface_src_get_property;
+
+	g_object_class_install_property (gobject_class, PROP_PORT,
+			g_param_spec_int ("port", "Port", "UDP port of the RTP stream",
+				0, 65535, DEFAULT_PORT, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+	g_object_class_install_property (gobject_class, PROP_ENCODING,
+			g_param_spec_enum ("encoding", "Encoding", "Encoding of the stream, as sent by surfacesend",
+				GST_TYPE_SURFACE_SRC_ENCODING, DEFAULT_ENCODING,
+				G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+	g_object_class_install_property (gobject_class, PROP_LATENCY_MIN,
+			g_param_spec_uint ("latency-min", "Minimum latency",
+				"Lowest jitter buffer latency in ms",
+				0, G_MAXUINT, DEFAULT_LATENCY_MIN, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+	g_object_class_install_property (gobject_class, PROP_LATENCY_MAX,
+			g_param_spec_uint ("latency-max", "Maximum latency",
+				"Highest jitter buffer latency in ms, whatever the jitter",
+				0, G_MAXUINT, DEFAULT_LATENCY_MAX, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+	g_object_class_install_property (gobject_class, PROP_FEC,
+			g_param_spec_enum ("fec", "FEC", "Forward error correction sent along with the stream",
+				GST_TYPE_SURFACE_SRC_FEC, DEFAULT_FEC,
+				G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+	g_object_class_install_property (gobject_class, PROP_FEC_PT,
+			g_param_spec_uint ("fec-pt", "FEC payload type", "Payload type of the ULPFEC packets",
+				0, 127, DEFAULT_FEC_PT, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+	g_object_class_install_property (gobject_class, PROP_STATS,
+			g_param_spec_boxed ("stats", "Statistics",
+				"Packets received and lost, frames delivered, dropped and damaged, jitter and latency in ms",
+				GST_TYPE_STRUCTURE, G_PARAM_READABLE | G_PARAM_STATIC_STRINGS));
+	g_object_class_install_property (gobject_class, PROP_STATS_INTERVAL,
+			g_param_spec_uint ("stats-interval", "Statistics interval",
+				"Frames between stats element messages on the bus (0-disable)",
+				0, G_MAXUINT, DEFAULT_STATS_INTERVAL, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+	g_object_class_install_property (gobject_class, PROP_RTCP_PORT,
+			g_param_spec_int ("rtcp-port", "RTCP port",
+				"UDP port of the sender's RTCP, frames are then timed by its sender reports (0-none)",
+				0, 65535, DEFAULT_RTCP_PORT, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+	gst_element_class_add_pad_template (element_class,
+			gst_static_pad_template_get (&src_template));
+	gst_element_class_set_static_metadata (element_class,
+			"Surface stream source", "Source/Network",
+			"Receives a surface stream with adaptive jitter buffering, optional FEC and a frame guard",
+			"surface-streams");
+
+	element_class->change_state = GST_DEBUG_FUNCPTR (gst_surface_src_change_state);
+}
+
+static void
+gst_surface_src_init (GstSurfaceSrc *src)
+{
+	src->port = DEFAULT_PORT;
+	src->encoding = DEFAULT_ENCODING;
+	src->latency_min = DEFAULT_LATENCY_MIN;
+	src->latency_max = DEFAULT_LATENCY_MAX;
+	src->fec = DEFAULT_FEC;
+	src->fec_pt = DEFAULT_FEC_PT;
+	src->stats_interval = DEFAULT_STATS_INTERVAL;
+	src->rtcp_port = DEFAULT_RTCP_PORT;
+
+	src->srcpad = gst_ghost_pad_new_no_target_from_template ("src",
+			gst_static_pad_template_get (&src_template));
+	gst_element_add_pad (GST_ELEMENT (src), src->srcpad);
+}
+
+static gboolean
+plugin_init (GstPlugin *plugin)
+{
+	GST_DEBUG_CATEGORY_INIT (surface_src_debug, "surfacesrc", 0,
+			"Surface stream source");
+
+	return gst_element_register (plugin, "surfacesrc", GST_RANK_NONE,
+			GST_TYPE_SURFACE_SRC);
+}
+
+gboolean
+surface_src_register (void)
+{
+	return gst_plugin_register_static (GST_VERSION_MAJOR, GST_VERSION_MINOR,
+			"surfacesrc", "Surface stream source", plugin_init, "1.0",
+			"LGPL", "3mixer", "3mixer", "https://gstreamer.freedesktop.org/");
+}
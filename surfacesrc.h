@@ -0,0 +1,57 @@
+/**
+ * surfacesrc: receives one surface stream from UDP, as sent by surfacesend.
+ *
+ *   udpsrc ! [rtpst2022-1-fecdec] ! rtpjitterbuffer ! [rtpulpfecdec]
+ *       ! (frame guard) ! rtpgstdepay | rtph264depay | rtpvp8depay
+ *
+ * The jitter buffer latency follows the measured network jitter between
+ * latency-min and latency-max; each change posts a latency message the
+ * application answers with gst_bin_recalculate_latency. For
+ * encoding=jpeg the frame guard drops every frame that lost a packet
+ * before it reaches the depayloader, so the decoder only ever sees
+ * complete JPEGs, and marks the next complete frame DISCONT so
+ * rtpgstdepay forgets the partial one. H.264 and VP8 frames with lost
+ * slices are passed on; the decoder conceals them and the sender's intra
+ * refresh repairs them. Optional FEC recovers packets before the guard
+ * looks at them.
+ *
+ *   surfacesrc port=5000 fec=st2022-1 ! jpegdec ! ...
+ *   surfacesrc port=5000 encoding=h264 ! avdec_h264 ! ...
+ *
+ * With rtcp-port, rtpbin takes the place of the jitter buffer and plays
+ * each frame at the sender's capture time in its RTCP sender reports plus
+ * the latency (ntp-sync), so streams of one sender in separate surfacesrcs
+ * and rtpbins stay aligned. That needs the sender's pipeline clock to be
+ * ours, as dualstream --sync shares it.
+ *
+ *   surfacesrc port=6000 rtcp-port=6500 ! jpegdec ! ...
+ *
+ * The "stats" property has packets, losses, frames, jitter and the
+ * current latency; they are posted as an element message every
+ * stats-interval frames.
+ **/
+#ifndef __SURFACE_SRC_H__
+#define __SURFACE_SRC_H__
+
+#include <gst/gst.h>
+
+G_BEGIN_DECLS
+
+#define GST_TYPE_SURFACE_SRC \
+  (gst_surface_src_get_type())
+#define GST_SURFACE_SRC(obj) \
+  (G_TYPE_CHECK_INSTANCE_CAST((obj),GST_TYPE_SURFACE_SRC,GstSurfaceSrc))
+#define GST_IS_SURFACE_SRC(obj) \
+  (G_TYPE_CHECK_INSTANCE_TYPE((obj),GST_TYPE_SURFACE_SRC))
+
+typedef struct _GstSurfaceSrc      GstSurfaceSrc;
+typedef struct _GstSurfaceSrcClass GstSurfaceSrcClass;
+
+GType gst_surface_src_get_type (void);
+
+/* registers the element with the application, call after gst_init */
+gboolean surface_src_register (void);
+
+G_END_DECLS
+
+#endif /* __SURFACE_SRC_H__ */
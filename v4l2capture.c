@@ -0,0 +1,87 @@
+/**
+ * zero-copy capture, see v4l2capture.h
+ **/
+#include <string.h>
+
+#include "v4l2capture.h"
+
+/**
+ * on the answered allocation query of v4l2src, before it sizes its pool:
+ * v4l2src reads the min of the query as what downstream holds and adds the
+ * driver's minimum and V4L2_CAPTURE_OWN_BUFFERS, so downstream is said to
+ * hold buffers less those. Without a pool from downstream the query is
+ * left alone, v4l2src then keeps its copy fallback.
+ **/
+static GstPadProbeReturn
+v4l2_capture_allocation_probe (GstPad *pad, GstPadProbeInfo *info,
+		gpointer user_data)
+{
+	GstQuery *query = GST_PAD_PROBE_INFO_QUERY (info);
+	guint buffers = GPOINTER_TO_UINT (user_data);
+	GstBufferPool *pool = NULL;
+	guint size = 0, min, max, held;
+
+	if (GST_QUERY_TYPE (query) != GST_QUERY_ALLOCATION ||
+			gst_query_get_n_allocation_pools (query) == 0)
+		return GST_PAD_PROBE_OK;
+
+	held = buffers > V4L2_CAPTURE_OWN_BUFFERS ? buffers - V4L2_CAPTURE_OWN_BUFFERS : 0;
+	gst_query_parse_nth_allocation_pool (query, 0, &pool, &size, &min, &max);
+	if (max && max < held)
+		max = held;
+	gst_query_set_nth_allocation_pool (query, 0, pool, size, held, max);
+	if (pool)
+		gst_object_unref (pool);
+	return GST_PAD_PROBE_OK;
+}
+
+static gboolean
+v4l2_capture_tune_source (GstElement *element, const gchar *io_mode,
+		guint buffers)
+{
+	GstElementFactory *factory = gst_element_get_factory (element);
+	GstPad *pad;
+
+	if (!factory || strcmp (GST_OBJECT_NAME (factory), "v4l2src") != 0)
+		return FALSE;
+
+	gst_util_set_object_arg (G_OBJECT (element), "io-mode", io_mode);
+	if (buffers) {
+		pad = gst_element_get_static_pad (element, "src");
+		/* PULL is the way back, when downstream has answered */
+		gst_pad_add_probe (pad, GST_PAD_PROBE_TYPE_QUERY_DOWNSTREAM | GST_PAD_PROBE_TYPE_PULL,
+				v4l2_capture_allocation_probe, GUINT_TO_POINTER (buffers), NULL);
+		gst_object_unref (pad);
+	}
+	GST_INFO_OBJECT (element, "io-mode %s, %u buffers", io_mode, buffers);
+	return TRUE;
+}
+
+guint
+v4l2_capture_tune (GstBin *bin, const gchar *io_mode, guint buffers)
+{
+	GstIterator *it = gst_bin_iterate_recurse (bin);
+	GValue item = G_VALUE_INIT;
+	gboolean done = FALSE;
+	guint n = 0;
+
+	while (!done) {
+		switch (gst_iterator_next (it, &item)) {
+			case GST_ITERATOR_OK:
+				if (v4l2_capture_tune_source (g_value_get_object (&item), io_mode, buffers))
+					n++;
+				g_value_reset (&item);
+				break;
+			case GST_ITERATOR_RESYNC:
+				/* the bin is not playing yet, nothing is added to it meanwhile */
+				gst_iterator_resync (it);
+				break;
+			default:
+				done = TRUE;
+				break;
+		}
+	}
+	g_value_unset (&item);
+	gst_iterator_free (it);
+	return n;
+}
@@ -0,0 +1,34 @@
+/**
+ * Zero-copy capture for the v4l2src elements of a pipeline.
+ *
+ * io-mode=mmap hands the driver's buffers downstream as they are, dmabuf
+ * exports them as dmabuf fds for an importing decoder; rtpgstpay, jpegdec
+ * and the encoders read them in place either way. Every queued buffer is
+ * a frame of latency when the sender falls behind, so the number
+ * downstream says it holds is replaced by one that keeps the pool small.
+ * v4l2src sizes its pool to what downstream holds plus the driver's
+ * minimum plus two of its own: buffers = 4 is a pool of 4 plus the
+ * driver's minimum, usually 6 in all. When downstream proposes no pool
+ * v4l2src is left to size its own and to copy frames once downstream
+ * holds too many.
+ **/
+#ifndef __V4L2_CAPTURE_H__
+#define __V4L2_CAPTURE_H__
+
+#include <gst/gst.h>
+
+G_BEGIN_DECLS
+
+#define V4L2_CAPTURE_IO_MODE_DEFAULT "mmap"
+#define V4L2_CAPTURE_BUFFERS_DEFAULT 4
+/* buffers v4l2src keeps on top of what downstream holds and the driver needs */
+#define V4L2_CAPTURE_OWN_BUFFERS 2
+
+/* sets io-mode on every v4l2src in bin, and sizes its pool to buffers
+ * plus the driver's minimum; call before the pipeline leaves NULL.
+ * Returns the number of sources. */
+guint v4l2_capture_tune (GstBin *bin, const gchar *io_mode, guint buffers);
+
+G_END_DECLS
+
+#endif /* __V4L2_CAPTURE_H__ */